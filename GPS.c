@@ -1,20 +1,73 @@
 #include "GPSConfig.h"
 #include "GPS.h"
+#if (_GPS_HOST==1)
+#include "GPSHost.h"
+#else
 #include "usart.h"
+#endif
+#if (_GPS_STATS==1)
+#include "GPSStats.h"
+#endif
+#if (_GPS_UBX==1)
+#include "GPSUbx.h"
+#endif
+#if (_GPS_ASSIST==1)
+#include "GPSAssist.h"
+#endif
+#if (_GPS_MAVLINK==1)
+#include "GPSMavlink.h"
+#endif
+#if (_GPS_N2K==1)
+#include "GPSN2k.h"
+#endif
+#if (_GPS_QUEUE==1)
+#include "GPSQueue.h"
+#endif
+#if (_GPS_POOL==1)
+#include "GPSPool.h"
+#endif
+#if (_GPS_FIX==1)
+#include "GPSFix.h"
+#endif
+#if (_GPS_TRIP==1)
+#include "GPSTrip.h"
+#endif
+#if (_GPS_JAM==1)
+#include "GPSJam.h"
+#endif
 #include <string.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <math.h>
 
 GPS_t GPS;
+
+#if (_GPS_STREAM==1)
+#define	GPS_STREAM_LOAD(p)					__atomic_load_n(p,__ATOMIC_ACQUIRE)
+#define	GPS_STREAM_STORE(p,v)				__atomic_store_n(p,v,__ATOMIC_RELEASE)
+#define	GPS_STREAM_FENCE()					__atomic_thread_fence(__ATOMIC_SEQ_CST)
+#define	GPS_STREAM_CLAIM(p,e)				__atomic_compare_exchange_n(p,e,*(e) | 1,0,__ATOMIC_ACQ_REL,__ATOMIC_ACQUIRE)
+#if (_GPS_JAM==1) && (_GPS_GSV==1)
+//	last complete sky of the GPS instance, taken in the receive context and handed to GPS_Jam by GPS_ProcessEx()
+static struct
+{
+	volatile uint32_t	Seq;
+	volatile uint8_t	Ready;
+	uint8_t						Count;
+	uint32_t					Time;
+	GPS_Sat_t					Sat[_GPS_GSV_SATS];
+
+}GPS_Sky;
+#endif
+#endif
 //##################################################################################################################
-double convertDegMinToDecDeg (float degMin)
+double convertDegMinToDecDeg (double degMin)
 {
   double min = 0.0;
   double decDeg = 0.0;
  
   //get the minutes, fmod() requires double
-  min = fmod((double)degMin, 100.0);
+  min = fmod(degMin, 100.0);
  
   //rebuild coordinates in decimal degrees
   degMin = (int) ( degMin / 100 );
@@ -22,51 +75,759 @@ double convertDegMinToDecDeg (float degMin)
  
   return decDeg;
 }
+#if (_GPS_STREAM==0)
+//##################################################################################################################
+static const char	*GPS_Next(const char *str)
+{
+	while((*str!=',') && (*str!='*') && (*str!='\r') && (*str!=0))
+		str++;
+	return (*str==',') ? str+1 : str;
+}
+//##################################################################################################################
+static char	*GPS_Find(GPS_t *Gps,const char *Sentence)
+{
+	//	any talker ($GPGNS, $GNGNS, $GLGST ...)
+	char	*str=(char*)Gps->rxBuffer;
+	while((str=strstr(str,Sentence))!=NULL)
+	{
+		if((str-(char*)Gps->rxBuffer>=3) && (str[-3]=='$'))
+			return str-3;
+		str++;
+	}
+	return NULL;
+}
+//##################################################################################################################
+static uint32_t	GPS_Time(const char *str)
+{
+	//	hhmmss.sss to milliseconds of day
+	double		t=strtod(str,NULL);
+	uint32_t	hms=(uint32_t)t;
+	return ((hms/10000)*3600+((hms/100)%100)*60+hms%100)*1000+(uint32_t)((t-hms)*1000.0+0.5);
+}
+//##################################################################################################################
+static const char	*GPS_Coordinate(const char *str,double *Value)
+{
+	*Value=convertDegMinToDecDeg(strtod(str,NULL));
+	str=GPS_Next(str);
+	if((*str=='S') || (*str=='W'))
+		*Value=-*Value;
+	return GPS_Next(str);
+}
+//##################################################################################################################
+static void	GPS_ParseGNS(GPS_t *Gps,const char *str)
+{
+	GPGNS_t			*gns=&Gps->GPGNS;
+	const char	*p=GPS_Next(str);
+	memset(gns,0,sizeof(GPGNS_t));
+	gns->UTC_Time=GPS_Time(p);
+	p=GPS_Coordinate(GPS_Next(p),&gns->Latitude);
+	p=GPS_Coordinate(p,&gns->Longitude);
+	for(uint8_t i=0 ; (i<sizeof(gns->Mode)-1) && (p[i]>='A') && (p[i]<='Z') ; i++)
+		gns->Mode[i]=p[i];
+	p=GPS_Next(p);
+	gns->SatellitesUsed=(uint8_t)strtoul(p,NULL,10);
+	p=GPS_Next(p);
+	gns->HDOP=strtof(p,NULL);
+	p=GPS_Next(p);
+	gns->MSL_Altitude=strtof(p,NULL);
+	p=GPS_Next(p);
+	gns->Geoid_Separation=strtof(p,NULL);
+	p=GPS_Next(GPS_Next(GPS_Next(p)));
+	if((*p>='A') && (*p<='Z'))
+		gns->NavStatus=*p;
+}
+//##################################################################################################################
+static void	GPS_ParseGST(GPS_t *Gps,const char *str)
+{
+	GPGST_t			*gst=&Gps->GPGST;
+	const char	*p=GPS_Next(str);
+	float				*f=&gst->RMS;
+	gst->UTC_Time=GPS_Time(p);
+	for(uint8_t i=0 ; i<7 ; i++)
+	{
+		p=GPS_Next(p);
+		f[i]=strtof(p,NULL);
+	}
+}
+#if (_GPS_GSV==1)
+//##################################################################################################################
+static void	GPS_ParseGSV(GPS_t *Gps,const char *str)
+{
+	//	a satellite is taken once its SNR field is there, empty or not
+	GPGSV_t			*gsv=&Gps->GPGSV;
+	const char	*f[20];
+	uint8_t			n=0;
+	for(const char *p=str ; (n<20) && (*p!='*') && (*p!='\r') && (*p!=0) ; p++)
+		if(*p==',')
+			f[n++]=p+1;
+	gsv->Talker=str[2];
+	gsv->Total=(n>0) ? (uint8_t)strtoul(f[0],NULL,10) : 0;
+	gsv->Number=(n>1) ? (uint8_t)strtoul(f[1],NULL,10) : 0;
+	for(gsv->Sats=0 ; (gsv->Sats<4) && (6+4*gsv->Sats<n) ; gsv->Sats++)
+	{
+		GPS_Sat_t	*sat=&gsv->Message[gsv->Sats];
+		const char	**g=&f[3+4*gsv->Sats];
+		sat->Talker=gsv->Talker;
+		sat->Prn=(uint8_t)strtoul(g[0],NULL,10);
+		sat->Elevation=(int8_t)strtol(g[1],NULL,10);
+		sat->Azimuth=(uint16_t)strtoul(g[2],NULL,10);
+		sat->Snr=(uint8_t)strtoul(g[3],NULL,10);
+	}
+}
+#endif
+#endif
+//##################################################################################################################
+static uint8_t	GPS_ModeToFix(const char *Mode)
+{
+	//	best of the per-constellation GNS modes, as a GGA fix quality
+	static const char			rank[]="NSMEADPFR";
+	static const uint8_t	fix[]={0,8,7,6,1,2,3,5,4};
+	uint8_t	best=0;
+	for( ; *Mode!=0 ; Mode++)
+	{
+		const char	*r=strchr(rank,*Mode);
+		if((r!=NULL) && (r-rank>best))
+			best=(uint8_t)(r-rank);
+	}
+	return fix[best];
+}
+//##################################################################################################################
+static void	GPS_Merge(GPS_t *Gps,uint8_t Sentences,uint32_t GgaTime,GPS_Epoch_t *Epoch)
+{
+	GPS_Epoch_t	*e=Epoch;
+	memset(e,0,sizeof(GPS_Epoch_t));
+	if(Sentences & GPS_EPOCH_GNS)
+	{
+		e->UTC_Time=Gps->GPGNS.UTC_Time;
+		e->Latitude=Gps->GPGNS.Latitude;
+		e->Longitude=Gps->GPGNS.Longitude;
+		e->MSL_Altitude=Gps->GPGNS.MSL_Altitude;
+		e->Geoid_Separation=Gps->GPGNS.Geoid_Separation;
+		e->SatellitesUsed=Gps->GPGNS.SatellitesUsed;
+		e->HDOP=Gps->GPGNS.HDOP;
+		memcpy(e->Mode,Gps->GPGNS.Mode,sizeof(e->Mode));
+		e->Fix=GPS_ModeToFix(e->Mode);
+	}
+	if(Sentences & GPS_EPOCH_GGA)
+	{
+		if((Sentences & GPS_EPOCH_GNS)==0)
+		{
+			e->UTC_Time=GgaTime;
+			e->Latitude=(Gps->GPGGA.NS_Indicator=='S') ? -Gps->GPGGA.LatitudeDecimal : Gps->GPGGA.LatitudeDecimal;
+			e->Longitude=(Gps->GPGGA.EW_Indicator=='W') ? -Gps->GPGGA.LongitudeDecimal : Gps->GPGGA.LongitudeDecimal;
+			e->MSL_Altitude=Gps->GPGGA.MSL_Altitude;
+			e->Geoid_Separation=Gps->GPGGA.Geoid_Separation;
+			e->SatellitesUsed=Gps->GPGGA.SatellitesUsed;
+			e->HDOP=Gps->GPGGA.HDOP;
+		}
+		e->Fix=Gps->GPGGA.PositionFixIndicator;
+	}
+	//	a GST left over from another epoch is not merged
+	if((Sentences & GPS_EPOCH_GST) && (Gps->GPGST.UTC_Time==e->UTC_Time))
+	{
+		e->RMS=Gps->GPGST.RMS;
+		e->SigmaMajor=Gps->GPGST.SigmaMajor;
+		e->SigmaMinor=Gps->GPGST.SigmaMinor;
+		e->Orientation=Gps->GPGST.Orientation;
+		e->SigmaLatitude=Gps->GPGST.SigmaLatitude;
+		e->SigmaLongitude=Gps->GPGST.SigmaLongitude;
+		e->SigmaAltitude=Gps->GPGST.SigmaAltitude;
+	}
+	else
+		Sentences&=(uint8_t)~GPS_EPOCH_GST;
+	e->Sentences=Sentences;
+}
+//##################################################################################################################
+static void	GPS_Publish(void)
+{
+	#if (_GPS_STATS==1)
+	if(GPS.Epoch.Fix>0)
+		GPS_Stats_AddPosition(GPS.Epoch.Latitude,GPS.Epoch.Longitude,GPS.Epoch.MSL_Altitude+GPS.Epoch.Geoid_Separation);
+	#endif
+	#if (_GPS_MAVLINK==1) && (_GPS_MAVLINK_AUTO!=0)
+	GPS_Mavlink_Publish(&GPS.Epoch);
+	#endif
+	#if (_GPS_N2K==1)
+	GPS_N2k_SetEpoch(&GPS.Epoch);
+	#endif
+	#if (_GPS_TRIP==1)
+	GPS_Trip_Add(&GPS_Trip,&GPS.Fix);
+	#endif
+	#if (_GPS_JAM==1)
+	GPS_Jam_AddFix(&GPS_Jam,&GPS.Fix,GPS.LastTime);
+	#endif
+	#if (_GPS_QUEUE==1) && (_GPS_QUEUE_HOT==1)
+	GPS_Queue_Push(&GPS.Fix,GPS.Fix.Fix);
+	#elif (_GPS_QUEUE==1)
+	GPS_Queue_Push(&GPS.Epoch,GPS.Epoch.Fix);
+	#endif
+}
+#if (_GPS_GSV==1)
+//##################################################################################################################
+static void	GPS_Gsv_Commit(GPS_t *Gps)
+{
+	//	message 1 drops the talker's previous cycle, a message out of order drops the cycle in progress
+	GPGSV_t	*g=&Gps->GPGSV;
+	if(g->Number==1)
+	{
+		uint8_t	k=0;
+		for(uint8_t i=0 ; i<g->Count ; i++)
+			if(g->Sat[i].Talker!=g->Talker)
+				g->Sat[k++]=g->Sat[i];
+		g->Count=k;
+		g->Start=k;
+		g->Cycle=g->Talker;
+		g->Next=1;
+	}
+	else if((g->Next==0) || (g->Number!=g->Next) || (g->Talker!=g->Cycle))
+	{
+		g->Next=0;
+		return;
+	}
+	for(uint8_t i=0 ; (i<g->Sats) && (g->Count<_GPS_GSV_SATS) ; i++)
+		g->Sat[g->Count++]=g->Message[i];
+	g->Next++;
+	if(g->Number<g->Total)
+		return;
+	g->Next=0;
+	g->Cycles++;
+	#if (_GPS_JAM==1) && (_GPS_STREAM==1)
+	if(Gps==&GPS)
+	{
+		GPS_STREAM_STORE(&GPS_Sky.Seq,GPS_Sky.Seq+1);
+		GPS_STREAM_FENCE();
+		GPS_Sky.Count=(uint8_t)(g->Count-g->Start);
+		GPS_Sky.Time=Gps->Stream.Epoch.UTC_Time;
+		memcpy(GPS_Sky.Sat,&g->Sat[g->Start],GPS_Sky.Count*sizeof(GPS_Sat_t));
+		GPS_STREAM_STORE(&GPS_Sky.Seq,GPS_Sky.Seq+1);
+		GPS_STREAM_STORE(&GPS_Sky.Ready,1);
+	}
+	#elif (_GPS_JAM==1)
+	if(Gps==&GPS)
+		GPS_Jam_AddSky(&GPS_Jam,&g->Sat[g->Start],(uint8_t)(g->Count-g->Start),Gps->Epoch.UTC_Time);
+	#endif
+}
+#endif
+//##################################################################################################################
+static void	GPS_Defaults(GPGGA_t *Gga)
+{
+	if(Gga->NS_Indicator==0)
+		Gga->NS_Indicator='-';
+	if(Gga->EW_Indicator==0)
+		Gga->EW_Indicator='-';
+	if(Gga->Geoid_Units==0)
+		Gga->Geoid_Units='-';
+	if(Gga->MSL_Units==0)
+		Gga->MSL_Units='-';
+}
+#if (_GPS_WCET==1) && (_GPS_STREAM==0)
+#error "_GPS_WCET needs the _GPS_STREAM decoder"
+#endif
+#if (_GPS_STREAM==1)
+//##################################################################################################################
+#define	GPS_STREAM_ID(a,b,c)				(((uint32_t)(a)<<16) | ((uint32_t)(b)<<8) | (c))
+#define	GPS_STREAM_POINT						0x80
+#define	GPS_STREAM_GSV							0x80
+
+static const double		GPS_StreamScale[10]={1e0,1e-1,1e-2,1e-3,1e-4,1e-5,1e-6,1e-7,1e-8,1e-9};
+static const uint32_t	GPS_StreamPow10[10]={1,10,100,1000,10000,100000,1000000,10000000,100000000,1000000000};
+//##################################################################################################################
+static double	GPS_Stream_Value(const GPS_Stream_t *s)
+{
+	double	v=s->Int+s->Frac*GPS_StreamScale[s->Digits & 0x0F];
+	return (s->Neg!=0) ? -v : v;
+}
+//##################################################################################################################
+static double	GPS_Stream_Degrees(const GPS_Stream_t *s)
+{
+	//	dddmm.mmmm, the integer part already holds degrees*100+minutes
+	return s->Int/100+((s->Int%100)+s->Frac*GPS_StreamScale[s->Digits & 0x0F])/60.0;
+}
+//##################################################################################################################
+static uint32_t	GPS_Stream_Time(const GPS_Stream_t *s)
+{
+	//	hhmmss.sss to milliseconds of day, the fraction rounded to 3 digits
+	uint32_t	p=GPS_StreamPow10[s->Digits & 0x0F];
+	uint32_t	ms=(uint32_t)(((uint64_t)s->Frac*1000+p/2)/p);
+	return ((s->Int/10000)*3600+((s->Int/100)%100)*60+s->Int%100)*1000+ms;
+}
+//##################################################################################################################
+static void	GPS_Stream_Field(GPS_t *Gps)
+{
+	GPS_Stream_t	*s=&Gps->Stream;
+	if(s->Field==0)
+	{
+		//	any talker, the last three letters of the address pick the sentence
+		switch(s->Int & 0xFFFFFF)
+		{
+			case GPS_STREAM_ID('G','G','A'):
+				s->Sentence=GPS_EPOCH_GGA;
+				memset(&s->Scratch,0,sizeof(s->Scratch));
+			break;
+			case GPS_STREAM_ID('G','N','S'):
+				s->Sentence=GPS_EPOCH_GNS;
+				memset(&s->Scratch,0,sizeof(s->Scratch));
+			break;
+			case GPS_STREAM_ID('G','S','T'):
+				s->Sentence=GPS_EPOCH_GST;
+				memset(&s->Scratch,0,sizeof(s->Scratch));
+			break;
+			#if (_GPS_GSV==1)
+			case GPS_STREAM_ID('G','S','V'):
+				//	the talker letter is still in the top byte
+				s->Sentence=GPS_STREAM_GSV;
+				Gps->GPGSV.Talker=(char)(s->Int>>24);
+				Gps->GPGSV.Sats=0;
+			break;
+			#endif
+			default:
+				s->State=0;
+			break;
+		}
+		return;
+	}
+	#if (_GPS_GSV==1)
+	if(s->Sentence==GPS_STREAM_GSV)
+	{
+		GPGSV_t		*gsv=&Gps->GPGSV;
+		GPS_Sat_t	*sat=&gsv->Message[(s->Field-4)/4 & 3];
+		if(s->Field==1)
+			gsv->Total=(uint8_t)s->Int;
+		else if(s->Field==2)
+			gsv->Number=(uint8_t)s->Int;
+		else if((s->Field>=4) && (s->Field<20))
+		{
+			switch((s->Field-4) & 3)
+			{
+				case 0:		sat->Talker=gsv->Talker;	sat->Prn=(uint8_t)s->Int;								break;
+				case 1:		sat->Elevation=(int8_t)((s->Neg!=0) ? -(int32_t)s->Int : (int32_t)s->Int);	break;
+				case 2:		sat->Azimuth=(uint16_t)s->Int;																		break;
+				default:	sat->Snr=(uint8_t)s->Int;				gsv->Sats=(uint8_t)((s->Field-4)/4+1);	break;
+			}
+		}
+		return;
+	}
+	#endif
+	if(s->Field==1)
+	{
+		s->Tag=GPS_Stream_Time(s);
+		switch(s->Sentence)
+		{
+			case GPS_EPOCH_GGA:
+				s->Scratch.GPGGA.UTC_Hour=(uint8_t)(s->Int/10000);
+				s->Scratch.GPGGA.UTC_Min=(uint8_t)((s->Int/100)%100);
+				s->Scratch.GPGGA.UTC_Sec=(uint8_t)(s->Int%100);
+				s->Scratch.GPGGA.UTC_MicroSec=(uint16_t)(s->Tag%1000);
+			break;
+			case GPS_EPOCH_GNS:
+				s->Scratch.GPGNS.UTC_Time=s->Tag;
+			break;
+			default:
+				s->Scratch.GPGST.UTC_Time=s->Tag;
+			break;
+		}
+		return;
+	}
+	if(s->Sentence==GPS_EPOCH_GGA)
+	{
+		GPGGA_t	*gga=&s->Scratch.GPGGA;
+		switch(s->Field)
+		{
+			case 2:		gga->Latitude=GPS_Stream_Value(s);		gga->LatitudeDecimal=GPS_Stream_Degrees(s);		break;
+			case 3:		gga->NS_Indicator=s->Letter;																									break;
+			case 4:		gga->Longitude=GPS_Stream_Value(s);		gga->LongitudeDecimal=GPS_Stream_Degrees(s);	break;
+			case 5:		gga->EW_Indicator=s->Letter;																									break;
+			case 6:		gga->PositionFixIndicator=(uint8_t)s->Int;																		break;
+			case 7:		gga->SatellitesUsed=(uint8_t)s->Int;																					break;
+			case 8:		gga->HDOP=(float)GPS_Stream_Value(s);																					break;
+			case 9:		gga->MSL_Altitude=(float)GPS_Stream_Value(s);																	break;
+			case 10:	gga->MSL_Units=s->Letter;																											break;
+			case 11:	gga->Geoid_Separation=(float)GPS_Stream_Value(s);															break;
+			case 12:	gga->Geoid_Units=s->Letter;																										break;
+			case 13:	gga->AgeofDiffCorr=(uint16_t)s->Int;																					break;
+		}
+	}
+	else if(s->Sentence==GPS_EPOCH_GNS)
+	{
+		GPGNS_t	*gns=&s->Scratch.GPGNS;
+		switch(s->Field)
+		{
+			case 2:		gns->Latitude=GPS_Stream_Degrees(s);															break;
+			case 3:		gns->Latitude=(s->Letter=='S') ? -gns->Latitude : gns->Latitude;	break;
+			case 4:		gns->Longitude=GPS_Stream_Degrees(s);															break;
+			case 5:		gns->Longitude=(s->Letter=='W') ? -gns->Longitude : gns->Longitude;	break;
+			case 7:		gns->SatellitesUsed=(uint8_t)s->Int;															break;
+			case 8:		gns->HDOP=(float)GPS_Stream_Value(s);															break;
+			case 9:		gns->MSL_Altitude=(float)GPS_Stream_Value(s);											break;
+			case 10:	gns->Geoid_Separation=(float)GPS_Stream_Value(s);									break;
+			case 13:	gns->NavStatus=s->Letter;															break;
+		}
+	}
+	else if(s->Field<=8)
+		(&s->Scratch.GPGST.RMS)[s->Field-2]=(float)GPS_Stream_Value(s);
+}
+//##################################################################################################################
+static void	GPS_Stream_Publish(GPS_t *Gps)
+{
+	//	receive context: claims the epoch and copies it to Out, the consumers run from GPS_ProcessEx()
+	GPS_Stream_t	*s=&Gps->Stream;
+	uint32_t	gen=GPS_STREAM_LOAD(&s->Gen);
+	if((gen & 1) || !GPS_STREAM_CLAIM(&s->Gen,&gen))
+		return;
+	GPS_STREAM_STORE(&s->OutSeq,s->OutSeq+1);
+	GPS_STREAM_FENCE();
+	s->Out.Epoch=s->Epoch;
+	#if (_GPS_FIX==1)
+	GPS_Fix_Split(Gps,&s->Epoch,&s->Out.Fix,&s->Out.FixCold);
+	#endif
+	GPS_STREAM_STORE(&s->OutSeq,s->OutSeq+1);
+	GPS_STREAM_STORE(&s->Ready,1);
+}
+//##################################################################################################################
+static void	GPS_Stream_Commit(GPS_t *Gps)
+{
+	//	a new time tag, or the same sentence again, starts the next epoch. An epoch is published as soon as it has
+	//	every sentence the previous one had, else when the next one starts or GPS_ProcessEx() sees the burst end.
+	GPS_Stream_t	*s=&Gps->Stream;
+	#if (_GPS_GSV==1)
+	if(s->Sentence==GPS_STREAM_GSV)
+	{
+		GPS_Gsv_Commit(Gps);
+		return;
+	}
+	#endif
+	if((s->Tag!=s->Time) || (s->Sentences & s->Sentence))
+	{
+		if(s->Sentences & (GPS_EPOCH_GGA | GPS_EPOCH_GNS))
+			GPS_Stream_Publish(Gps);
+		if(s->Sentences!=0)
+		{
+			//	one epoch short of a sentence still waits for it, the second in a row stops waiting
+			uint8_t	full=((s->Sentences & s->Expect)==s->Expect);
+			s->Expect=(full || (s->Short==0)) ? (uint8_t)(s->Expect | s->Sentences) : s->Sentences;
+			s->Short=!full;
+		}
+		s->Time=s->Tag;
+		s->Sentences=0;
+		GPS_STREAM_STORE(&s->Gen,(s->Gen | 1)+1);
+	}
+	GPS_STREAM_STORE(&s->WorkSeq,s->WorkSeq+1);
+	GPS_STREAM_FENCE();
+	s->Sentences|=s->Sentence;
+	switch(s->Sentence)
+	{
+		case GPS_EPOCH_GGA:
+			Gps->GPGGA=s->Scratch.GPGGA;
+			GPS_Defaults(&Gps->GPGGA);
+		break;
+		case GPS_EPOCH_GNS:
+			Gps->GPGNS=s->Scratch.GPGNS;
+		break;
+		default:
+			Gps->GPGST=s->Scratch.GPGST;
+		break;
+	}
+	if(s->Sentences & (GPS_EPOCH_GGA | GPS_EPOCH_GNS))
+		GPS_Merge(Gps,s->Sentences,s->Time,&s->Epoch);
+	GPS_STREAM_STORE(&s->WorkSeq,s->WorkSeq+1);
+	if((s->Sentences & (GPS_EPOCH_GGA | GPS_EPOCH_GNS))==0)
+		return;
+	if((Gps->TTFF==0) && (s->Epoch.Fix>0))
+		Gps->TTFF=(Gps->LastTime-Gps->InitTime)|1;
+	if((s->Sentences & s->Expect)==s->Expect)
+		GPS_Stream_Publish(Gps);
+}
+//##################################################################################################################
+static void	GPS_Stream_RxByte(GPS_t *Gps,uint8_t Data)
+{
+	GPS_Stream_t	*s=&Gps->Stream;
+	uint8_t				hex;
+	if(Data=='$')
+	{
+		s->State=1;
+		s->Field=0;
+		s->Length=0;
+		s->Sum=0;
+		s->Int=0;
+		s->Frac=0;
+		s->Digits=0;
+		s->Neg=0;
+		s->Chars=0;
+		s->Letter=0;
+		return;
+	}
+	switch(s->State)
+	{
+		case 1:
+			#if (_GPS_WCET==1)
+			//	longer than NMEA allows is dropped, so no sentence costs more than its length bound
+			if((++s->Length>_GPS_WCET_SENTENCE) || (s->Chars>_GPS_WCET_FIELD))
+			{
+				s->State=0;
+				return;
+			}
+			#endif
+			if((Data==',') || (Data=='*'))
+			{
+				GPS_Stream_Field(Gps);
+				if(s->State==0)
+					return;
+				s->Field++;
+				s->Int=0;
+				s->Frac=0;
+				s->Digits=0;
+				s->Neg=0;
+				s->Chars=0;
+				s->Letter=0;
+				if(Data=='*')
+					s->State=2;
+				else
+					s->Sum^=Data;
+				return;
+			}
+			s->Sum^=Data;
+			if((s->Field==14) && (s->Sentence==GPS_EPOCH_GGA) && (s->Chars<sizeof(s->Scratch.GPGGA.DiffRefStationID)))
+				s->Scratch.GPGGA.DiffRefStationID[s->Chars]=(char)Data;
+			s->Chars++;
+			if((Data>='0') && (Data<='9'))
+			{
+				if((s->Digits & GPS_STREAM_POINT)==0)
+					s->Int=s->Int*10+(Data-'0');
+				else if((s->Digits & 0x0F)<9)
+				{
+					s->Frac=s->Frac*10+(Data-'0');
+					s->Digits++;
+				}
+			}
+			else if(Data=='.')
+				s->Digits|=GPS_STREAM_POINT;
+			else if(Data=='-')
+				s->Neg=1;
+			else if(Data<' ')
+				s->State=0;
+			else
+			{
+				s->Letter=(char)Data;
+				if(s->Field==0)
+					s->Int=(s->Int<<8) | Data;
+				else if((s->Field==6) && (s->Sentence==GPS_EPOCH_GNS) && (s->Chars<sizeof(s->Scratch.GPGNS.Mode)))
+					s->Scratch.GPGNS.Mode[s->Chars-1]=(char)Data;
+			}
+		return;
+		case 2:
+		case 3:
+			if((Data>='0') && (Data<='9'))
+				hex=(uint8_t)(Data-'0');
+			else if((Data>='A') && (Data<='F'))
+				hex=(uint8_t)(Data-'A'+10);
+			else
+			{
+				s->State=0;
+				return;
+			}
+			if(s->Sentence==GPS_EPOCH_GGA)
+				s->Scratch.GPGGA.CheckSum[s->State-2]=(char)Data;
+			if(s->State==2)
+			{
+				s->Check=(uint8_t)(hex<<4);
+				s->State=3;
+				return;
+			}
+			s->State=0;
+			if((s->Check | hex)==s->Sum)
+				GPS_Stream_Commit(Gps);
+		return;
+	}
+}
+#endif
+//##################################################################################################################
+void	GPS_InitEx(GPS_t *Gps)
+{
+	#if (_GPS_STREAM==1)
+	memset(&Gps->Stream,0,sizeof(GPS_Stream_t));
+	#else
+	Gps->rxIndex=0;
+	#endif
+	Gps->InitTime=HAL_GetTick();
+	Gps->TTFF=0;
+}
 //##################################################################################################################
 void	GPS_Init(void)
 {
-	GPS.rxIndex=0;
+	#if (_GPS_POOL==1)
+	GPS_Pool_Init();
+	#endif
+	GPS_InitEx(&GPS);
 	HAL_UART_Receive_IT(&_GPS_USART,&GPS.rxTmp,1);	
 }
 //##################################################################################################################
 void	GPS_CallBack(void)
 {
 	GPS.LastTime=HAL_GetTick();
+	#if (_GPS_STREAM==1)
+	GPS_Stream_RxByte(&GPS,GPS.rxTmp);
+	#else
 	if(GPS.rxIndex < sizeof(GPS.rxBuffer)-2)
 	{
 		GPS.rxBuffer[GPS.rxIndex] = GPS.rxTmp;
 		GPS.rxIndex++;
 	}	
+	#endif
+	#if (_GPS_ASSIST==1)
+	GPS_Assist_RxByte(GPS.rxTmp);
+	#endif
+	#if (_GPS_UBX==1)
+	GPS_Ubx_RxByte(GPS.rxTmp);
+	#endif
 	HAL_UART_Receive_IT(&_GPS_USART,&GPS.rxTmp,1);
 }
 //##################################################################################################################
-void	GPS_Process(void)
+void	GPS_RxChunk(GPS_t *Gps,const uint8_t *Data,uint16_t Len)
+{
+	//	block counterpart of GPS_CallBack for DMA fed instances, the overflow is dropped the same way
+	Gps->LastTime=HAL_GetTick();
+	#if (_GPS_STREAM==1)
+	for(uint16_t i=0 ; i<Len ; i++)
+		GPS_Stream_RxByte(Gps,Data[i]);
+	#else
+	uint16_t	room=(uint16_t)(sizeof(Gps->rxBuffer)-2-Gps->rxIndex);
+	if(Len>room)
+		Len=room;
+	memcpy(&Gps->rxBuffer[Gps->rxIndex],Data,Len);
+	Gps->rxIndex+=Len;
+	#endif
+}
+//##################################################################################################################
+uint8_t	GPS_ProcessEx(GPS_t *Gps)
 {
-	if( (HAL_GetTick()-GPS.LastTime>50) && (GPS.rxIndex>0))
+	//	returns 1 when a burst was parsed. Only the GPS instance feeds GPS_Publish().
+	#if (_GPS_STREAM==1)
+	//	already decoded byte by byte in the receive context. This takes the epoch it completed, or one left
+	//	incomplete at the end of the burst, into Gps->Epoch/Fix/FixCold and runs the consumers here. An epoch not
+	//	taken before the next one completes is superseded by it.
+	GPS_Stream_t	*s=&Gps->Stream;
+	uint8_t		ready=__atomic_exchange_n(&s->Ready,0,__ATOMIC_ACQ_REL);
+	uint32_t	seq,gen;
+	if(ready)
+	{
+		do
+		{
+			while((seq=GPS_STREAM_LOAD(&s->OutSeq)) & 1);
+			Gps->Epoch=s->Out.Epoch;
+			#if (_GPS_FIX==1)
+			Gps->Fix=s->Out.Fix;
+			Gps->FixCold=s->Out.FixCold;
+			#endif
+			GPS_STREAM_FENCE();
+		}while(GPS_STREAM_LOAD(&s->OutSeq)!=seq);
+	}
+	else if((HAL_GetTick()-Gps->LastTime>50) && (((gen=GPS_STREAM_LOAD(&s->Gen)) & 1)==0) && (((seq=GPS_STREAM_LOAD(&s->WorkSeq)) & 1)==0) && (s->Sentences & (GPS_EPOCH_GGA | GPS_EPOCH_GNS)))
+	{
+		//	the receive side is quiet, so the epoch is read in place. Claiming it fails if it was published or
+		//	superseded meanwhile, a sentence merged during the copy makes the next call try again.
+		GPS_Epoch_t		epoch=s->Epoch;
+		#if (_GPS_FIX==1)
+		GPS_Fix_t			fix;
+		GPS_FixCold_t	cold;
+		GPS_Fix_Split(Gps,&epoch,&fix,&cold);
+		#endif
+		GPS_STREAM_FENCE();
+		if((GPS_STREAM_LOAD(&s->WorkSeq)==seq) && GPS_STREAM_CLAIM(&s->Gen,&gen))
+		{
+			Gps->Epoch=epoch;
+			#if (_GPS_FIX==1)
+			Gps->Fix=fix;
+			Gps->FixCold=cold;
+			#endif
+			ready=1;
+		}
+	}
+	#if (_GPS_JAM==1) && (_GPS_GSV==1)
+	if((Gps==&GPS) && __atomic_exchange_n(&GPS_Sky.Ready,0,__ATOMIC_ACQ_REL))
 	{
-		char	*str;
+		GPS_Sat_t	sat[_GPS_GSV_SATS];
+		uint8_t		count;
+		uint32_t	time;
+		do
+		{
+			while((seq=GPS_STREAM_LOAD(&GPS_Sky.Seq)) & 1);
+			count=GPS_Sky.Count;
+			time=GPS_Sky.Time;
+			memcpy(sat,GPS_Sky.Sat,count*sizeof(GPS_Sat_t));
+			GPS_STREAM_FENCE();
+		}while(GPS_STREAM_LOAD(&GPS_Sky.Seq)!=seq);
+		GPS_Jam_AddSky(&GPS_Jam,sat,count,time);
+	}
+	#endif
+	if((ready) && (Gps==&GPS))
+		GPS_Publish();
+	return ready;
+	#else
+	if( (HAL_GetTick()-Gps->LastTime>50) && (Gps->rxIndex>0))
+	{
+		char			*str;
+		uint8_t		sentences=0;
+		uint32_t	ggaTime=0;
 		#if (_GPS_DEBUG==1)
-		printf("%s",GPS.rxBuffer);
+		printf("%s",Gps->rxBuffer);
 		#endif
-		str=strstr((char*)GPS.rxBuffer,"$GPGGA,");
+		str=strstr((char*)Gps->rxBuffer,"$GPGGA,");
+		if(str!=NULL)
+		{
+			memset(&Gps->GPGGA,0,sizeof(Gps->GPGGA));
+			sscanf(str,"$GPGGA,%2hhd%2hhd%2hhd.%3hd,%lf,%c,%lf,%c,%hhd,%hhd,%f,%f,%c,%hd,%3s,*%2c\r\n",&Gps->GPGGA.UTC_Hour,&Gps->GPGGA.UTC_Min,&Gps->GPGGA.UTC_Sec,&Gps->GPGGA.UTC_MicroSec,&Gps->GPGGA.Latitude,&Gps->GPGGA.NS_Indicator,&Gps->GPGGA.Longitude,&Gps->GPGGA.EW_Indicator,&Gps->GPGGA.PositionFixIndicator,&Gps->GPGGA.SatellitesUsed,&Gps->GPGGA.HDOP,&Gps->GPGGA.MSL_Altitude,&Gps->GPGGA.MSL_Units,&Gps->GPGGA.AgeofDiffCorr,Gps->GPGGA.DiffRefStationID,Gps->GPGGA.CheckSum);
+			GPS_Defaults(&Gps->GPGGA);
+			Gps->GPGGA.LatitudeDecimal=convertDegMinToDecDeg(Gps->GPGGA.Latitude);
+			Gps->GPGGA.LongitudeDecimal=convertDegMinToDecDeg(Gps->GPGGA.Longitude);			
+			ggaTime=GPS_Time(GPS_Next(str));
+			sentences|=GPS_EPOCH_GGA;
+		}
+		str=GPS_Find(Gps,"GNS,");
 		if(str!=NULL)
 		{
-			memset(&GPS.GPGGA,0,sizeof(GPS.GPGGA));
-			sscanf(str,"$GPGGA,%2hhd%2hhd%2hhd.%3hd,%f,%c,%f,%c,%hhd,%hhd,%f,%f,%c,%hd,%s,*%2s\r\n",&GPS.GPGGA.UTC_Hour,&GPS.GPGGA.UTC_Min,&GPS.GPGGA.UTC_Sec,&GPS.GPGGA.UTC_MicroSec,&GPS.GPGGA.Latitude,&GPS.GPGGA.NS_Indicator,&GPS.GPGGA.Longitude,&GPS.GPGGA.EW_Indicator,&GPS.GPGGA.PositionFixIndicator,&GPS.GPGGA.SatellitesUsed,&GPS.GPGGA.HDOP,&GPS.GPGGA.MSL_Altitude,&GPS.GPGGA.MSL_Units,&GPS.GPGGA.AgeofDiffCorr,GPS.GPGGA.DiffRefStationID,GPS.GPGGA.CheckSum);
-			if(GPS.GPGGA.NS_Indicator==0)
-				GPS.GPGGA.NS_Indicator='-';
-			if(GPS.GPGGA.EW_Indicator==0)
-				GPS.GPGGA.EW_Indicator='-';
-			if(GPS.GPGGA.Geoid_Units==0)
-				GPS.GPGGA.Geoid_Units='-';
-			if(GPS.GPGGA.MSL_Units==0)
-				GPS.GPGGA.MSL_Units='-';
-			GPS.GPGGA.LatitudeDecimal=convertDegMinToDecDeg(GPS.GPGGA.Latitude);
-			GPS.GPGGA.LongitudeDecimal=convertDegMinToDecDeg(GPS.GPGGA.Longitude);			
+			GPS_ParseGNS(Gps,str);
+			sentences|=GPS_EPOCH_GNS;
+		}
+		str=GPS_Find(Gps,"GST,");
+		if(str!=NULL)
+		{
+			GPS_ParseGST(Gps,str);
+			sentences|=GPS_EPOCH_GST;
+		}
+		if(sentences & (GPS_EPOCH_GGA | GPS_EPOCH_GNS))
+		{
+			GPS_Merge(Gps,sentences,ggaTime,&Gps->Epoch);
+			#if (_GPS_FIX==1)
+			GPS_Fix_Update(Gps);
+			#endif
+			if((Gps->TTFF==0) && (Gps->Epoch.Fix>0))
+				Gps->TTFF=(Gps->LastTime-Gps->InitTime)|1;
+			if(Gps==&GPS)
+				GPS_Publish();
 		}		
-		memset(GPS.rxBuffer,0,sizeof(GPS.rxBuffer));
-		GPS.rxIndex=0;
+		#if (_GPS_GSV==1)
+		for(str=(char*)Gps->rxBuffer ; (str=strstr(str,"GSV,"))!=NULL ; str++)
+			if((str-(char*)Gps->rxBuffer>=3) && (str[-3]=='$'))
+			{
+				GPS_ParseGSV(Gps,str-3);
+				GPS_Gsv_Commit(Gps);
+			}
+		#endif
+		memset(Gps->rxBuffer,0,sizeof(Gps->rxBuffer));
+		Gps->rxIndex=0;
+		return 1;
 	}
+	return 0;
+	#endif
+
+}
+//##################################################################################################################
+void	GPS_Process(void)
+{
+	GPS_ProcessEx(&GPS);
+	#if (_GPS_N2K==1)
+	GPS_N2k_Poll(HAL_GetTick());
+	#endif
 	HAL_UART_Receive_IT(&_GPS_USART,&GPS.rxTmp,1);
 }
 //##################################################################################################################
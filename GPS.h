@@ -2,6 +2,7 @@
 #define _GPS_H_
 
 #include <stdint.h>
+#include "GPSConfig.h"
 
 //##################################################################################################################
 
@@ -12,10 +13,10 @@ typedef struct
 	uint8_t			UTC_Sec;
 	uint16_t		UTC_MicroSec;
 	
-	float				Latitude;
+	double			Latitude;
 	double			LatitudeDecimal;
 	char				NS_Indicator;
-	float				Longitude;
+	double			Longitude;
 	double			LongitudeDecimal;
 	char				EW_Indicator;
 	
@@ -33,14 +34,196 @@ typedef struct
 	
 }GPGGA_t;
 
+typedef struct
+{
+	uint32_t		UTC_Time;
+	double			Latitude;
+	double			Longitude;
+	char				Mode[7];								//	GPS, GLONASS, Galileo, BeiDou, QZSS, NavIC
+	uint8_t			SatellitesUsed;
+	float				HDOP;
+	float				MSL_Altitude;
+	float				Geoid_Separation;
+	char				NavStatus;
+
+}GPGNS_t;
+
+typedef struct
+{
+	uint32_t		UTC_Time;
+	float				RMS;
+	float				SigmaMajor;
+	float				SigmaMinor;
+	float				Orientation;
+	float				SigmaLatitude;
+	float				SigmaLongitude;
+	float				SigmaAltitude;
+
+}GPGST_t;
+
+typedef struct
+{
+	char				Talker;									//	second letter of the address, P for $GPGSV
+	uint8_t			Prn;
+	int8_t			Elevation;
+	uint8_t			Snr;										//	dB-Hz, 0 when not tracked
+	uint16_t		Azimuth;
+
+}GPS_Sat_t;
+
+//	satellites in view (_GPS_GSV). A talker's cycle replaces its own entries, so they always sit last in Sat.
+typedef struct
+{
+	GPS_Sat_t		Sat[_GPS_GSV_SATS];
+	uint8_t			Count;
+	uint8_t			Start;									//	first entry of the cycle in progress
+	char				Cycle;									//	talker of the cycle in progress
+	char				Talker;
+	uint8_t			Total;
+	uint8_t			Number;
+	uint8_t			Next;										//	message expected next, 0 until a message 1
+	uint8_t			Sats;
+	GPS_Sat_t		Message[4];							//	satellites of the sentence being decoded
+	uint32_t		Cycles;
+
+}GPGSV_t;
+
+#define	GPS_EPOCH_GGA						0x01
+#define	GPS_EPOCH_GNS						0x02
+#define	GPS_EPOCH_GST						0x04
+
+//	one solution per burst: position and fix from GGA/GNS, per-constellation mode from GNS, 1-sigma errors in
+//	meters from GST when its time tag matches. Sentences tells which of them were merged.
+typedef struct
+{
+	uint8_t			Sentences;
+	uint32_t		UTC_Time;
+	double			Latitude;
+	double			Longitude;
+	float				MSL_Altitude;
+	float				Geoid_Separation;
+	uint8_t			Fix;
+	char				Mode[7];
+	uint8_t			SatellitesUsed;
+	float				HDOP;
+	float				RMS;
+	float				SigmaMajor;
+	float				SigmaMinor;
+	float				Orientation;
+	float				SigmaLatitude;
+	float				SigmaLongitude;
+	float				SigmaAltitude;
+
+}GPS_Epoch_t;
+
+//	hot fix record (_GPS_FIX), 32 bytes on a 32-byte boundary so two share a cache line. Fixed point: 1e-7 degree,
+//	mm above MSL, cm geoid separation and 1-sigma errors, HDOP in 0.01. Diagnostics go to GPS_FixCold_t.
+typedef struct __attribute__((aligned(32)))
+{
+	int32_t			Latitude;
+	int32_t			Longitude;
+	int32_t			Altitude;
+	uint32_t		UTC_Time;
+	int16_t			Geoid;
+	uint16_t		HDOP;
+	uint16_t		SigmaHorizontal;
+	uint16_t		SigmaVertical;
+	uint8_t			Fix;
+	uint8_t			SatellitesUsed;
+	uint8_t			Sentences;
+	uint8_t			Reserved[5];
+
+}GPS_Fix_t;
+
+typedef struct
+{
+	char				Mode[7];
+	char				NavStatus;
+	char				MSL_Units;
+	char				Geoid_Units;
+	char				DiffRefStationID[4];
+	char				CheckSum[2];
+	uint16_t		AgeofDiffCorr;
+	float				RMS;
+	float				SigmaMajor;
+	float				SigmaMinor;
+	float				Orientation;
+	float				SigmaLatitude;
+	float				SigmaLongitude;
+
+}GPS_FixCold_t;
+
+//	bufferless decoder (_GPS_STREAM): each byte advances the field state machine and numbers are accumulated as
+//	integers into Scratch. A sentence is copied to GPGGA/GPGNS/GPGST only once its checksum matched and merged
+//	into Epoch. A complete epoch is copied to Out in the receive context, GPS_ProcessEx() hands Out on to
+//	GPS_t.Epoch/Fix/FixCold, so those only change in the context that calls it.
+typedef struct
+{
+	uint8_t			State;
+	uint8_t			Sentence;
+	uint8_t			Field;
+	uint8_t			Chars;
+	uint8_t			Sum;
+	uint8_t			Check;
+	uint8_t			Digits;
+	uint8_t			Neg;
+	char				Letter;
+	uint8_t			Sentences;
+	uint8_t			Expect;
+	uint8_t			Short;
+	uint8_t			Length;
+	volatile uint8_t	Ready;
+	//	epoch number times two, plus one once it was published
+	volatile uint32_t	Gen;
+	//	odd while the receive side writes GPGGA/GPGNS/GPGST and Epoch, resp. Out
+	volatile uint32_t	WorkSeq;
+	volatile uint32_t	OutSeq;
+	uint32_t		Int;
+	uint32_t		Frac;
+	uint32_t		Tag;
+	uint32_t		Time;
+	union
+	{
+		GPGGA_t		GPGGA;
+		GPGNS_t		GPGNS;
+		GPGST_t		GPGST;
+	}Scratch;
+	GPS_Epoch_t	Epoch;
+	struct
+	{
+		GPS_Epoch_t		Epoch;
+		#if (_GPS_FIX==1)
+		GPS_Fix_t			Fix;
+		GPS_FixCold_t	FixCold;
+		#endif
+	}Out;
+
+}GPS_Stream_t;
+
 typedef struct 
 {
+	#if (_GPS_STREAM==1)
+	GPS_Stream_t	Stream;
+	#else
 	uint8_t		rxBuffer[512];
 	uint16_t	rxIndex;
+	#endif
 	uint8_t		rxTmp;	
 	uint32_t	LastTime;	
+	uint32_t	InitTime;
+	uint32_t	TTFF;
 	
 	GPGGA_t		GPGGA;
+	GPGNS_t		GPGNS;
+	GPGST_t		GPGST;
+	GPS_Epoch_t	Epoch;
+	#if (_GPS_GSV==1)
+	GPGSV_t		GPGSV;
+	#endif
+	#if (_GPS_FIX==1)
+	GPS_Fix_t			Fix;
+	GPS_FixCold_t	FixCold;
+	#endif
 	
 }GPS_t;
 
@@ -49,6 +232,11 @@ extern GPS_t GPS;
 void	GPS_Init(void);
 void	GPS_CallBack(void);
 void	GPS_Process(void);
+
+//	per-instance handles for extra receivers fed by DMA, see GPSMulti.h
+void		GPS_InitEx(GPS_t *Gps);
+void		GPS_RxChunk(GPS_t *Gps,const uint8_t *Data,uint16_t Len);
+uint8_t	GPS_ProcessEx(GPS_t *Gps);
 //##################################################################################################################
 
 #endif
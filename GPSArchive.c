@@ -0,0 +1,815 @@
+#if !defined(_GNU_SOURCE)
+#define	_GNU_SOURCE
+#endif
+#include "GPSConfig.h"
+
+#if (_GPS_ARCHIVE==1)
+
+#if (_GPS_HOST==0)
+#error "GPSArchive needs _GPS_HOST"
+#endif
+#if (_GPS_STREAM==0) || (_GPS_FIX==0)
+#error "GPSArchive decodes with _GPS_STREAM into the _GPS_FIX record"
+#endif
+
+#include "GPSArchive.h"
+#include "GPS.h"
+#include "GPSHost.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <sched.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#define	GPS_ARCHIVE_QUEUE							256
+#define	GPS_ARCHIVE_WORKERS						64
+//	a chunk is stretched to the end of its last epoch, by at most a quarter
+#define	GPS_ARCHIVE_STRETCH						(_GPS_ARCHIVE_CHUNK/4)
+//	rows a chunk starts with, about one fix per 64 bytes of NMEA. Denser captures grow the chunk once.
+#define	GPS_ARCHIVE_ROWS							(_GPS_ARCHIVE_CHUNK/64)
+#define	GPS_ARCHIVE_NONE							UINT64_MAX
+
+#define	GPS_ARCHIVE_LOAD(p)						__atomic_load_n(p,__ATOMIC_ACQUIRE)
+#define	GPS_ARCHIVE_STORE(p,v)				__atomic_store_n(p,v,__ATOMIC_RELEASE)
+#define	GPS_ARCHIVE_ADD(p,v)					__atomic_fetch_add(p,v,__ATOMIC_RELAXED)
+
+typedef char	GPS_ArchiveBlockSize[(sizeof(GPS_ArchiveBlock_t)==104) ? 1 : -1];
+typedef char	GPS_ArchiveFooterSize[(sizeof(GPS_ArchiveFooter_t)==32) ? 1 : -1];
+
+typedef struct
+{
+	uint64_t		Seq;
+	const uint8_t	*Data;
+	uint32_t		Len;
+	uint32_t		Rows;
+	uint32_t		Blocks;
+	uint32_t		Size;
+	uint32_t		Errors;
+	uint32_t		Room;
+	int32_t			*Column[GPS_ARCHIVE_COLUMNS];
+	uint32_t		*Block;
+	uint8_t			*Out;
+
+}GPS_ArchiveChunk_t;
+
+typedef struct
+{
+	uint32_t						Seq;
+	GPS_ArchiveChunk_t	*Chunk;
+
+}GPS_ArchiveCell_t;
+
+//	bounded multi-producer multi-consumer ring, a sequence number per cell (Vyukov)
+typedef struct
+{
+	GPS_ArchiveCell_t	Cell[GPS_ARCHIVE_QUEUE];
+	uint32_t					Head __attribute__((aligned(64)));
+	uint32_t					Tail __attribute__((aligned(64)));
+
+}GPS_ArchiveQueue_t;
+
+typedef struct
+{
+	GPS_ArchiveQueue_t	Free;
+	GPS_ArchiveQueue_t	Decode;
+	GPS_ArchiveQueue_t	Compress;
+	GPS_ArchiveQueue_t	Index;
+	GPS_ArchiveChunk_t	*Chunk;
+	uint32_t						Chunks;
+	uint64_t						Total;
+	uint8_t							Stop;
+	GPS_ArchiveWrite_t	Write;
+	void								*Context;
+	GPS_ArchiveStats_t	*Stats;
+
+}GPS_Archive_t;
+
+//	second order for the smooth columns, the block keeps whichever order is cheaper
+static const uint8_t	GPS_ArchiveOrder[GPS_ARCHIVE_COLUMNS]={2,2,2,1,1,1,1};
+//##################################################################################################################
+static uint64_t	GPS_Archive_Now(void)
+{
+	struct timespec	ts;
+	clock_gettime(CLOCK_MONOTONIC,&ts);
+	return (uint64_t)ts.tv_sec*1000000000ULL+(uint64_t)ts.tv_nsec;
+}
+//##################################################################################################################
+static void	GPS_Archive_Idle(uint32_t *Spin)
+{
+	if(++*Spin<64)
+	{
+		#if defined(__x86_64__) || defined(__i386__)
+		__builtin_ia32_pause();
+		#endif
+	}
+	else
+		sched_yield();
+}
+//##################################################################################################################
+static uint32_t	GPS_Archive_OutSize(uint32_t Rows)
+{
+	//	a residual never takes more than 5 varint bytes
+	return Rows*GPS_ARCHIVE_COLUMNS*5+(Rows/_GPS_ARCHIVE_BLOCK+1)*(uint32_t)sizeof(GPS_ArchiveBlock_t);
+}
+//##################################################################################################################
+static uint8_t	GPS_Archive_Grow(GPS_ArchiveChunk_t *Chunk,uint32_t Rows)
+{
+	//	buffers follow the largest chunk seen and are kept for the next one
+	uint8_t	ok=1;
+	for(uint8_t k=0 ; k<GPS_ARCHIVE_COLUMNS ; k++)
+	{
+		int32_t	*p=(int32_t*)realloc(Chunk->Column[k],(size_t)Rows*sizeof(int32_t));
+		if(p!=NULL)
+			Chunk->Column[k]=p;
+		ok&=(p!=NULL);
+	}
+	uint32_t	*b=(uint32_t*)realloc(Chunk->Block,(Rows/_GPS_ARCHIVE_BLOCK+1)*sizeof(uint32_t));
+	uint8_t		*o=(uint8_t*)realloc(Chunk->Out,GPS_Archive_OutSize(Rows));
+	if(b!=NULL)
+		Chunk->Block=b;
+	if(o!=NULL)
+		Chunk->Out=o;
+	if(ok && (b!=NULL) && (o!=NULL))
+	{
+		Chunk->Room=Rows;
+		return 1;
+	}
+	return 0;
+}
+//##################################################################################################################
+static void	GPS_Archive_QueueInit(GPS_ArchiveQueue_t *Queue)
+{
+	memset(Queue,0,sizeof(GPS_ArchiveQueue_t));
+	for(uint32_t i=0 ; i<GPS_ARCHIVE_QUEUE ; i++)
+		Queue->Cell[i].Seq=i;
+}
+//##################################################################################################################
+static uint8_t	GPS_Archive_Push(GPS_ArchiveQueue_t *Queue,GPS_ArchiveChunk_t *Chunk)
+{
+	uint32_t	pos=__atomic_load_n(&Queue->Tail,__ATOMIC_RELAXED);
+	for(;;)
+	{
+		GPS_ArchiveCell_t	*cell=&Queue->Cell[pos & (GPS_ARCHIVE_QUEUE-1)];
+		int32_t	dif=(int32_t)(GPS_ARCHIVE_LOAD(&cell->Seq)-pos);
+		if(dif==0)
+		{
+			if(__atomic_compare_exchange_n(&Queue->Tail,&pos,pos+1,1,__ATOMIC_RELAXED,__ATOMIC_RELAXED))
+			{
+				cell->Chunk=Chunk;
+				GPS_ARCHIVE_STORE(&cell->Seq,pos+1);
+				return 1;
+			}
+		}
+		else if(dif<0)
+			return 0;
+		else
+			pos=__atomic_load_n(&Queue->Tail,__ATOMIC_RELAXED);
+	}
+}
+//##################################################################################################################
+static GPS_ArchiveChunk_t	*GPS_Archive_Pop(GPS_ArchiveQueue_t *Queue)
+{
+	uint32_t	pos=__atomic_load_n(&Queue->Head,__ATOMIC_RELAXED);
+	for(;;)
+	{
+		GPS_ArchiveCell_t	*cell=&Queue->Cell[pos & (GPS_ARCHIVE_QUEUE-1)];
+		int32_t	dif=(int32_t)(GPS_ARCHIVE_LOAD(&cell->Seq)-(pos+1));
+		if(dif==0)
+		{
+			if(__atomic_compare_exchange_n(&Queue->Head,&pos,pos+1,1,__ATOMIC_RELAXED,__ATOMIC_RELAXED))
+			{
+				GPS_ArchiveChunk_t	*chunk=cell->Chunk;
+				GPS_ARCHIVE_STORE(&cell->Seq,pos+GPS_ARCHIVE_QUEUE);
+				return chunk;
+			}
+		}
+		else if(dif<0)
+			return NULL;
+		else
+			pos=__atomic_load_n(&Queue->Head,__ATOMIC_RELAXED);
+	}
+}
+//##################################################################################################################
+static void	GPS_Archive_Send(GPS_Archive_t *Archive,GPS_ArchiveQueue_t *Queue,GPS_ArchiveChunk_t *Chunk,GPS_ArchiveStage_t Stage)
+{
+	uint32_t	spin=0;
+	uint64_t	t;
+	if(GPS_Archive_Push(Queue,Chunk))
+		return;
+	t=GPS_Archive_Now();
+	while(GPS_Archive_Push(Queue,Chunk)==0)
+		GPS_Archive_Idle(&spin);
+	GPS_ARCHIVE_ADD(&Archive->Stats->Stage[Stage].Stall,GPS_Archive_Now()-t);
+}
+//##################################################################################################################
+static uint32_t	GPS_Archive_Tag(const uint8_t *Line,const uint8_t *End,const uint8_t **Tag)
+{
+	//	time field of a GGA/GNS/GST line, any talker
+	if((End-Line<8) || (Line[0]!='$') || (Line[6]!=','))
+		return 0;
+	if((memcmp(&Line[3],"GGA",3)!=0) && (memcmp(&Line[3],"GNS",3)!=0) && (memcmp(&Line[3],"GST",3)!=0))
+		return 0;
+	const uint8_t	*p=&Line[7];
+	while((p<End) && (*p!=',') && (*p!='*'))
+		p++;
+	*Tag=&Line[7];
+	return (uint32_t)(p-&Line[7]);
+}
+//##################################################################################################################
+static uint64_t	GPS_Archive_Cut(const uint8_t *Data,uint64_t Pos,uint64_t Len)
+{
+	//	ends on a line end, and before the first sentence with a new time tag, so no epoch straddles two chunks
+	const uint8_t	*end=Data+Len;
+	const uint8_t	*limit=Data+((Pos+GPS_ARCHIVE_STRETCH<Len) ? Pos+GPS_ARCHIVE_STRETCH : Len);
+	const uint8_t	*p=(const uint8_t*)memchr(Data+Pos,'\n',Len-Pos);
+	const uint8_t	*tag=NULL,*t;
+	uint32_t			tagLen=0,n;
+	if(p==NULL)
+		return Len;
+	p++;
+	while(p<limit)
+	{
+		const uint8_t	*e=(const uint8_t*)memchr(p,'\n',(size_t)(end-p));
+		e=(e==NULL) ? end : e+1;
+		if((n=GPS_Archive_Tag(p,e,&t))>0)
+		{
+			if(tag==NULL)
+			{
+				tag=t;
+				tagLen=n;
+			}
+			else if((n!=tagLen) || (memcmp(t,tag,n)!=0))
+				return (uint64_t)(p-Data);
+		}
+		p=e;
+	}
+	return (uint64_t)(p-Data);
+}
+//##################################################################################################################
+static void	GPS_Archive_Decode(GPS_ArchiveChunk_t *Chunk)
+{
+	//	line by line through a private decoder, a row is added from gps.Fix each time an epoch completes
+	GPS_t					gps;
+	const uint8_t	*p=Chunk->Data;
+	const uint8_t	*end=p+Chunk->Len;
+	uint32_t			rows=0;
+	memset(&gps,0,sizeof(gps));
+	GPS_InitEx(&gps);
+	while(p<=end)
+	{
+		const uint8_t	*e;
+		if(p==end)
+		{
+			//	the end of the chunk counts as the line going idle, so its last epoch is taken even without a GST
+			gps.LastTime=HAL_GetTick()-51;
+			p++;
+		}
+		else
+		{
+			e=(const uint8_t*)memchr(p,'\n',(size_t)(end-p));
+			e=(e==NULL) ? end : e+1;
+			while(p<e)
+			{
+				uint16_t	n=(e-p>65535) ? 65535 : (uint16_t)(e-p);
+				GPS_RxChunk(&gps,p,n);
+				p+=n;
+			}
+		}
+		if(GPS_ProcessEx(&gps)==0)
+			continue;
+		if((rows>=Chunk->Room) && (GPS_Archive_Grow(Chunk,Chunk->Room*2)==0))
+		{
+			Chunk->Errors++;
+			continue;
+		}
+		Chunk->Column[GPS_ARCHIVE_TIME][rows]=(int32_t)gps.Fix.UTC_Time;
+		Chunk->Column[GPS_ARCHIVE_LATITUDE][rows]=gps.Fix.Latitude;
+		Chunk->Column[GPS_ARCHIVE_LONGITUDE][rows]=gps.Fix.Longitude;
+		Chunk->Column[GPS_ARCHIVE_ALTITUDE][rows]=gps.Fix.Altitude;
+		Chunk->Column[GPS_ARCHIVE_HDOP][rows]=gps.Fix.HDOP;
+		Chunk->Column[GPS_ARCHIVE_FIX][rows]=gps.Fix.Fix;
+		Chunk->Column[GPS_ARCHIVE_SATELLITES][rows]=gps.Fix.SatellitesUsed;
+		rows++;
+	}
+	Chunk->Rows=rows;
+}
+//##################################################################################################################
+static uint8_t	*GPS_Archive_Varint(uint8_t *Out,uint64_t Value)
+{
+	while(Value>=0x80)
+	{
+		*Out++=(uint8_t)(Value | 0x80);
+		Value>>=7;
+	}
+	*Out++=(uint8_t)Value;
+	return Out;
+}
+//##################################################################################################################
+static uint32_t	GPS_Archive_Cost(const int32_t *In,uint32_t Rows,uint8_t Order)
+{
+	//	bits of the zigzag residuals, zeros free: enough to rank the two orders
+	uint32_t	prev=0,delta=0,bits=0;
+	for(uint32_t i=0 ; i<Rows ; i++)
+	{
+		uint32_t	v=(uint32_t)In[i];
+		int32_t		r=(int32_t)(v-prev-((Order==2) ? delta : 0));
+		uint32_t	zz=((uint32_t)r<<1) ^ (uint32_t)(r>>31);
+		bits+=(zz!=0) ? 32-(uint32_t)__builtin_clz(zz) : 0;
+		delta=v-prev;
+		prev=v;
+	}
+	return bits;
+}
+//##################################################################################################################
+static uint32_t	GPS_Archive_Encode(const int32_t *In,uint32_t Rows,uint8_t Order,uint8_t *Out)
+{
+	//	residual of the order 1 or 2 prediction, zigzag and varint. A run of zero residuals is one varint with the
+	//	low bit set.
+	uint8_t		*o=Out;
+	uint32_t	prev=0,delta=0,run=0;
+	for(uint32_t i=0 ; i<Rows ; i++)
+	{
+		uint32_t	v=(uint32_t)In[i];
+		int32_t		r=(int32_t)(v-prev-((Order==2) ? delta : 0));
+		delta=v-prev;
+		prev=v;
+		if(r==0)
+		{
+			run++;
+			continue;
+		}
+		if(run>0)
+		{
+			o=GPS_Archive_Varint(o,((uint64_t)run<<1) | 1);
+			run=0;
+		}
+		o=GPS_Archive_Varint(o,(uint64_t)(((uint32_t)r<<1) ^ (uint32_t)(r>>31))<<1);
+	}
+	if(run>0)
+		o=GPS_Archive_Varint(o,((uint64_t)run<<1) | 1);
+	return (uint32_t)(o-Out);
+}
+//##################################################################################################################
+static void	GPS_Archive_Compress(GPS_ArchiveChunk_t *Chunk)
+{
+	uint32_t	size=0;
+	Chunk->Blocks=0;
+	for(uint32_t first=0 ; first<Chunk->Rows ; first+=_GPS_ARCHIVE_BLOCK)
+	{
+		GPS_ArchiveBlock_t	b;
+		uint32_t						start=size;
+		memset(&b,0,sizeof(b));
+		b.Magic=GPS_ARCHIVE_MAGIC;
+		b.Rows=(Chunk->Rows-first<_GPS_ARCHIVE_BLOCK) ? Chunk->Rows-first : _GPS_ARCHIVE_BLOCK;
+		size+=sizeof(GPS_ArchiveBlock_t);
+		for(uint8_t c=0 ; c<GPS_ARCHIVE_COLUMNS ; c++)
+		{
+			const int32_t	*in=&Chunk->Column[c][first];
+			int32_t				lo=in[0],hi=in[0];
+			for(uint32_t i=1 ; i<b.Rows ; i++)
+			{
+				lo=(in[i]<lo) ? in[i] : lo;
+				hi=(in[i]>hi) ? in[i] : hi;
+			}
+			b.Min[c]=lo;
+			b.Max[c]=hi;
+			b.Order[c]=1;
+			if((GPS_ArchiveOrder[c]==2) && (GPS_Archive_Cost(in,b.Rows,2)<GPS_Archive_Cost(in,b.Rows,1)))
+				b.Order[c]=2;
+			b.Size[c]=GPS_Archive_Encode(in,b.Rows,b.Order[c],&Chunk->Out[size]);
+			size+=b.Size[c];
+		}
+		memcpy(&Chunk->Out[start],&b,sizeof(b));
+		Chunk->Block[Chunk->Blocks++]=start;
+	}
+	Chunk->Size=size;
+}
+//##################################################################################################################
+static void	*GPS_Archive_Worker(void *Arg)
+{
+	//	decode and compress workers in one pool, the later stage first so chunks drain towards the writer
+	GPS_Archive_t	*a=(GPS_Archive_t*)Arg;
+	uint32_t			spin=0;
+	while(GPS_ARCHIVE_LOAD(&a->Stop)==0)
+	{
+		GPS_ArchiveChunk_t	*c;
+		uint64_t						t;
+		if((c=GPS_Archive_Pop(&a->Compress))!=NULL)
+		{
+			t=GPS_Archive_Now();
+			GPS_Archive_Compress(c);
+			GPS_ARCHIVE_ADD(&a->Stats->Stage[GPS_ARCHIVE_COMPRESS].Busy,GPS_Archive_Now()-t);
+			GPS_ARCHIVE_ADD(&a->Stats->Stage[GPS_ARCHIVE_COMPRESS].Chunks,1);
+			GPS_ARCHIVE_ADD(&a->Stats->Stage[GPS_ARCHIVE_COMPRESS].Bytes,(uint64_t)c->Rows*GPS_ARCHIVE_COLUMNS*4);
+			GPS_Archive_Send(a,&a->Index,c,GPS_ARCHIVE_COMPRESS);
+			spin=0;
+		}
+		else if((c=GPS_Archive_Pop(&a->Decode))!=NULL)
+		{
+			t=GPS_Archive_Now();
+			GPS_Archive_Decode(c);
+			GPS_ARCHIVE_ADD(&a->Stats->Stage[GPS_ARCHIVE_DECODE].Busy,GPS_Archive_Now()-t);
+			GPS_ARCHIVE_ADD(&a->Stats->Stage[GPS_ARCHIVE_DECODE].Chunks,1);
+			GPS_ARCHIVE_ADD(&a->Stats->Stage[GPS_ARCHIVE_DECODE].Bytes,c->Len);
+			GPS_Archive_Send(a,&a->Compress,c,GPS_ARCHIVE_DECODE);
+			spin=0;
+		}
+		else
+			GPS_Archive_Idle(&spin);
+	}
+	return NULL;
+}
+//##################################################################################################################
+static void	GPS_Archive_Emit(GPS_Archive_t *Archive,const void *Data,uint32_t Len)
+{
+	if((Len>0) && (Archive->Write(Archive->Context,Data,Len)!=Len))
+		Archive->Stats->Errors++;
+	Archive->Stats->Output+=Len;
+}
+//##################################################################################################################
+static void	*GPS_Archive_Indexer(void *Arg)
+{
+	//	chunks come back out of order and are written in sequence; the index grows with every block written
+	GPS_Archive_t				*a=(GPS_Archive_t*)Arg;
+	GPS_ArchiveChunk_t	**pending=(GPS_ArchiveChunk_t**)calloc(a->Chunks,sizeof(GPS_ArchiveChunk_t*));
+	GPS_ArchiveIndex_t	*index=NULL;
+	GPS_ArchiveFooter_t	footer;
+	uint32_t						count=0,room=0,spin=0;
+	uint64_t						next=0;
+	memset(&footer,0,sizeof(footer));
+	while(next!=GPS_ARCHIVE_LOAD(&a->Total))
+	{
+		GPS_ArchiveChunk_t	*c=GPS_Archive_Pop(&a->Index);
+		uint64_t						t;
+		if(c==NULL)
+		{
+			GPS_Archive_Idle(&spin);
+			continue;
+		}
+		spin=0;
+		pending[c->Seq % a->Chunks]=c;
+		while(((c=pending[next % a->Chunks])!=NULL) && (c->Seq==next))
+		{
+			t=GPS_Archive_Now();
+			pending[next % a->Chunks]=NULL;
+			if(count+c->Blocks>room)
+			{
+				room=(room==0) ? 1024 : room*2;
+				room=(room<count+c->Blocks) ? count+c->Blocks : room;
+				index=(GPS_ArchiveIndex_t*)realloc(index,(size_t)room*sizeof(GPS_ArchiveIndex_t));
+			}
+			for(uint32_t i=0 ; i<c->Blocks ; i++)
+			{
+				index[count].Offset=a->Stats->Output+c->Block[i];
+				memcpy(&index[count].Block,&c->Out[c->Block[i]],sizeof(GPS_ArchiveBlock_t));
+				count++;
+			}
+			GPS_Archive_Emit(a,c->Out,c->Size);
+			a->Stats->Rows+=c->Rows;
+			a->Stats->Errors+=c->Errors;
+			a->Stats->Stage[GPS_ARCHIVE_INDEX].Chunks++;
+			a->Stats->Stage[GPS_ARCHIVE_INDEX].Bytes+=c->Size;
+			a->Stats->Stage[GPS_ARCHIVE_INDEX].Busy+=GPS_Archive_Now()-t;
+			GPS_Archive_Send(a,&a->Free,c,GPS_ARCHIVE_INDEX);
+			next++;
+		}
+	}
+	footer.Magic=GPS_ARCHIVE_MAGIC;
+	footer.Version=GPS_ARCHIVE_VERSION;
+	footer.Blocks=count;
+	footer.Columns=GPS_ARCHIVE_COLUMNS;
+	footer.Rows=a->Stats->Rows;
+	footer.Index=a->Stats->Output;
+	for(uint32_t i=0 ; i<count ; i+=65536)
+		GPS_Archive_Emit(a,&index[i],(uint32_t)(((count-i<65536) ? count-i : 65536)*sizeof(GPS_ArchiveIndex_t)));
+	GPS_Archive_Emit(a,&footer,sizeof(footer));
+	a->Stats->Blocks=count;
+	free(index);
+	free(pending);
+	GPS_ARCHIVE_STORE(&a->Stop,1);
+	return NULL;
+}
+//##################################################################################################################
+uint8_t	GPS_Archive_Run(const uint8_t *Data,uint64_t Len,GPS_ArchiveWrite_t Write,void *Context,uint32_t Threads,GPS_ArchiveStats_t *Stats)
+{
+	GPS_Archive_t					*a;
+	pthread_t							worker[GPS_ARCHIVE_WORKERS];
+	pthread_t							indexer;
+	uint64_t							start=GPS_Archive_Now();
+	uint64_t							pos=0,seq=0;
+	uint32_t							started=0;
+	uint8_t								ok=1;
+	memset(Stats,0,sizeof(GPS_ArchiveStats_t));
+	if(Threads==0)
+		Threads=_GPS_ARCHIVE_THREADS;
+	if(Threads==0)
+		Threads=(uint32_t)sysconf(_SC_NPROCESSORS_ONLN);
+	Threads=(Threads<1) ? 1 : (Threads>GPS_ARCHIVE_WORKERS) ? GPS_ARCHIVE_WORKERS : Threads;
+	//	one per call, so runs on other threads do not share queues
+	if((a=(GPS_Archive_t*)aligned_alloc(64,sizeof(GPS_Archive_t)))==NULL)
+		return 0;
+	memset(a,0,sizeof(GPS_Archive_t));
+	GPS_Archive_QueueInit(&a->Free);
+	GPS_Archive_QueueInit(&a->Decode);
+	GPS_Archive_QueueInit(&a->Compress);
+	GPS_Archive_QueueInit(&a->Index);
+	a->Write=Write;
+	a->Context=Context;
+	a->Stats=Stats;
+	a->Total=GPS_ARCHIVE_NONE;
+	//	two chunks per worker keep every worker busy while the framer and the writer run ahead
+	a->Chunks=2*Threads+2;
+	a->Chunk=(GPS_ArchiveChunk_t*)calloc(a->Chunks,sizeof(GPS_ArchiveChunk_t));
+	if(a->Chunk==NULL)
+	{
+		free(a);
+		return 0;
+	}
+	for(uint32_t i=0 ; i<a->Chunks ; i++)
+	{
+		ok&=GPS_Archive_Grow(&a->Chunk[i],GPS_ARCHIVE_ROWS);
+		GPS_Archive_Push(&a->Free,&a->Chunk[i]);
+	}
+	Stats->Chunks=a->Chunks;
+	Stats->Input=Len;
+	for( ; ok && (started<Threads) ; started++)
+		if(pthread_create(&worker[started],NULL,GPS_Archive_Worker,a)!=0)
+			break;
+	Stats->Threads=started;
+	if(ok && (started>0) && (pthread_create(&indexer,NULL,GPS_Archive_Indexer,a)==0))
+	{
+		while(pos<Len)
+		{
+			GPS_ArchiveChunk_t	*c=GPS_Archive_Pop(&a->Free);
+			uint64_t						t=GPS_Archive_Now(),end;
+			uint32_t						spin=0;
+			if(c==NULL)
+			{
+				//	backpressure: every chunk is somewhere downstream
+				while((c=GPS_Archive_Pop(&a->Free))==NULL)
+					GPS_Archive_Idle(&spin);
+				Stats->Stage[GPS_ARCHIVE_FRAME].Stall+=GPS_Archive_Now()-t;
+				t=GPS_Archive_Now();
+			}
+			end=(Len-pos<=_GPS_ARCHIVE_CHUNK) ? Len : GPS_Archive_Cut(Data,pos+_GPS_ARCHIVE_CHUNK,Len);
+			c->Seq=seq++;
+			c->Data=Data+pos;
+			c->Len=(uint32_t)(end-pos);
+			c->Rows=0;
+			c->Blocks=0;
+			c->Size=0;
+			c->Errors=0;
+			pos=end;
+			Stats->Stage[GPS_ARCHIVE_FRAME].Chunks++;
+			Stats->Stage[GPS_ARCHIVE_FRAME].Bytes+=c->Len;
+			Stats->Stage[GPS_ARCHIVE_FRAME].Busy+=GPS_Archive_Now()-t;
+			GPS_Archive_Send(a,&a->Decode,c,GPS_ARCHIVE_FRAME);
+		}
+		GPS_ARCHIVE_STORE(&a->Total,seq);
+		pthread_join(indexer,NULL);
+	}
+	else
+	{
+		GPS_ARCHIVE_STORE(&a->Stop,1);
+		Stats->Errors++;
+	}
+	for(uint32_t i=0 ; i<started ; i++)
+		pthread_join(worker[i],NULL);
+	for(uint32_t i=0 ; i<a->Chunks ; i++)
+	{
+		for(uint8_t k=0 ; k<GPS_ARCHIVE_COLUMNS ; k++)
+			free(a->Chunk[i].Column[k]);
+		free(a->Chunk[i].Block);
+		free(a->Chunk[i].Out);
+	}
+	free(a->Chunk);
+	free(a);
+	Stats->Seconds=(GPS_Archive_Now()-start)*1e-9;
+	return (Stats->Errors==0);
+}
+//##################################################################################################################
+static uint32_t	GPS_Archive_FileWrite(void *Context,const void *Data,uint32_t Len)
+{
+	return (uint32_t)fwrite(Data,1,Len,(FILE*)Context);
+}
+//##################################################################################################################
+uint8_t	GPS_Archive_File(const char *Input,const char *Output,uint32_t Threads,GPS_ArchiveStats_t *Stats)
+{
+	struct stat	st;
+	uint8_t			*data=NULL;
+	uint8_t			ok;
+	FILE				*out;
+	int					fd=open(Input,O_RDONLY);
+	memset(Stats,0,sizeof(GPS_ArchiveStats_t));
+	if((fd<0) || (fstat(fd,&st)!=0))
+	{
+		if(fd>=0)
+			close(fd);
+		return 0;
+	}
+	if(st.st_size>0)
+	{
+		data=(uint8_t*)mmap(NULL,(size_t)st.st_size,PROT_READ,MAP_PRIVATE,fd,0);
+		if(data==MAP_FAILED)
+		{
+			close(fd);
+			return 0;
+		}
+		madvise(data,(size_t)st.st_size,MADV_SEQUENTIAL);
+	}
+	if((out=fopen(Output,"wb"))==NULL)
+	{
+		if(data!=NULL)
+			munmap(data,(size_t)st.st_size);
+		close(fd);
+		return 0;
+	}
+	setvbuf(out,NULL,_IOFBF,1<<20);
+	ok=GPS_Archive_Run(data,(uint64_t)st.st_size,GPS_Archive_FileWrite,out,Threads,Stats);
+	if(fclose(out)!=0)
+		ok=0;
+	if(data!=NULL)
+		munmap(data,(size_t)st.st_size);
+	close(fd);
+	return ok;
+}
+//##################################################################################################################
+void	GPS_Archive_Report(const GPS_ArchiveStats_t *Stats)
+{
+	static const char	*name[GPS_ARCHIVE_STAGES]={"frame","decode","compress","index"};
+	printf("%lu bytes -> %lu bytes (%.1fx), %lu fixes in %lu blocks, %.3f s, %.1f MB/s, %lu workers, %lu chunks, %lu errors\r\n",
+		(unsigned long)Stats->Input,(unsigned long)Stats->Output,(Stats->Output>0) ? (double)Stats->Input/Stats->Output : 0.0,
+		(unsigned long)Stats->Rows,(unsigned long)Stats->Blocks,Stats->Seconds,(Stats->Seconds>0.0) ? Stats->Input/Stats->Seconds*1e-6 : 0.0,
+		(unsigned long)Stats->Threads,(unsigned long)Stats->Chunks,(unsigned long)Stats->Errors);
+	for(uint8_t i=0 ; i<GPS_ARCHIVE_STAGES ; i++)
+	{
+		const GPS_ArchiveStageStats_t	*s=&Stats->Stage[i];
+		printf("%-9s %6lu chunks %12lu bytes busy %9.3f s (%8.1f MB/s per thread) stalled %8.3f s\r\n",name[i],(unsigned long)s->Chunks,
+			(unsigned long)s->Bytes,s->Busy*1e-9,(s->Busy>0) ? s->Bytes*1e3/s->Busy : 0.0,s->Stall*1e-9);
+	}
+}
+//##################################################################################################################
+uint8_t	GPS_Archive_Open(GPS_ArchiveReader_t *Reader,const uint8_t *Data,uint64_t Len)
+{
+	//	blocks have any length, so neither the footer nor the index is aligned in the file
+	GPS_ArchiveFooter_t	f;
+	memset(Reader,0,sizeof(GPS_ArchiveReader_t));
+	if(Len<sizeof(GPS_ArchiveFooter_t))
+		return 0;
+	memcpy(&f,Data+Len-sizeof(GPS_ArchiveFooter_t),sizeof(GPS_ArchiveFooter_t));
+	if((f.Magic!=GPS_ARCHIVE_MAGIC) || (f.Version!=GPS_ARCHIVE_VERSION) || (f.Columns!=GPS_ARCHIVE_COLUMNS) ||
+		(f.Index>Len-sizeof(GPS_ArchiveFooter_t)) || ((Len-sizeof(GPS_ArchiveFooter_t)-f.Index)/sizeof(GPS_ArchiveIndex_t)!=f.Blocks))
+		return 0;
+	if((Reader->Index=(GPS_ArchiveIndex_t*)malloc(((f.Blocks>0) ? f.Blocks : 1)*sizeof(GPS_ArchiveIndex_t)))==NULL)
+		return 0;
+	memcpy(Reader->Index,Data+f.Index,(size_t)f.Blocks*sizeof(GPS_ArchiveIndex_t));
+	Reader->Data=Data;
+	Reader->Len=Len;
+	Reader->Footer=f;
+	return 1;
+}
+//##################################################################################################################
+void	GPS_Archive_Close(GPS_ArchiveReader_t *Reader)
+{
+	free(Reader->Index);
+	memset(Reader,0,sizeof(GPS_ArchiveReader_t));
+}
+//##################################################################################################################
+uint32_t	GPS_Archive_Column(const GPS_ArchiveReader_t *Reader,uint32_t Block,GPS_ArchiveColumn_t Column,int32_t *Out)
+{
+	const GPS_ArchiveBlock_t	*b;
+	const uint8_t							*p,*end;
+	uint32_t									prev=0,delta=0,n=0;
+	uint64_t									offset;
+	if((Reader->Index==NULL) || (Block>=Reader->Footer.Blocks) || ((uint32_t)Column>=GPS_ARCHIVE_COLUMNS))
+		return 0;
+	b=&Reader->Index[Block].Block;
+	offset=Reader->Index[Block].Offset+sizeof(GPS_ArchiveBlock_t);
+	for(uint8_t c=0 ; c<Column ; c++)
+		offset+=b->Size[c];
+	if((b->Rows>_GPS_ARCHIVE_BLOCK) || (offset+b->Size[Column]>Reader->Footer.Index))
+		return 0;
+	p=Reader->Data+offset;
+	end=p+b->Size[Column];
+	while((p<end) && (n<b->Rows))
+	{
+		uint64_t	v=0;
+		uint8_t		shift=0;
+		while((p<end) && (*p & 0x80) && (shift<63))
+		{
+			v|=(uint64_t)(*p++ & 0x7F)<<shift;
+			shift+=7;
+		}
+		if(p==end)
+			return 0;
+		v|=(uint64_t)*p++<<shift;
+		if(v & 1)
+		{
+			//	run of exact predictions
+			uint64_t	run=v>>1;
+			if(run>b->Rows-n)
+				return 0;
+			for( ; run>0 ; run--)
+			{
+				uint32_t	x=prev+((b->Order[Column]==2) ? delta : 0);
+				delta=x-prev;
+				prev=x;
+				Out[n++]=(int32_t)x;
+			}
+		}
+		else
+		{
+			uint32_t	zz=(uint32_t)(v>>1);
+			uint32_t	x=prev+((b->Order[Column]==2) ? delta : 0)+((zz>>1) ^ (0U-(zz & 1)));
+			delta=x-prev;
+			prev=x;
+			Out[n++]=(int32_t)x;
+		}
+	}
+	return (n==b->Rows) ? n : 0;
+}
+//##################################################################################################################
+static int64_t	GPS_Archive_Time(const uint8_t *Line,const uint8_t *End,uint8_t *Sentence)
+{
+	//	time tag of a GGA/GNS line with a good checksum in ms of day, -1 for anything else
+	const uint8_t	*p=Line+1;
+	uint8_t		sum=0;
+	uint32_t	hms=0,ms=0,scale=100;
+	if((End-Line<12) || (Line[0]!='$') || (Line[6]!=','))
+		return -1;
+	if(memcmp(&Line[3],"GGA",3)==0)
+		*Sentence=1;
+	else if(memcmp(&Line[3],"GNS",3)==0)
+		*Sentence=2;
+	else
+		return -1;
+	while((p<End) && (*p!='*'))
+		sum^=*p++;
+	if((End-p<3) || (p[1]!="0123456789ABCDEF"[sum>>4]) || (p[2]!="0123456789ABCDEF"[sum & 15]))
+		return -1;
+	for(p=&Line[7] ; (p<End) && (*p>='0') && (*p<='9') ; p++)
+		hms=hms*10+(uint32_t)(*p-'0');
+	if((p<End) && (*p=='.'))
+		for(p++ ; (p<End) && (*p>='0') && (*p<='9') ; p++,scale/=10)
+			ms+=(uint32_t)(*p-'0')*scale;
+	return (int64_t)(hms/10000*3600000+hms/100%100*60000+hms%100*1000+ms);
+}
+//##################################################################################################################
+uint8_t	GPS_Archive_Check(const GPS_ArchiveReader_t *Reader,const uint8_t *Data,uint64_t Len,uint64_t *Mismatch)
+{
+	//	same epoch rule as the decoder: a new tag, or the same sentence again, starts the next one
+	const uint8_t	*p=Data;
+	const uint8_t	*end=Data+Len;
+	int32_t		*time=(int32_t*)malloc(_GPS_ARCHIVE_BLOCK*sizeof(int32_t));
+	int64_t		tag=-1;
+	uint64_t	epochs=0,row=0;
+	uint32_t	block=0,rows=0,next=0;
+	uint8_t		seen=0;
+	*Mismatch=0;
+	if((time==NULL) || (Reader->Index==NULL))
+	{
+		free(time);
+		return 0;
+	}
+	while(p<end)
+	{
+		const uint8_t	*e=(const uint8_t*)memchr(p,'\n',(size_t)(end-p));
+		uint8_t		sentence=0;
+		int64_t		t;
+		e=(e==NULL) ? end : e+1;
+		t=GPS_Archive_Time(p,e,&sentence);
+		p=e;
+		if((t<0) || ((t==tag) && ((seen & sentence)==0)))
+		{
+			seen|=sentence;
+			continue;
+		}
+		tag=t;
+		seen=sentence;
+		epochs++;
+		while((next==rows) && (block<Reader->Footer.Blocks))
+		{
+			rows=GPS_Archive_Column(Reader,block++,GPS_ARCHIVE_TIME,time);
+			next=0;
+		}
+		if(next<rows)
+		{
+			*Mismatch+=(time[next++]!=(int32_t)t);
+			row++;
+		}
+	}
+	while(block<Reader->Footer.Blocks)
+		row+=GPS_Archive_Column(Reader,block++,GPS_ARCHIVE_TIME,time);
+	row+=rows-next;
+	free(time);
+	*Mismatch+=(row>epochs) ? row-epochs : epochs-row;
+	return (*Mismatch==0) && (row==Reader->Footer.Rows);
+}
+//##################################################################################################################
+
+#endif
@@ -0,0 +1,122 @@
+#ifndef _GPSARCHIVE_H_
+#define _GPSARCHIVE_H_
+
+#include <stdint.h>
+#include "GPSConfig.h"
+
+//##################################################################################################################
+//	Columnar fix archive for the host build. A raw NMEA capture becomes blocks of up to _GPS_ARCHIVE_BLOCK fixes
+//	with one delta coded varint stream per column, then an index holding every block header and a footer.
+//	GPS_Archive_Run() frames, decodes, compresses and indexes as concurrent stages. _GPS_ARCHIVE_CHUNK byte chunks
+//	travel between them through bounded lock-free queues and go back to a free queue once written, so a slow stage
+//	holds up the framer instead of growing memory.
+//##################################################################################################################
+
+#define	GPS_ARCHIVE_MAGIC						0x41535047		//	"GPSA"
+#define	GPS_ARCHIVE_VERSION					1
+
+typedef enum
+{
+	GPS_ARCHIVE_TIME=0,								//	ms of day UTC
+	GPS_ARCHIVE_LATITUDE,							//	1e-7 degree
+	GPS_ARCHIVE_LONGITUDE,						//	1e-7 degree
+	GPS_ARCHIVE_ALTITUDE,							//	mm above MSL
+	GPS_ARCHIVE_HDOP,									//	0.01
+	GPS_ARCHIVE_FIX,									//	GGA fix quality
+	GPS_ARCHIVE_SATELLITES,
+	GPS_ARCHIVE_COLUMNS,
+
+}GPS_ArchiveColumn_t;
+
+typedef enum
+{
+	GPS_ARCHIVE_FRAME=0,
+	GPS_ARCHIVE_DECODE,
+	GPS_ARCHIVE_COMPRESS,
+	GPS_ARCHIVE_INDEX,
+	GPS_ARCHIVE_STAGES,
+
+}GPS_ArchiveStage_t;
+
+//	block header, followed by the column streams in column order. Order is the delta order of each column.
+typedef struct
+{
+	uint32_t		Magic;
+	uint32_t		Rows;
+	uint32_t		Size[GPS_ARCHIVE_COLUMNS];
+	int32_t			Min[GPS_ARCHIVE_COLUMNS];
+	int32_t			Max[GPS_ARCHIVE_COLUMNS];
+	uint8_t			Order[GPS_ARCHIVE_COLUMNS];
+	uint8_t			Reserved[5];
+
+}GPS_ArchiveBlock_t;
+
+typedef struct
+{
+	uint64_t						Offset;
+	GPS_ArchiveBlock_t	Block;
+
+}GPS_ArchiveIndex_t;
+
+//	last bytes of the file
+typedef struct
+{
+	uint32_t		Magic;
+	uint32_t		Version;
+	uint32_t		Blocks;
+	uint32_t		Columns;
+	uint64_t		Rows;
+	uint64_t		Index;
+
+}GPS_ArchiveFooter_t;
+
+typedef struct
+{
+	uint64_t		Chunks;
+	uint64_t		Bytes;
+	uint64_t		Busy;										//	ns of work, summed over threads
+	uint64_t		Stall;									//	ns waiting for a free chunk or a queue slot
+
+}GPS_ArchiveStageStats_t;
+
+typedef struct
+{
+	GPS_ArchiveStageStats_t	Stage[GPS_ARCHIVE_STAGES];
+	uint32_t		Threads;
+	uint32_t		Chunks;
+	uint32_t		Blocks;
+	uint32_t		Errors;
+	uint64_t		Rows;
+	uint64_t		Input;
+	uint64_t		Output;
+	double			Seconds;
+
+}GPS_ArchiveStats_t;
+
+typedef struct
+{
+	const uint8_t							*Data;
+	uint64_t									Len;
+	GPS_ArchiveFooter_t				Footer;
+	GPS_ArchiveIndex_t				*Index;									//	aligned copy, NULL until opened
+
+}GPS_ArchiveReader_t;
+
+typedef uint32_t	(*GPS_ArchiveWrite_t)(void *Context,const void *Data,uint32_t Len);
+
+//##################################################################################################################
+//	Threads 0 takes _GPS_ARCHIVE_THREADS, and 0 there takes one worker per online core. Returns 1 without errors.
+uint8_t		GPS_Archive_Run(const uint8_t *Data,uint64_t Len,GPS_ArchiveWrite_t Write,void *Context,uint32_t Threads,GPS_ArchiveStats_t *Stats);
+uint8_t		GPS_Archive_File(const char *Input,const char *Output,uint32_t Threads,GPS_ArchiveStats_t *Stats);
+void			GPS_Archive_Report(const GPS_ArchiveStats_t *Stats);
+//	reader over an archive in memory. Column returns the rows of the block written to Out, 0 on a damaged block.
+//	Open copies the footer and index out of Data, Close frees the copy.
+uint8_t		GPS_Archive_Open(GPS_ArchiveReader_t *Reader,const uint8_t *Data,uint64_t Len);
+void			GPS_Archive_Close(GPS_ArchiveReader_t *Reader);
+uint32_t	GPS_Archive_Column(const GPS_ArchiveReader_t *Reader,uint32_t Block,GPS_ArchiveColumn_t Column,int32_t *Out);
+//	round trip of the TIME column against the epochs of the capture it was made from, one per GGA/GNS time tag.
+//	Mismatch gets the rows that differ plus the difference in row count. Returns 1 when everything matches.
+uint8_t		GPS_Archive_Check(const GPS_ArchiveReader_t *Reader,const uint8_t *Data,uint64_t Len,uint64_t *Mismatch);
+//##################################################################################################################
+
+#endif
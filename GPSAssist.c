@@ -0,0 +1,441 @@
+#include "GPSConfig.h"
+#include "GPSAssist.h"
+#if (_GPS_HOST==1)
+#include "GPSHost.h"
+#else
+#include "usart.h"
+#endif
+#include <string.h>
+
+#if (_GPS_ASSIST==1)
+
+#define	GPS_ASSIST_EPO_RECORD				72
+#define	GPS_ASSIST_EPO_SET					(32*GPS_ASSIST_EPO_RECORD)
+#define	GPS_ASSIST_EPO_DATA					(3*GPS_ASSIST_EPO_RECORD)
+#define	GPS_ASSIST_EPO_PACKET				(GPS_ASSIST_EPO_DATA+11)
+#define	GPS_ASSIST_SCAN							64
+#define	GPS_ASSIST_RETRY						3
+
+#if (_GPS_ASSIST_CHUNK < GPS_ASSIST_EPO_PACKET)
+#error "_GPS_ASSIST_CHUNK must hold one EPO packet (227 bytes)"
+#endif
+
+GPS_Assist_t GPS_Assist;
+//##################################################################################################################
+static uint32_t	GPS_Assist_Days(uint16_t Year,uint8_t Month,uint8_t Day)
+{
+	//	days since 1970-01-01, proleptic gregorian
+	int32_t	y=(int32_t)Year-(Month<=2);
+	int32_t	era=y/400;
+	uint32_t	yoe=(uint32_t)(y-era*400);
+	uint32_t	doy=(153*(Month+(Month>2 ? -3 : 9))+2)/5+Day-1;
+	uint32_t	doe=yoe*365+yoe/4-yoe/100+doy;
+	return (uint32_t)(era*146097+(int32_t)doe-719468);
+}
+//##################################################################################################################
+static uint32_t	GPS_Assist_Fetch(uint32_t Offset,uint8_t *Data,uint32_t Size)
+{
+	if(Offset>=GPS_Assist.Size)
+		return 0;
+	if(Size>GPS_Assist.Size-Offset)
+		Size=GPS_Assist.Size-Offset;
+	if(GPS_Assist.Flash!=NULL)
+	{
+		memcpy(Data,&GPS_Assist.Flash[Offset],Size);
+		return Size;
+	}
+	return GPS_Assist.Read(Offset,Data,Size);
+}
+//##################################################################################################################
+static void	GPS_Assist_Send(void)
+{
+	GPS_Assist.TxBusy=1;
+	GPS_Assist.LastTime=HAL_GetTick();
+	if(_GPS_ASSIST_TX(GPS_Assist.txBuffer,GPS_Assist.txIndex)!=HAL_OK)
+		GPS_Assist.TxBusy=0;
+	else
+		GPS_Assist.Sent++;
+}
+//##################################################################################################################
+static void	GPS_Assist_UbxChecksum(uint8_t *Frame,uint16_t Len)
+{
+	uint8_t	a=0,b=0;
+	for(uint16_t i=2 ; i<Len+6 ; i++)
+	{
+		a+=Frame[i];
+		b+=a;
+	}
+	Frame[Len+6]=a;
+	Frame[Len+7]=b;
+}
+//##################################################################################################################
+static uint16_t	GPS_Assist_MtkPacket(uint8_t *Frame,uint16_t Cmd,const uint8_t *Payload,uint16_t Len)
+{
+	uint16_t	total=Len+9;
+	uint8_t		cs=0;
+	Frame[0]=0x04;
+	Frame[1]=0x24;
+	Frame[2]=(uint8_t)total;
+	Frame[3]=(uint8_t)(total>>8);
+	Frame[4]=(uint8_t)Cmd;
+	Frame[5]=(uint8_t)(Cmd>>8);
+	if(Payload!=NULL)
+		memcpy(&Frame[6],Payload,Len);
+	for(uint16_t i=2 ; i<Len+6 ; i++)
+		cs^=Frame[i];
+	Frame[Len+6]=cs;
+	Frame[Len+7]=0x0D;
+	Frame[Len+8]=0x0A;
+	return total;
+}
+//##################################################################################################################
+static void	GPS_Assist_UbxTime(void)
+{
+	uint8_t	*f=GPS_Assist.txBuffer;
+	memset(f,0,32);
+	f[0]=0xB5;
+	f[1]=0x62;
+	f[2]=0x13;
+	f[3]=0x40;
+	f[4]=24;
+	f[6]=0x10;
+	f[9]=0x80;
+	f[10]=(uint8_t)GPS_Assist.Time.Year;
+	f[11]=(uint8_t)(GPS_Assist.Time.Year>>8);
+	f[12]=GPS_Assist.Time.Month;
+	f[13]=GPS_Assist.Time.Day;
+	f[14]=GPS_Assist.Time.Hour;
+	f[15]=GPS_Assist.Time.Min;
+	f[16]=GPS_Assist.Time.Sec;
+	f[22]=(uint8_t)_GPS_ASSIST_TIME_ACC;
+	f[23]=(uint8_t)(_GPS_ASSIST_TIME_ACC>>8);
+	GPS_Assist_UbxChecksum(f,24);
+	GPS_Assist.txIndex=32;
+}
+//##################################################################################################################
+static uint8_t	GPS_Assist_UbxFill(void)
+{
+	uint8_t	hdr[6];
+	uint8_t	scan=GPS_ASSIST_SCAN;
+	while((GPS_Assist.Outstanding<_GPS_ASSIST_WINDOW) && (scan-- > 0))
+	{
+		if(GPS_Assist_Fetch(GPS_Assist.Offset,hdr,6)!=6)
+		{
+			GPS_Assist.Offset=GPS_Assist.Size;
+			break;
+		}
+		if((hdr[0]!=0xB5) || (hdr[1]!=0x62))
+		{
+			GPS_Assist.Offset++;
+			continue;
+		}
+		uint16_t	total=(uint16_t)(hdr[4] | (hdr[5]<<8))+8;
+		if(total>sizeof(GPS_Assist.txBuffer))
+		{
+			GPS_Assist.Offset+=total;
+			GPS_Assist.Skipped++;
+			continue;
+		}
+		if(GPS_Assist.txIndex+total>sizeof(GPS_Assist.txBuffer))
+			break;
+		uint8_t	*rec=&GPS_Assist.txBuffer[GPS_Assist.txIndex];
+		if(GPS_Assist_Fetch(GPS_Assist.Offset,rec,total)!=total)
+		{
+			GPS_Assist.Offset=GPS_Assist.Size;
+			break;
+		}
+		GPS_Assist.Offset+=total;
+		if((rec[2]==0x13) && (rec[3]==0x20) && (total>=8+8))
+		{
+			uint32_t	day=GPS_Assist_Days(2000+rec[6+4],rec[6+5],rec[6+6]);
+			if((day<GPS_Assist.FirstDay) || (day>GPS_Assist.LastDay))
+			{
+				GPS_Assist.Skipped++;
+				continue;
+			}
+		}
+		GPS_Assist.txIndex+=total;
+		#if (_GPS_ASSIST_ACK==1)
+		if(rec[2]==0x13)
+			GPS_Assist.Outstanding++;
+		#endif
+	}
+	return (GPS_Assist.txIndex>0);
+}
+//##################################################################################################################
+static void	GPS_Assist_EpoRange(void)
+{
+	//	sets are stored in time order, each one valid for 6 hours from its first record's GPS hour
+	uint8_t		hour[3];
+	uint32_t	offset;
+	GPS_Assist.Offset=GPS_Assist.Size;
+	GPS_Assist.End=GPS_Assist.Size;
+	for(offset=0 ; offset+GPS_ASSIST_EPO_SET<=GPS_Assist.Size ; offset+=GPS_ASSIST_EPO_SET)
+	{
+		if(GPS_Assist_Fetch(offset,hour,3)!=3)
+			break;
+		uint32_t	h=hour[0] | (hour[1]<<8) | ((uint32_t)hour[2]<<16);
+		if(h+6<=GPS_Assist.GpsHour)
+		{
+			GPS_Assist.Skipped++;
+			continue;
+		}
+		if(h>=GPS_Assist.GpsHour+_GPS_ASSIST_EPO_HOURS)
+			break;
+		if(GPS_Assist.Offset==GPS_Assist.Size)
+			GPS_Assist.Offset=offset;
+		GPS_Assist.End=offset+GPS_ASSIST_EPO_SET;
+	}
+	if(GPS_Assist.Offset==GPS_Assist.Size)
+		GPS_Assist.End=GPS_Assist.Size;
+}
+//##################################################################################################################
+static void	GPS_Assist_EpoFill(uint16_t Seq)
+{
+	uint8_t		*f=GPS_Assist.txBuffer;
+	uint32_t	n=0;
+	memset(&f[8],0,GPS_ASSIST_EPO_DATA);
+	if(Seq!=0xFFFF)
+	{
+		n=GPS_Assist.End-GPS_Assist.Offset;
+		if(n>GPS_ASSIST_EPO_DATA)
+			n=GPS_ASSIST_EPO_DATA;
+		n=GPS_Assist_Fetch(GPS_Assist.Offset,&f[8],n);
+		GPS_Assist.Offset+=n;
+	}
+	f[6]=(uint8_t)Seq;
+	f[7]=(uint8_t)(Seq>>8);
+	GPS_Assist.txIndex=GPS_Assist_MtkPacket(f,722,NULL,GPS_ASSIST_EPO_DATA+2);
+	GPS_Assist.EpoSeq=Seq;
+	GPS_Assist.Outstanding=1;
+	GPS_Assist.Retry=0;
+}
+//##################################################################################################################
+static uint8_t	GPS_Assist_Begin(GPS_AssistFormat_t Format,GPS_AssistRead_t Read,const uint8_t *Flash,uint32_t Size,const GPS_AssistTime_t *Time)
+{
+	if((GPS_Assist.State==GPS_ASSIST_BUSY) || (Time==NULL))
+		return 0;
+	memset(&GPS_Assist,0,sizeof(GPS_Assist));
+	GPS_Assist.Format=Format;
+	GPS_Assist.Read=Read;
+	GPS_Assist.Flash=Flash;
+	GPS_Assist.Size=Size;
+	GPS_Assist.Time=*Time;
+	GPS_Assist.FirstDay=GPS_Assist_Days(Time->Year,Time->Month,Time->Day);
+	GPS_Assist.LastDay=GPS_Assist.FirstDay+_GPS_ASSIST_DAYS-1;
+	GPS_Assist.GpsHour=(GPS_Assist.FirstDay-GPS_Assist_Days(1980,1,6))*24+Time->Hour;
+	GPS_Assist.End=Size;
+	if(Format==GPS_ASSIST_MTK_EPO)
+		GPS_Assist_EpoRange();
+	GPS_Assist.State=GPS_ASSIST_BUSY;
+	return 1;
+}
+//##################################################################################################################
+uint8_t	GPS_Assist_Start(GPS_AssistFormat_t Format,GPS_AssistRead_t Read,uint32_t Size,const GPS_AssistTime_t *Time)
+{
+	if(Read==NULL)
+		return 0;
+	return GPS_Assist_Begin(Format,Read,NULL,Size,Time);
+}
+//##################################################################################################################
+uint8_t	GPS_Assist_StartFlash(GPS_AssistFormat_t Format,const uint8_t *Flash,uint32_t Size,const GPS_AssistTime_t *Time)
+{
+	if(Flash==NULL)
+		return 0;
+	return GPS_Assist_Begin(Format,NULL,Flash,Size,Time);
+}
+//##################################################################################################################
+void	GPS_Assist_Stop(void)
+{
+	GPS_Assist.State=GPS_ASSIST_IDLE;
+}
+//##################################################################################################################
+void	GPS_Assist_TxCallBack(void)
+{
+	GPS_Assist.TxBusy=0;
+	GPS_Assist.LastTime=HAL_GetTick();
+	if(GPS_Assist.Format==GPS_ASSIST_UBX_ANO)
+		GPS_Assist.txIndex=0;
+}
+//##################################################################################################################
+static void	GPS_Assist_ProcessUbx(void)
+{
+	if(GPS_Assist.Outstanding>0)
+	{
+		if(HAL_GetTick()-GPS_Assist.LastTime<_GPS_ASSIST_TIMEOUT)
+			return;
+		GPS_Assist.Timeouts+=GPS_Assist.Outstanding;
+		GPS_Assist.Outstanding=0;
+	}
+	#if (_GPS_ASSIST_ACK==0)
+	if(HAL_GetTick()-GPS_Assist.LastTime<_GPS_ASSIST_GAP)
+		return;
+	#endif
+	if(GPS_Assist.Phase==0)
+	{
+		GPS_Assist_UbxTime();
+		#if (_GPS_ASSIST_ACK==1)
+		GPS_Assist.Outstanding=1;
+		#endif
+		GPS_Assist.Phase=1;
+		GPS_Assist_Send();
+		return;
+	}
+	if(GPS_Assist_UbxFill())
+		GPS_Assist_Send();
+	else if(GPS_Assist.Offset>=GPS_Assist.Size)
+		GPS_Assist.State=GPS_ASSIST_DONE;
+}
+//##################################################################################################################
+static void	GPS_Assist_ProcessEpo(void)
+{
+	switch(GPS_Assist.Phase)
+	{
+		case 0:
+			memcpy(GPS_Assist.txBuffer,"$PMTK253,1,0*37\r\n",17);
+			GPS_Assist.txIndex=17;
+			GPS_Assist.Phase=1;
+			GPS_Assist_Send();
+		return;
+		case 1:
+			if(HAL_GetTick()-GPS_Assist.LastTime<100)
+				return;
+			GPS_Assist.Phase=2;
+			GPS_Assist.txIndex=0;
+		break;
+	}
+	if(GPS_Assist.Outstanding>0)
+	{
+		if(HAL_GetTick()-GPS_Assist.LastTime<_GPS_ASSIST_TIMEOUT)
+			return;
+		GPS_Assist.Timeouts++;
+		if(++GPS_Assist.Retry>GPS_ASSIST_RETRY)
+		{
+			GPS_Assist.State=GPS_ASSIST_ERROR;
+			return;
+		}
+		GPS_Assist_Send();
+		return;
+	}
+	switch(GPS_Assist.Phase)
+	{
+		case 2:
+			if(GPS_Assist.Offset<GPS_Assist.End)
+				GPS_Assist_EpoFill(GPS_Assist.EpoSeq);
+			else
+			{
+				GPS_Assist_EpoFill(0xFFFF);
+				GPS_Assist.Phase=3;
+			}
+			GPS_Assist_Send();
+		break;
+		case 3:
+		{
+			//	back to NMEA, keep current baudrate
+			uint8_t	mode[5]={0,0,0,0,0};
+			GPS_Assist.txIndex=GPS_Assist_MtkPacket(GPS_Assist.txBuffer,253,mode,sizeof(mode));
+			GPS_Assist.Phase=4;
+			GPS_Assist_Send();
+		}
+		break;
+		default:
+			GPS_Assist.State=GPS_ASSIST_DONE;
+		break;
+	}
+}
+//##################################################################################################################
+void	GPS_Assist_Process(void)
+{
+	if((GPS_Assist.State!=GPS_ASSIST_BUSY) || (GPS_Assist.TxBusy))
+		return;
+	if(GPS_Assist.Format==GPS_ASSIST_UBX_ANO)
+		GPS_Assist_ProcessUbx();
+	else
+		GPS_Assist_ProcessEpo();
+}
+//##################################################################################################################
+static void	GPS_Assist_RxFrame(void)
+{
+	uint8_t	*f=GPS_Assist.rxBuffer;
+	if(f[0]==0xB5)
+	{
+		uint8_t	a=0,b=0;
+		for(uint8_t i=2 ; i<GPS_Assist.rxLen-2 ; i++)
+		{
+			a+=f[i];
+			b+=a;
+		}
+		if((a!=f[GPS_Assist.rxLen-2]) || (b!=f[GPS_Assist.rxLen-1]))
+			return;
+		if((f[2]!=0x13) || (f[3]!=0x60) || (GPS_Assist.rxLen!=16) || (GPS_Assist.Outstanding==0))
+			return;
+		GPS_Assist.Outstanding--;
+		if(f[6]==1)
+			GPS_Assist.Acked++;
+		else
+			GPS_Assist.Nacked++;
+	}
+	else
+	{
+		uint8_t	cs=0;
+		for(uint8_t i=2 ; i<GPS_Assist.rxLen-3 ; i++)
+			cs^=f[i];
+		if((cs!=f[GPS_Assist.rxLen-3]) || (f[4]!=2) || (f[5]!=0) || (GPS_Assist.rxLen!=12))
+			return;
+		if((f[6] | (f[7]<<8))!=GPS_Assist.EpoSeq)
+			return;
+		if(f[8]==1)
+		{
+			GPS_Assist.Acked++;
+			GPS_Assist.Outstanding=0;
+			GPS_Assist.txIndex=0;
+			if(GPS_Assist.EpoSeq!=0xFFFF)
+				GPS_Assist.EpoSeq++;
+		}
+		else
+		{
+			//	force a resend on the next process call
+			GPS_Assist.Nacked++;
+			GPS_Assist.LastTime=HAL_GetTick()-_GPS_ASSIST_TIMEOUT;
+			return;
+		}
+	}
+	GPS_Assist.LastTime=HAL_GetTick();
+}
+//##################################################################################################################
+void	GPS_Assist_RxByte(uint8_t Data)
+{
+	if(GPS_Assist.State!=GPS_ASSIST_BUSY)
+		return;
+	uint8_t	i=GPS_Assist.rxIndex;
+	if(i==0)
+	{
+		if((Data==0xB5) || (Data==0x04))
+			GPS_Assist.rxBuffer[GPS_Assist.rxIndex++]=Data;
+		return;
+	}
+	if((i==1) && (Data!=(GPS_Assist.rxBuffer[0]==0xB5 ? 0x62 : 0x24)))
+	{
+		GPS_Assist.rxIndex=0;
+		return;
+	}
+	GPS_Assist.rxBuffer[GPS_Assist.rxIndex++]=Data;
+	if(GPS_Assist.rxIndex==6)
+	{
+		if(GPS_Assist.rxBuffer[0]==0xB5)
+			GPS_Assist.rxLen=(GPS_Assist.rxBuffer[4] | (GPS_Assist.rxBuffer[5]<<8))+8;
+		else
+			GPS_Assist.rxLen=GPS_Assist.rxBuffer[2] | (GPS_Assist.rxBuffer[3]<<8);
+		if((GPS_Assist.rxLen>sizeof(GPS_Assist.rxBuffer)) || (GPS_Assist.rxLen<8))
+			GPS_Assist.rxIndex=0;
+		return;
+	}
+	if((GPS_Assist.rxIndex>6) && (GPS_Assist.rxIndex==GPS_Assist.rxLen))
+	{
+		GPS_Assist_RxFrame();
+		GPS_Assist.rxIndex=0;
+	}
+}
+//##################################################################################################################
+
+#endif
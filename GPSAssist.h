@@ -0,0 +1,87 @@
+#ifndef _GPSASSIST_H_
+#define _GPSASSIST_H_
+
+#include <stdint.h>
+#include "GPSConfig.h"
+
+//##################################################################################################################
+//	Offline assistance loader. Streams a u-blox AssistNow Offline file (MGA-ANO records) or a MediaTek EPO file
+//	from flash or from any reader into the receiver, keeping only the records valid for the given date.
+//##################################################################################################################
+
+typedef enum
+{
+	GPS_ASSIST_UBX_ANO=0,
+	GPS_ASSIST_MTK_EPO,
+
+}GPS_AssistFormat_t;
+
+typedef enum
+{
+	GPS_ASSIST_IDLE=0,
+	GPS_ASSIST_BUSY,
+	GPS_ASSIST_DONE,
+	GPS_ASSIST_ERROR,
+
+}GPS_AssistState_t;
+
+typedef struct
+{
+	uint16_t		Year;
+	uint8_t			Month;
+	uint8_t			Day;
+	uint8_t			Hour;
+	uint8_t			Min;
+	uint8_t			Sec;
+
+}GPS_AssistTime_t;
+
+//	returns number of bytes copied to Data, 0 at end of file
+typedef uint32_t	(*GPS_AssistRead_t)(uint32_t Offset,uint8_t *Data,uint32_t Size);
+
+typedef struct
+{
+	GPS_AssistFormat_t	Format;
+	volatile GPS_AssistState_t	State;
+	GPS_AssistRead_t		Read;
+	const uint8_t				*Flash;
+	uint32_t						Size;
+	uint32_t						Offset;
+	uint32_t						End;
+	GPS_AssistTime_t		Time;
+	uint32_t						FirstDay;
+	uint32_t						LastDay;
+	uint32_t						GpsHour;
+	uint8_t							Phase;
+
+	uint16_t						Sent;
+	uint16_t						Acked;
+	uint16_t						Nacked;
+	uint16_t						Timeouts;
+	uint16_t						Skipped;
+	uint16_t						EpoSeq;
+	uint8_t							Retry;
+	volatile uint8_t		Outstanding;
+	volatile uint8_t		TxBusy;
+	uint32_t						LastTime;
+
+	uint8_t							txBuffer[_GPS_ASSIST_CHUNK];
+	uint16_t						txIndex;
+
+	uint8_t							rxBuffer[16];
+	uint8_t							rxIndex;
+	uint16_t						rxLen;
+
+}GPS_Assist_t;
+
+extern GPS_Assist_t GPS_Assist;
+//##################################################################################################################
+uint8_t	GPS_Assist_Start(GPS_AssistFormat_t Format,GPS_AssistRead_t Read,uint32_t Size,const GPS_AssistTime_t *Time);
+uint8_t	GPS_Assist_StartFlash(GPS_AssistFormat_t Format,const uint8_t *Flash,uint32_t Size,const GPS_AssistTime_t *Time);
+void		GPS_Assist_Stop(void);
+void		GPS_Assist_Process(void);
+void		GPS_Assist_TxCallBack(void);
+void		GPS_Assist_RxByte(uint8_t Data);
+//##################################################################################################################
+
+#endif
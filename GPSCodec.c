@@ -0,0 +1,1202 @@
+#include "GPSConfig.h"
+
+#if (_GPS_CODEC==1)
+
+#if (_GPS_HOST==0)
+#error "GPSCodec needs _GPS_HOST"
+#endif
+
+#include "GPSCodec.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#if defined(__BYTE_ORDER__) && (__BYTE_ORDER__!=__ORDER_LITTLE_ENDIAN__)
+#error "GPSCodec writes its header little-endian"
+#endif
+
+typedef char	GPS_CodecHeaderSize[(sizeof(GPS_CodecHeader_t)==16) ? 1 : -1];
+
+//	11-bit probabilities of a zero, moved by 1/32 of the error each time
+#define	GPS_CODEC_BITS							11
+#define	GPS_CODEC_HALF							(1<<(GPS_CODEC_BITS-1))
+#define	GPS_CODEC_ADAPT							5
+#define	GPS_CODEC_TOP							(1U<<24)
+//	longer lines are cut and kept as bytes
+#define	GPS_CODEC_LINE							4096
+#define	GPS_CODEC_ADDRESS						8
+#define	GPS_CODEC_KEY							16
+#define	GPS_CODEC_DIGITS						18
+#define	GPS_CODEC_OUTPUT						65536
+//	numbers that changed lately, searched for the source of a field that keeps missing
+#define	GPS_CODEC_RECENT						32
+//	sentence symbols past the type table, sent with a 6-bit tree
+#define	GPS_CODEC_NEW							GPS_CODEC_TYPES
+#define	GPS_CODEC_RAW							(GPS_CODEC_TYPES+1)
+#define	GPS_CODEC_END							(GPS_CODEC_TYPES+2)
+#define	GPS_CODEC_SYMBOLS						64
+
+typedef char	GPS_CodecSymbols[(GPS_CODEC_END<GPS_CODEC_SYMBOLS) ? 1 : -1];
+typedef char	GPS_CodecSlots[(GPS_CODEC_FIELDS==32) && (GPS_CODEC_TYPES<=2048) ? 1 : -1];
+
+enum
+{
+	GPS_CODEC_EMPTY=0,
+	GPS_CODEC_NUMBER,
+	GPS_CODEC_STRING,
+};
+
+//	magnitudes: bit length, the two bits under the leading one modelled, the rest sent flat
+typedef struct
+{
+	uint16_t		Zero;
+	uint16_t		Sign;
+	uint16_t		Length[64];
+	uint16_t		High[64][4];
+
+}GPS_CodecInt_t;
+
+typedef struct GPS_CodecField_s
+{
+	uint64_t		Value;
+	uint64_t		Step;
+	const struct GPS_CodecField_s	*Source;		//	same value in another sentence type, decoded just before
+	int32_t			Score;									//	below zero while the last step predicts better than the last value
+	uint8_t			Class;
+	uint8_t			Digits;
+	uint8_t			Point;
+	uint8_t			Fraction;
+	uint8_t			Length;
+	char				Text[GPS_CODEC_TEXT+1];		//	last text, numbers as the decoder printed them
+	uint16_t		Same[4];
+	uint16_t		Number;
+	uint16_t		Kind[4];
+
+}GPS_CodecField_t;
+
+typedef struct
+{
+	char				Key[GPS_CODEC_KEY];
+	uint8_t			KeyLength;
+	char				Address[GPS_CODEC_ADDRESS];
+	uint8_t			Size;
+	uint8_t			Fields;
+	uint32_t		Mask;										//	fields that missed their prediction last time
+	uint16_t		Count;
+	uint16_t		Pattern;
+	GPS_CodecField_t	Field[GPS_CODEC_FIELDS];
+	//	kept apart so the state read on every sentence stays in a few cache lines
+	GPS_CodecInt_t		Residual[GPS_CODEC_FIELDS];
+
+}GPS_CodecType_t;
+
+typedef struct
+{
+	uint16_t		Symbol[GPS_CODEC_SYMBOLS][GPS_CODEC_SYMBOLS];
+	uint16_t		Hit[GPS_CODEC_SYMBOLS];
+	uint8_t			Next[GPS_CODEC_SYMBOLS];					//	symbol that followed last time
+	uint16_t		Byte[256][256];
+	GPS_CodecInt_t	Fields;
+	GPS_CodecInt_t	Format;
+	GPS_CodecInt_t	Length;
+	uint32_t		Previous;
+	uint32_t		Types;
+	uint16_t		Recent[GPS_CODEC_RECENT];
+	uint64_t		RecentValue[GPS_CODEC_RECENT];			//	value it changed to, the newest entry of a slot is current
+	uint32_t		Count;
+	GPS_CodecType_t	Type[GPS_CODEC_TYPES];
+
+}GPS_CodecModel_t;
+
+typedef struct
+{
+	uint64_t		Low;
+	uint32_t		Range;
+	uint8_t			Cache;
+	uint64_t		Pending;
+	uint8_t			*Buffer;
+	uint32_t		Used;
+	uint8_t			Error;
+	uint64_t		Total;
+	GPS_CodecWrite_t	Write;
+	void				*Context;
+
+}GPS_CodecEncoder_t;
+
+typedef struct
+{
+	uint32_t		Range;
+	uint32_t		Code;
+	const uint8_t	*In;
+	const uint8_t	*End;
+
+}GPS_CodecDecoder_t;
+
+typedef struct
+{
+	const char	*Data;
+	uint32_t		Length;
+
+}GPS_CodecSpan_t;
+
+typedef struct
+{
+	uint64_t		Value;
+	uint64_t		Residual;
+	uint8_t			Class;
+	uint8_t			Digits;
+	uint8_t			Point;
+	uint8_t			Fraction;
+	uint8_t			Format;									//	number with the layout of the last one
+	uint8_t			Same;
+
+}GPS_CodecValue_t;
+
+static const char	GPS_CodecHex[]="0123456789ABCDEF";
+static const char	GPS_CodecPairs[]=
+	"00010203040506070809101112131415161718192021222324252627282930313233343536373839404142434445464748495051525354555657585960616263646566676869"
+	"7071727374757677787980818283848586878889909192939495969798990";
+static const uint64_t	GPS_CodecPower[GPS_CODEC_DIGITS+1]=
+{
+	1ULL,10ULL,100ULL,1000ULL,10000ULL,100000ULL,1000000ULL,10000000ULL,100000000ULL,1000000000ULL,10000000000ULL,
+	100000000000ULL,1000000000000ULL,10000000000000ULL,100000000000000ULL,1000000000000000ULL,10000000000000000ULL,
+	100000000000000000ULL,1000000000000000000ULL
+};
+//##################################################################################################################
+static double	GPS_Codec_Now(void)
+{
+	struct timespec	ts;
+	clock_gettime(CLOCK_MONOTONIC,&ts);
+	return ts.tv_sec+ts.tv_nsec*1e-9;
+}
+//##################################################################################################################
+static void	GPS_Codec_Probs(uint16_t *Prob,uint32_t Count)
+{
+	for(uint32_t i=0 ; i<Count ; i++)
+		Prob[i]=GPS_CODEC_HALF;
+}
+//##################################################################################################################
+static void	GPS_Codec_Reset(GPS_CodecModel_t *Model)
+{
+	//	types are cleared when they are first seen, the table is too large to touch up front
+	GPS_Codec_Probs(&Model->Symbol[0][0],sizeof(Model->Symbol)/2);
+	GPS_Codec_Probs(Model->Hit,GPS_CODEC_SYMBOLS);
+	memset(Model->Next,GPS_CODEC_END,sizeof(Model->Next));
+	GPS_Codec_Probs(&Model->Byte[0][0],sizeof(Model->Byte)/2);
+	GPS_Codec_Probs((uint16_t*)&Model->Fields,sizeof(GPS_CodecInt_t)/2);
+	GPS_Codec_Probs((uint16_t*)&Model->Format,sizeof(GPS_CodecInt_t)/2);
+	GPS_Codec_Probs((uint16_t*)&Model->Length,sizeof(GPS_CodecInt_t)/2);
+	Model->Previous=GPS_CODEC_END;
+	Model->Types=0;
+	Model->Count=0;
+}
+//##################################################################################################################
+static GPS_CodecType_t	*GPS_Codec_NewType(GPS_CodecModel_t *Model,const char *Address,uint8_t Size)
+{
+	GPS_CodecType_t	*t=&Model->Type[Model->Types++];
+	memset(t,0,sizeof(GPS_CodecType_t));
+	memcpy(t->Address,Address,Size);
+	t->Size=Size;
+	t->Count=GPS_CODEC_HALF;
+	t->Pattern=GPS_CODEC_HALF;
+	for(uint8_t i=0 ; i<GPS_CODEC_FIELDS ; i++)
+	{
+		GPS_CodecField_t	*f=&t->Field[i];
+		GPS_Codec_Probs(f->Same,4);
+		GPS_Codec_Probs(&f->Number,1);
+		GPS_Codec_Probs(f->Kind,4);
+	}
+	GPS_Codec_Probs((uint16_t*)t->Residual,sizeof(t->Residual)/2);
+	return t;
+}
+//##################################################################################################################
+static inline uint8_t	GPS_Codec_Bits(uint64_t Value)
+{
+	return (Value==0) ? 0 : (uint8_t)(64-__builtin_clzll(Value));
+}
+//##################################################################################################################
+static void	GPS_Codec_Update(GPS_CodecField_t *Field,uint64_t Value)
+{
+	//	both predictors are scored on every value, the score decays so the choice follows the recent past
+	uint64_t	r1=Value-Field->Value;
+	uint64_t	r2=r1-Field->Step;
+	int32_t		d=GPS_Codec_Bits(((int64_t)r2<0) ? 0-r2 : r2)-GPS_Codec_Bits(((int64_t)r1<0) ? 0-r1 : r1);
+	Field->Score+=d*16-(Field->Score>>4);
+	Field->Step=r1;
+	Field->Value=Value;
+}
+//##################################################################################################################
+static inline uint64_t	GPS_Codec_Predict(const GPS_CodecField_t *Field)
+{
+	if(Field->Source!=NULL)
+		return Field->Source->Value;
+	return (Field->Score<0) ? Field->Value+Field->Step : Field->Value;
+}
+//##################################################################################################################
+static void	GPS_Codec_Remember(GPS_CodecModel_t *Model,GPS_CodecField_t *Field,uint32_t Slot,uint64_t Value,uint8_t Miss)
+{
+	//	GNS, RMC or GLL repeat the time and position of the GGA before them. A field that missed looks for a
+	//	number of the same layout and value among the last ones changed in other sentence types, and follows it
+	//	while it holds. Sources in the same sentence are left out, the encoder predicts a sentence at once.
+	//	The ring keeps the values, so only a match touches the field.
+	if(Miss==1)
+	{
+		Field->Source=NULL;
+		for(uint32_t i=1 ; (i<=GPS_CODEC_RECENT) && (i<=Model->Count) ; i++)
+		{
+			uint32_t	k=(Model->Count-i) % GPS_CODEC_RECENT;
+			uint16_t	s=Model->Recent[k];
+			const GPS_CodecField_t	*f;
+			if(Model->RecentValue[k]!=Value)
+				continue;
+			f=&Model->Type[s>>5].Field[s & 31];
+			if(((s>>5)!=(Slot>>5)) && (f->Value==Value) && (f->Class==GPS_CODEC_NUMBER) && (f->Digits==Field->Digits) &&
+				(f->Point==Field->Point) && (f->Fraction==Field->Fraction))
+			{
+				Field->Source=f;
+				break;
+			}
+		}
+	}
+	if(Value!=Field->Value)
+	{
+		Model->Recent[Model->Count % GPS_CODEC_RECENT]=(uint16_t)Slot;
+		Model->RecentValue[Model->Count++ % GPS_CODEC_RECENT]=Value;
+	}
+	GPS_Codec_Update(Field,Value);
+}
+//##################################################################################################################
+//	encoder
+//##################################################################################################################
+static void	GPS_Codec_Emit(GPS_CodecEncoder_t *Enc,uint8_t Byte)
+{
+	Enc->Buffer[Enc->Used++]=Byte;
+	if(Enc->Used==GPS_CODEC_OUTPUT)
+	{
+		if(Enc->Write(Enc->Context,Enc->Buffer,Enc->Used)!=Enc->Used)
+			Enc->Error=1;
+		Enc->Total+=Enc->Used;
+		Enc->Used=0;
+	}
+}
+//##################################################################################################################
+static void	GPS_Codec_ShiftLow(GPS_CodecEncoder_t *Enc)
+{
+	//	bytes are held back while a carry could still ripple into them
+	if(((uint32_t)Enc->Low<0xFF000000U) || ((Enc->Low>>32)!=0))
+	{
+		uint8_t	carry=(uint8_t)(Enc->Low>>32);
+		uint8_t	b=Enc->Cache;
+		do
+		{
+			GPS_Codec_Emit(Enc,(uint8_t)(b+carry));
+			b=0xFF;
+		}while(--Enc->Pending!=0);
+		Enc->Cache=(uint8_t)(Enc->Low>>24);
+	}
+	Enc->Pending++;
+	Enc->Low=(Enc->Low & 0x00FFFFFFU)<<8;
+}
+//##################################################################################################################
+static inline void	GPS_Codec_Put(GPS_CodecEncoder_t *Enc,uint16_t *Prob,uint32_t Bit)
+{
+	uint32_t	bound=(Enc->Range>>GPS_CODEC_BITS)*(*Prob);
+	if(Bit==0)
+	{
+		Enc->Range=bound;
+		*Prob+=((1<<GPS_CODEC_BITS)-*Prob)>>GPS_CODEC_ADAPT;
+	}
+	else
+	{
+		Enc->Low+=bound;
+		Enc->Range-=bound;
+		*Prob-=*Prob>>GPS_CODEC_ADAPT;
+	}
+	while(Enc->Range<GPS_CODEC_TOP)
+	{
+		Enc->Range<<=8;
+		GPS_Codec_ShiftLow(Enc);
+	}
+}
+//##################################################################################################################
+static void	GPS_Codec_PutFlat(GPS_CodecEncoder_t *Enc,uint64_t Value,uint8_t Count)
+{
+	while(Count-->0)
+	{
+		Enc->Range>>=1;
+		if((Value>>Count) & 1)
+			Enc->Low+=Enc->Range;
+		if(Enc->Range<GPS_CODEC_TOP)
+		{
+			Enc->Range<<=8;
+			GPS_Codec_ShiftLow(Enc);
+		}
+	}
+}
+//##################################################################################################################
+static void	GPS_Codec_PutTree(GPS_CodecEncoder_t *Enc,uint16_t *Prob,uint32_t Value,uint8_t Count)
+{
+	uint32_t	m=1;
+	while(Count-->0)
+	{
+		uint32_t	b=(Value>>Count) & 1;
+		GPS_Codec_Put(Enc,&Prob[m],b);
+		m=(m<<1) | b;
+	}
+}
+//##################################################################################################################
+static void	GPS_Codec_PutMagnitude(GPS_CodecEncoder_t *Enc,GPS_CodecInt_t *Model,uint64_t Value)
+{
+	//	Value>0
+	uint8_t	n=GPS_Codec_Bits(Value);
+	GPS_Codec_PutTree(Enc,Model->Length,n-1,6);
+	if(n==2)
+		GPS_Codec_Put(Enc,&Model->High[1][1],(uint32_t)Value & 1);
+	else if(n>2)
+	{
+		GPS_Codec_PutTree(Enc,Model->High[n-1],(uint32_t)(Value>>(n-3)) & 3,2);
+		GPS_Codec_PutFlat(Enc,Value,n-3);
+	}
+}
+//##################################################################################################################
+static void	GPS_Codec_PutSigned(GPS_CodecEncoder_t *Enc,GPS_CodecInt_t *Model,uint64_t Value,uint8_t NonZero)
+{
+	if(NonZero==0)
+	{
+		GPS_Codec_Put(Enc,&Model->Zero,Value==0);
+		if(Value==0)
+			return;
+	}
+	GPS_Codec_Put(Enc,&Model->Sign,(int64_t)Value<0);
+	GPS_Codec_PutMagnitude(Enc,Model,((int64_t)Value<0) ? 0-Value : Value);
+}
+//##################################################################################################################
+static void	GPS_Codec_PutBytes(GPS_CodecEncoder_t *Enc,GPS_CodecModel_t *Model,const char *Data,uint32_t Len,uint8_t Context)
+{
+	GPS_Codec_PutMagnitude(Enc,&Model->Length,(uint64_t)Len+1);
+	for(uint32_t i=0 ; i<Len ; i++)
+	{
+		GPS_Codec_PutTree(Enc,Model->Byte[Context],(uint8_t)Data[i],8);
+		Context=(uint8_t)Data[i];
+	}
+}
+//##################################################################################################################
+static void	GPS_Codec_PutSymbol(GPS_CodecEncoder_t *Enc,GPS_CodecModel_t *Model,uint32_t Symbol)
+{
+	//	the type sequence of a receiver hardly changes, the one that followed last time costs a single bit
+	uint32_t	hit=(Symbol==Model->Next[Model->Previous]);
+	GPS_Codec_Put(Enc,&Model->Hit[Model->Previous],hit);
+	if(hit==0)
+		GPS_Codec_PutTree(Enc,Model->Symbol[Model->Previous],Symbol,6);
+}
+//##################################################################################################################
+static void	GPS_Codec_Follow(GPS_CodecModel_t *Model,uint32_t Symbol)
+{
+	Model->Next[Model->Previous]=(uint8_t)Symbol;
+	Model->Previous=Symbol;
+}
+//##################################################################################################################
+static uint8_t	GPS_Codec_ParseNumber(const char *Data,uint32_t Len,GPS_CodecValue_t *Number)
+{
+	//	-?D*(.D*)? with 1..18 digits, whatever does not come back byte for byte stays text
+	uint32_t	i=0;
+	uint64_t	v=0;
+	uint8_t		neg=0;
+	Number->Digits=0;
+	Number->Point=0;
+	Number->Fraction=0;
+	if((Len>0) && (Data[0]=='-'))
+	{
+		neg=1;
+		i=1;
+	}
+	for( ; (i<Len) && (Data[i]>='0') && (Data[i]<='9') && (Number->Digits<GPS_CODEC_DIGITS) ; i++,Number->Digits++)
+		v=v*10+(uint64_t)(Data[i]-'0');
+	if((i<Len) && (Data[i]=='.'))
+	{
+		Number->Point=1;
+		for(i++ ; (i<Len) && (Data[i]>='0') && (Data[i]<='9') && (Number->Digits+Number->Fraction<GPS_CODEC_DIGITS) ; i++,Number->Fraction++)
+			v=v*10+(uint64_t)(Data[i]-'0');
+	}
+	if((i!=Len) || (Number->Digits+Number->Fraction==0) || ((neg==1) && (v==0)))
+		return 0;
+	Number->Value=(neg==1) ? 0-v : v;
+	return 1;
+}
+//##################################################################################################################
+static void	GPS_Codec_Classify(const GPS_CodecField_t *Field,const GPS_CodecSpan_t *Span,GPS_CodecValue_t *Value)
+{
+	Value->Class=(Span->Length==0) ? GPS_CODEC_EMPTY : (GPS_Codec_ParseNumber(Span->Data,Span->Length,Value)==1) ? GPS_CODEC_NUMBER : GPS_CODEC_STRING;
+	Value->Format=(Value->Class==GPS_CODEC_NUMBER) && (Field->Class==GPS_CODEC_NUMBER) && (Value->Digits==Field->Digits) &&
+		(Value->Point==Field->Point) && (Value->Fraction==Field->Fraction);
+	if(Value->Class==GPS_CODEC_NUMBER)
+		Value->Residual=Value->Value-GPS_Codec_Predict(Field);
+	if(Value->Class!=Field->Class)
+		Value->Same=0;
+	else if(Value->Class==GPS_CODEC_NUMBER)
+		Value->Same=(Value->Format==1) && (Value->Residual==0);
+	else if(Value->Class==GPS_CODEC_STRING)
+		Value->Same=(Field->Length<=GPS_CODEC_TEXT) && (Span->Length==Field->Length) && (memcmp(Span->Data,Field->Text,Span->Length)==0);
+	else
+		Value->Same=1;
+}
+//##################################################################################################################
+static void	GPS_Codec_PutField(GPS_CodecEncoder_t *Enc,GPS_CodecModel_t *Model,uint32_t Slot,const GPS_CodecSpan_t *Span,const GPS_CodecValue_t *Value)
+{
+	GPS_CodecField_t	*Field=&Model->Type[Slot>>5].Field[Slot & 31];
+	GPS_CodecInt_t		*Residual=&Model->Type[Slot>>5].Residual[Slot & 31];
+	if(Value->Same==0)
+	{
+		//	a number that keeps its layout is the common miss, it skips the class and the zero test
+		if(Field->Class==GPS_CODEC_NUMBER)
+			GPS_Codec_Put(Enc,&Field->Number,Value->Format);
+		if(Value->Format==1)
+			GPS_Codec_PutSigned(Enc,Residual,Value->Residual,1);
+		else
+		{
+			GPS_Codec_PutTree(Enc,Field->Kind,Value->Class,2);
+			if(Value->Class==GPS_CODEC_NUMBER)
+			{
+				GPS_Codec_PutMagnitude(Enc,&Model->Format,((uint64_t)Value->Point<<10 | (uint64_t)Value->Digits<<5 | Value->Fraction)+1);
+				GPS_Codec_PutSigned(Enc,Residual,Value->Residual,0);
+			}
+			else if(Value->Class==GPS_CODEC_STRING)
+				GPS_Codec_PutBytes(Enc,Model,Span->Data,Span->Length,',');
+		}
+	}
+	Field->Class=Value->Class;
+	if(Value->Class==GPS_CODEC_NUMBER)
+	{
+		Field->Digits=Value->Digits;
+		Field->Point=Value->Point;
+		Field->Fraction=Value->Fraction;
+		GPS_Codec_Remember(Model,Field,Slot,Value->Value,Value->Same==0);
+	}
+	else if(Value->Class==GPS_CODEC_STRING)
+	{
+		Field->Length=(Span->Length<=GPS_CODEC_TEXT) ? (uint8_t)Span->Length : 0xFF;
+		if(Span->Length<=GPS_CODEC_TEXT)
+			memcpy(Field->Text,Span->Data,Span->Length);
+	}
+}
+//##################################################################################################################
+static uint8_t	GPS_Codec_PutSentence(GPS_CodecEncoder_t *Enc,GPS_CodecModel_t *Model,const char *Line,uint32_t Len)
+{
+	//	$<address>[,field]*<HH>\r\n with a checksum that verifies, 0 when the line has to go as bytes
+	GPS_CodecSpan_t		span[GPS_CODEC_FIELDS];
+	GPS_CodecValue_t	value[GPS_CODEC_FIELDS];
+	GPS_CodecType_t		*t=NULL;
+	char			key[GPS_CODEC_KEY];
+	uint32_t	end=Len-5;
+	uint32_t	i,n=0,size,keyLength,symbol,mask=0;
+	uint8_t		sum=0,hi,lo,same=1;
+	if((Len<7) || (Len>GPS_CODEC_LINE) || (Line[0]!='$') || (Line[end]!='*') || (Line[Len-2]!='\r') || (Line[Len-1]!='\n'))
+		return 0;
+	hi=(uint8_t)Line[end+1];
+	lo=(uint8_t)Line[end+2];
+	if((((hi<'0') || (hi>'9')) && ((hi<'A') || (hi>'F'))) || (((lo<'0') || (lo>'9')) && ((lo<'A') || (lo>'F'))))
+		return 0;
+	for(i=1 ; i<end ; i++)
+	{
+		uint8_t	c=(uint8_t)Line[i];
+		if((c<0x20) || (c>0x7E) || (c=='*') || (c=='$'))
+			return 0;
+		sum^=c;
+	}
+	if(sum!=(uint8_t)((((hi<='9') ? hi-'0' : hi-'A'+10)<<4) | ((lo<='9') ? lo-'0' : lo-'A'+10)))
+		return 0;
+	for(size=0 ; (1+size<end) && (Line[1+size]!=',') ; size++)
+		if(((Line[1+size]<'A') || (Line[1+size]>'Z')) && ((Line[1+size]<'0') || (Line[1+size]>'9')))
+			return 0;
+	if((size==0) || (size>GPS_CODEC_ADDRESS))
+		return 0;
+	for(i=1+size ; i<end ; )
+	{
+		uint32_t	s=++i;
+		if(n==GPS_CODEC_FIELDS)
+			return 0;
+		while((i<end) && (Line[i]!=','))
+			i++;
+		span[n].Data=&Line[s];
+		span[n++].Length=i-s;
+	}
+	//	GSV pages rotate, each page number gets its own type so its fields are predicted from the same page
+	memcpy(key,&Line[1],size);
+	keyLength=size;
+	if((size>=3) && (memcmp(&Line[size-2],"GSV",3)==0) && (n>=2) && (span[1].Length<GPS_CODEC_KEY-size))
+	{
+		memcpy(&key[keyLength],span[1].Data,span[1].Length);
+		keyLength+=span[1].Length;
+	}
+	for(symbol=0 ; symbol<Model->Types ; symbol++)
+		if((Model->Type[symbol].KeyLength==keyLength) && (memcmp(Model->Type[symbol].Key,key,keyLength)==0))
+			break;
+	if((symbol==Model->Types) && (Model->Types==GPS_CODEC_TYPES))
+		return 0;
+	GPS_Codec_PutSymbol(Enc,Model,(symbol==Model->Types) ? GPS_CODEC_NEW : symbol);
+	if(symbol==Model->Types)
+	{
+		GPS_Codec_PutBytes(Enc,Model,&Line[1],size,'$');
+		GPS_Codec_PutMagnitude(Enc,&Model->Fields,n+1);
+		t=GPS_Codec_NewType(Model,&Line[1],(uint8_t)size);
+		memcpy(t->Key,key,keyLength);
+		t->KeyLength=(uint8_t)keyLength;
+	}
+	else
+	{
+		t=&Model->Type[symbol];
+		GPS_Codec_Put(Enc,&t->Count,n!=t->Fields);
+		if(n!=t->Fields)
+			GPS_Codec_PutMagnitude(Enc,&Model->Fields,n+1);
+	}
+	t->Fields=(uint8_t)n;
+	GPS_Codec_Follow(Model,symbol);
+	//	the set of fields that miss their prediction tends to repeat, one bit when it does
+	for(i=0 ; i<n ; i++)
+	{
+		GPS_Codec_Classify(&t->Field[i],&span[i],&value[i]);
+		mask|=(uint32_t)(value[i].Same==0)<<i;
+	}
+	GPS_Codec_Put(Enc,&t->Pattern,mask!=t->Mask);
+	if(mask!=t->Mask)
+		for(i=0 ; i<n ; i++)
+		{
+			GPS_Codec_Put(Enc,&t->Field[i].Same[same | ((t->Mask>>i) & 1)<<1],value[i].Same);
+			same=value[i].Same;
+		}
+	t->Mask=mask;
+	for(i=0 ; i<n ; i++)
+		GPS_Codec_PutField(Enc,Model,symbol<<5 | i,&span[i],&value[i]);
+	return 1;
+}
+//##################################################################################################################
+uint8_t	GPS_Codec_Encode(const uint8_t *Data,uint64_t Len,GPS_CodecWrite_t Write,void *Context,GPS_CodecStats_t *Stats)
+{
+	GPS_CodecEncoder_t	enc;
+	GPS_CodecModel_t		*model=(GPS_CodecModel_t*)malloc(sizeof(GPS_CodecModel_t));
+	GPS_CodecHeader_t		h={GPS_CODEC_MAGIC,GPS_CODEC_VERSION,Len};
+	uint8_t		*buffer=(uint8_t*)malloc(GPS_CODEC_OUTPUT);
+	double		t0=GPS_Codec_Now();
+	uint64_t	at=0;
+	memset(Stats,0,sizeof(GPS_CodecStats_t));
+	if((model==NULL) || (buffer==NULL))
+	{
+		free(model);
+		free(buffer);
+		return 0;
+	}
+	GPS_Codec_Reset(model);
+	memset(&enc,0,sizeof(enc));
+	enc.Range=0xFFFFFFFFU;
+	enc.Pending=1;
+	enc.Buffer=buffer;
+	enc.Write=Write;
+	enc.Context=Context;
+	if(Write(Context,&h,sizeof(h))!=sizeof(h))
+		enc.Error=1;
+	while((at<Len) && (enc.Error==0))
+	{
+		const uint8_t	*p=&Data[at];
+		uint64_t	rest=Len-at;
+		uint32_t	n=(rest<GPS_CODEC_LINE) ? (uint32_t)rest : GPS_CODEC_LINE;
+		const uint8_t	*eol=(const uint8_t*)memchr(p,'\n',n);
+		if(eol!=NULL)
+			n=(uint32_t)(eol-p)+1;
+		if(GPS_Codec_PutSentence(&enc,model,(const char*)p,n)==1)
+			Stats->Sentences++;
+		else
+		{
+			GPS_Codec_PutSymbol(&enc,model,GPS_CODEC_RAW);
+			GPS_Codec_PutBytes(&enc,model,(const char*)p,n,'\n');
+			GPS_Codec_Follow(model,GPS_CODEC_RAW);
+			Stats->Lines++;
+		}
+		at+=n;
+	}
+	GPS_Codec_PutSymbol(&enc,model,GPS_CODEC_END);
+	for(uint8_t i=0 ; i<5 ; i++)
+		GPS_Codec_ShiftLow(&enc);
+	if((enc.Used>0) && (Write(Context,buffer,enc.Used)!=enc.Used))
+		enc.Error=1;
+	Stats->Input=Len;
+	Stats->Output=enc.Total+enc.Used+sizeof(h);
+	Stats->Types=model->Types;
+	Stats->Seconds=GPS_Codec_Now()-t0;
+	free(model);
+	free(buffer);
+	return enc.Error==0;
+}
+//##################################################################################################################
+//	decoder
+//##################################################################################################################
+static inline uint32_t	GPS_Codec_Get(GPS_CodecDecoder_t *Dec,uint16_t *Prob)
+{
+	uint32_t	bound=(Dec->Range>>GPS_CODEC_BITS)*(*Prob);
+	uint32_t	bit;
+	if(Dec->Code<bound)
+	{
+		Dec->Range=bound;
+		*Prob+=((1<<GPS_CODEC_BITS)-*Prob)>>GPS_CODEC_ADAPT;
+		bit=0;
+	}
+	else
+	{
+		Dec->Code-=bound;
+		Dec->Range-=bound;
+		*Prob-=*Prob>>GPS_CODEC_ADAPT;
+		bit=1;
+	}
+	if(Dec->Range<GPS_CODEC_TOP)
+	{
+		Dec->Range<<=8;
+		Dec->Code=(Dec->Code<<8) | ((Dec->In<Dec->End) ? *Dec->In++ : 0);
+	}
+	return bit;
+}
+//##################################################################################################################
+static uint64_t	GPS_Codec_GetFlat(GPS_CodecDecoder_t *Dec,uint8_t Count)
+{
+	uint64_t	v=0;
+	while(Count-->0)
+	{
+		uint32_t	t;
+		Dec->Range>>=1;
+		Dec->Code-=Dec->Range;
+		t=0-(Dec->Code>>31);
+		Dec->Code+=Dec->Range & t;
+		v=(v<<1) | (t+1);
+		if(Dec->Range<GPS_CODEC_TOP)
+		{
+			Dec->Range<<=8;
+			Dec->Code=(Dec->Code<<8) | ((Dec->In<Dec->End) ? *Dec->In++ : 0);
+		}
+	}
+	return v;
+}
+//##################################################################################################################
+static inline uint32_t	GPS_Codec_GetTree(GPS_CodecDecoder_t *Dec,uint16_t *Prob,uint8_t Count)
+{
+	uint32_t	m=1;
+	for(uint8_t i=0 ; i<Count ; i++)
+		m=(m<<1) | GPS_Codec_Get(Dec,&Prob[m]);
+	return m-(1U<<Count);
+}
+//##################################################################################################################
+static uint64_t	GPS_Codec_GetMagnitude(GPS_CodecDecoder_t *Dec,GPS_CodecInt_t *Model)
+{
+	uint8_t		n=(uint8_t)GPS_Codec_GetTree(Dec,Model->Length,6)+1;
+	uint64_t	v;
+	if(n==1)
+		return 1;
+	if(n==2)
+		return 2 | GPS_Codec_Get(Dec,&Model->High[1][1]);
+	v=4 | GPS_Codec_GetTree(Dec,Model->High[n-1],2);
+	return (v<<(n-3)) | GPS_Codec_GetFlat(Dec,n-3);
+}
+//##################################################################################################################
+static uint64_t	GPS_Codec_GetSigned(GPS_CodecDecoder_t *Dec,GPS_CodecInt_t *Model,uint8_t NonZero)
+{
+	uint32_t	neg;
+	if((NonZero==0) && (GPS_Codec_Get(Dec,&Model->Zero)==1))
+		return 0;
+	neg=GPS_Codec_Get(Dec,&Model->Sign);
+	return (neg==1) ? 0-GPS_Codec_GetMagnitude(Dec,Model) : GPS_Codec_GetMagnitude(Dec,Model);
+}
+//##################################################################################################################
+static uint8_t	GPS_Codec_GetBytes(GPS_CodecDecoder_t *Dec,GPS_CodecModel_t *Model,char *Out,uint32_t *Len,uint8_t Context)
+{
+	uint64_t	n=GPS_Codec_GetMagnitude(Dec,&Model->Length)-1;
+	if(n>GPS_CODEC_LINE)
+		return 0;
+	for(uint32_t i=0 ; i<n ; i++)
+	{
+		Context=(uint8_t)GPS_Codec_GetTree(Dec,Model->Byte[Context],8);
+		Out[i]=(char)Context;
+	}
+	*Len=(uint32_t)n;
+	return 1;
+}
+//##################################################################################################################
+static uint32_t	GPS_Codec_GetSymbol(GPS_CodecDecoder_t *Dec,GPS_CodecModel_t *Model)
+{
+	if(GPS_Codec_Get(Dec,&Model->Hit[Model->Previous])==1)
+		return Model->Next[Model->Previous];
+	return GPS_Codec_GetTree(Dec,Model->Symbol[Model->Previous],6);
+}
+//##################################################################################################################
+static char	*GPS_Codec_Format(char *Out,GPS_CodecField_t *Field)
+{
+	//	exactly Digits.Fraction digits with leading zeros, printed backwards in place and kept for the next repeat
+	uint64_t	v=Field->Value;
+	char			*p=Out;
+	char			*q;
+	uint8_t		i;
+	if((int64_t)v<0)
+	{
+		*p++='-';
+		v=0-v;
+	}
+	p+=Field->Digits+Field->Point+Field->Fraction;
+	q=p;
+	for(i=Field->Fraction ; i>=2 ; i-=2,v/=100)
+	{
+		q-=2;
+		memcpy(q,&GPS_CodecPairs[(v%100)*2],2);
+	}
+	if(i==1)
+	{
+		*--q=(char)('0'+v%10);
+		v/=10;
+	}
+	if(Field->Point==1)
+		*--q='.';
+	for(i=Field->Digits ; i>=2 ; i-=2,v/=100)
+	{
+		q-=2;
+		memcpy(q,&GPS_CodecPairs[(v%100)*2],2);
+	}
+	if(i==1)
+		*--q=(char)('0'+v%10);
+	Field->Length=(uint8_t)(p-Out);
+	memcpy(Field->Text,Out,GPS_CODEC_TEXT+1);
+	return p;
+}
+//##################################################################################################################
+static char	*GPS_Codec_GetField(GPS_CodecDecoder_t *Dec,GPS_CodecModel_t *Model,uint32_t Slot,char *Out,uint8_t Same)
+{
+	GPS_CodecField_t	*Field=&Model->Type[Slot>>5].Field[Slot & 31];
+	GPS_CodecInt_t		*Residual=&Model->Type[Slot>>5].Residual[Slot & 31];
+	uint32_t	len,cls;
+	uint64_t	v,mag;
+	if(Same==1)
+	{
+		if((Field->Class==GPS_CODEC_NUMBER) && (Field->Step==0) && (Field->Source==NULL))
+		{
+			//	a number that stands still, what GPS_Codec_Update() comes down to
+			Field->Score-=Field->Score>>4;
+		}
+		else if(Field->Class==GPS_CODEC_NUMBER)
+		{
+			v=GPS_Codec_Predict(Field);
+			if(v!=Field->Value)
+			{
+				GPS_Codec_Remember(Model,Field,Slot,v,0);
+				return GPS_Codec_Format(Out,Field);
+			}
+			GPS_Codec_Update(Field,v);
+		}
+		else if(Field->Class==GPS_CODEC_EMPTY)
+			return Out;
+		else if(Field->Length>GPS_CODEC_TEXT)
+			return NULL;
+		//	the whole slot is copied, the line is built with room to spare and the tail is written over
+		memcpy(Out,Field->Text,GPS_CODEC_TEXT+1);
+		return Out+Field->Length;
+	}
+	if((Field->Class==GPS_CODEC_NUMBER) && (GPS_Codec_Get(Dec,&Field->Number)==1))
+		v=GPS_Codec_Predict(Field)+GPS_Codec_GetSigned(Dec,Residual,1);
+	else
+	{
+		cls=GPS_Codec_GetTree(Dec,Field->Kind,2);
+		if(cls==GPS_CODEC_EMPTY)
+		{
+			Field->Class=GPS_CODEC_EMPTY;
+			return Out;
+		}
+		if(cls==GPS_CODEC_STRING)
+		{
+			if(GPS_Codec_GetBytes(Dec,Model,Out,&len,',')==0)
+				return NULL;
+			Field->Class=GPS_CODEC_STRING;
+			Field->Length=(len<=GPS_CODEC_TEXT) ? (uint8_t)len : 0xFF;
+			if(len<=GPS_CODEC_TEXT)
+				memcpy(Field->Text,Out,len);
+			return Out+len;
+		}
+		if(cls!=GPS_CODEC_NUMBER)
+			return NULL;
+		mag=GPS_Codec_GetMagnitude(Dec,&Model->Format)-1;
+		Field->Point=(uint8_t)(mag>>10);
+		Field->Digits=(uint8_t)(mag>>5) & 31;
+		Field->Fraction=(uint8_t)mag & 31;
+		if((mag>=2048) || (Field->Digits+Field->Fraction==0) || (Field->Digits+Field->Fraction>GPS_CODEC_DIGITS) || ((Field->Point==0) && (Field->Fraction!=0)))
+			return NULL;
+		v=GPS_Codec_Predict(Field)+GPS_Codec_GetSigned(Dec,Residual,0);
+	}
+	//	a value the format cannot hold, or a negative zero, was never encoded
+	mag=((int64_t)v<0) ? 0-v : v;
+	if((mag>=GPS_CodecPower[Field->Digits+Field->Fraction]) || ((v==0) && ((int64_t)v<0)))
+		return NULL;
+	Field->Class=GPS_CODEC_NUMBER;
+	GPS_Codec_Remember(Model,Field,Slot,v,1);
+	return GPS_Codec_Format(Out,Field);
+}
+//##################################################################################################################
+static uint8_t	GPS_Codec_Checksum(const char *Data,uint32_t Len)
+{
+	uint64_t	x=0,w;
+	uint32_t	i=0;
+	for( ; i+8<=Len ; i+=8)
+	{
+		memcpy(&w,&Data[i],8);
+		x^=w;
+	}
+	x^=x>>32;
+	x^=x>>16;
+	x^=x>>8;
+	for( ; i<Len ; i++)
+		x^=(uint8_t)Data[i];
+	return (uint8_t)x;
+}
+//##################################################################################################################
+uint8_t	GPS_Codec_Decode(const uint8_t *Data,uint64_t Len,GPS_CodecWrite_t Write,void *Context,GPS_CodecStats_t *Stats)
+{
+	//	a line never grows past GPS_CODEC_LINE plus one field, so it is built in place behind the pending output
+	GPS_CodecDecoder_t	dec;
+	GPS_CodecHeader_t		h;
+	GPS_CodecModel_t		*model;
+	char			*buffer;
+	uint32_t	used=0;
+	uint64_t	total=0;
+	uint8_t		ok=0;
+	double		t0=GPS_Codec_Now();
+	memset(Stats,0,sizeof(GPS_CodecStats_t));
+	if(Len<sizeof(h))
+		return 0;
+	memcpy(&h,Data,sizeof(h));
+	if((h.Magic!=GPS_CODEC_MAGIC) || (h.Version!=GPS_CODEC_VERSION))
+		return 0;
+	model=(GPS_CodecModel_t*)malloc(sizeof(GPS_CodecModel_t));
+	buffer=(char*)malloc(GPS_CODEC_OUTPUT+2*GPS_CODEC_LINE+64);
+	if((model==NULL) || (buffer==NULL))
+	{
+		free(model);
+		free(buffer);
+		return 0;
+	}
+	GPS_Codec_Reset(model);
+	dec.In=Data+sizeof(h);
+	dec.End=Data+Len;
+	dec.Range=0xFFFFFFFFU;
+	dec.Code=0;
+	for(uint8_t i=0 ; i<5 ; i++)
+		dec.Code=(dec.Code<<8) | ((dec.In<dec.End) ? *dec.In++ : 0);
+	while(1)
+	{
+		char			*line=&buffer[used];
+		char			*p=line;
+		uint32_t	symbol=GPS_Codec_GetSymbol(&dec,model);
+		uint32_t	n;
+		if(symbol==GPS_CODEC_END)
+		{
+			ok=1;
+			break;
+		}
+		if(symbol==GPS_CODEC_RAW)
+		{
+			if((GPS_Codec_GetBytes(&dec,model,p,&n,'\n')==0) || (n==0))
+				break;
+			GPS_Codec_Follow(model,GPS_CODEC_RAW);
+			p+=n;
+			Stats->Lines++;
+		}
+		else
+		{
+			GPS_CodecType_t	*t;
+			uint32_t	mask;
+			uint8_t		sum,same=1;
+			if((symbol>GPS_CODEC_NEW) || ((symbol<GPS_CODEC_NEW) && (symbol>=model->Types)) || ((symbol==GPS_CODEC_NEW) && (model->Types==GPS_CODEC_TYPES)))
+				break;
+			*p++='$';
+			if(symbol==GPS_CODEC_NEW)
+			{
+				if((GPS_Codec_GetBytes(&dec,model,p,&n,'$')==0) || (n==0) || (n>GPS_CODEC_ADDRESS))
+					break;
+				symbol=model->Types;
+				t=GPS_Codec_NewType(model,p,(uint8_t)n);
+				n=(uint32_t)GPS_Codec_GetMagnitude(&dec,&model->Fields)-1;
+			}
+			else
+			{
+				t=&model->Type[symbol];
+				n=t->Fields;
+				if(GPS_Codec_Get(&dec,&t->Count)==1)
+					n=(uint32_t)GPS_Codec_GetMagnitude(&dec,&model->Fields)-1;
+			}
+			if(n>GPS_CODEC_FIELDS)
+				break;
+			t->Fields=(uint8_t)n;
+			GPS_Codec_Follow(model,symbol);
+			mask=t->Mask;
+			if(GPS_Codec_Get(&dec,&t->Pattern)==1)
+			{
+				mask=0;
+				for(uint32_t i=0 ; i<n ; i++)
+				{
+					same=(uint8_t)GPS_Codec_Get(&dec,&t->Field[i].Same[same | ((t->Mask>>i) & 1)<<1]);
+					mask|=(uint32_t)(same==0)<<i;
+				}
+				t->Mask=mask;
+			}
+			memcpy(p,t->Address,t->Size);
+			p+=t->Size;
+			for(uint32_t i=0 ; (i<n) && (p!=NULL) && (p-line<=GPS_CODEC_LINE) ; i++)
+			{
+				*p++=',';
+				p=GPS_Codec_GetField(&dec,model,symbol<<5 | i,p,((mask>>i) & 1)==0);
+			}
+			if((p==NULL) || (p-line>GPS_CODEC_LINE-5))
+				break;
+			sum=GPS_Codec_Checksum(line+1,(uint32_t)(p-line-1));
+			p[0]='*';
+			p[1]=GPS_CodecHex[sum>>4];
+			p[2]=GPS_CodecHex[sum & 15];
+			p[3]='\r';
+			p[4]='\n';
+			p+=5;
+			Stats->Sentences++;
+		}
+		used+=(uint32_t)(p-line);
+		//	a damaged stream can go on decoding after its input, the header length bounds it
+		if(total+used>h.Length)
+			break;
+		if(used>=GPS_CODEC_OUTPUT)
+		{
+			if(Write(Context,buffer,used)!=used)
+				break;
+			total+=used;
+			used=0;
+		}
+	}
+	if((ok==1) && (used>0) && (Write(Context,buffer,used)!=used))
+		ok=0;
+	total+=used;
+	if(total!=h.Length)
+		ok=0;
+	Stats->Input=Len;
+	Stats->Output=total;
+	Stats->Types=model->Types;
+	Stats->Seconds=GPS_Codec_Now()-t0;
+	free(model);
+	free(buffer);
+	return ok;
+}
+//##################################################################################################################
+static uint32_t	GPS_Codec_FileWrite(void *Context,const void *Data,uint32_t Len)
+{
+	return (uint32_t)fwrite(Data,1,Len,(FILE*)Context);
+}
+//##################################################################################################################
+uint8_t	GPS_Codec_File(const char *Input,const char *Output,uint8_t Decode,GPS_CodecStats_t *Stats)
+{
+	struct stat	st;
+	uint8_t			*data=NULL;
+	uint8_t			ok;
+	FILE				*out;
+	int					fd=open(Input,O_RDONLY);
+	memset(Stats,0,sizeof(GPS_CodecStats_t));
+	if((fd<0) || (fstat(fd,&st)!=0))
+	{
+		if(fd>=0)
+			close(fd);
+		return 0;
+	}
+	if(st.st_size>0)
+	{
+		data=(uint8_t*)mmap(NULL,(size_t)st.st_size,PROT_READ,MAP_PRIVATE,fd,0);
+		if(data==MAP_FAILED)
+		{
+			close(fd);
+			return 0;
+		}
+		madvise(data,(size_t)st.st_size,MADV_SEQUENTIAL);
+	}
+	if((out=fopen(Output,"wb"))==NULL)
+	{
+		if(data!=NULL)
+			munmap(data,(size_t)st.st_size);
+		close(fd);
+		return 0;
+	}
+	setvbuf(out,NULL,_IOFBF,1<<20);
+	if(Decode==1)
+		ok=GPS_Codec_Decode(data,(uint64_t)st.st_size,GPS_Codec_FileWrite,out,Stats);
+	else
+		ok=GPS_Codec_Encode(data,(uint64_t)st.st_size,GPS_Codec_FileWrite,out,Stats);
+	if(fclose(out)!=0)
+		ok=0;
+	if(data!=NULL)
+		munmap(data,(size_t)st.st_size);
+	close(fd);
+	return ok;
+}
+//##################################################################################################################
+void	GPS_Codec_Report(const GPS_CodecStats_t *Stats)
+{
+	uint64_t	raw=(Stats->Input>Stats->Output) ? Stats->Input : Stats->Output;
+	uint64_t	packed=(Stats->Input>Stats->Output) ? Stats->Output : Stats->Input;
+	printf("%lu bytes -> %lu bytes (%.1fx), %lu sentences, %lu lines as bytes, %u types, %.3f s, %.1f MB/s\r\n",
+		(unsigned long)Stats->Input,(unsigned long)Stats->Output,(packed>0) ? (double)raw/packed : 0.0,(unsigned long)Stats->Sentences,
+		(unsigned long)Stats->Lines,(unsigned)Stats->Types,Stats->Seconds,(Stats->Seconds>0.0) ? raw/Stats->Seconds*1e-6 : 0.0);
+}
+//##################################################################################################################
+//	benchmark
+//##################################################################################################################
+typedef struct
+{
+	uint8_t			*Data;
+	uint64_t		Len;
+	uint64_t		Room;
+
+}GPS_CodecBuffer_t;
+//##################################################################################################################
+static uint32_t	GPS_Codec_BufferWrite(void *Context,const void *Data,uint32_t Len)
+{
+	GPS_CodecBuffer_t	*b=(GPS_CodecBuffer_t*)Context;
+	if(b->Len+Len>b->Room)
+		return 0;
+	memcpy(&b->Data[b->Len],Data,Len);
+	b->Len+=Len;
+	return Len;
+}
+//##################################################################################################################
+static uint32_t	GPS_Codec_Random(uint32_t *Seed,uint32_t Range)
+{
+	*Seed=*Seed*1664525+1013904223;
+	return (*Seed>>8)%Range;
+}
+//##################################################################################################################
+static uint32_t	GPS_Codec_Line(char *Out,const char *Body,uint32_t *Seed,uint64_t *Damaged)
+{
+	//	one line in 40 is spoiled the ways captures are: bad checksum, lowercase hex, no CR, cut short or noise
+	uint8_t		sum=GPS_Codec_Checksum(Body,(uint32_t)strlen(Body));
+	uint32_t	n;
+	if(GPS_Codec_Random(Seed,40)!=0)
+		return (uint32_t)sprintf(Out,"$%s*%02X\r\n",Body,sum);
+	(*Damaged)++;
+	switch(GPS_Codec_Random(Seed,5))
+	{
+		case 0:
+			return (uint32_t)sprintf(Out,"$%s*%02X\r\n",Body,sum ^ 0x5A);
+		case 1:
+			//	forced to a letter, "%02x" of 0x42 would still be a clean sentence
+			return (uint32_t)sprintf(Out,"$%s*%02x\r\n",Body,sum | 0x0A);
+		case 2:
+			return (uint32_t)sprintf(Out,"$%s*%02X\n",Body,sum);
+		case 3:
+			n=(uint32_t)sprintf(Out,"$%s",Body);
+			n=1+GPS_Codec_Random(Seed,n-1);
+			Out[n++]='\r';
+			Out[n++]='\n';
+			return n;
+		default:
+			n=8+GPS_Codec_Random(Seed,40);
+			for(uint32_t i=0 ; i<n ; i++)
+				Out[i]=(char)(0x80 | GPS_Codec_Random(Seed,128));
+			Out[n++]='\n';
+			return n;
+	}
+}
+//##################################################################################################################
+static uint64_t	GPS_Codec_Corpus(char *Out,uint32_t Epochs,uint64_t *Damaged)
+{
+	//	10 Hz GGA, GNS and GST on a slow drive, RMC and three GSV messages once a second
+	uint32_t	seed=0x2545F491;
+	uint64_t	len=0;
+	double		lat=4807.038,lon=1131.000,alt=545.4;
+	char			body[160],time[16],pos[48];
+	for(uint32_t e=0 ; e<Epochs ; e++)
+	{
+		uint32_t	ms=(43200000+e*100)%86400000;
+		uint8_t		sats=(uint8_t)(8+GPS_Codec_Random(&seed,4));
+		float			hdop=0.7f+GPS_Codec_Random(&seed,5)*0.1f;
+		lat+=((int32_t)GPS_Codec_Random(&seed,21)-10)*1e-5;
+		lon+=((int32_t)GPS_Codec_Random(&seed,21)-10)*1e-5;
+		alt+=((int32_t)GPS_Codec_Random(&seed,11)-5)*0.1;
+		sprintf(time,"%02u%02u%02u.%02u",ms/3600000,ms/60000%60,ms/1000%60,ms%1000/10);
+		sprintf(pos,"%09.4f,N,%010.4f,E",lat,lon);
+		sprintf(body,"GPGGA,%s,%s,1,%02u,%.1f,%.1f,M,46.9,M,,",time,pos,sats,hdop,alt);
+		len+=GPS_Codec_Line(&Out[len],body,&seed,Damaged);
+		sprintf(body,"GNGNS,%s,%s,AAN,%02u,%.1f,%.1f,46.9,,,V",time,pos,sats+4,hdop,alt);
+		len+=GPS_Codec_Line(&Out[len],body,&seed,Damaged);
+		sprintf(body,"GNGST,%s,%.1f,%.1f,%.1f,%.1f,%.2f,%.2f,%.2f",time,0.5+GPS_Codec_Random(&seed,10)*0.1,1.0+GPS_Codec_Random(&seed,10)*0.1,
+			0.8,45.0+GPS_Codec_Random(&seed,90),0.6+GPS_Codec_Random(&seed,30)*0.01,0.5+GPS_Codec_Random(&seed,30)*0.01,1.2+GPS_Codec_Random(&seed,30)*0.01);
+		len+=GPS_Codec_Line(&Out[len],body,&seed,Damaged);
+		if(ms%1000!=0)
+			continue;
+		sprintf(body,"GPRMC,%s,A,%s,%.2f,%.1f,181026,,,A",time,pos,GPS_Codec_Random(&seed,300)*0.01,GPS_Codec_Random(&seed,3600)*0.1);
+		len+=GPS_Codec_Line(&Out[len],body,&seed,Damaged);
+		for(uint8_t m=1 ; m<=3 ; m++)
+		{
+			char	*p=body+sprintf(body,"GPGSV,3,%u,12",m);
+			for(uint8_t prn=m*4-3 ; prn<=m*4 ; prn++)
+				p+=sprintf(p,",%02u,%02u,%03u,%02u",prn,10+prn*6,prn*29,30+GPS_Codec_Random(&seed,20));
+			len+=GPS_Codec_Line(&Out[len],body,&seed,Damaged);
+		}
+	}
+	return len;
+}
+//##################################################################################################################
+uint8_t	GPS_Codec_Bench(uint32_t Epochs,GPS_CodecBench_t *Result)
+{
+	//	three lines an epoch and four more once a second, none longer than '$', a 160-byte body, "*hh" and CRLF
+	uint64_t					room=((uint64_t)Epochs*3+(Epochs/10+1)*4)*166;
+	char							*nmea=(char*)malloc(room);
+	GPS_CodecBuffer_t	packed={NULL,0,2*room+GPS_CODEC_OUTPUT};
+	GPS_CodecBuffer_t	plain={NULL,0,room};
+	GPS_CodecStats_t	stats;
+	uint8_t						ok=1;
+	memset(Result,0,sizeof(GPS_CodecBench_t));
+	packed.Data=(uint8_t*)malloc(packed.Room);
+	plain.Data=(uint8_t*)malloc(plain.Room);
+	if((nmea!=NULL) && (packed.Data!=NULL) && (plain.Data!=NULL))
+	{
+		Result->Input=GPS_Codec_Corpus(nmea,Epochs,&Result->Damaged);
+		//	best of 3 each way
+		for(uint8_t run=0 ; ok && (run<3) ; run++)
+		{
+			packed.Len=0;
+			ok=GPS_Codec_Encode((const uint8_t*)nmea,Result->Input,GPS_Codec_BufferWrite,&packed,&stats);
+			if((run==0) || (stats.Seconds<Result->Encode))
+				Result->Encode=stats.Seconds;
+			Result->Sentences=stats.Sentences;
+			Result->Lines=stats.Lines;
+		}
+		for(uint8_t run=0 ; ok && (run<3) ; run++)
+		{
+			plain.Len=0;
+			ok=GPS_Codec_Decode(packed.Data,packed.Len,GPS_Codec_BufferWrite,&plain,&stats);
+			if((run==0) || (stats.Seconds<Result->Decode))
+				Result->Decode=stats.Seconds;
+		}
+		Result->Output=packed.Len;
+		Result->Ratio=(packed.Len>0) ? (double)Result->Input/packed.Len : 0.0;
+		Result->Encode=(Result->Encode>0.0) ? Result->Input/Result->Encode*1e-6 : 0.0;
+		Result->Decode=(Result->Decode>0.0) ? Result->Input/Result->Decode*1e-6 : 0.0;
+		//	every spoiled line kept as bytes, the rest back as sentences, and a cut stream refused
+		Result->Exact=ok && (plain.Len==Result->Input) && (memcmp(plain.Data,nmea,plain.Len)==0) && (Result->Lines==Result->Damaged);
+		plain.Len=0;
+		if(Result->Exact && GPS_Codec_Decode(packed.Data,packed.Len/2,GPS_Codec_BufferWrite,&plain,&stats))
+			Result->Exact=0;
+	}
+	free(nmea);
+	free(packed.Data);
+	free(plain.Data);
+	return Result->Exact;
+}
+//##################################################################################################################
+void	GPS_Codec_BenchReport(const GPS_CodecBench_t *Result)
+{
+	printf("%lu bytes -> %lu bytes (%.1fx), %lu sentences, %lu of %lu spoiled lines as bytes, %s\r\n",(unsigned long)Result->Input,
+		(unsigned long)Result->Output,Result->Ratio,(unsigned long)Result->Sentences,(unsigned long)Result->Lines,(unsigned long)Result->Damaged,
+		(Result->Exact!=0) ? "bit-exact" : "MISMATCH");
+	printf("encode %.1f MB/s, decode %.1f MB/s\r\n",Result->Encode,Result->Decode);
+}
+//##################################################################################################################
+
+#endif
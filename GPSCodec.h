@@ -0,0 +1,68 @@
+#ifndef _GPSCODEC_H_
+#define _GPSCODEC_H_
+
+#include <stdint.h>
+#include "GPSConfig.h"
+
+//##################################################################################################################
+//	Lossless codec for raw NMEA captures, host build. Lines are cut into sentences and fields the way the decoder
+//	frames them. Every field is predicted from the same field of the previous sentence of its type: text is
+//	expected to repeat, numbers to follow the last value or the last step, whichever predicted better lately,
+//	or a field of another type they have been repeating (GNS and RMC after GGA). What is left goes through an
+//	adaptive binary range coder. Checksums are not stored, a sentence whose checksum verifies is rebuilt with
+//	it. Any line that is not a clean sentence goes in as bytes, so every input comes back bit for bit.
+//##################################################################################################################
+
+#define	GPS_CODEC_MAGIC							0x4E535047		//	"GPSN"
+#define	GPS_CODEC_VERSION						1
+#define	GPS_CODEC_TYPES							32						//	sentence types (GSV keyed by message number too)
+#define	GPS_CODEC_FIELDS						32
+#define	GPS_CODEC_TEXT							23						//	longer text fields are never predicted
+
+typedef struct
+{
+	uint32_t		Magic;
+	uint32_t		Version;
+	uint64_t		Length;									//	of the original
+
+}GPS_CodecHeader_t;
+
+typedef struct
+{
+	uint64_t		Input;
+	uint64_t		Output;
+	uint64_t		Sentences;
+	uint64_t		Lines;									//	kept as bytes
+	uint32_t		Types;
+	double			Seconds;
+
+}GPS_CodecStats_t;
+
+typedef struct
+{
+	uint64_t		Input;
+	uint64_t		Output;
+	uint64_t		Sentences;
+	uint64_t		Lines;
+	uint64_t		Damaged;								//	lines the corpus spoiled on purpose
+	uint8_t			Exact;
+	double			Ratio;
+	double			Encode;									//	MB/s of NMEA
+	double			Decode;
+
+}GPS_CodecBench_t;
+
+typedef uint32_t	(*GPS_CodecWrite_t)(void *Context,const void *Data,uint32_t Len);
+
+//##################################################################################################################
+//	both return 1 on success; Decode fails on a damaged stream or a length that does not match the header
+uint8_t		GPS_Codec_Encode(const uint8_t *Data,uint64_t Len,GPS_CodecWrite_t Write,void *Context,GPS_CodecStats_t *Stats);
+uint8_t		GPS_Codec_Decode(const uint8_t *Data,uint64_t Len,GPS_CodecWrite_t Write,void *Context,GPS_CodecStats_t *Stats);
+uint8_t		GPS_Codec_File(const char *Input,const char *Output,uint8_t Decode,GPS_CodecStats_t *Stats);
+void			GPS_Codec_Report(const GPS_CodecStats_t *Stats);
+//	encodes and decodes a generated 10 Hz capture in memory and compares it byte for byte, returns Exact
+uint8_t		GPS_Codec_Bench(uint32_t Epochs,GPS_CodecBench_t *Result);
+void			GPS_Codec_BenchReport(const GPS_CodecBench_t *Result);
+//##################################################################################################################
+
+#endif
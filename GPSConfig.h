@@ -3,6 +3,126 @@
 
 #define	_GPS_USART					huart3
 #define	_GPS_DEBUG					0
+#define	_GPS_HOST					0
+#define	_GPS_STREAM					0
+#define	_GPS_FIX					0
+#define	_GPS_GSV					0
+#define	_GPS_GSV_SATS				48
+#define	_GPS_WCET					0
+#define	_GPS_WCET_SENTENCE			82
+#define	_GPS_WCET_FIELD				15
+
+#define	_GPS_SIM					0
+#define	_GPS_SIM_RUNS				200
+#define	_GPS_SIM_TIMEOUT			300000
+
+#define	_GPS_FUZZ					0
+#define	_GPS_FUZZ_INPUT				510
+#define	_GPS_FUZZ_CORPUS			256
+#define	_GPS_FUZZ_KEEP				8
+
+#define	_GPS_ARCHIVE				0
+#define	_GPS_ARCHIVE_CHUNK			1048576
+#define	_GPS_ARCHIVE_BLOCK			4096
+#define	_GPS_ARCHIVE_THREADS		0
+
+#define	_GPS_QUERY					0
+#define	_GPS_QUERY_FILTERS			4
+#define	_GPS_QUERY_GROUPS			1440
+#define	_GPS_QUERY_GAP				5000
+#define	_GPS_QUERY_SIMD				1
+
+#define	_GPS_HEATMAP				0
+#define	_GPS_HEATMAP_ZOOM			18
+#define	_GPS_HEATMAP_THREADS		0
+#define	_GPS_HEATMAP_SIMD			1
+
+#define	_GPS_TRIP					0
+#define	_GPS_TRIP_WINDOW			16
+#define	_GPS_TRIP_RADIUS			25
+#define	_GPS_TRIP_SPEED				50
+#define	_GPS_TRIP_DWELL				60000
+#define	_GPS_TRIP_GAP				5000
+
+#define	_GPS_JAM					0
+#define	_GPS_JAM_SATS				64
+#define	_GPS_JAM_DROP				6
+#define	_GPS_JAM_RISE				6
+#define	_GPS_JAM_UNIFORM			2
+#define	_GPS_JAM_JUMP				50
+#define	_GPS_JAM_TIME				500
+#define	_GPS_JAM_PPS				1000
+
+#define	_GPS_CODEC					0
+
+#define	_GPS_STATS					0
+#define	_GPS_STATS_OCTAVES			16
+
+#define	_GPS_UBX					0
+#define	_GPS_UBX_BUFFER				2064
+
+#define	_GPS_RINEX					0
+#define	_GPS_RINEX_MAX_SATS			64
+
+#define	_GPS_MAVLINK				0
+#define	_GPS_MAVLINK_SYSID			1
+#define	_GPS_MAVLINK_COMPID			220
+#define	_GPS_MAVLINK_AUTO			0
+#define	_GPS_MAVLINK_USART			huart2
+#define	_GPS_MAVLINK_TX(data,len)		HAL_UART_Transmit_DMA(&_GPS_MAVLINK_USART,data,len)
+
+#define	_GPS_N2K					0
+#define	_GPS_N2K_ADDRESS			35
+#define	_GPS_N2K_TX(frames,count)		GPS_N2k_CanSend(frames,count)
+
+#define	_GPS_TELEMETRY				0
+#define	_GPS_TELEMETRY_KEYFRAME		10
+#define	_GPS_TELEMETRY_LAT_BITS		24
+#define	_GPS_TELEMETRY_LON_BITS		25
+#define	_GPS_TELEMETRY_ALT_BITS		15
+#define	_GPS_TELEMETRY_ALT_STEP		1.0f
+#define	_GPS_TELEMETRY_DELTA_BITS	10
+
+#define	_GPS_MULTI					0
+#define	_GPS_MULTI_MAX				4
+#define	_GPS_MULTI_DMA				512
+#define	_GPS_MULTI_BUDGET			128
+#define	_GPS_MULTI_IDLE				1
+
+#define	_GPS_DAEMON					0
+#define	_GPS_DAEMON_WORKERS			4
+#define	_GPS_DAEMON_PORTS			512
+#define	_GPS_DAEMON_READ			4096
+
+#define	_GPS_URING					0
+#define	_GPS_URING_DEPTH			8
+#define	_GPS_URING_BUFFER			65536
+
+#define	_GPS_QUEUE					0
+#define	_GPS_QUEUE_DEPTH			8
+#define	_GPS_QUEUE_CONSUMERS		4
+#define	_GPS_QUEUE_HOT				0
+
+#define	_GPS_POOL					0
+#define	_GPS_POOL_SENTENCES			32
+#define	_GPS_POOL_SENTENCE_SIZE		96
+#define	_GPS_POOL_EPOCHS			16
+
+#define	_GPS_CRC					0
+#define	_GPS_CRC_SLICES				8
+#define	_GPS_CRC_HW					0
+#define	_GPS_CRC_HANDLE				hcrc
+
+#define	_GPS_ASSIST					0
+#define	_GPS_ASSIST_CHUNK				256
+#define	_GPS_ASSIST_WINDOW				4
+#define	_GPS_ASSIST_ACK					1
+#define	_GPS_ASSIST_TIMEOUT				1000
+#define	_GPS_ASSIST_GAP					10
+#define	_GPS_ASSIST_DAYS				1
+#define	_GPS_ASSIST_EPO_HOURS			24
+#define	_GPS_ASSIST_TIME_ACC			2
+#define	_GPS_ASSIST_TX(data,len)		HAL_UART_Transmit_DMA(&_GPS_USART,data,len)
 
 
 
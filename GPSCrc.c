@@ -0,0 +1,286 @@
+#include "GPSConfig.h"
+
+#if (_GPS_CRC==1)
+
+#include "GPSCrc.h"
+#include <string.h>
+#if (_GPS_HOST==1)
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#if defined(__x86_64__) && defined(__GNUC__)
+#define	GPS_CRC_CLMUL
+#include <immintrin.h>
+#endif
+#endif
+#if (_GPS_CRC_HW==1)
+#if (_GPS_HOST==1)
+#error "_GPS_CRC_HW needs the STM32 CRC unit"
+#endif
+#include "crc.h"
+#endif
+
+#if (_GPS_CRC_SLICES!=1) && (_GPS_CRC_SLICES!=8)
+#error "_GPS_CRC_SLICES must be 1 or 8"
+#endif
+#if defined(__BYTE_ORDER__) && (__BYTE_ORDER__!=__ORDER_LITTLE_ENDIAN__)
+#error "GPS_Crc_Fletcher16 assumes little-endian word loads"
+#endif
+
+//	x^24+x^23+x^18+x^17+x^14+x^11+x^10+x^7+x^6+x^5+x^4+x^3+x+1, kept left aligned in 32 bits
+#define	GPS_CRC_24Q_POLY						0x864CFB00UL
+
+#if (UINTPTR_MAX>0xFFFFFFFFUL)
+typedef uint64_t	GPS_CrcWord_t;
+#else
+typedef uint32_t	GPS_CrcWord_t;
+#endif
+//	0x00FF in every 16-bit lane
+#define	GPS_CRC_LANES								((GPS_CrcWord_t)-1/0xFFFF*0x00FF)
+
+static uint32_t	GPS_CrcTable[_GPS_CRC_SLICES][256];
+static uint8_t	GPS_CrcReady;
+#ifdef GPS_CRC_CLMUL
+static uint8_t	GPS_CrcClmul;
+static uint64_t	GPS_CrcFold[4];
+#endif
+//##################################################################################################################
+#ifdef GPS_CRC_CLMUL
+static uint64_t	GPS_Crc_XPow(uint32_t n)
+{
+	//	x^n mod the CRC-24Q polynomial
+	uint32_t	r=1;
+	while(n--)
+	{
+		r<<=1;
+		if(r & (1UL<<24))
+			r^=(GPS_CRC_24Q_POLY>>8) | (1UL<<24);
+	}
+	return r;
+}
+#endif
+//##################################################################################################################
+void	GPS_Crc_Init(void)
+{
+	for(uint32_t i=0 ; i<256 ; i++)
+	{
+		uint32_t	c=i<<24;
+		for(uint8_t k=0 ; k<8 ; k++)
+			c=(c & 0x80000000UL) ? (c<<1) ^ GPS_CRC_24Q_POLY : c<<1;
+		GPS_CrcTable[0][i]=c;
+	}
+	//	table s is a byte followed by s zero bytes
+	for(uint8_t s=1 ; s<_GPS_CRC_SLICES ; s++)
+		for(uint32_t i=0 ; i<256 ; i++)
+			GPS_CrcTable[s][i]=(GPS_CrcTable[s-1][i]<<8) ^ GPS_CrcTable[0][GPS_CrcTable[s-1][i]>>24];
+	#ifdef GPS_CRC_CLMUL
+	GPS_CrcFold[0]=GPS_Crc_XPow(512+64);
+	GPS_CrcFold[1]=GPS_Crc_XPow(512);
+	GPS_CrcFold[2]=GPS_Crc_XPow(128+64);
+	GPS_CrcFold[3]=GPS_Crc_XPow(128);
+	__builtin_cpu_init();
+	GPS_CrcClmul=__builtin_cpu_supports("pclmul") && __builtin_cpu_supports("ssse3");
+	#endif
+	GPS_CrcReady=1;
+}
+//##################################################################################################################
+static uint32_t	GPS_Crc_24qBitwise(uint32_t Crc,const uint8_t *Data,uint32_t Len)
+{
+	uint32_t	c=Crc<<8;
+	while(Len--)
+	{
+		c^=(uint32_t)*Data++<<24;
+		for(uint8_t k=0 ; k<8 ; k++)
+			c=(c & 0x80000000UL) ? (c<<1) ^ GPS_CRC_24Q_POLY : c<<1;
+	}
+	return c>>8;
+}
+//##################################################################################################################
+static uint32_t	GPS_Crc_24qTable(uint32_t Crc,const uint8_t *Data,uint32_t Len)
+{
+	uint32_t	c=Crc<<8;
+	while(Len--)
+		c=(c<<8) ^ GPS_CrcTable[0][(c>>24) ^ *Data++];
+	return c>>8;
+}
+//##################################################################################################################
+#if (_GPS_CRC_SLICES==8)
+static uint32_t	GPS_Crc_24qSlice8(uint32_t Crc,const uint8_t *Data,uint32_t Len)
+{
+	const uint32_t	(*t)[256]=(const uint32_t (*)[256])GPS_CrcTable;
+	uint32_t	c=Crc<<8;
+	for( ; Len>=8 ; Data+=8,Len-=8)
+	{
+		uint32_t	h=c ^ ((uint32_t)Data[0]<<24 | (uint32_t)Data[1]<<16 | (uint32_t)Data[2]<<8 | Data[3]);
+		c=t[7][h>>24] ^ t[6][(h>>16) & 0xFF] ^ t[5][(h>>8) & 0xFF] ^ t[4][h & 0xFF] ^
+			t[3][Data[4]] ^ t[2][Data[5]] ^ t[1][Data[6]] ^ t[0][Data[7]];
+	}
+	return GPS_Crc_24qTable(c>>8,Data,Len);
+}
+#define	GPS_Crc_24qSoft							GPS_Crc_24qSlice8
+#else
+#define	GPS_Crc_24qSoft							GPS_Crc_24qTable
+#endif
+//##################################################################################################################
+#ifdef GPS_CRC_CLMUL
+#define	GPS_CRC_FOLD(x,k,next)			_mm_xor_si128(_mm_xor_si128(_mm_clmulepi64_si128(x,k,0x01),_mm_clmulepi64_si128(x,k,0x10)),next)
+__attribute__((target("pclmul,ssse3")))
+static uint32_t	GPS_Crc_24qClmul(uint32_t Crc,const uint8_t *Data,uint32_t Len)
+{
+	//	Len>=64. Four 128-bit lanes are folded 512 bits at a time with x^576 and x^512 mod P, then into one lane
+	//	with x^192 and x^128. The last lane is congruent to the message, so the table finishes it from CRC 0.
+	const __m128i	swap=_mm_set_epi8(0,1,2,3,4,5,6,7,8,9,10,11,12,13,14,15);
+	const __m128i	k512=_mm_set_epi64x((long long)GPS_CrcFold[1],(long long)GPS_CrcFold[0]);
+	const __m128i	k128=_mm_set_epi64x((long long)GPS_CrcFold[3],(long long)GPS_CrcFold[2]);
+	__m128i	x0,x1,x2,x3;
+	uint8_t	v[16];
+	x0=_mm_shuffle_epi8(_mm_loadu_si128((const __m128i*)&Data[0]),swap);
+	x1=_mm_shuffle_epi8(_mm_loadu_si128((const __m128i*)&Data[16]),swap);
+	x2=_mm_shuffle_epi8(_mm_loadu_si128((const __m128i*)&Data[32]),swap);
+	x3=_mm_shuffle_epi8(_mm_loadu_si128((const __m128i*)&Data[48]),swap);
+	//	a running CRC is the same as XORing it into the first three bytes
+	x0=_mm_xor_si128(x0,_mm_set_epi64x((long long)((uint64_t)Crc<<40),0));
+	for(Data+=64,Len-=64 ; Len>=64 ; Data+=64,Len-=64)
+	{
+		x0=GPS_CRC_FOLD(x0,k512,_mm_shuffle_epi8(_mm_loadu_si128((const __m128i*)&Data[0]),swap));
+		x1=GPS_CRC_FOLD(x1,k512,_mm_shuffle_epi8(_mm_loadu_si128((const __m128i*)&Data[16]),swap));
+		x2=GPS_CRC_FOLD(x2,k512,_mm_shuffle_epi8(_mm_loadu_si128((const __m128i*)&Data[32]),swap));
+		x3=GPS_CRC_FOLD(x3,k512,_mm_shuffle_epi8(_mm_loadu_si128((const __m128i*)&Data[48]),swap));
+	}
+	x1=GPS_CRC_FOLD(x0,k128,x1);
+	x2=GPS_CRC_FOLD(x1,k128,x2);
+	x3=GPS_CRC_FOLD(x2,k128,x3);
+	for( ; Len>=16 ; Data+=16,Len-=16)
+		x3=GPS_CRC_FOLD(x3,k128,_mm_shuffle_epi8(_mm_loadu_si128((const __m128i*)Data),swap));
+	_mm_storeu_si128((__m128i*)v,_mm_shuffle_epi8(x3,swap));
+	return GPS_Crc_24qSoft(GPS_Crc_24qSoft(0,v,16),Data,Len);
+}
+#endif
+//##################################################################################################################
+uint32_t	GPS_Crc_24q(uint32_t Crc,const uint8_t *Data,uint32_t Len)
+{
+	if(GPS_CrcReady==0)
+		GPS_Crc_Init();
+	#ifdef GPS_CRC_CLMUL
+	if((GPS_CrcClmul!=0) && (Len>=64))
+		return GPS_Crc_24qClmul(Crc,Data,Len);
+	#endif
+	return GPS_Crc_24qSoft(Crc,Data,Len);
+}
+//##################################################################################################################
+static uint16_t	GPS_Crc_FletcherByte(uint16_t Ck,const uint8_t *Data,uint32_t Len)
+{
+	uint8_t	a=(uint8_t)Ck,b=(uint8_t)(Ck>>8);
+	while(Len--)
+	{
+		a+=*Data++;
+		b+=a;
+	}
+	return (uint16_t)(a | (b<<8));
+}
+//##################################################################################################################
+uint16_t	GPS_Crc_Fletcher16(uint16_t Ck,const uint8_t *Data,uint32_t Len)
+{
+	//	even and odd bytes of each word add into 16-bit lanes masked back to 8 bits, so no lane carries into the
+	//	next. B takes A before every add, and the byte sums are rebuilt from both at the end:
+	//	a+=sum(A), b+=n*W*a+W*sum(B)+sum((W-i)*A[i]), all modulo 256
+	const uint32_t	w=sizeof(GPS_CrcWord_t);
+	uint32_t	n=Len/w;
+	uint8_t		a=(uint8_t)Ck,b=(uint8_t)(Ck>>8);
+	GPS_CrcWord_t	ae=0,ao=0,be=0,bo=0,x;
+	for(uint32_t i=0 ; i<n ; i++,Data+=w)
+	{
+		memcpy(&x,Data,w);
+		be=(be+ae) & GPS_CRC_LANES;
+		bo=(bo+ao) & GPS_CRC_LANES;
+		ae=(ae+(x & GPS_CRC_LANES)) & GPS_CRC_LANES;
+		ao=(ao+((x>>8) & GPS_CRC_LANES)) & GPS_CRC_LANES;
+	}
+	b+=(uint8_t)(n*w*a);
+	for(uint32_t l=0 ; l<w/2 ; l++)
+	{
+		uint8_t	e=(uint8_t)(ae>>(16*l));
+		uint8_t	o=(uint8_t)(ao>>(16*l));
+		a+=e+o;
+		b+=(uint8_t)(w*((uint8_t)(be>>(16*l))+(uint8_t)(bo>>(16*l)))+(w-2*l)*e+(w-2*l-1)*o);
+	}
+	return GPS_Crc_FletcherByte((uint16_t)(a | (b<<8)),Data,Len-n*w);
+}
+//##################################################################################################################
+#if (_GPS_CRC_HW==1)
+uint16_t	GPS_Crc_Mcrf4xx(const uint8_t *Data,uint32_t Len)
+{
+	//	the CRC unit has to be set up in CubeMX with a 16-bit polynomial 0x1021, init 0xFFFF, byte input, input
+	//	reversed by byte and output reversed. Units with the fixed CRC-32 polynomial (F1, F2, F4) cannot do it.
+	return (uint16_t)HAL_CRC_Calculate(&_GPS_CRC_HANDLE,(uint32_t*)Data,Len);
+}
+#endif
+//##################################################################################################################
+#if (_GPS_HOST==1)
+static double	GPS_Crc_Now(void)
+{
+	struct timespec	ts;
+	clock_gettime(CLOCK_MONOTONIC,&ts);
+	return ts.tv_sec+ts.tv_nsec*1e-9;
+}
+//##################################################################################################################
+static double	GPS_Crc_Rate(uint32_t (*Crc)(uint32_t,const uint8_t*,uint32_t),uint16_t (*Ck)(uint16_t,const uint8_t*,uint32_t),const uint8_t *Data,uint32_t Len,uint32_t Rounds)
+{
+	volatile uint32_t	sink=0;
+	double	t=GPS_Crc_Now();
+	for(uint32_t r=0 ; r<Rounds ; r++)
+		sink+=(Crc!=NULL) ? Crc(sink & 0xFFFFFF,Data,Len) : Ck((uint16_t)sink,Data,Len);
+	return (double)Len*Rounds/(GPS_Crc_Now()-t)/1e6;
+}
+//##################################################################################################################
+uint8_t	GPS_Crc_Bench(uint32_t Len,uint32_t Rounds,GPS_CrcBench_t *Result)
+{
+	uint8_t		*buf=(uint8_t*)malloc(Len+4096);
+	uint32_t	seed=0x2545F491;
+	memset(Result,0,sizeof(GPS_CrcBench_t));
+	if(buf==NULL)
+		return 0;
+	GPS_Crc_Init();
+	for(uint32_t i=0 ; i<Len+4096 ; i++)
+	{
+		seed^=seed<<13;
+		seed^=seed>>17;
+		seed^=seed<<5;
+		buf[i]=(uint8_t)seed;
+	}
+	Result->Len=Len;
+	Result->Exact=(GPS_Crc_24q(0,(const uint8_t*)"123456789",9)==0xCDE703);
+	//	every length up to 4 KB and every offset modulo 16, each from a different running value
+	for(uint32_t n=0 ; (n<=4096) && Result->Exact ; n++)
+	{
+		const uint8_t	*p=&buf[n & 15];
+		uint32_t	crc=(seed=seed*1664525+1013904223)>>8;
+		uint32_t	ref=GPS_Crc_24qBitwise(crc,p,n);
+		Result->Exact=(GPS_Crc_24qTable(crc,p,n)==ref) && (GPS_Crc_24qSoft(crc,p,n)==ref) && (GPS_Crc_24q(crc,p,n)==ref) &&
+									(GPS_Crc_Fletcher16((uint16_t)crc,p,n)==GPS_Crc_FletcherByte((uint16_t)crc,p,n));
+	}
+	#ifdef GPS_CRC_CLMUL
+	Result->Clmul=GPS_CrcClmul;
+	#endif
+	Result->Bitwise=GPS_Crc_Rate(GPS_Crc_24qBitwise,NULL,buf,Len,(Rounds/16>0) ? Rounds/16 : 1);
+	Result->Table=GPS_Crc_Rate(GPS_Crc_24qTable,NULL,buf,Len,Rounds);
+	#if (_GPS_CRC_SLICES==8)
+	Result->Slice8=GPS_Crc_Rate(GPS_Crc_24qSlice8,NULL,buf,Len,Rounds);
+	#endif
+	Result->Folded=GPS_Crc_Rate(GPS_Crc_24q,NULL,buf,Len,Rounds);
+	Result->FletcherByte=GPS_Crc_Rate(NULL,GPS_Crc_FletcherByte,buf,Len,Rounds);
+	Result->FletcherWord=GPS_Crc_Rate(NULL,GPS_Crc_Fletcher16,buf,Len,Rounds);
+	free(buf);
+	return Result->Exact;
+}
+//##################################################################################################################
+void	GPS_Crc_Report(const GPS_CrcBench_t *Result)
+{
+	printf("%lu bytes, %s\r\n",(unsigned long)Result->Len,(Result->Exact!=0) ? "bit-exact" : "MISMATCH");
+	printf("CRC-24Q: bitwise %.0f MB/s, table %.0f MB/s, slicing-by-8 %.0f MB/s, %s %.0f MB/s\r\n",Result->Bitwise,Result->Table,Result->Slice8,(Result->Clmul!=0) ? "pclmul" : "default",Result->Folded);
+	printf("Fletcher-16: byte %.0f MB/s, word %.0f MB/s\r\n",Result->FletcherByte,Result->FletcherWord);
+}
+#endif
+//##################################################################################################################
+
+#endif
@@ -0,0 +1,46 @@
+#ifndef _GPSCRC_H_
+#define _GPSCRC_H_
+
+#include <stdint.h>
+#include "GPSConfig.h"
+
+//##################################################################################################################
+//	Checksums of the binary protocols. CRC-24Q (RTCM3) is table driven, slicing-by-8 when _GPS_CRC_SLICES is 8,
+//	and folded with carry-less multiplies on x86 hosts that have PCLMULQDQ. The UBX Fletcher-16 runs a word at a
+//	time. Tables are built by GPS_Crc_Init(), called on first use if needed.
+//##################################################################################################################
+
+#if (_GPS_HOST==1)
+typedef struct
+{
+	uint32_t		Len;
+	uint8_t			Exact;
+	uint8_t			Clmul;
+	double			Bitwise;
+	double			Table;
+	double			Slice8;
+	double			Folded;
+	double			FletcherByte;
+	double			FletcherWord;
+
+}GPS_CrcBench_t;
+#endif
+
+//##################################################################################################################
+void			GPS_Crc_Init(void);
+//	Crc is 0 for a new RTCM3 frame, the result can be passed back to continue
+uint32_t	GPS_Crc_24q(uint32_t Crc,const uint8_t *Data,uint32_t Len);
+//	Ck is CK_A | CK_B<<8, 0 for a new UBX frame
+uint16_t	GPS_Crc_Fletcher16(uint16_t Ck,const uint8_t *Data,uint32_t Len);
+#if (_GPS_CRC_HW==1)
+//	MAVLink CRC-16/MCRF4XX from init 0xFFFF on the CRC unit, not reentrant
+uint16_t	GPS_Crc_Mcrf4xx(const uint8_t *Data,uint32_t Len);
+#endif
+#if (_GPS_HOST==1)
+//	checks every path bit-exact against the bitwise reference, then MB/s for each on a Len-byte buffer
+uint8_t		GPS_Crc_Bench(uint32_t Len,uint32_t Rounds,GPS_CrcBench_t *Result);
+void			GPS_Crc_Report(const GPS_CrcBench_t *Result);
+#endif
+//##################################################################################################################
+
+#endif
@@ -0,0 +1,310 @@
+#if !defined(_GNU_SOURCE)
+#define	_GNU_SOURCE								//	pthread_setaffinity_np, ptsname_r
+#endif
+#include "GPSConfig.h"
+
+#if (_GPS_DAEMON==1)
+
+#if (_GPS_HOST==0)
+#error "GPSDaemon needs _GPS_HOST"
+#endif
+
+#include "GPSDaemon.h"
+#include "GPSHost.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <sched.h>
+#include <termios.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/epoll.h>
+#include <sys/resource.h>
+
+#define	GPS_DAEMON_EVENTS							64
+#define	GPS_DAEMON_TICK								10
+
+typedef struct
+{
+	pthread_t					Thread;
+	int								Epoll;
+	uint8_t						Index;
+	GPS_DaemonStats_t	Stats;
+
+}GPS_DaemonWorker_t;
+
+typedef struct
+{
+	GPS_DaemonFix_t			Fix;
+	uint8_t							Workers;
+	volatile uint8_t		Run;
+	volatile uint16_t		Count;
+	pthread_mutex_t			Lock;
+	GPS_DaemonWorker_t	Worker[_GPS_DAEMON_WORKERS];
+	GPS_DaemonPort_t		Port[_GPS_DAEMON_PORTS];
+
+}GPS_Daemon_t;
+
+static GPS_Daemon_t GPS_Daemon={.Lock=PTHREAD_MUTEX_INITIALIZER};
+//##################################################################################################################
+static void	*GPS_Daemon_Worker(void *Arg)
+{
+	GPS_DaemonWorker_t	*w=(GPS_DaemonWorker_t*)Arg;
+	struct epoll_event	ev[GPS_DAEMON_EVENTS];
+	uint8_t							buf[_GPS_DAEMON_READ];
+	while(GPS_Daemon.Run)
+	{
+		int	n=epoll_wait(w->Epoll,ev,GPS_DAEMON_EVENTS,GPS_DAEMON_TICK);
+		w->Stats.Wakeups++;
+		//	read pass: drain every ready port into its own GPS_t
+		for(int i=0 ; i<n ; i++)
+		{
+			GPS_DaemonPort_t	*p=&GPS_Daemon.Port[ev[i].data.u32];
+			ssize_t	len;
+			while((len=read(p->fd,buf,sizeof(buf)))>0)
+			{
+				GPS_RxChunk(&p->Gps,buf,(uint16_t)len);
+				p->Bytes+=(uint32_t)len;
+				w->Stats.Bytes+=(uint64_t)len;
+				w->Stats.Reads++;
+			}
+		}
+		//	decode pass over the shard, a burst is parsed once its port has gone quiet
+		for(uint16_t j=w->Index ; j<GPS_Daemon.Count ; j+=GPS_Daemon.Workers)
+		{
+			GPS_DaemonPort_t	*p=&GPS_Daemon.Port[j];
+			#if (_GPS_STREAM==0)
+			if(p->Gps.rxIndex==0)
+				continue;
+			#endif
+			if(GPS_ProcessEx(&p->Gps)==0)
+				continue;
+			p->Epochs++;
+			w->Stats.Epochs++;
+			if(GPS_Daemon.Fix!=NULL)
+				GPS_Daemon.Fix(j,&p->Gps.Epoch);
+		}
+	}
+	return NULL;
+}
+//##################################################################################################################
+int	GPS_Daemon_Start(uint8_t Workers,GPS_DaemonFix_t Fix)
+{
+	long	cores=sysconf(_SC_NPROCESSORS_ONLN);
+	if((Workers==0) || (Workers>_GPS_DAEMON_WORKERS))
+		Workers=_GPS_DAEMON_WORKERS;
+	HAL_GetTick();
+	GPS_Daemon.Fix=Fix;
+	GPS_Daemon.Workers=Workers;
+	GPS_Daemon.Count=0;
+	GPS_Daemon.Run=1;
+	for(uint8_t i=0 ; i<Workers ; i++)
+	{
+		GPS_DaemonWorker_t	*w=&GPS_Daemon.Worker[i];
+		cpu_set_t	set;
+		memset(&w->Stats,0,sizeof(w->Stats));
+		w->Index=i;
+		w->Epoll=epoll_create1(EPOLL_CLOEXEC);
+		if((w->Epoll<0) || (pthread_create(&w->Thread,NULL,GPS_Daemon_Worker,w)!=0))
+		{
+			//	this worker has no thread to join, Stop() only tears down the ones before it
+			if(w->Epoll>=0)
+				close(w->Epoll);
+			w->Epoll=-1;
+			GPS_Daemon.Workers=i;
+			GPS_Daemon_Stop();
+			return -1;
+		}
+		CPU_ZERO(&set);
+		CPU_SET((int)(i%((cores>0) ? cores : 1)),&set);
+		pthread_setaffinity_np(w->Thread,sizeof(set),&set);
+	}
+	return 0;
+}
+//##################################################################################################################
+void	GPS_Daemon_Stop(void)
+{
+	GPS_Daemon.Run=0;
+	for(uint8_t i=0 ; i<GPS_Daemon.Workers ; i++)
+	{
+		pthread_join(GPS_Daemon.Worker[i].Thread,NULL);
+		close(GPS_Daemon.Worker[i].Epoll);
+	}
+	for(uint16_t j=0 ; j<GPS_Daemon.Count ; j++)
+		close(GPS_Daemon.Port[j].fd);
+	GPS_Daemon.Count=0;
+	GPS_Daemon.Workers=0;
+}
+//##################################################################################################################
+int	GPS_Daemon_AddFd(int fd)
+{
+	struct epoll_event	ev;
+	GPS_DaemonPort_t		*p;
+	int		port;
+	pthread_mutex_lock(&GPS_Daemon.Lock);
+	if((GPS_Daemon.Workers==0) || (GPS_Daemon.Count>=_GPS_DAEMON_PORTS))
+	{
+		pthread_mutex_unlock(&GPS_Daemon.Lock);
+		return -1;
+	}
+	port=GPS_Daemon.Count;
+	p=&GPS_Daemon.Port[port];
+	memset(p,0,sizeof(GPS_DaemonPort_t));
+	p->fd=fd;
+	GPS_InitEx(&p->Gps);
+	fcntl(fd,F_SETFL,fcntl(fd,F_GETFL) | O_NONBLOCK);
+	ev.events=EPOLLIN;
+	ev.data.u32=(uint32_t)port;
+	//	the port is visible to its worker's decode pass only after Count moves on
+	if(epoll_ctl(GPS_Daemon.Worker[port%GPS_Daemon.Workers].Epoll,EPOLL_CTL_ADD,fd,&ev)<0)
+		port=-1;
+	else
+		__atomic_store_n(&GPS_Daemon.Count,(uint16_t)(port+1),__ATOMIC_RELEASE);
+	pthread_mutex_unlock(&GPS_Daemon.Lock);
+	return port;
+}
+//##################################################################################################################
+int	GPS_Daemon_Open(const char *Path,uint32_t Baud)
+{
+	static const struct {uint32_t Baud;speed_t Speed;}	speeds[]=
+	{
+		{4800,B4800},{9600,B9600},{19200,B19200},{38400,B38400},{57600,B57600},{115200,B115200},{230400,B230400},{460800,B460800},{921600,B921600},
+	};
+	struct termios	tio;
+	int	port,fd=open(Path,O_RDWR | O_NOCTTY | O_NONBLOCK | O_CLOEXEC);
+	if(fd<0)
+		return -1;
+	if(tcgetattr(fd,&tio)==0)
+	{
+		cfmakeraw(&tio);
+		for(uint8_t i=0 ; i<sizeof(speeds)/sizeof(speeds[0]) ; i++)
+			if(speeds[i].Baud==Baud)
+			{
+				cfsetispeed(&tio,speeds[i].Speed);
+				cfsetospeed(&tio,speeds[i].Speed);
+			}
+		tio.c_cflag|=CLOCAL | CREAD;
+		tcsetattr(fd,TCSANOW,&tio);
+	}
+	port=GPS_Daemon_AddFd(fd);
+	if(port<0)
+		close(fd);
+	return port;
+}
+//##################################################################################################################
+const GPS_DaemonPort_t	*GPS_Daemon_Port(uint16_t Port)
+{
+	return (Port<GPS_Daemon.Count) ? &GPS_Daemon.Port[Port] : NULL;
+}
+//##################################################################################################################
+void	GPS_Daemon_Stats(GPS_DaemonStats_t *Stats)
+{
+	//	read while running, the counters are approximate
+	memset(Stats,0,sizeof(GPS_DaemonStats_t));
+	for(uint8_t i=0 ; i<GPS_Daemon.Workers ; i++)
+	{
+		Stats->Wakeups+=GPS_Daemon.Worker[i].Stats.Wakeups;
+		Stats->Reads+=GPS_Daemon.Worker[i].Stats.Reads;
+		Stats->Bytes+=GPS_Daemon.Worker[i].Stats.Bytes;
+		Stats->Epochs+=GPS_Daemon.Worker[i].Stats.Epochs;
+	}
+}
+//##################################################################################################################
+static double	GPS_Daemon_Cpu(void)
+{
+	struct rusage	ru;
+	getrusage(RUSAGE_SELF,&ru);
+	return ru.ru_utime.tv_sec+ru.ru_stime.tv_sec+(ru.ru_utime.tv_usec+ru.ru_stime.tv_usec)*1e-6;
+}
+//##################################################################################################################
+static uint16_t	GPS_Daemon_Sentence(char *Out,uint16_t Size,const char *Body)
+{
+	uint8_t	cs=0;
+	for(const char *c=Body ; *c!=0 ; c++)
+		cs^=(uint8_t)*c;
+	return (uint16_t)snprintf(Out,Size,"$%s*%02X\r\n",Body,cs);
+}
+//##################################################################################################################
+uint8_t	GPS_Daemon_Bench(uint16_t Ports,uint16_t Rate,uint32_t Seconds,GPS_DaemonBench_t *Result)
+{
+	//	the masters of the ptys are written from this thread, one GGA+GNS+GST burst per port and epoch
+	int							*master;
+	struct rlimit		rl;
+	struct timespec	next;
+	double					cpu;
+	GPS_DaemonStats_t	stats;
+	uint16_t				open=0;
+	memset(Result,0,sizeof(GPS_DaemonBench_t));
+	getrlimit(RLIMIT_NOFILE,&rl);
+	rl.rlim_cur=rl.rlim_max;
+	setrlimit(RLIMIT_NOFILE,&rl);
+	master=(int*)calloc(Ports,sizeof(int));
+	if((master==NULL) || (Rate==0) || (GPS_Daemon_Start(0,NULL)!=0))
+	{
+		free(master);
+		return 0;
+	}
+	for( ; open<Ports ; open++)
+	{
+		char	name[64];
+		master[open]=posix_openpt(O_RDWR | O_NOCTTY | O_NONBLOCK);
+		if((master[open]<0) || (grantpt(master[open])!=0) || (unlockpt(master[open])!=0) || (ptsname_r(master[open],name,sizeof(name))!=0) || (GPS_Daemon_Open(name,115200)<0))
+		{
+			if(master[open]>=0)
+				close(master[open]);
+			break;
+		}
+	}
+	Result->Ports=open;
+	Result->Rate=Rate;
+	Result->Seconds=Seconds;
+	cpu=GPS_Daemon_Cpu();
+	clock_gettime(CLOCK_MONOTONIC,&next);
+	for(uint32_t e=0 ; e<Seconds*Rate ; e++)
+	{
+		uint32_t	ms=(uint32_t)((43200000ULL+(uint64_t)e*1000/Rate)%86400000);
+		char			utc[16],body[128],burst[384];
+		uint16_t	len;
+		snprintf(utc,sizeof(utc),"%02u%02u%02u.%02u",(unsigned)(ms/3600000),(unsigned)(ms/60000%60),(unsigned)(ms/1000%60),(unsigned)(ms%1000/10));
+		snprintf(body,sizeof(body),"GPGGA,%s,4807.0380,N,01131.0000,E,1,09,0.90,545.4,M,46.9,M,,",utc);
+		len=GPS_Daemon_Sentence(burst,sizeof(burst),body);
+		snprintf(body,sizeof(body),"GNGNS,%s,4807.0380,N,01131.0000,E,AAN,14,0.80,545.4,46.9,,,V",utc);
+		len+=GPS_Daemon_Sentence(&burst[len],(uint16_t)(sizeof(burst)-len),body);
+		snprintf(body,sizeof(body),"GNGST,%s,0.6,1.8,1.1,45.0,1.5,1.2,3.0",utc);
+		len+=GPS_Daemon_Sentence(&burst[len],(uint16_t)(sizeof(burst)-len),body);
+		for(uint16_t i=0 ; i<open ; i++)
+			if(write(master[i],burst,len)!=len)
+				break;
+		next.tv_nsec+=1000000000L/Rate;
+		while(next.tv_nsec>=1000000000L)
+		{
+			next.tv_nsec-=1000000000L;
+			next.tv_sec++;
+		}
+		clock_nanosleep(CLOCK_MONOTONIC,TIMER_ABSTIME,&next,NULL);
+	}
+	usleep(200000);
+	Result->Cpu=(GPS_Daemon_Cpu()-cpu)/Seconds;
+	GPS_Daemon_Stats(&stats);
+	GPS_Daemon_Stop();
+	for(uint16_t i=0 ; i<open ; i++)
+		close(master[i]);
+	free(master);
+	Result->Expected=(uint64_t)open*Seconds*Rate;
+	Result->Epochs=stats.Epochs;
+	Result->EpochsPerWakeup=(stats.Wakeups>0) ? (double)stats.Epochs/stats.Wakeups : 0.0;
+	return (open==Ports);
+}
+//##################################################################################################################
+void	GPS_Daemon_Report(const GPS_DaemonBench_t *Result)
+{
+	printf("%u ports at %u Hz for %u s: %llu/%llu epochs decoded, %.1f%% of one core, %.2f epochs per wakeup\r\n",
+		Result->Ports,Result->Rate,(unsigned)Result->Seconds,(unsigned long long)Result->Epochs,(unsigned long long)Result->Expected,
+		Result->Cpu*100.0,Result->EpochsPerWakeup);
+}
+//##################################################################################################################
+
+#endif
@@ -0,0 +1,60 @@
+#ifndef _GPSDAEMON_H_
+#define _GPSDAEMON_H_
+
+#include <stdint.h>
+#include "GPSConfig.h"
+#include "GPS.h"
+
+//##################################################################################################################
+//	Linux daemon core for many serial/pty receivers. Ports are sharded over a fixed pool of worker threads, one
+//	per core, each with its own epoll set. A worker reads every ready port first and then decodes the batch, so
+//	one wakeup serves many ports.
+//##################################################################################################################
+
+//	called from the worker thread that owns the port
+typedef void	(*GPS_DaemonFix_t)(uint16_t Port,const GPS_Epoch_t *Epoch);
+
+typedef struct
+{
+	int					fd;
+	GPS_t				Gps;
+	uint32_t		Bytes;
+	uint32_t		Epochs;
+
+}GPS_DaemonPort_t;
+
+typedef struct
+{
+	uint64_t		Wakeups;
+	uint64_t		Reads;
+	uint64_t		Bytes;
+	uint64_t		Epochs;
+
+}GPS_DaemonStats_t;
+
+typedef struct
+{
+	uint16_t		Ports;
+	uint16_t		Rate;
+	uint32_t		Seconds;
+	uint64_t		Expected;
+	uint64_t		Epochs;
+	double			Cpu;
+	double			EpochsPerWakeup;
+
+}GPS_DaemonBench_t;
+
+//##################################################################################################################
+int				GPS_Daemon_Start(uint8_t Workers,GPS_DaemonFix_t Fix);
+void			GPS_Daemon_Stop(void);
+//	both return the port number or -1
+int				GPS_Daemon_Open(const char *Path,uint32_t Baud);
+int				GPS_Daemon_AddFd(int fd);
+const GPS_DaemonPort_t	*GPS_Daemon_Port(uint16_t Port);
+void			GPS_Daemon_Stats(GPS_DaemonStats_t *Stats);
+//	Ports simulated receivers on ptys at Rate Hz for Seconds
+uint8_t		GPS_Daemon_Bench(uint16_t Ports,uint16_t Rate,uint32_t Seconds,GPS_DaemonBench_t *Result);
+void			GPS_Daemon_Report(const GPS_DaemonBench_t *Result);
+//##################################################################################################################
+
+#endif
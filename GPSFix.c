@@ -0,0 +1,163 @@
+#include "GPSConfig.h"
+
+#if (_GPS_FIX==1)
+
+#include "GPSFix.h"
+#include <string.h>
+#include <math.h>
+#if (_GPS_HOST==1)
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#endif
+
+typedef char	GPS_FixSize[(sizeof(GPS_Fix_t)==32) ? 1 : -1];
+typedef char	GPS_FixAlign[(_Alignof(GPS_Fix_t)==32) ? 1 : -1];
+//##################################################################################################################
+static int32_t	GPS_Fix_Round(double Value,double Min,double Max)
+{
+	if(Value<Min)
+		Value=Min;
+	else if(Value>Max)
+		Value=Max;
+	return (int32_t)lround(Value);
+}
+//##################################################################################################################
+void	GPS_Fix_FromEpoch(const GPS_Epoch_t *Epoch,GPS_Fix_t *Fix)
+{
+	memset(Fix,0,sizeof(GPS_Fix_t));
+	Fix->Latitude=GPS_Fix_Round(Epoch->Latitude*1e7,-900000000.0,900000000.0);
+	Fix->Longitude=GPS_Fix_Round(Epoch->Longitude*1e7,-1800000000.0,1800000000.0);
+	Fix->Altitude=GPS_Fix_Round(Epoch->MSL_Altitude*1000.0,-2e9,2e9);
+	Fix->UTC_Time=Epoch->UTC_Time;
+	Fix->Geoid=(int16_t)GPS_Fix_Round(Epoch->Geoid_Separation*100.0,-32768.0,32767.0);
+	Fix->HDOP=(uint16_t)GPS_Fix_Round(Epoch->HDOP*100.0,0.0,65535.0);
+	Fix->SigmaHorizontal=(uint16_t)GPS_Fix_Round(hypot(Epoch->SigmaLatitude,Epoch->SigmaLongitude)*100.0,0.0,65535.0);
+	Fix->SigmaVertical=(uint16_t)GPS_Fix_Round(Epoch->SigmaAltitude*100.0,0.0,65535.0);
+	Fix->Fix=Epoch->Fix;
+	Fix->SatellitesUsed=Epoch->SatellitesUsed;
+	Fix->Sentences=Epoch->Sentences;
+}
+//##################################################################################################################
+void	GPS_Fix_Split(const GPS_t *Gps,const GPS_Epoch_t *Epoch,GPS_Fix_t *Fix,GPS_FixCold_t *Cold)
+{
+	GPS_FixCold_t	*c=Cold;
+	GPS_Fix_FromEpoch(Epoch,Fix);
+	memset(c,0,sizeof(GPS_FixCold_t));
+	memcpy(c->Mode,Epoch->Mode,sizeof(c->Mode));
+	c->RMS=Epoch->RMS;
+	c->SigmaMajor=Epoch->SigmaMajor;
+	c->SigmaMinor=Epoch->SigmaMinor;
+	c->Orientation=Epoch->Orientation;
+	c->SigmaLatitude=Epoch->SigmaLatitude;
+	c->SigmaLongitude=Epoch->SigmaLongitude;
+	if(Epoch->Sentences & GPS_EPOCH_GNS)
+		c->NavStatus=Gps->GPGNS.NavStatus;
+	if(Epoch->Sentences & GPS_EPOCH_GGA)
+	{
+		c->MSL_Units=Gps->GPGGA.MSL_Units;
+		c->Geoid_Units=Gps->GPGGA.Geoid_Units;
+		c->AgeofDiffCorr=Gps->GPGGA.AgeofDiffCorr;
+		memcpy(c->DiffRefStationID,Gps->GPGGA.DiffRefStationID,sizeof(c->DiffRefStationID));
+		memcpy(c->CheckSum,Gps->GPGGA.CheckSum,sizeof(c->CheckSum));
+	}
+}
+//##################################################################################################################
+void	GPS_Fix_Update(GPS_t *Gps)
+{
+	GPS_Fix_Split(Gps,&Gps->Epoch,&Gps->Fix,&Gps->FixCold);
+}
+//##################################################################################################################
+#if (_GPS_HOST==1)
+static double	GPS_Fix_Now(void)
+{
+	struct timespec	ts;
+	clock_gettime(CLOCK_MONOTONIC,&ts);
+	return ts.tv_sec+ts.tv_nsec*1e-9;
+}
+//##################################################################################################################
+uint8_t	GPS_Fix_Bench(uint32_t Count,GPS_FixBench_t *Result)
+{
+	GPS_Epoch_t	*e=(GPS_Epoch_t*)malloc((size_t)Count*sizeof(GPS_Epoch_t));
+	GPS_Fix_t		*f=(GPS_Fix_t*)aligned_alloc(32,(size_t)Count*sizeof(GPS_Fix_t));
+	uint32_t		seed=12345;
+	memset(Result,0,sizeof(GPS_FixBench_t));
+	if((e==NULL) || (f==NULL))
+	{
+		free(e);
+		free(f);
+		return 0;
+	}
+	Result->Count=Count;
+	Result->EpochSize=sizeof(GPS_Epoch_t);
+	Result->GgaSize=sizeof(GPGGA_t);
+	Result->FixSize=sizeof(GPS_Fix_t);
+	Result->EpochPerLine=64.0/sizeof(GPS_Epoch_t);
+	Result->FixPerLine=64.0/sizeof(GPS_Fix_t);
+	memset(e,0,(size_t)Count*sizeof(GPS_Epoch_t));
+	for(uint32_t i=0 ; i<Count ; i++)
+	{
+		seed=seed*1664525+1013904223;
+		e[i].UTC_Time=i*100;
+		e[i].Latitude=48.1+(seed>>8)*1e-10;
+		e[i].Longitude=11.5-(seed>>12)*1e-9;
+		e[i].MSL_Altitude=545.0f+(float)(seed & 1023)*0.01f;
+		e[i].HDOP=0.5f+(float)(seed>>28)*0.1f;
+		e[i].Fix=(uint8_t)((seed>>20) % 5);
+		e[i].SatellitesUsed=12;
+		GPS_Fix_FromEpoch(&e[i],&f[i]);
+	}
+	for(uint8_t r=0 ; r<5 ; r++)
+	{
+		//	the same query on both layouts, best of five. The sums keep the compiler from dropping the loops.
+		volatile double	sink;
+		double		t=GPS_Fix_Now();
+		double		lat0=90.0,lat1=-90.0,lon0=180.0,lon1=-180.0;
+		float			hdop=0.0f;
+		uint32_t	fixed=0;
+		int32_t		ilat0=INT32_MAX,ilat1=INT32_MIN,ilon0=INT32_MAX,ilon1=INT32_MIN;
+		uint16_t	ihdop=0;
+		for(uint32_t i=0 ; i<Count ; i++)
+		{
+			lat0=(e[i].Latitude<lat0) ? e[i].Latitude : lat0;
+			lat1=(e[i].Latitude>lat1) ? e[i].Latitude : lat1;
+			lon0=(e[i].Longitude<lon0) ? e[i].Longitude : lon0;
+			lon1=(e[i].Longitude>lon1) ? e[i].Longitude : lon1;
+			hdop=(e[i].HDOP>hdop) ? e[i].HDOP : hdop;
+			fixed+=(e[i].Fix>0);
+		}
+		sink=lat0+lat1+lon0+lon1+hdop+fixed;
+		t=(GPS_Fix_Now()-t)*1e9/Count;
+		if((r==0) || (t<Result->EpochScan))
+			Result->EpochScan=t;
+		t=GPS_Fix_Now();
+		fixed=0;
+		for(uint32_t i=0 ; i<Count ; i++)
+		{
+			ilat0=(f[i].Latitude<ilat0) ? f[i].Latitude : ilat0;
+			ilat1=(f[i].Latitude>ilat1) ? f[i].Latitude : ilat1;
+			ilon0=(f[i].Longitude<ilon0) ? f[i].Longitude : ilon0;
+			ilon1=(f[i].Longitude>ilon1) ? f[i].Longitude : ilon1;
+			ihdop=(f[i].HDOP>ihdop) ? f[i].HDOP : ihdop;
+			fixed+=(f[i].Fix>0);
+		}
+		sink=(double)ilat0+ilat1+ilon0+ilon1+ihdop+fixed;
+		(void)sink;
+		t=(GPS_Fix_Now()-t)*1e9/Count;
+		if((r==0) || (t<Result->FixScan))
+			Result->FixScan=t;
+	}
+	free(e);
+	free(f);
+	return 1;
+}
+//##################################################################################################################
+void	GPS_Fix_Report(const GPS_FixBench_t *Result)
+{
+	printf("GPGGA_t %lu bytes, GPS_Epoch_t %lu bytes (%.2f per cache line), GPS_Fix_t %lu bytes (%.2f per cache line)\r\n",(unsigned long)Result->GgaSize,(unsigned long)Result->EpochSize,Result->EpochPerLine,(unsigned long)Result->FixSize,Result->FixPerLine);
+	printf("scan of %lu records: GPS_Epoch_t %.2f ns, GPS_Fix_t %.2f ns per record\r\n",(unsigned long)Result->Count,Result->EpochScan,Result->FixScan);
+}
+#endif
+//##################################################################################################################
+
+#endif
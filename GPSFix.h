@@ -0,0 +1,41 @@
+#ifndef _GPSFIX_H_
+#define _GPSFIX_H_
+
+#include <stdint.h>
+#include "GPSConfig.h"
+#include "GPS.h"
+
+//##################################################################################################################
+//	Hot/cold split of the epoch. GPS_Fix_t keeps what every consumer reads in 32 bytes of fixed point, for bulk
+//	arrays and the fix queue (_GPS_QUEUE_HOT). GPS_FixCold_t keeps the per-constellation modes, the GST ellipse,
+//	differential data and the sentence leftovers. GPS_t.Fix and GPS_t.FixCold follow every merged epoch.
+//##################################################################################################################
+
+#if (_GPS_HOST==1)
+typedef struct
+{
+	uint32_t		Count;
+	uint32_t		EpochSize;
+	uint32_t		GgaSize;
+	uint32_t		FixSize;
+	double			EpochPerLine;
+	double			FixPerLine;
+	double			EpochScan;
+	double			FixScan;
+
+}GPS_FixBench_t;
+#endif
+
+//##################################################################################################################
+void			GPS_Fix_FromEpoch(const GPS_Epoch_t *Epoch,GPS_Fix_t *Fix);
+//	Fix and Cold of Epoch, the sentence leftovers come from the GPGGA/GPGNS of Gps it was merged from
+void			GPS_Fix_Split(const GPS_t *Gps,const GPS_Epoch_t *Epoch,GPS_Fix_t *Fix,GPS_FixCold_t *Cold);
+void			GPS_Fix_Update(GPS_t *Gps);
+#if (_GPS_HOST==1)
+//	bounding box, fixed count and worst HDOP over Count records, GPS_Epoch_t[] against GPS_Fix_t[], in ns per record
+uint8_t		GPS_Fix_Bench(uint32_t Count,GPS_FixBench_t *Result);
+void			GPS_Fix_Report(const GPS_FixBench_t *Result);
+#endif
+//##################################################################################################################
+
+#endif
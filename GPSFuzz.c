@@ -0,0 +1,304 @@
+#include "GPSConfig.h"
+
+#if (_GPS_FUZZ==1)
+
+#if (_GPS_HOST==0)
+#error "GPSFuzz needs _GPS_HOST"
+#endif
+
+#include "GPSFuzz.h"
+#include "GPS.h"
+#include "GPSHost.h"
+#include <string.h>
+#include <stdio.h>
+#include <time.h>
+
+#define	GPS_FUZZ_MAP								65536
+#define	GPS_FUZZ_REPEAT							3
+//	short inputs are charged as this many bytes, so the fixed cost of GPS_Process() does not win on its own
+#define	GPS_FUZZ_FLOOR							128
+
+typedef struct
+{
+	uint16_t		Len;
+	double			Cost;
+	uint8_t			Data[_GPS_FUZZ_INPUT];
+
+}GPS_FuzzInput_t;
+
+typedef struct
+{
+	GPS_FuzzInput_t	Corpus[_GPS_FUZZ_CORPUS];
+	GPS_FuzzInput_t	Keep[_GPS_FUZZ_KEEP];
+	uint32_t				Count;
+	uint32_t				Kept;
+	uint32_t				Seed;
+	uint32_t				Tick;
+	uintptr_t				Prev;
+	uint8_t					Map[GPS_FUZZ_MAP/8];
+	uint8_t					Run[GPS_FUZZ_MAP/8];
+
+}GPS_Fuzz_t;
+
+static GPS_Fuzz_t	GPS_Fuzz;
+
+static const char	*GPS_FuzzDict[]=
+{
+	"$GPGGA,","$GNGNS,","$GNGST,","GNS,","GST,",",",",,,,,,,,","$","*","*69","\r\n",".","-","N","S","E","W","RAN",
+	"123519.00","4807.038","01131.000","545.4","0000000000","9999999999",
+};
+
+static const char	*GPS_FuzzSeeds[]=
+{
+	"$GPGGA,123519.00,4807.038,N,01131.000,E,1,08,0.9,545.4,M,46.9,M,,*69\r\n",
+	"$GNGNS,123519.00,4807.0381,N,01131.0002,E,RAN,14,0.8,545.4,46.9,,,V*75\r\n",
+	"$GNGST,123519.00,0.6,0.02,0.01,45.0,0.015,0.012,0.03*44\r\n",
+	"$GPGGA,,,,,,0,00,99.99,,,,,,*48\r\n",
+};
+//##################################################################################################################
+void	__sanitizer_cov_trace_pc(void)
+{
+	//	AFL-style edge hash of the caller and the previous block
+	uintptr_t	pc=(uintptr_t)__builtin_return_address(0);
+	uint32_t	e=(uint32_t)((pc ^ GPS_Fuzz.Prev)*0x9E3779B1U)>>16;
+	GPS_Fuzz.Run[e>>3]|=(uint8_t)(1<<(e & 7));
+	GPS_Fuzz.Prev=pc>>1;
+}
+//##################################################################################################################
+static uint32_t	GPS_Fuzz_Random(uint32_t Range)
+{
+	GPS_Fuzz.Seed^=GPS_Fuzz.Seed<<13;
+	GPS_Fuzz.Seed^=GPS_Fuzz.Seed>>17;
+	GPS_Fuzz.Seed^=GPS_Fuzz.Seed<<5;
+	return (Range>0) ? GPS_Fuzz.Seed%Range : 0;
+}
+//##################################################################################################################
+static double	GPS_Fuzz_Exec(const uint8_t *Data,uint32_t Len,uint8_t Repeat)
+{
+	//	one receive burst as the usart interrupt sees it, then GPS_Process() once the line is idle. Best of Repeat,
+	//	in ns per byte with the GPS_FUZZ_FLOOR minimum.
+	uint32_t	best=0xFFFFFFFFUL;
+	for(uint8_t r=0 ; r<Repeat ; r++)
+	{
+		uint32_t	t=GPS_Host_Cycles();
+		GPS_Host_Feed(&_GPS_USART,Data,Len);
+		GPS_Host_SetTick(GPS_Fuzz.Tick+=100);
+		GPS_Process();
+		t=GPS_Host_Cycles()-t;
+		if(t<best)
+			best=t;
+	}
+	return (double)best/((Len>GPS_FUZZ_FLOOR) ? Len : GPS_FUZZ_FLOOR);
+}
+//##################################################################################################################
+static uint32_t	GPS_Fuzz_Coverage(void)
+{
+	//	new edges of the last run, merged into the global map
+	uint32_t	n=0;
+	for(uint32_t i=0 ; i<sizeof(GPS_Fuzz.Map) ; i++)
+	{
+		uint8_t	b=(uint8_t)(GPS_Fuzz.Run[i] & ~GPS_Fuzz.Map[i]);
+		if(b!=0)
+		{
+			n+=(uint32_t)__builtin_popcount(b);
+			GPS_Fuzz.Map[i]|=b;
+		}
+	}
+	memset(GPS_Fuzz.Run,0,sizeof(GPS_Fuzz.Run));
+	return n;
+}
+//##################################################################################################################
+static uint16_t	GPS_Fuzz_Insert(uint8_t *Data,uint16_t Len,uint16_t At,const uint8_t *Src,uint16_t n)
+{
+	if(Len+n>_GPS_FUZZ_INPUT)
+		n=(uint16_t)(_GPS_FUZZ_INPUT-Len);
+	memmove(&Data[At+n],&Data[At],Len-At);
+	memcpy(&Data[At],Src,n);
+	return (uint16_t)(Len+n);
+}
+//##################################################################################################################
+static uint16_t	GPS_Fuzz_Mutate(uint8_t *Data,uint16_t Len)
+{
+	//	a few stacked edits. Runs of a repeated chunk find the comma, '$' and long field cases.
+	uint8_t		tmp[_GPS_FUZZ_INPUT];
+	for(uint8_t k=(uint8_t)(1+GPS_Fuzz_Random(4)) ; k>0 ; k--)
+	{
+		uint16_t	at=(uint16_t)GPS_Fuzz_Random(Len+1);
+		switch(GPS_Fuzz_Random(7))
+		{
+			case 0:
+				if(Len>0)
+					Data[GPS_Fuzz_Random(Len)]^=(uint8_t)(1<<GPS_Fuzz_Random(8));
+			break;
+			case 1:
+				if(Len>0)
+					Data[GPS_Fuzz_Random(Len)]=(uint8_t)GPS_Fuzz_Random(256);
+			break;
+			case 2:
+			{
+				const char	*d=GPS_FuzzDict[GPS_Fuzz_Random(sizeof(GPS_FuzzDict)/sizeof(GPS_FuzzDict[0]))];
+				Len=GPS_Fuzz_Insert(Data,Len,at,(const uint8_t*)d,(uint16_t)strlen(d));
+			}
+			break;
+			case 3:
+				if(Len>at)
+				{
+					uint16_t	n=(uint16_t)(1+GPS_Fuzz_Random(Len-at));
+					memmove(&Data[at],&Data[at+n],Len-at-n);
+					Len=(uint16_t)(Len-n);
+				}
+			break;
+			case 4:
+				//	repeat a chunk until the input is full or the count runs out
+				if(Len>at)
+				{
+					uint16_t	n=(uint16_t)(1+GPS_Fuzz_Random((Len-at<16) ? Len-at : 16));
+					memcpy(tmp,&Data[at],n);
+					for(uint16_t r=(uint16_t)GPS_Fuzz_Random(64) ; (r>0) && (Len+n<=_GPS_FUZZ_INPUT) ; r--)
+						Len=GPS_Fuzz_Insert(Data,Len,at,tmp,n);
+				}
+			break;
+			case 5:
+				//	splice with another kept input
+				if(GPS_Fuzz.Count>0)
+				{
+					const GPS_FuzzInput_t	*o=&GPS_Fuzz.Corpus[GPS_Fuzz_Random(GPS_Fuzz.Count)];
+					uint16_t	from=(uint16_t)GPS_Fuzz_Random(o->Len);
+					Len=GPS_Fuzz_Insert(Data,Len,at,&o->Data[from],(uint16_t)(o->Len-from));
+				}
+			break;
+			default:
+				Len=at;
+			break;
+		}
+	}
+	return Len;
+}
+//##################################################################################################################
+static void	GPS_Fuzz_Rank(GPS_FuzzInput_t *List,uint32_t *Count,uint32_t Max,const uint8_t *Data,uint16_t Len,double Cost)
+{
+	//	sorted by cost, the cheapest drops out when the list is full
+	uint32_t	i=*Count;
+	if(i==Max)
+	{
+		if(Cost<=List[Max-1].Cost)
+			return;
+		i--;
+	}
+	else
+		(*Count)++;
+	for( ; (i>0) && (List[i-1].Cost<Cost) ; i--)
+		List[i]=List[i-1];
+	List[i].Len=Len;
+	List[i].Cost=Cost;
+	memcpy(List[i].Data,Data,Len);
+}
+//##################################################################################################################
+static void	GPS_Fuzz_Sort(GPS_FuzzInput_t *List,uint32_t Count)
+{
+	//	back into cost order after costs changed in place
+	for(uint32_t i=1 ; i<Count ; i++)
+		for(uint32_t j=i ; (j>0) && (List[j-1].Cost<List[j].Cost) ; j--)
+		{
+			GPS_FuzzInput_t	t=List[j];
+			List[j]=List[j-1];
+			List[j-1]=t;
+		}
+}
+//##################################################################################################################
+uint8_t	GPS_Fuzz_Run(uint32_t Seconds,uint32_t Seed,double Limit,GPS_FuzzResult_t *Result)
+{
+	uint8_t		input[_GPS_FUZZ_INPUT];
+	uint8_t		burst[256];
+	uint16_t	len=0;
+	time_t		end=time(NULL)+Seconds;
+	memset(&GPS_Fuzz,0,sizeof(GPS_Fuzz));
+	memset(Result,0,sizeof(GPS_FuzzResult_t));
+	GPS_Fuzz.Seed=(Seed!=0) ? Seed : 1;
+	GPS_Host_VirtualTick(1);
+	GPS_Init();
+	//	the reference cost, a normal epoch
+	for(uint8_t i=0 ; i<3 ; i++)
+	{
+		memcpy(&burst[len],GPS_FuzzSeeds[i],strlen(GPS_FuzzSeeds[i]));
+		len=(uint16_t)(len+strlen(GPS_FuzzSeeds[i]));
+	}
+	Result->Baseline=GPS_Fuzz_Exec(burst,len,50);
+	for(uint8_t i=0 ; i<sizeof(GPS_FuzzSeeds)/sizeof(GPS_FuzzSeeds[0]) ; i++)
+	{
+		len=(uint16_t)strlen(GPS_FuzzSeeds[i]);
+		GPS_Fuzz_Rank(GPS_Fuzz.Corpus,&GPS_Fuzz.Count,_GPS_FUZZ_CORPUS,(const uint8_t*)GPS_FuzzSeeds[i],len,GPS_Fuzz_Exec((const uint8_t*)GPS_FuzzSeeds[i],len,GPS_FUZZ_REPEAT));
+		Result->Features+=GPS_Fuzz_Coverage();
+	}
+	while(time(NULL)<end)
+	{
+		for(uint16_t b=0 ; b<256 ; b++)
+		{
+			//	half of the parents are among the eight costliest
+			uint32_t	pick=(GPS_Fuzz_Random(2)==0) ? GPS_Fuzz_Random((GPS_Fuzz.Count<8) ? GPS_Fuzz.Count : 8) : GPS_Fuzz_Random(GPS_Fuzz.Count);
+			const GPS_FuzzInput_t	*p=&GPS_Fuzz.Corpus[pick];
+			double		cost;
+			uint32_t	edges;
+			memcpy(input,p->Data,p->Len);
+			len=GPS_Fuzz_Mutate(input,p->Len);
+			if(len==0)
+				continue;
+			cost=GPS_Fuzz_Exec(input,len,GPS_FUZZ_REPEAT);
+			edges=GPS_Fuzz_Coverage();
+			Result->Execs++;
+			Result->Features+=edges;
+			if((edges>0) || (GPS_Fuzz.Count<_GPS_FUZZ_CORPUS) || (cost>GPS_Fuzz.Corpus[GPS_Fuzz.Count-1].Cost))
+				GPS_Fuzz_Rank(GPS_Fuzz.Corpus,&GPS_Fuzz.Count,_GPS_FUZZ_CORPUS,input,len,(edges>0) ? cost+1e9 : cost);
+			GPS_Fuzz_Rank(GPS_Fuzz.Keep,&GPS_Fuzz.Kept,_GPS_FUZZ_KEEP,input,len,cost);
+		}
+		//	new coverage gets one round at the front, then competes on cost
+		for(uint32_t i=0 ; i<GPS_Fuzz.Count ; i++)
+			if(GPS_Fuzz.Corpus[i].Cost>=1e9)
+				GPS_Fuzz.Corpus[i].Cost-=1e9;
+		GPS_Fuzz_Sort(GPS_Fuzz.Corpus,GPS_Fuzz.Count);
+	}
+	//	the worst are timed again with more runs so a preempted run does not stay on top
+	for(uint32_t i=0 ; i<GPS_Fuzz.Kept ; i++)
+		GPS_Fuzz.Keep[i].Cost=GPS_Fuzz_Exec(GPS_Fuzz.Keep[i].Data,GPS_Fuzz.Keep[i].Len,50);
+	GPS_Fuzz_Sort(GPS_Fuzz.Keep,GPS_Fuzz.Kept);
+	Result->Corpus=GPS_Fuzz.Count;
+	Result->Worst=(GPS_Fuzz.Kept>0) ? GPS_Fuzz.Keep[0].Cost : 0.0;
+	Result->Slowdown=(Result->Baseline>0.0) ? Result->Worst/Result->Baseline : 0.0;
+	return Result->Slowdown<=Limit;
+}
+//##################################################################################################################
+uint32_t	GPS_Fuzz_Worst(uint8_t Rank,const uint8_t **Data,double *Cost)
+{
+	if(Rank>=GPS_Fuzz.Kept)
+		return 0;
+	*Data=GPS_Fuzz.Keep[Rank].Data;
+	if(Cost!=NULL)
+		*Cost=GPS_Fuzz.Keep[Rank].Cost;
+	return GPS_Fuzz.Keep[Rank].Len;
+}
+//##################################################################################################################
+uint8_t	GPS_Fuzz_Save(const char *Dir)
+{
+	uint8_t	n=0;
+	for(uint32_t i=0 ; i<GPS_Fuzz.Kept ; i++)
+	{
+		char	path[256];
+		FILE	*f;
+		snprintf(path,sizeof(path),"%s/worst-%02lu.nmea",Dir,(unsigned long)i);
+		if((f=fopen(path,"wb"))==NULL)
+			continue;
+		if(fwrite(GPS_Fuzz.Keep[i].Data,1,GPS_Fuzz.Keep[i].Len,f)==GPS_Fuzz.Keep[i].Len)
+			n++;
+		fclose(f);
+	}
+	return n;
+}
+//##################################################################################################################
+void	GPS_Fuzz_Report(const GPS_FuzzResult_t *Result)
+{
+	printf("%llu execs, %lu edges, %lu inputs kept\r\n",(unsigned long long)Result->Execs,(unsigned long)Result->Features,(unsigned long)Result->Corpus);
+	printf("valid burst %.1f ns/byte, worst input %.1f ns/byte (%.1fx)\r\n",Result->Baseline,Result->Worst,Result->Slowdown);
+}
+//##################################################################################################################
+
+#endif
@@ -0,0 +1,35 @@
+#ifndef _GPSFUZZ_H_
+#define _GPSFUZZ_H_
+
+#include <stdint.h>
+#include "GPSConfig.h"
+
+//##################################################################################################################
+//	Performance fuzzer for the host build. Inputs go through GPS_Host_Feed() (GPS_CallBack per byte) and one
+//	GPS_Process() after the idle gap, and their cost is the best of a few runs in ns per byte. An input is kept
+//	when it reaches new code or costs more than the cheapest kept one, and the costliest are mutated most.
+//	Coverage needs GPS.c built with -fsanitize-coverage=trace-pc; without it the search is guided by cost only.
+//##################################################################################################################
+
+typedef struct
+{
+	uint64_t		Execs;
+	uint32_t		Features;
+	uint32_t		Corpus;
+	double			Baseline;
+	double			Worst;
+	double			Slowdown;
+
+}GPS_FuzzResult_t;
+
+//##################################################################################################################
+//	returns 1 while the worst input stays within Limit times the cost of a valid GGA+GNS+GST burst
+uint8_t		GPS_Fuzz_Run(uint32_t Seconds,uint32_t Seed,double Limit,GPS_FuzzResult_t *Result);
+//	worst inputs found, Rank 0 is the slowest. Returns the length, 0 past the end.
+uint32_t	GPS_Fuzz_Worst(uint8_t Rank,const uint8_t **Data,double *Cost);
+//	writes the worst inputs to Dir/worst-NN.nmea, returns how many
+uint8_t		GPS_Fuzz_Save(const char *Dir);
+void			GPS_Fuzz_Report(const GPS_FuzzResult_t *Result);
+//##################################################################################################################
+
+#endif
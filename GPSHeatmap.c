@@ -0,0 +1,712 @@
+#include "GPSConfig.h"
+
+#if (_GPS_HEATMAP==1)
+
+#if (_GPS_HOST==0)
+#error "GPSHeatmap needs _GPS_HOST"
+#endif
+#if (_GPS_HEATMAP_ZOOM>18)
+#error "_GPS_HEATMAP_ZOOM is 18 at most"
+#endif
+
+#include "GPSHeatmap.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <errno.h>
+#include <pthread.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#if (_GPS_HEATMAP_SIMD==1) && defined(__x86_64__) && defined(__GNUC__)
+#define	GPS_HEATMAP_AVX2
+#include <immintrin.h>
+#endif
+
+#if defined(__BYTE_ORDER__) && (__BYTE_ORDER__!=__ORDER_LITTLE_ENDIAN__)
+#error "GPSHeatmap raw tiles and match compares assume little-endian"
+#endif
+
+//	latitude table: normalised Mercator y every 2^14 units of 1e-7 degree (0.0016 degree), linear in between.
+//	The interpolation error stays under 0.15 pixel at zoom 18 and 85 degrees.
+#define	GPS_HEATMAP_SHIFT							14
+#define	GPS_HEATMAP_ENTRIES						((1800000000UL>>GPS_HEATMAP_SHIFT)+2)
+#define	GPS_HEATMAP_LIMIT							85.05112878
+#define	GPS_HEATMAP_NONE							0xFFFFFFFFUL
+#define	GPS_HEATMAP_BATCH							1024
+#define	GPS_HEATMAP_THREADS						64
+//	filter byte + 256 palette indices per row
+#define	GPS_HEATMAP_RAW_SIZE					((GPS_HEATMAP_SIZE+1)*GPS_HEATMAP_SIZE)
+//	fixed Huffman never takes more than 9 bits a byte
+#define	GPS_HEATMAP_PNG_SIZE					(GPS_HEATMAP_RAW_SIZE*9/8+2048)
+#define	GPS_HEATMAP_HASH							15
+#define	GPS_HEATMAP_WINDOW						32768
+#define	GPS_HEATMAP_CHAIN							16
+#define	GPS_HEATMAP_NICE							32
+
+typedef struct
+{
+	uint64_t		Bits;
+	uint32_t		Count;
+	uint8_t			*Out;
+	uint8_t			*End;
+
+}GPS_HeatmapBits_t;
+
+typedef struct
+{
+	uint8_t			Raw[GPS_HEATMAP_RAW_SIZE];
+	int32_t			Head[1<<GPS_HEATMAP_HASH];
+	int32_t			Prev[GPS_HEATMAP_RAW_SIZE];
+
+}GPS_HeatmapDeflate_t;
+
+typedef struct
+{
+	GPS_Heatmap_t				*Map;
+	uint8_t							Level;
+	uint32_t						Next;
+	const char					*Dir;
+	GPS_HeatmapFormat_t	Format;
+
+}GPS_HeatmapJob_t;
+
+static double			*GPS_HeatmapMercator;
+static uint32_t		GPS_HeatmapCrc[256];
+static uint8_t		GPS_HeatmapPalette[256*3];
+static uint16_t		GPS_HeatmapLit[288];						//	fixed Huffman codes, bit reversed
+static uint8_t		GPS_HeatmapLitBits[288];
+
+static const uint16_t	GPS_HeatmapLenBase[29]={3,4,5,6,7,8,9,10,11,13,15,17,19,23,27,31,35,43,51,59,67,83,99,115,131,163,195,227,258};
+static const uint8_t	GPS_HeatmapLenExtra[29]={0,0,0,0,0,0,0,0,1,1,1,1,2,2,2,2,3,3,3,3,4,4,4,4,5,5,5,5,0};
+static const uint16_t	GPS_HeatmapDistBase[30]={1,2,3,4,5,7,9,13,17,25,33,49,65,97,129,193,257,385,513,769,1025,1537,2049,3073,4097,6145,8193,12289,16385,24577};
+static const uint8_t	GPS_HeatmapDistExtra[30]={0,0,0,0,1,1,2,2,3,3,4,4,5,5,6,6,7,7,8,8,9,9,10,10,11,11,12,12,13,13};
+//##################################################################################################################
+static double	GPS_Heatmap_Now(void)
+{
+	struct timespec	ts;
+	clock_gettime(CLOCK_MONOTONIC,&ts);
+	return ts.tv_sec+ts.tv_nsec*1e-9;
+}
+//##################################################################################################################
+static uint16_t	GPS_Heatmap_Reverse(uint16_t Code,uint8_t Bits)
+{
+	uint16_t	r=0;
+	for(uint8_t i=0 ; i<Bits ; i++)
+		r=(uint16_t)((r<<1) | ((Code>>i) & 1));
+	return r;
+}
+//##################################################################################################################
+static uint8_t	GPS_Heatmap_Tables(void)
+{
+	if(GPS_HeatmapMercator!=NULL)
+		return 1;
+	double	*t=(double*)malloc(GPS_HEATMAP_ENTRIES*sizeof(double));
+	if(t==NULL)
+		return 0;
+	for(uint32_t i=0 ; i<GPS_HEATMAP_ENTRIES ; i++)
+	{
+		double	lat=((double)i*(1UL<<GPS_HEATMAP_SHIFT)-900000000.0)*1e-7;
+		if(lat>=GPS_HEATMAP_LIMIT)
+			t[i]=-1.0;
+		else if(lat<=-GPS_HEATMAP_LIMIT)
+			t[i]=2.0;
+		else
+			t[i]=0.5-log(tan(M_PI/4.0+lat*M_PI/360.0))/(2.0*M_PI);
+	}
+	for(uint32_t i=0 ; i<256 ; i++)
+	{
+		uint32_t	c=i;
+		double		v=i/255.0;
+		for(uint8_t k=0 ; k<8 ; k++)
+			c=(c & 1) ? 0xEDB88320UL ^ (c>>1) : c>>1;
+		GPS_HeatmapCrc[i]=c;
+		//	black body ramp: red, then yellow, then white
+		GPS_HeatmapPalette[i*3+0]=(uint8_t)(255.0*fmin(1.0,3.0*v));
+		GPS_HeatmapPalette[i*3+1]=(uint8_t)(255.0*fmin(1.0,fmax(0.0,3.0*v-1.0)));
+		GPS_HeatmapPalette[i*3+2]=(uint8_t)(255.0*fmin(1.0,fmax(0.0,3.0*v-2.0)));
+	}
+	for(uint16_t i=0 ; i<288 ; i++)
+	{
+		if(i<144)
+			GPS_HeatmapLitBits[i]=8,GPS_HeatmapLit[i]=GPS_Heatmap_Reverse((uint16_t)(0x30+i),8);
+		else if(i<256)
+			GPS_HeatmapLitBits[i]=9,GPS_HeatmapLit[i]=GPS_Heatmap_Reverse((uint16_t)(0x190+i-144),9);
+		else if(i<280)
+			GPS_HeatmapLitBits[i]=7,GPS_HeatmapLit[i]=GPS_Heatmap_Reverse((uint16_t)(i-256),7);
+		else
+			GPS_HeatmapLitBits[i]=8,GPS_HeatmapLit[i]=GPS_Heatmap_Reverse((uint16_t)(0xC0+i-280),8);
+	}
+	GPS_HeatmapMercator=t;
+	return 1;
+}
+//##################################################################################################################
+static uint32_t	GPS_Heatmap_Find(const GPS_HeatmapLevel_t *Level,uint32_t X,uint32_t Y)
+{
+	//	index+1 of the tile, or 0
+	uint32_t	h=(X*0x9E3779B1UL) ^ (Y*0x85EBCA77UL);
+	for(uint32_t i=h ; ; i++)
+	{
+		uint32_t	s=Level->Slot[i & (Level->Slots-1)];
+		if((s==0) || ((Level->Tile[s-1]->X==X) && (Level->Tile[s-1]->Y==Y)))
+			return s;
+	}
+}
+//##################################################################################################################
+static uint32_t	GPS_Heatmap_Insert(GPS_HeatmapLevel_t *Level,uint32_t X,uint32_t Y)
+{
+	uint32_t	s;
+	if(Level->Tiles*2>=Level->Slots)
+	{
+		//	rehash at half load
+		uint32_t	slots=(Level->Slots==0) ? 256 : Level->Slots*2;
+		uint32_t	*slot=(uint32_t*)calloc(slots,sizeof(uint32_t));
+		if(slot==NULL)
+			return 0;
+		free(Level->Slot);
+		Level->Slot=slot;
+		Level->Slots=slots;
+		for(uint32_t i=0 ; i<Level->Tiles ; i++)
+		{
+			uint32_t	h=(Level->Tile[i]->X*0x9E3779B1UL) ^ (Level->Tile[i]->Y*0x85EBCA77UL);
+			while(slot[h & (slots-1)]!=0)
+				h++;
+			slot[h & (slots-1)]=i+1;
+		}
+	}
+	if((s=GPS_Heatmap_Find(Level,X,Y))!=0)
+		return s;
+	if(Level->Tiles==Level->Room)
+	{
+		uint32_t						room=(Level->Room==0) ? 64 : Level->Room*2;
+		GPS_HeatmapTile_t	**tile=(GPS_HeatmapTile_t**)realloc(Level->Tile,room*sizeof(GPS_HeatmapTile_t*));
+		if(tile==NULL)
+			return 0;
+		Level->Tile=tile;
+		Level->Room=room;
+	}
+	GPS_HeatmapTile_t	*t=(GPS_HeatmapTile_t*)calloc(1,sizeof(GPS_HeatmapTile_t));
+	if(t==NULL)
+		return 0;
+	t->X=X;
+	t->Y=Y;
+	Level->Tile[Level->Tiles++]=t;
+	uint32_t	h=(X*0x9E3779B1UL) ^ (Y*0x85EBCA77UL);
+	while(Level->Slot[h & (Level->Slots-1)]!=0)
+		h++;
+	Level->Slot[h & (Level->Slots-1)]=Level->Tiles;
+	return Level->Tiles;
+}
+//##################################################################################################################
+static void	GPS_Heatmap_ProjectC(const int32_t *Lat,const int32_t *Lon,uint32_t N,double World,uint32_t *X,uint32_t *Y)
+{
+	const double	sx=World/3600000000.0;
+	for(uint32_t i=0 ; i<N ; i++)
+	{
+		uint32_t	u=(uint32_t)Lat[i]+900000000UL;
+		uint32_t	k=u>>GPS_HEATMAP_SHIFT;
+		double		x=((double)Lon[i]+1800000000.0)*sx;
+		double		y;
+		if(u>1800000000UL)
+		{
+			X[i]=Y[i]=GPS_HEATMAP_NONE;
+			continue;
+		}
+		y=GPS_HeatmapMercator[k]+(GPS_HeatmapMercator[k+1]-GPS_HeatmapMercator[k])*(u & ((1UL<<GPS_HEATMAP_SHIFT)-1))*(1.0/(1UL<<GPS_HEATMAP_SHIFT));
+		y*=World;
+		X[i]=((x>=0.0) && (x<World)) ? (uint32_t)x : GPS_HEATMAP_NONE;
+		Y[i]=((y>=0.0) && (y<World)) ? (uint32_t)y : GPS_HEATMAP_NONE;
+	}
+}
+#ifdef GPS_HEATMAP_AVX2
+//##################################################################################################################
+__attribute__((target("avx2")))
+static void	GPS_Heatmap_ProjectAvx2(const int32_t *Lat,const int32_t *Lon,uint32_t N,double World,uint32_t *X,uint32_t *Y)
+{
+	//	four points at a time in double, the two table entries of each latitude gathered
+	const __m256d	sx=_mm256_set1_pd(World/3600000000.0);
+	const __m256d	world=_mm256_set1_pd(World);
+	const __m256d	zero=_mm256_setzero_pd();
+	const __m256d	step=_mm256_set1_pd(1.0/(1UL<<GPS_HEATMAP_SHIFT));
+	const __m256d	half=_mm256_set1_pd(1800000000.0);
+	const __m128i	bias=_mm_set1_epi32(900000000);
+	const __m128i	top=_mm_set1_epi32(1800000000);
+	const __m128i	frac=_mm_set1_epi32((1<<GPS_HEATMAP_SHIFT)-1);
+	uint32_t			i=0;
+	for( ; i+4<=N ; i+=4)
+	{
+		__m128i	u=_mm_add_epi32(_mm_loadu_si128((const __m128i*)&Lat[i]),bias);
+		__m128i	bad=_mm_or_si128(_mm_cmplt_epi32(u,_mm_setzero_si128()),_mm_cmpgt_epi32(u,top));
+		u=_mm_andnot_si128(bad,u);
+		__m128i	k=_mm_srli_epi32(u,GPS_HEATMAP_SHIFT);
+		__m256d	y0=_mm256_i32gather_pd(GPS_HeatmapMercator,k,8);
+		__m256d	y1=_mm256_i32gather_pd(GPS_HeatmapMercator+1,k,8);
+		__m256d	f=_mm256_mul_pd(_mm256_cvtepi32_pd(_mm_and_si128(u,frac)),step);
+		__m256d	y=_mm256_mul_pd(_mm256_add_pd(y0,_mm256_mul_pd(_mm256_sub_pd(y1,y0),f)),world);
+		__m256d	x=_mm256_mul_pd(_mm256_add_pd(_mm256_cvtepi32_pd(_mm_loadu_si128((const __m128i*)&Lon[i])),half),sx);
+		__m256d	okx=_mm256_and_pd(_mm256_cmp_pd(x,zero,_CMP_GE_OQ),_mm256_cmp_pd(x,world,_CMP_LT_OQ));
+		__m256d	oky=_mm256_and_pd(_mm256_cmp_pd(y,zero,_CMP_GE_OQ),_mm256_cmp_pd(y,world,_CMP_LT_OQ));
+		__m128i	mx=_mm256_castsi256_si128(_mm256_permutevar8x32_epi32(_mm256_castpd_si256(okx),_mm256_setr_epi32(0,2,4,6,1,3,5,7)));
+		__m128i	my=_mm256_castsi256_si128(_mm256_permutevar8x32_epi32(_mm256_castpd_si256(oky),_mm256_setr_epi32(0,2,4,6,1,3,5,7)));
+		my=_mm_andnot_si128(bad,my);
+		_mm_storeu_si128((__m128i*)&X[i],_mm_or_si128(_mm_and_si128(_mm256_cvttpd_epi32(_mm256_and_pd(x,okx)),mx),_mm_andnot_si128(mx,_mm_set1_epi32(-1))));
+		_mm_storeu_si128((__m128i*)&Y[i],_mm_or_si128(_mm_and_si128(_mm256_cvttpd_epi32(_mm256_and_pd(y,oky)),my),_mm_andnot_si128(my,_mm_set1_epi32(-1))));
+	}
+	GPS_Heatmap_ProjectC(&Lat[i],&Lon[i],N-i,World,&X[i],&Y[i]);
+}
+#endif
+//##################################################################################################################
+uint8_t	GPS_Heatmap_Init(GPS_Heatmap_t *Map,uint8_t Zoom)
+{
+	memset(Map,0,sizeof(GPS_Heatmap_t));
+	if((Zoom>_GPS_HEATMAP_ZOOM) || (GPS_Heatmap_Tables()==0))
+		return 0;
+	Map->Zoom=Zoom;
+	Map->Last=GPS_HEATMAP_NONE;
+	#ifdef GPS_HEATMAP_AVX2
+	__builtin_cpu_init();
+	Map->Simd=(__builtin_cpu_supports("avx2")!=0);
+	#endif
+	return 1;
+}
+//##################################################################################################################
+void	GPS_Heatmap_Free(GPS_Heatmap_t *Map)
+{
+	for(uint8_t z=0 ; z<=_GPS_HEATMAP_ZOOM ; z++)
+	{
+		GPS_HeatmapLevel_t	*l=&Map->Level[z];
+		for(uint32_t i=0 ; i<l->Tiles ; i++)
+			free(l->Tile[i]);
+		free(l->Tile);
+		free(l->Slot);
+	}
+	memset(Map,0,sizeof(GPS_Heatmap_t));
+}
+//##################################################################################################################
+void	GPS_Heatmap_Add(GPS_Heatmap_t *Map,const int32_t *Latitude,const int32_t *Longitude,uint32_t Count)
+{
+	GPS_HeatmapLevel_t	*l=&Map->Level[Map->Zoom];
+	double		world=(double)(GPS_HEATMAP_SIZE<<Map->Zoom);
+	double		t=GPS_Heatmap_Now();
+	uint32_t	x[GPS_HEATMAP_BATCH],y[GPS_HEATMAP_BATCH];
+	GPS_HeatmapTile_t	*tile=(Map->Last!=GPS_HEATMAP_NONE) ? l->Tile[Map->Last] : NULL;
+	for(uint32_t first=0 ; first<Count ; first+=GPS_HEATMAP_BATCH)
+	{
+		uint32_t	n=(Count-first<GPS_HEATMAP_BATCH) ? Count-first : GPS_HEATMAP_BATCH;
+		#ifdef GPS_HEATMAP_AVX2
+		if(Map->Simd)
+			GPS_Heatmap_ProjectAvx2(&Latitude[first],&Longitude[first],n,world,x,y);
+		else
+		#endif
+		GPS_Heatmap_ProjectC(&Latitude[first],&Longitude[first],n,world,x,y);
+		for(uint32_t i=0 ; i<n ; i++)
+		{
+			if((x[i]==GPS_HEATMAP_NONE) || (y[i]==GPS_HEATMAP_NONE))
+			{
+				Map->Dropped++;
+				continue;
+			}
+			if((tile==NULL) || (tile->X!=x[i]>>8) || (tile->Y!=y[i]>>8))
+			{
+				uint32_t	s=GPS_Heatmap_Insert(l,x[i]>>8,y[i]>>8);
+				if(s==0)
+				{
+					Map->Dropped++;
+					continue;
+				}
+				tile=l->Tile[s-1];
+				Map->Last=s-1;
+			}
+			tile->Count[((y[i] & 0xFF)<<8) | (x[i] & 0xFF)]++;
+			Map->Points++;
+		}
+	}
+	Map->AddTime+=GPS_Heatmap_Now()-t;
+}
+#if (_GPS_ARCHIVE==1)
+//##################################################################################################################
+uint8_t	GPS_Heatmap_Archive(GPS_Heatmap_t *Map,const GPS_ArchiveReader_t *Reader)
+{
+	//	fixes without a position are left out
+	static int32_t	lat[_GPS_ARCHIVE_BLOCK],lon[_GPS_ARCHIVE_BLOCK],fix[_GPS_ARCHIVE_BLOCK];
+	if(Reader->Index==NULL)
+		return 0;
+	for(uint32_t b=0 ; b<Reader->Footer.Blocks ; b++)
+	{
+		uint32_t	n=GPS_Archive_Column(Reader,b,GPS_ARCHIVE_LATITUDE,lat);
+		uint32_t	k=0;
+		if((n==0) || (GPS_Archive_Column(Reader,b,GPS_ARCHIVE_LONGITUDE,lon)!=n) || (GPS_Archive_Column(Reader,b,GPS_ARCHIVE_FIX,fix)!=n))
+			return 0;
+		if(Reader->Index[b].Block.Min[GPS_ARCHIVE_FIX]==0)
+		{
+			for(uint32_t i=0 ; i<n ; i++)
+				if(fix[i]!=0)
+				{
+					lat[k]=lat[i];
+					lon[k++]=lon[i];
+				}
+			n=k;
+		}
+		GPS_Heatmap_Add(Map,lat,lon,n);
+	}
+	return 1;
+}
+#endif
+//##################################################################################################################
+static void	GPS_Heatmap_Reduce(const GPS_HeatmapTile_t *Child,GPS_HeatmapTile_t *Parent)
+{
+	//	2x2 sums into the quadrant of the parent this child covers
+	uint32_t	*p=&Parent->Count[((Child->Y & 1)*128<<8)+(Child->X & 1)*128];
+	for(uint32_t y=0 ; y<128 ; y++)
+	{
+		const uint32_t	*a=&Child->Count[(2*y)<<8];
+		const uint32_t	*b=a+GPS_HEATMAP_SIZE;
+		for(uint32_t x=0 ; x<128 ; x++)
+			p[(y<<8)+x]=a[2*x]+a[2*x+1]+b[2*x]+b[2*x+1];
+	}
+}
+//##################################################################################################################
+static uint32_t	GPS_Heatmap_TileMax(const GPS_HeatmapTile_t *Tile)
+{
+	uint32_t	m=0;
+	for(uint32_t i=0 ; i<GPS_HEATMAP_SIZE*GPS_HEATMAP_SIZE ; i++)
+		m=(Tile->Count[i]>m) ? Tile->Count[i] : m;
+	return m;
+}
+//##################################################################################################################
+static void	*GPS_Heatmap_PyramidWorker(void *Arg)
+{
+	//	tiles of the level are taken one by one; level Zoom only needs its maxima
+	GPS_HeatmapJob_t		*j=(GPS_HeatmapJob_t*)Arg;
+	GPS_HeatmapLevel_t	*l=&j->Map->Level[j->Level];
+	uint32_t	i;
+	while((i=__atomic_fetch_add(&j->Next,1,__ATOMIC_RELAXED))<l->Tiles)
+	{
+		GPS_HeatmapTile_t	*t=l->Tile[i];
+		if(j->Level<j->Map->Zoom)
+		{
+			const GPS_HeatmapLevel_t	*c=&j->Map->Level[j->Level+1];
+			for(uint8_t q=0 ; q<4 ; q++)
+			{
+				uint32_t	s=GPS_Heatmap_Find(c,t->X*2+(q & 1),t->Y*2+(q>>1));
+				if(s!=0)
+					GPS_Heatmap_Reduce(c->Tile[s-1],t);
+			}
+		}
+		t->Max=GPS_Heatmap_TileMax(t);
+	}
+	return NULL;
+}
+//##################################################################################################################
+static uint32_t	GPS_Heatmap_Threads(uint32_t Threads)
+{
+	if(Threads==0)
+		Threads=_GPS_HEATMAP_THREADS;
+	if(Threads==0)
+		Threads=(uint32_t)sysconf(_SC_NPROCESSORS_ONLN);
+	return (Threads<1) ? 1 : (Threads>GPS_HEATMAP_THREADS) ? GPS_HEATMAP_THREADS : Threads;
+}
+//##################################################################################################################
+static void	GPS_Heatmap_Parallel(GPS_HeatmapJob_t *Job,uint32_t Threads,void *(*Worker)(void*))
+{
+	pthread_t	t[GPS_HEATMAP_THREADS];
+	uint32_t	n=0;
+	Job->Next=0;
+	while((n+1<Threads) && (pthread_create(&t[n],NULL,Worker,Job)==0))
+		n++;
+	Worker(Job);
+	while(n>0)
+		pthread_join(t[--n],NULL);
+}
+//##################################################################################################################
+uint8_t	GPS_Heatmap_Pyramid(GPS_Heatmap_t *Map,uint32_t Threads)
+{
+	GPS_HeatmapJob_t	job;
+	double						t=GPS_Heatmap_Now();
+	memset(&job,0,sizeof(job));
+	job.Map=Map;
+	Threads=GPS_Heatmap_Threads(Threads);
+	for(int8_t z=(int8_t)Map->Zoom ; z>=0 ; z--)
+	{
+		GPS_HeatmapLevel_t	*l=&Map->Level[z];
+		if(z<Map->Zoom)
+		{
+			//	parents are created up front, then filled in parallel from the read-only child level
+			const GPS_HeatmapLevel_t	*c=&Map->Level[z+1];
+			for(uint32_t i=0 ; i<c->Tiles ; i++)
+				if(GPS_Heatmap_Insert(l,c->Tile[i]->X>>1,c->Tile[i]->Y>>1)==0)
+					return 0;
+		}
+		job.Level=(uint8_t)z;
+		GPS_Heatmap_Parallel(&job,Threads,GPS_Heatmap_PyramidWorker);
+		l->Max=0;
+		for(uint32_t i=0 ; i<l->Tiles ; i++)
+			l->Max=(l->Tile[i]->Max>l->Max) ? l->Tile[i]->Max : l->Max;
+	}
+	Map->PyramidTime+=GPS_Heatmap_Now()-t;
+	return 1;
+}
+//##################################################################################################################
+static void	GPS_Heatmap_Put(GPS_HeatmapBits_t *b,uint32_t Value,uint8_t Bits)
+{
+	b->Bits|=(uint64_t)Value<<b->Count;
+	b->Count+=Bits;
+	while(b->Count>=8)
+	{
+		if(b->Out<b->End)
+			*b->Out++=(uint8_t)b->Bits;
+		else
+			b->End=NULL;
+		b->Bits>>=8;
+		b->Count-=8;
+	}
+}
+//##################################################################################################################
+static void	GPS_Heatmap_Match(GPS_HeatmapBits_t *b,uint32_t Len,uint32_t Dist)
+{
+	uint8_t	l=0,d=0;
+	while((l<28) && (GPS_HeatmapLenBase[l+1]<=Len))
+		l++;
+	while((d<29) && (GPS_HeatmapDistBase[d+1]<=Dist))
+		d++;
+	GPS_Heatmap_Put(b,GPS_HeatmapLit[257+l],GPS_HeatmapLitBits[257+l]);
+	GPS_Heatmap_Put(b,Len-GPS_HeatmapLenBase[l],GPS_HeatmapLenExtra[l]);
+	GPS_Heatmap_Put(b,GPS_Heatmap_Reverse(d,5),5);
+	GPS_Heatmap_Put(b,Dist-GPS_HeatmapDistBase[d],GPS_HeatmapDistExtra[d]);
+}
+//##################################################################################################################
+static uint32_t	GPS_Heatmap_Deflate(GPS_HeatmapDeflate_t *s,uint32_t Len,uint8_t *Out,uint32_t Size)
+{
+	//	zlib stream, one fixed Huffman block. Greedy LZ77 over a hash of 3 bytes with a short chain that stops at the
+	//	first fair match: heatmap rows are mostly runs and repeats of the row above, which this catches.
+	GPS_HeatmapBits_t	b={0,0,Out,Out+Size};
+	const uint8_t			*r=s->Raw;
+	uint32_t	a1=1,a2=0;
+	if(Size<6)
+		return 0;
+	GPS_Heatmap_Put(&b,0x78,8);
+	GPS_Heatmap_Put(&b,0x01,8);
+	GPS_Heatmap_Put(&b,1,1);
+	GPS_Heatmap_Put(&b,1,2);
+	for(uint32_t i=0 ; i<(1U<<GPS_HEATMAP_HASH) ; i++)
+		s->Head[i]=-1;
+	for(uint32_t i=0 ; i<Len ; )
+	{
+		uint32_t	best=0,dist=0;
+		if(i+3<=Len)
+		{
+			uint32_t	h=((r[i]<<10) ^ (r[i+1]<<5) ^ r[i+2]) & ((1U<<GPS_HEATMAP_HASH)-1);
+			int32_t		c=s->Head[h];
+			uint32_t	max=(Len-i<258) ? Len-i : 258;
+			for(uint8_t k=0 ; (k<GPS_HEATMAP_CHAIN) && (c>=0) && (i-(uint32_t)c<=GPS_HEATMAP_WINDOW) ; k++,c=s->Prev[c])
+			{
+				uint32_t	n=0;
+				uint64_t	x,y;
+				//	eight bytes a compare, the first differing byte from the lowest set bit (little-endian)
+				while(n+8<=max)
+				{
+					memcpy(&x,&r[c+n],8);
+					memcpy(&y,&r[i+n],8);
+					if(x!=y)
+						break;
+					n+=8;
+				}
+				if(n+8<=max)
+					n+=(uint32_t)__builtin_ctzll(x ^ y)>>3;
+				else
+					while((n<max) && (r[c+n]==r[i+n]))
+						n++;
+				if(n>best)
+				{
+					best=n;
+					dist=i-(uint32_t)c;
+					if(n>=GPS_HEATMAP_NICE)
+						break;
+				}
+			}
+			s->Prev[i]=s->Head[h];
+			s->Head[h]=(int32_t)i;
+		}
+		if(best>=3)
+		{
+			GPS_Heatmap_Match(&b,best,dist);
+			//	positions inside a short match go into the hash too, so the next match can start from them. Long ones are
+			//	zero runs, where the last positions are enough.
+			for(uint32_t k=(best<GPS_HEATMAP_NICE) ? 1 : best-3 ; (k<best) && (i+k+3<=Len) ; k++)
+			{
+				uint32_t	h=((r[i+k]<<10) ^ (r[i+k+1]<<5) ^ r[i+k+2]) & ((1U<<GPS_HEATMAP_HASH)-1);
+				s->Prev[i+k]=s->Head[h];
+				s->Head[h]=(int32_t)(i+k);
+			}
+			i+=best;
+		}
+		else
+		{
+			GPS_Heatmap_Put(&b,GPS_HeatmapLit[r[i]],GPS_HeatmapLitBits[r[i]]);
+			i++;
+		}
+	}
+	GPS_Heatmap_Put(&b,GPS_HeatmapLit[256],GPS_HeatmapLitBits[256]);
+	GPS_Heatmap_Put(&b,0,(uint8_t)((8-b.Count) & 7));
+	for(uint32_t i=0 ; i<Len ; )
+	{
+		//	5552 bytes is the longest run the sums take without overflow
+		uint32_t	end=(Len-i>5552) ? i+5552 : Len;
+		for( ; i<end ; i++)
+		{
+			a1+=r[i];
+			a2+=a1;
+		}
+		a1%=65521;
+		a2%=65521;
+	}
+	a1|=a2<<16;
+	for(int8_t k=3 ; k>=0 ; k--)
+		GPS_Heatmap_Put(&b,(a1>>(k*8)) & 0xFF,8);
+	return (b.End==NULL) ? 0 : (uint32_t)(b.Out-Out);
+}
+//##################################################################################################################
+static uint8_t	*GPS_Heatmap_Chunk(uint8_t *Out,const char *Type,uint32_t Len)
+{
+	//	Len bytes of data already sit after the 8 byte head, the CRC goes after them
+	uint32_t	crc=0xFFFFFFFFUL;
+	Out[0]=(uint8_t)(Len>>24);
+	Out[1]=(uint8_t)(Len>>16);
+	Out[2]=(uint8_t)(Len>>8);
+	Out[3]=(uint8_t)Len;
+	memcpy(&Out[4],Type,4);
+	for(uint32_t i=4 ; i<Len+8 ; i++)
+		crc=GPS_HeatmapCrc[(crc ^ Out[i]) & 0xFF] ^ (crc>>8);
+	crc^=0xFFFFFFFFUL;
+	Out+=Len+8;
+	Out[0]=(uint8_t)(crc>>24);
+	Out[1]=(uint8_t)(crc>>16);
+	Out[2]=(uint8_t)(crc>>8);
+	Out[3]=(uint8_t)crc;
+	return Out+4;
+}
+//##################################################################################################################
+static uint32_t	GPS_Heatmap_Encode(GPS_HeatmapDeflate_t *s,const GPS_HeatmapTile_t *Tile,uint32_t Max,uint8_t *Out,uint32_t Size)
+{
+	static const uint8_t	sig[8]={0x89,'P','N','G','\r','\n',0x1A,'\n'};
+	double		scale=(Max>1) ? 254.0/log((double)Max) : 0.0;
+	uint8_t		*o=Out;
+	uint32_t	n;
+	if(Size<8+25+12+768+12+1+12+12)
+		return 0;
+	//	palette index 0 is transparent, counts map to 1..255 on a log scale
+	for(uint32_t y=0 ; y<GPS_HEATMAP_SIZE ; y++)
+	{
+		uint8_t					*row=&s->Raw[y*(GPS_HEATMAP_SIZE+1)];
+		const uint32_t	*c=&Tile->Count[y<<8];
+		row[0]=0;
+		for(uint32_t x=0 ; x<GPS_HEATMAP_SIZE ; x++)
+			row[x+1]=(c[x]==0) ? 0 : (uint8_t)(1.0+log((double)c[x])*scale+0.5);
+	}
+	memcpy(o,sig,8);
+	o+=8;
+	memset(&o[8],0,13);
+	o[10]=1;
+	o[14]=1;
+	o[16]=8;
+	o[17]=3;
+	o=GPS_Heatmap_Chunk(o,"IHDR",13);
+	memcpy(&o[8],GPS_HeatmapPalette,768);
+	o=GPS_Heatmap_Chunk(o,"PLTE",768);
+	o[8]=0;
+	o=GPS_Heatmap_Chunk(o,"tRNS",1);
+	if((n=GPS_Heatmap_Deflate(s,GPS_HEATMAP_RAW_SIZE,&o[8],(uint32_t)(Size-(o-Out)-24)))==0)
+		return 0;
+	o=GPS_Heatmap_Chunk(o,"IDAT",n);
+	o=GPS_Heatmap_Chunk(o,"IEND",0);
+	return (uint32_t)(o-Out);
+}
+//##################################################################################################################
+uint32_t	GPS_Heatmap_Png(const GPS_HeatmapTile_t *Tile,uint32_t Max,uint8_t *Out,uint32_t Size)
+{
+	GPS_HeatmapDeflate_t	*s=(GPS_HeatmapDeflate_t*)malloc(sizeof(GPS_HeatmapDeflate_t));
+	uint32_t							n=0;
+	if((s!=NULL) && GPS_Heatmap_Tables())
+		n=GPS_Heatmap_Encode(s,Tile,Max,Out,Size);
+	free(s);
+	return n;
+}
+//##################################################################################################################
+static uint8_t	GPS_Heatmap_Mkdir(const char *Path)
+{
+	return (mkdir(Path,0755)==0) || (errno==EEXIST);
+}
+//##################################################################################################################
+static void	*GPS_Heatmap_WriteWorker(void *Arg)
+{
+	GPS_HeatmapJob_t			*j=(GPS_HeatmapJob_t*)Arg;
+	GPS_HeatmapLevel_t		*l=&j->Map->Level[j->Level];
+	GPS_HeatmapDeflate_t	*s=(GPS_HeatmapDeflate_t*)malloc(sizeof(GPS_HeatmapDeflate_t));
+	uint8_t								*png=(uint8_t*)malloc(GPS_HEATMAP_PNG_SIZE);
+	char									path[4096];
+	uint32_t							i;
+	while((s!=NULL) && (png!=NULL) && ((i=__atomic_fetch_add(&j->Next,1,__ATOMIC_RELAXED))<l->Tiles))
+	{
+		const GPS_HeatmapTile_t	*t=l->Tile[i];
+		const void	*data=t->Count;
+		uint32_t		len=sizeof(t->Count);
+		FILE				*f;
+		snprintf(path,sizeof(path),"%s/%u/%lu",j->Dir,j->Level,(unsigned long)t->X);
+		if(GPS_Heatmap_Mkdir(path)==0)
+			continue;
+		snprintf(path,sizeof(path),"%s/%u/%lu/%lu.%s",j->Dir,j->Level,(unsigned long)t->X,(unsigned long)t->Y,(j->Format==GPS_HEATMAP_PNG) ? "png" : "raw");
+		if(j->Format==GPS_HEATMAP_PNG)
+		{
+			len=GPS_Heatmap_Encode(s,t,l->Max,png,GPS_HEATMAP_PNG_SIZE);
+			data=png;
+		}
+		if((len==0) || ((f=fopen(path,"wb"))==NULL))
+			continue;
+		if((fwrite(data,1,len,f)==len) & (fclose(f)==0))
+		{
+			__atomic_fetch_add(&j->Map->Bytes,len,__ATOMIC_RELAXED);
+			__atomic_fetch_add(&j->Map->Files,1,__ATOMIC_RELAXED);
+		}
+	}
+	free(png);
+	free(s);
+	return NULL;
+}
+//##################################################################################################################
+uint32_t	GPS_Heatmap_Write(GPS_Heatmap_t *Map,const char *Dir,GPS_HeatmapFormat_t Format,uint32_t Threads)
+{
+	GPS_HeatmapJob_t	job;
+	char							path[4096];
+	double						t=GPS_Heatmap_Now();
+	uint32_t					files=Map->Files;
+	memset(&job,0,sizeof(job));
+	job.Map=Map;
+	job.Dir=Dir;
+	job.Format=Format;
+	Threads=GPS_Heatmap_Threads(Threads);
+	if(GPS_Heatmap_Mkdir(Dir)==0)
+		return 0;
+	for(uint8_t z=0 ; z<=Map->Zoom ; z++)
+	{
+		snprintf(path,sizeof(path),"%s/%u",Dir,z);
+		if(GPS_Heatmap_Mkdir(path)==0)
+			return Map->Files-files;
+		job.Level=z;
+		GPS_Heatmap_Parallel(&job,Threads,GPS_Heatmap_WriteWorker);
+	}
+	Map->WriteTime+=GPS_Heatmap_Now()-t;
+	return Map->Files-files;
+}
+//##################################################################################################################
+void	GPS_Heatmap_Report(const GPS_Heatmap_t *Map)
+{
+	printf("%lu points (%lu dropped) at zoom %u, %s projection: add %.3f s (%.1f ns/point), pyramid %.3f s, write %.3f s, %lu files %lu bytes\r\n",
+		(unsigned long)Map->Points,(unsigned long)Map->Dropped,Map->Zoom,(Map->Simd!=0) ? "avx2" : "scalar",Map->AddTime,
+		(Map->Points>0) ? Map->AddTime*1e9/(Map->Points+Map->Dropped) : 0.0,Map->PyramidTime,Map->WriteTime,(unsigned long)Map->Files,(unsigned long)Map->Bytes);
+	for(uint8_t z=0 ; z<=Map->Zoom ; z++)
+		printf("zoom %2u: %6lu tiles, max %lu\r\n",z,(unsigned long)Map->Level[z].Tiles,(unsigned long)Map->Level[z].Max);
+}
+//##################################################################################################################
+
+#endif
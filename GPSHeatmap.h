@@ -0,0 +1,78 @@
+#ifndef _GPSHEATMAP_H_
+#define _GPSHEATMAP_H_
+
+#include <stdint.h>
+#include "GPSConfig.h"
+#if (_GPS_ARCHIVE==1)
+#include "GPSArchive.h"
+#endif
+
+//##################################################################################################################
+//	Track density heatmaps for the host build. Fixes are projected to Web Mercator at the deepest zoom and counted
+//	into sparse 256x256 tiles. Each shallower level is made by summing 2x2 pixels of the four child tiles, and the
+//	tiles go to Dir/z/x/y.png (palette PNG, deflate done here) or Dir/z/x/y.raw (256x256 uint32 counts). Levels
+//	and files are built by a pool of threads that take one tile at a time.
+//##################################################################################################################
+
+#define	GPS_HEATMAP_SIZE						256
+
+typedef enum
+{
+	GPS_HEATMAP_PNG=0,
+	GPS_HEATMAP_RAW,
+
+}GPS_HeatmapFormat_t;
+
+typedef struct
+{
+	uint32_t		X;
+	uint32_t		Y;
+	uint32_t		Max;
+	uint32_t		Count[GPS_HEATMAP_SIZE*GPS_HEATMAP_SIZE];
+
+}GPS_HeatmapTile_t;
+
+typedef struct
+{
+	GPS_HeatmapTile_t	**Tile;
+	uint32_t		*Slot;									//	open addressing on X/Y, index+1 into Tile
+	uint32_t		Slots;
+	uint32_t		Tiles;
+	uint32_t		Room;
+	uint32_t		Max;
+
+}GPS_HeatmapLevel_t;
+
+typedef struct
+{
+	GPS_HeatmapLevel_t	Level[_GPS_HEATMAP_ZOOM+1];
+	uint8_t			Zoom;
+	uint8_t			Simd;
+	uint32_t		Last;										//	tile of the previous point, most points fall in it too
+	uint64_t		Points;
+	uint64_t		Dropped;
+	uint64_t		Bytes;
+	uint32_t		Files;
+	double			AddTime;
+	double			PyramidTime;
+	double			WriteTime;
+
+}GPS_Heatmap_t;
+
+//##################################################################################################################
+uint8_t		GPS_Heatmap_Init(GPS_Heatmap_t *Map,uint8_t Zoom);
+void			GPS_Heatmap_Free(GPS_Heatmap_t *Map);
+//	1e-7 degree, as GPS_Fix_t. Points beyond the Mercator latitude limit are dropped.
+void			GPS_Heatmap_Add(GPS_Heatmap_t *Map,const int32_t *Latitude,const int32_t *Longitude,uint32_t Count);
+#if (_GPS_ARCHIVE==1)
+uint8_t		GPS_Heatmap_Archive(GPS_Heatmap_t *Map,const GPS_ArchiveReader_t *Reader);
+#endif
+//	levels Zoom-1 to 0 from the deepest one. Threads 0 takes _GPS_HEATMAP_THREADS, and 0 there one per core.
+uint8_t		GPS_Heatmap_Pyramid(GPS_Heatmap_t *Map,uint32_t Threads);
+uint32_t	GPS_Heatmap_Write(GPS_Heatmap_t *Map,const char *Dir,GPS_HeatmapFormat_t Format,uint32_t Threads);
+//	PNG of one tile, colours scaled to Max on a log scale. Returns the length, 0 when Size is too small.
+uint32_t	GPS_Heatmap_Png(const GPS_HeatmapTile_t *Tile,uint32_t Max,uint8_t *Out,uint32_t Size);
+void			GPS_Heatmap_Report(const GPS_Heatmap_t *Map);
+//##################################################################################################################
+
+#endif
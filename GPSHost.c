@@ -0,0 +1,145 @@
+#include "GPSConfig.h"
+
+#if (_GPS_HOST==1)
+
+#include "GPSHost.h"
+#include "GPS.h"
+#if (_GPS_ASSIST==1)
+#include "GPSAssist.h"
+#endif
+#include <stddef.h>
+#include <time.h>
+
+UART_HandleTypeDef _GPS_USART;
+#if (_GPS_MAVLINK==1)
+UART_HandleTypeDef _GPS_MAVLINK_USART;
+#endif
+
+static GPS_HostTx_t	GPS_HostTx;
+static uint8_t			GPS_HostVirtual;
+static uint32_t			GPS_HostTick;
+//##################################################################################################################
+uint32_t	HAL_GetTick(void)
+{
+	static uint64_t	start;
+	struct timespec	ts;
+	uint64_t				ms;
+	if(GPS_HostVirtual)
+		return GPS_HostTick;
+	clock_gettime(CLOCK_MONOTONIC,&ts);
+	ms=(uint64_t)ts.tv_sec*1000+(uint64_t)ts.tv_nsec/1000000;
+	if(start==0)
+		start=ms;
+	return (uint32_t)(ms-start);
+}
+//##################################################################################################################
+HAL_StatusTypeDef	HAL_UART_Receive_IT(UART_HandleTypeDef *huart,uint8_t *pData,uint16_t Size)
+{
+	huart->pRxBuffPtr=pData;
+	huart->RxXferSize=Size;
+	return HAL_OK;
+}
+//##################################################################################################################
+HAL_StatusTypeDef	HAL_UART_Receive_DMA(UART_HandleTypeDef *huart,uint8_t *pData,uint16_t Size)
+{
+	//	circular mode, Counter counts down like NDTR
+	huart->pRxBuffPtr=pData;
+	huart->RxXferSize=Size;
+	huart->RxCircular=1;
+	huart->hdmarx=&huart->DmaRx;
+	huart->DmaRx.Counter=Size;
+	return HAL_OK;
+}
+//##################################################################################################################
+HAL_StatusTypeDef	HAL_UARTEx_ReceiveToIdle_DMA(UART_HandleTypeDef *huart,uint8_t *pData,uint16_t Size)
+{
+	return HAL_UART_Receive_DMA(huart,pData,Size);
+}
+//##################################################################################################################
+HAL_StatusTypeDef	HAL_UART_Transmit(UART_HandleTypeDef *huart,uint8_t *pData,uint16_t Size,uint32_t Timeout)
+{
+	(void)huart;
+	(void)Timeout;
+	if(GPS_HostTx!=NULL)
+		GPS_HostTx(pData,Size);
+	return HAL_OK;
+}
+//##################################################################################################################
+HAL_StatusTypeDef	HAL_UART_Transmit_DMA(UART_HandleTypeDef *huart,uint8_t *pData,uint16_t Size)
+{
+	if(GPS_HostTx!=NULL)
+		GPS_HostTx(pData,Size);
+	HAL_UART_TxCpltCallback(huart);
+	return HAL_OK;
+}
+//##################################################################################################################
+__attribute__((weak)) void	HAL_UART_RxCpltCallback(UART_HandleTypeDef *huart)
+{
+	if(huart==&_GPS_USART)
+		GPS_CallBack();
+}
+//##################################################################################################################
+__attribute__((weak)) void	HAL_UART_TxCpltCallback(UART_HandleTypeDef *huart)
+{
+	(void)huart;
+	#if (_GPS_ASSIST==1)
+	if(huart==&_GPS_USART)
+		GPS_Assist_TxCallBack();
+	#endif
+}
+//##################################################################################################################
+void	GPS_Host_Feed(UART_HandleTypeDef *huart,const uint8_t *Data,uint32_t Len)
+{
+	//	one byte per "interrupt", a byte arriving while reception is not armed is lost like an overrun
+	if(huart->RxCircular)
+	{
+		//	circular DMA just fills the buffer, nothing is called
+		for(uint32_t i=0 ; i<Len ; i++)
+		{
+			huart->pRxBuffPtr[huart->RxXferSize-huart->DmaRx.Counter]=Data[i];
+			if(--huart->DmaRx.Counter==0)
+				huart->DmaRx.Counter=huart->RxXferSize;
+		}
+		return;
+	}
+	for(uint32_t i=0 ; i<Len ; i++)
+	{
+		uint8_t	*p=huart->pRxBuffPtr;
+		if(p==NULL)
+			continue;
+		huart->pRxBuffPtr=NULL;
+		*p=Data[i];
+		HAL_UART_RxCpltCallback(huart);
+	}
+}
+//##################################################################################################################
+void	GPS_Host_SetTx(GPS_HostTx_t Tx)
+{
+	GPS_HostTx=Tx;
+}
+//##################################################################################################################
+void	GPS_Host_VirtualTick(uint8_t Enable)
+{
+	GPS_HostVirtual=Enable;
+}
+//##################################################################################################################
+void	GPS_Host_SetTick(uint32_t Tick)
+{
+	GPS_HostTick=Tick;
+}
+//##################################################################################################################
+void	GPS_Host_Delay(uint32_t Delay)
+{
+	GPS_HostTick+=Delay;
+}
+//##################################################################################################################
+uint32_t	GPS_Host_Cycles(void)
+{
+	//	stands in for DWT->CYCCNT, one count per nanosecond
+	struct timespec	ts;
+	clock_gettime(CLOCK_MONOTONIC,&ts);
+	return (uint32_t)((uint64_t)ts.tv_sec*1000000000ULL+(uint64_t)ts.tv_nsec);
+}
+//##################################################################################################################
+
+#endif
@@ -0,0 +1,64 @@
+#ifndef _GPSHOST_H_
+#define _GPSHOST_H_
+
+#include <stdint.h>
+#include "GPSConfig.h"
+
+//##################################################################################################################
+//	Minimal HAL replacement so the library builds and runs on a PC. Received bytes are pushed with GPS_Host_Feed()
+//	and reach GPS_CallBack() through HAL_UART_RxCpltCallback(), exactly like the usart interrupt on target.
+//##################################################################################################################
+
+typedef enum
+{
+	HAL_OK=0,
+	HAL_ERROR,
+	HAL_BUSY,
+	HAL_TIMEOUT,
+
+}HAL_StatusTypeDef;
+
+typedef struct
+{
+	uint32_t		Counter;
+
+}DMA_HandleTypeDef;
+
+typedef struct
+{
+	int					fd;
+	uint8_t			*pRxBuffPtr;
+	uint16_t		RxXferSize;
+	uint8_t			RxCircular;
+	DMA_HandleTypeDef	*hdmarx;
+	DMA_HandleTypeDef	DmaRx;
+
+}UART_HandleTypeDef;
+
+#define	__HAL_DMA_GET_COUNTER(__HANDLE__)		((__HANDLE__)->Counter)
+
+typedef void	(*GPS_HostTx_t)(const uint8_t *Data,uint16_t Len);
+
+extern UART_HandleTypeDef _GPS_USART;
+#if (_GPS_MAVLINK==1)
+extern UART_HandleTypeDef _GPS_MAVLINK_USART;
+#endif
+//##################################################################################################################
+uint32_t					HAL_GetTick(void);
+HAL_StatusTypeDef	HAL_UART_Receive_IT(UART_HandleTypeDef *huart,uint8_t *pData,uint16_t Size);
+HAL_StatusTypeDef	HAL_UART_Receive_DMA(UART_HandleTypeDef *huart,uint8_t *pData,uint16_t Size);
+HAL_StatusTypeDef	HAL_UARTEx_ReceiveToIdle_DMA(UART_HandleTypeDef *huart,uint8_t *pData,uint16_t Size);
+HAL_StatusTypeDef	HAL_UART_Transmit(UART_HandleTypeDef *huart,uint8_t *pData,uint16_t Size,uint32_t Timeout);
+HAL_StatusTypeDef	HAL_UART_Transmit_DMA(UART_HandleTypeDef *huart,uint8_t *pData,uint16_t Size);
+void							HAL_UART_RxCpltCallback(UART_HandleTypeDef *huart);
+void							HAL_UART_TxCpltCallback(UART_HandleTypeDef *huart);
+
+void	GPS_Host_Feed(UART_HandleTypeDef *huart,const uint8_t *Data,uint32_t Len);
+void	GPS_Host_SetTx(GPS_HostTx_t Tx);
+void	GPS_Host_VirtualTick(uint8_t Enable);
+void	GPS_Host_SetTick(uint32_t Tick);
+void	GPS_Host_Delay(uint32_t Delay);
+uint32_t	GPS_Host_Cycles(void);
+//##################################################################################################################
+
+#endif
@@ -0,0 +1,238 @@
+#include "GPSConfig.h"
+
+#if (_GPS_JAM==1)
+
+#if (_GPS_GSV==0) || (_GPS_FIX==0)
+#error "GPSJam needs _GPS_GSV and _GPS_FIX"
+#endif
+#if (_GPS_JAM_SATS & (_GPS_JAM_SATS-1))!=0
+#error "_GPS_JAM_SATS must be a power of two"
+#endif
+
+#include "GPSJam.h"
+#include <string.h>
+#include <math.h>
+
+#define	GPS_JAM_METRE									0.011131949					//	m per 1e-7 degree of latitude
+#define	GPS_JAM_DAY										86400000L
+#define	GPS_JAM_WARMUP								8										//	cycles before a baseline counts
+#define	GPS_JAM_MINIMUM								4										//	satellites for a C/N0 verdict
+#define	GPS_JAM_ACCEL									10.0								//	m/s2 a vehicle may add to the prediction
+#define	GPS_JAM_HISTORY								4096
+#define	GPS_JAM_HALF									1800000000.0				//	180 degrees
+
+GPS_Jam_t GPS_Jam;
+//##################################################################################################################
+static void	GPS_Jam_Update(GPS_Jam_t *Jam,uint32_t Time)
+{
+	uint8_t	flags=(uint8_t)(Jam->Sky | Jam->Motion | Jam->Clock);
+	if(flags==Jam->Alert.Flags)
+		return;
+	Jam->Alert.Raised=(uint8_t)(flags & ~Jam->Alert.Flags);
+	Jam->Alert.Flags=flags;
+	Jam->Alert.Time=Time;
+	if(Jam->Alert.Raised!=0)
+		Jam->Alerts++;
+	if(Jam->Callback!=NULL)
+		Jam->Callback(Jam->Context,&Jam->Alert);
+}
+//##################################################################################################################
+static GPS_JamSat_t	*GPS_Jam_Find(GPS_Jam_t *Jam,char Talker,uint8_t Prn)
+{
+	//	open addressing, a full table leaves new satellites without a baseline
+	uint16_t	key=(uint16_t)(((uint8_t)Talker<<8) | Prn);
+	uint32_t	h=key*0x9E3779B1UL>>16;
+	if(key==0)
+		return NULL;
+	for(uint32_t i=0 ; i<_GPS_JAM_SATS ; i++)
+	{
+		GPS_JamSat_t	*s=&Jam->Sat[(h+i) & (_GPS_JAM_SATS-1)];
+		if(s->Key==key)
+			return s;
+		if(s->Key==0)
+		{
+			s->Key=key;
+			return s;
+		}
+	}
+	return NULL;
+}
+//##################################################################################################################
+void	GPS_Jam_Init(GPS_Jam_t *Jam,GPS_JamCallback_t Callback,void *Context)
+{
+	memset(Jam,0,sizeof(GPS_Jam_t));
+	Jam->Callback=Callback;
+	Jam->Context=Context;
+}
+//##################################################################################################################
+void	GPS_Jam_AddSky(GPS_Jam_t *Jam,const GPS_Sat_t *Sat,uint8_t Count,uint32_t Time)
+{
+	GPS_JamSat_t	*slot[_GPS_GSV_SATS];
+	uint8_t		based=0,lost=0,compared=0,tracked=0;
+	double		shift=0.0,sum=0.0,sum2=0.0,spread=0.0;
+	if(Count>_GPS_GSV_SATS)
+		Count=_GPS_GSV_SATS;
+	for(uint8_t i=0 ; i<Count ; i++)
+	{
+		GPS_JamSat_t	*s=slot[i]=GPS_Jam_Find(Jam,Sat[i].Talker,Sat[i].Prn);
+		uint8_t				snr=Sat[i].Snr;
+		uint8_t				ready=(s!=NULL) && (s->Updates>=GPS_JAM_WARMUP);
+		based+=ready;
+		if(snr==0)
+		{
+			lost+=ready;
+			continue;
+		}
+		tracked++;
+		sum+=snr;
+		sum2+=(double)snr*snr;
+		Jam->Histogram[(snr<63) ? snr : 63]++;
+		Jam->Samples++;
+		if(ready)
+		{
+			shift+=snr-s->Mean;
+			compared++;
+		}
+	}
+	if(Jam->Samples>=GPS_JAM_HISTORY)
+	{
+		Jam->Samples=0;
+		for(uint8_t i=0 ; i<64 ; i++)
+			Jam->Samples+=(Jam->Histogram[i]>>=1);
+	}
+	if(compared>0)
+		shift/=compared;
+	if(tracked>1)
+		spread=sqrt(fmax(0.0,(sum2-sum*sum/tracked)/(tracked-1)));
+	//	each talker keeps its verdict until its next cycle, the sky flags are all of them together
+	uint8_t	t=0;
+	while((t<GPS_JAM_TALKERS-1) && (Jam->Talker[t]!=0) && (Jam->Talker[t]!=Sat[0].Talker))
+		t++;
+	Jam->Talker[t]=(Count>0) ? Sat[0].Talker : 0;
+	Jam->Verdict[t]=0;
+	if(compared>=GPS_JAM_MINIMUM)
+	{
+		if(shift<=-_GPS_JAM_DROP)
+			Jam->Verdict[t]|=GPS_JAM_CN0_DROP;
+		else if(shift>=_GPS_JAM_RISE)
+			Jam->Verdict[t]|=GPS_JAM_CN0_RISE;
+	}
+	if((based>=GPS_JAM_MINIMUM) && (lost*2>based))
+		Jam->Verdict[t]|=GPS_JAM_LOST;
+	//	only against a sky that used to be spread out, some antennas see every satellite alike
+	if((tracked>GPS_JAM_MINIMUM) && (spread<_GPS_JAM_UNIFORM) && (Jam->Spread>=2*_GPS_JAM_UNIFORM))
+		Jam->Verdict[t]|=GPS_JAM_UNIFORM;
+	Jam->Sky=0;
+	for(uint8_t i=0 ; i<GPS_JAM_TALKERS ; i++)
+		Jam->Sky|=Jam->Verdict[i];
+	Jam->Alert.Satellites=compared;
+	Jam->Alert.Shift=(float)shift;
+	Jam->Alert.Spread=(float)spread;
+	if(Jam->Sky==0)
+	{
+		//	baselines are frozen while an indicator is up, so the attack does not become the reference
+		for(uint8_t i=0 ; i<Count ; i++)
+			if((slot[i]!=NULL) && (Sat[i].Snr!=0))
+			{
+				GPS_JamSat_t	*s=slot[i];
+				s->Mean=(s->Updates==0) ? Sat[i].Snr : s->Mean+(Sat[i].Snr-s->Mean)*(1.0f/16.0f);
+				if(s->Updates<0xFFFF)
+					s->Updates++;
+			}
+		if(tracked>GPS_JAM_MINIMUM)
+			Jam->Spread=(Jam->Spread==0.0f) ? (float)spread : Jam->Spread+((float)spread-Jam->Spread)*(1.0f/16.0f);
+	}
+	GPS_Jam_Update(Jam,Time);
+}
+//##################################################################################################################
+void	GPS_Jam_AddFix(GPS_Jam_t *Jam,const GPS_Fix_t *Fix,uint32_t Tick)
+{
+	if(Fix->Fix==0)
+		return;
+	Jam->Motion=0;
+	if(Jam->Fixes>0)
+	{
+		int32_t	dt=(int32_t)(Fix->UTC_Time-Jam->UtcTime);
+		int32_t	dtick=(int32_t)(Tick-Jam->Tick);
+		if(dt<-GPS_JAM_DAY/2)
+			dt+=GPS_JAM_DAY;
+		else if(dt>GPS_JAM_DAY/2)
+			dt-=GPS_JAM_DAY;
+		Jam->Alert.TimeError=dt-dtick;
+		if((Jam->Alert.TimeError>_GPS_JAM_TIME) || (Jam->Alert.TimeError<-_GPS_JAM_TIME))
+			Jam->Motion|=GPS_JAM_TIME;
+		if(dt>0)
+		{
+			double	s=dt*1e-3;
+			double	north=((double)Fix->Latitude-Jam->Latitude)*GPS_JAM_METRE;
+			double	east=(double)Fix->Longitude-Jam->Longitude;
+			east=(east>GPS_JAM_HALF) ? east-2.0*GPS_JAM_HALF : (east<-GPS_JAM_HALF) ? east+2.0*GPS_JAM_HALF : east;
+			east*=GPS_JAM_METRE*cos(Fix->Latitude*1e-7*M_PI/180.0);
+			double	dn=north-Jam->North*s,de=east-Jam->East*s;
+			double	margin=_GPS_JAM_JUMP+0.5*GPS_JAM_ACCEL*s*s;
+			Jam->Alert.Jump=(float)sqrt(dn*dn+de*de);
+			if((Jam->Fixes>1) && (Jam->Alert.Jump>margin))
+			{
+				//	started again from the new position, so one jump raises one alert
+				Jam->Motion|=GPS_JAM_POSITION;
+				Jam->Fixes=1;
+				Jam->North=Jam->East=0.0f;
+			}
+			else
+			{
+				Jam->North=(float)(north/s);
+				Jam->East=(float)(east/s);
+				Jam->Fixes=2;
+			}
+		}
+	}
+	else
+		Jam->Fixes=1;
+	Jam->Latitude=Fix->Latitude;
+	Jam->Longitude=Fix->Longitude;
+	Jam->UtcTime=Fix->UTC_Time;
+	Jam->Tick=Tick;
+	GPS_Jam_Update(Jam,Fix->UTC_Time);
+}
+//##################################################################################################################
+void	GPS_Jam_AddPPS(GPS_Jam_t *Jam,int32_t OffsetNs)
+{
+	//	two offsets of opposite sign can be more than INT32_MAX apart
+	int64_t	step=(int64_t)OffsetNs-Jam->PpsLast;
+	Jam->Clock=0;
+	if(Jam->Pps>=2)
+	{
+		float	error=(float)step-Jam->Drift;
+		Jam->Alert.ClockError=(error>=2147483520.0f) ? INT32_MAX : (error<=-2147483648.0f) ? INT32_MIN : (int32_t)lroundf(error);
+		if((Jam->Alert.ClockError>_GPS_JAM_PPS) || (Jam->Alert.ClockError<-_GPS_JAM_PPS))
+			Jam->Clock=GPS_JAM_CLOCK;
+		else
+			Jam->Drift+=error*(1.0f/8.0f);
+	}
+	else if(Jam->Pps==1)
+	{
+		Jam->Drift=(float)step;
+		Jam->Pps++;
+	}
+	else
+		Jam->Pps++;
+	Jam->PpsLast=OffsetNs;
+	GPS_Jam_Update(Jam,Jam->UtcTime);
+}
+//##################################################################################################################
+uint8_t	GPS_Jam_Percentile(const GPS_Jam_t *Jam,uint8_t Percent)
+{
+	uint32_t	total=0,run=0;
+	for(uint8_t i=0 ; i<64 ; i++)
+		total+=Jam->Histogram[i];
+	for(uint8_t i=0 ; i<64 ; i++)
+	{
+		run+=Jam->Histogram[i];
+		if((total>0) && (run*100>=total*Percent))
+			return i;
+	}
+	return 0;
+}
+//##################################################################################################################
+
+#endif
@@ -0,0 +1,99 @@
+#ifndef _GPSJAM_H_
+#define _GPSJAM_H_
+
+#include <stdint.h>
+#include "GPSConfig.h"
+#include "GPS.h"
+
+//##################################################################################################################
+//	Jamming and spoofing indicators. Each satellite keeps a running C/N0 baseline, and every GSV cycle is compared
+//	with it: a drop common to all satellites points to jamming, a common rise or a collapse of the spread between
+//	satellites to spoofing. Fixes are checked against a constant velocity prediction and the receiver clock, PPS
+//	offsets against their drift. Memory is fixed and an alert goes out from the call that brought the evidence.
+//##################################################################################################################
+
+typedef enum
+{
+	GPS_JAM_CN0_DROP=0x01,							//	C/N0 down by _GPS_JAM_DROP dB on average over the baselines
+	GPS_JAM_LOST=0x02,									//	most satellites with a baseline lost their SNR
+	GPS_JAM_CN0_RISE=0x04,							//	C/N0 up by _GPS_JAM_RISE dB
+	GPS_JAM_UNIFORM=0x08,								//	spread between satellites under _GPS_JAM_UNIFORM dB
+	GPS_JAM_POSITION=0x10,							//	fix off the prediction by more than _GPS_JAM_JUMP m and the manoeuvre margin
+	GPS_JAM_TIME=0x20,									//	UTC step off the local tick by more than _GPS_JAM_TIME ms
+	GPS_JAM_CLOCK=0x40,									//	PPS offset off its drift by more than _GPS_JAM_PPS ns
+
+}GPS_JamFlag_t;
+
+#define	GPS_JAM_TALKERS					8
+#define	GPS_JAM_SKY							(GPS_JAM_CN0_DROP | GPS_JAM_LOST | GPS_JAM_CN0_RISE | GPS_JAM_UNIFORM)
+
+typedef struct
+{
+	uint8_t			Flags;
+	uint8_t			Raised;									//	flags new in this alert
+	uint8_t			Satellites;							//	compared with a baseline in the last cycle
+	uint32_t		Time;										//	UTC ms of day of the epoch
+	float				Shift;									//	mean C/N0 change against the baselines, dB
+	float				Spread;									//	C/N0 standard deviation between satellites, dB
+	float				Jump;										//	distance of the last fix from its prediction, m
+	int32_t			TimeError;							//	ms
+	int32_t			ClockError;							//	ns
+
+}GPS_JamAlert_t;
+
+typedef void	(*GPS_JamCallback_t)(void *Context,const GPS_JamAlert_t *Alert);
+
+typedef struct
+{
+	uint16_t		Key;										//	talker<<8 | PRN, 0 when free
+	uint16_t		Updates;
+	float				Mean;
+
+}GPS_JamSat_t;
+
+typedef struct
+{
+	GPS_JamCallback_t	Callback;
+	void				*Context;
+	GPS_JamAlert_t	Alert;
+
+	GPS_JamSat_t	Sat[_GPS_JAM_SATS];
+	float				Spread;									//	baseline of the spread between satellites
+	uint16_t		Histogram[64];					//	C/N0 in 1 dB bins, halved as it fills
+	uint32_t		Samples;
+	char				Talker[GPS_JAM_TALKERS];
+	uint8_t			Verdict[GPS_JAM_TALKERS];	//	sky flags of the talker's last cycle
+	uint8_t			Sky;
+
+	uint8_t			Fixes;
+	uint8_t			Motion;
+	int32_t			Latitude;
+	int32_t			Longitude;
+	uint32_t		UtcTime;
+	uint32_t		Tick;
+	float				East;										//	m/s
+	float				North;
+
+	uint8_t			Pps;
+	uint8_t			Clock;
+	int32_t			PpsLast;
+	float				Drift;									//	ns per PPS
+
+	uint32_t		Alerts;
+
+}GPS_Jam_t;
+
+extern GPS_Jam_t GPS_Jam;
+//##################################################################################################################
+void			GPS_Jam_Init(GPS_Jam_t *Jam,GPS_JamCallback_t Callback,void *Context);
+//	one talker's GSV cycle; GPS_Jam gets them from the decoder
+void			GPS_Jam_AddSky(GPS_Jam_t *Jam,const GPS_Sat_t *Sat,uint8_t Count,uint32_t Time);
+//	Tick is the local ms clock the fix arrived at (HAL_GetTick); GPS_Jam gets every published fix
+void			GPS_Jam_AddFix(GPS_Jam_t *Jam,const GPS_Fix_t *Fix,uint32_t Tick);
+//	offset of the PPS edge against the local timebase, once a second
+void			GPS_Jam_AddPPS(GPS_Jam_t *Jam,int32_t OffsetNs);
+//	C/N0 below which Percent of the recent samples fall, dB-Hz
+uint8_t		GPS_Jam_Percentile(const GPS_Jam_t *Jam,uint8_t Percent);
+//##################################################################################################################
+
+#endif
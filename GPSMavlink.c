@@ -0,0 +1,233 @@
+#include "GPSConfig.h"
+
+#if (_GPS_MAVLINK==1)
+
+#include "GPSMavlink.h"
+#if (_GPS_HOST==1)
+#include "GPSHost.h"
+#else
+#include "usart.h"
+#endif
+#if (_GPS_CRC==1) && (_GPS_CRC_HW==1)
+#include "GPSCrc.h"
+#endif
+#include <string.h>
+#include <math.h>
+
+#define	GPS_MAVLINK_STX								0xFD
+#define	GPS_MAVLINK_HEADER						10
+#define	GPS_MAVLINK_UNKNOWN						0xFFFF
+
+//	GPS_INPUT ignore_flags
+#define	GPS_MAVLINK_IGNORE_VDOP				0x0004
+#define	GPS_MAVLINK_IGNORE_VEL				0x0018
+#define	GPS_MAVLINK_IGNORE_SPEED_ACC	0x0020
+#define	GPS_MAVLINK_IGNORE_HORIZ_ACC	0x0040
+#define	GPS_MAVLINK_IGNORE_VERT_ACC		0x0080
+
+GPS_Mavlink_t GPS_Mavlink;
+//##################################################################################################################
+//	CRC-16/MCRF4XX (reflected 0x1021, init 0xFFFF), one table lookup per byte
+static const uint16_t	GPS_Mavlink_CrcTable[256]=
+{
+	0x0000,0x1189,0x2312,0x329B,0x4624,0x57AD,0x6536,0x74BF,0x8C48,0x9DC1,0xAF5A,0xBED3,0xCA6C,0xDBE5,0xE97E,0xF8F7,
+	0x1081,0x0108,0x3393,0x221A,0x56A5,0x472C,0x75B7,0x643E,0x9CC9,0x8D40,0xBFDB,0xAE52,0xDAED,0xCB64,0xF9FF,0xE876,
+	0x2102,0x308B,0x0210,0x1399,0x6726,0x76AF,0x4434,0x55BD,0xAD4A,0xBCC3,0x8E58,0x9FD1,0xEB6E,0xFAE7,0xC87C,0xD9F5,
+	0x3183,0x200A,0x1291,0x0318,0x77A7,0x662E,0x54B5,0x453C,0xBDCB,0xAC42,0x9ED9,0x8F50,0xFBEF,0xEA66,0xD8FD,0xC974,
+	0x4204,0x538D,0x6116,0x709F,0x0420,0x15A9,0x2732,0x36BB,0xCE4C,0xDFC5,0xED5E,0xFCD7,0x8868,0x99E1,0xAB7A,0xBAF3,
+	0x5285,0x430C,0x7197,0x601E,0x14A1,0x0528,0x37B3,0x263A,0xDECD,0xCF44,0xFDDF,0xEC56,0x98E9,0x8960,0xBBFB,0xAA72,
+	0x6306,0x728F,0x4014,0x519D,0x2522,0x34AB,0x0630,0x17B9,0xEF4E,0xFEC7,0xCC5C,0xDDD5,0xA96A,0xB8E3,0x8A78,0x9BF1,
+	0x7387,0x620E,0x5095,0x411C,0x35A3,0x242A,0x16B1,0x0738,0xFFCF,0xEE46,0xDCDD,0xCD54,0xB9EB,0xA862,0x9AF9,0x8B70,
+	0x8408,0x9581,0xA71A,0xB693,0xC22C,0xD3A5,0xE13E,0xF0B7,0x0840,0x19C9,0x2B52,0x3ADB,0x4E64,0x5FED,0x6D76,0x7CFF,
+	0x9489,0x8500,0xB79B,0xA612,0xD2AD,0xC324,0xF1BF,0xE036,0x18C1,0x0948,0x3BD3,0x2A5A,0x5EE5,0x4F6C,0x7DF7,0x6C7E,
+	0xA50A,0xB483,0x8618,0x9791,0xE32E,0xF2A7,0xC03C,0xD1B5,0x2942,0x38CB,0x0A50,0x1BD9,0x6F66,0x7EEF,0x4C74,0x5DFD,
+	0xB58B,0xA402,0x9699,0x8710,0xF3AF,0xE226,0xD0BD,0xC134,0x39C3,0x284A,0x1AD1,0x0B58,0x7FE7,0x6E6E,0x5CF5,0x4D7C,
+	0xC60C,0xD785,0xE51E,0xF497,0x8028,0x91A1,0xA33A,0xB2B3,0x4A44,0x5BCD,0x6956,0x78DF,0x0C60,0x1DE9,0x2F72,0x3EFB,
+	0xD68D,0xC704,0xF59F,0xE416,0x90A9,0x8120,0xB3BB,0xA232,0x5AC5,0x4B4C,0x79D7,0x685E,0x1CE1,0x0D68,0x3FF3,0x2E7A,
+	0xE70E,0xF687,0xC41C,0xD595,0xA12A,0xB0A3,0x8238,0x93B1,0x6B46,0x7ACF,0x4854,0x59DD,0x2D62,0x3CEB,0x0E70,0x1FF9,
+	0xF78F,0xE606,0xD49D,0xC514,0xB1AB,0xA022,0x92B9,0x8330,0x7BC7,0x6A4E,0x58D5,0x495C,0x3DE3,0x2C6A,0x1EF1,0x0F78,
+};
+//##################################################################################################################
+static uint16_t	GPS_Mavlink_Crc(uint16_t Crc,const uint8_t *Data,uint16_t Len)
+{
+	while(Len--)
+		Crc=(uint16_t)((Crc>>8) ^ GPS_Mavlink_CrcTable[(uint8_t)(Crc ^ *Data++)]);
+	return Crc;
+}
+//##################################################################################################################
+static void	GPS_Mavlink_U16(uint8_t *p,uint16_t Value)
+{
+	p[0]=(uint8_t)Value;
+	p[1]=(uint8_t)(Value>>8);
+}
+//##################################################################################################################
+static void	GPS_Mavlink_U32(uint8_t *p,uint32_t Value)
+{
+	p[0]=(uint8_t)Value;
+	p[1]=(uint8_t)(Value>>8);
+	p[2]=(uint8_t)(Value>>16);
+	p[3]=(uint8_t)(Value>>24);
+}
+//##################################################################################################################
+static void	GPS_Mavlink_U64(uint8_t *p,uint64_t Value)
+{
+	GPS_Mavlink_U32(p,(uint32_t)Value);
+	GPS_Mavlink_U32(p+4,(uint32_t)(Value>>32));
+}
+//##################################################################################################################
+static void	GPS_Mavlink_F32(uint8_t *p,float Value)
+{
+	uint32_t	u;
+	memcpy(&u,&Value,4);
+	GPS_Mavlink_U32(p,u);
+}
+//##################################################################################################################
+static uint8_t	GPS_Mavlink_FixType(const GPS_Epoch_t *Epoch)
+{
+	//	GGA quality to GPS_FIX_TYPE, dead reckoning has no MAVLink equivalent and reads as no fix
+	static const uint8_t	type[9]={1,3,4,3,6,5,1,7,3};
+	if((Epoch->Sentences & (GPS_EPOCH_GGA | GPS_EPOCH_GNS))==0)
+		return 0;
+	return (Epoch->Fix<9) ? type[Epoch->Fix] : 1;
+}
+//##################################################################################################################
+static uint16_t	GPS_Mavlink_Dop(float Dop)
+{
+	return ((Dop<=0.0f) || (Dop>=655.0f)) ? GPS_MAVLINK_UNKNOWN : (uint16_t)(Dop*100.0f+0.5f);
+}
+//##################################################################################################################
+static uint32_t	GPS_Mavlink_Mm(float Meters)
+{
+	return (uint32_t)(Meters*1000.0f+0.5f);
+}
+//##################################################################################################################
+static uint16_t	GPS_Mavlink_Finish(uint8_t *Buffer,uint32_t MsgId,uint8_t Len,uint8_t CrcExtra)
+{
+	//	v2 drops trailing zero bytes of the payload, at least one byte is kept
+	uint8_t		*payload=&Buffer[GPS_MAVLINK_HEADER];
+	uint16_t	crc;
+	while((Len>1) && (payload[Len-1]==0))
+		Len--;
+	Buffer[0]=GPS_MAVLINK_STX;
+	Buffer[1]=Len;
+	Buffer[2]=0;
+	Buffer[3]=0;
+	Buffer[4]=GPS_Mavlink.Sequence++;
+	Buffer[5]=GPS_Mavlink.System;
+	Buffer[6]=GPS_Mavlink.Component;
+	Buffer[7]=(uint8_t)MsgId;
+	Buffer[8]=(uint8_t)(MsgId>>8);
+	Buffer[9]=(uint8_t)(MsgId>>16);
+	#if (_GPS_CRC==1) && (_GPS_CRC_HW==1)
+	crc=GPS_Crc_Mcrf4xx(&Buffer[1],GPS_MAVLINK_HEADER-1+Len);
+	#else
+	crc=GPS_Mavlink_Crc(0xFFFF,&Buffer[1],(uint16_t)(GPS_MAVLINK_HEADER-1+Len));
+	#endif
+	crc=GPS_Mavlink_Crc(crc,&CrcExtra,1);
+	GPS_Mavlink_U16(&payload[Len],crc);
+	GPS_Mavlink.Frames++;
+	return (uint16_t)(GPS_MAVLINK_HEADER+Len+2);
+}
+//##################################################################################################################
+void	GPS_Mavlink_Init(uint8_t System,uint8_t Component)
+{
+	memset(&GPS_Mavlink,0,sizeof(GPS_Mavlink));
+	GPS_Mavlink.System=System;
+	GPS_Mavlink.Component=Component;
+}
+//##################################################################################################################
+uint16_t	GPS_Mavlink_GpsRawInt(uint8_t *Buffer,const GPS_Epoch_t *Epoch,uint64_t TimeUsec)
+{
+	uint8_t	*p=&Buffer[GPS_MAVLINK_HEADER];
+	uint8_t	gst=(Epoch->Sentences & GPS_EPOCH_GST)!=0;
+	GPS_Mavlink_U64(&p[0],TimeUsec);
+	GPS_Mavlink_U32(&p[8],(uint32_t)lround(Epoch->Latitude*1e7));
+	GPS_Mavlink_U32(&p[12],(uint32_t)lround(Epoch->Longitude*1e7));
+	GPS_Mavlink_U32(&p[16],(uint32_t)lroundf(Epoch->MSL_Altitude*1000.0f));
+	GPS_Mavlink_U16(&p[20],GPS_Mavlink_Dop(Epoch->HDOP));
+	GPS_Mavlink_U16(&p[22],GPS_MAVLINK_UNKNOWN);
+	GPS_Mavlink_U16(&p[24],GPS_MAVLINK_UNKNOWN);
+	GPS_Mavlink_U16(&p[26],GPS_MAVLINK_UNKNOWN);
+	p[28]=GPS_Mavlink_FixType(Epoch);
+	p[29]=Epoch->SatellitesUsed;
+	//	extensions
+	GPS_Mavlink_U32(&p[30],(uint32_t)lroundf((Epoch->MSL_Altitude+Epoch->Geoid_Separation)*1000.0f));
+	GPS_Mavlink_U32(&p[34],gst ? GPS_Mavlink_Mm(hypotf(Epoch->SigmaLatitude,Epoch->SigmaLongitude)) : 0);
+	GPS_Mavlink_U32(&p[38],gst ? GPS_Mavlink_Mm(Epoch->SigmaAltitude) : 0);
+	GPS_Mavlink_U32(&p[42],0);
+	GPS_Mavlink_U32(&p[46],0);
+	GPS_Mavlink_U16(&p[50],0);
+	return GPS_Mavlink_Finish(Buffer,GPS_MAVLINK_ID_GPS_RAW_INT,52,24);
+}
+//##################################################################################################################
+uint16_t	GPS_Mavlink_Gps2Raw(uint8_t *Buffer,const GPS_Epoch_t *Epoch,uint64_t TimeUsec)
+{
+	uint8_t	*p=&Buffer[GPS_MAVLINK_HEADER];
+	uint8_t	gst=(Epoch->Sentences & GPS_EPOCH_GST)!=0;
+	GPS_Mavlink_U64(&p[0],TimeUsec);
+	GPS_Mavlink_U32(&p[8],(uint32_t)lround(Epoch->Latitude*1e7));
+	GPS_Mavlink_U32(&p[12],(uint32_t)lround(Epoch->Longitude*1e7));
+	GPS_Mavlink_U32(&p[16],(uint32_t)lroundf(Epoch->MSL_Altitude*1000.0f));
+	GPS_Mavlink_U32(&p[20],0);
+	GPS_Mavlink_U16(&p[24],GPS_Mavlink_Dop(Epoch->HDOP));
+	GPS_Mavlink_U16(&p[26],GPS_MAVLINK_UNKNOWN);
+	GPS_Mavlink_U16(&p[28],GPS_MAVLINK_UNKNOWN);
+	GPS_Mavlink_U16(&p[30],GPS_MAVLINK_UNKNOWN);
+	p[32]=GPS_Mavlink_FixType(Epoch);
+	p[33]=Epoch->SatellitesUsed;
+	p[34]=0;
+	//	extensions
+	GPS_Mavlink_U16(&p[35],0);
+	GPS_Mavlink_U32(&p[37],(uint32_t)lroundf((Epoch->MSL_Altitude+Epoch->Geoid_Separation)*1000.0f));
+	GPS_Mavlink_U32(&p[41],gst ? GPS_Mavlink_Mm(hypotf(Epoch->SigmaLatitude,Epoch->SigmaLongitude)) : 0);
+	GPS_Mavlink_U32(&p[45],gst ? GPS_Mavlink_Mm(Epoch->SigmaAltitude) : 0);
+	GPS_Mavlink_U32(&p[49],0);
+	GPS_Mavlink_U32(&p[53],0);
+	return GPS_Mavlink_Finish(Buffer,GPS_MAVLINK_ID_GPS2_RAW,57,87);
+}
+//##################################################################################################################
+uint16_t	GPS_Mavlink_GpsInput(uint8_t *Buffer,const GPS_Epoch_t *Epoch,uint64_t TimeUsec,uint16_t Week,uint32_t WeekMs)
+{
+	uint8_t		*p=&Buffer[GPS_MAVLINK_HEADER];
+	uint16_t	ignore=GPS_MAVLINK_IGNORE_VDOP | GPS_MAVLINK_IGNORE_VEL | GPS_MAVLINK_IGNORE_SPEED_ACC;
+	if((Epoch->Sentences & GPS_EPOCH_GST)==0)
+		ignore|=GPS_MAVLINK_IGNORE_HORIZ_ACC | GPS_MAVLINK_IGNORE_VERT_ACC;
+	GPS_Mavlink_U64(&p[0],TimeUsec);
+	GPS_Mavlink_U32(&p[8],WeekMs);
+	GPS_Mavlink_U32(&p[12],(uint32_t)lround(Epoch->Latitude*1e7));
+	GPS_Mavlink_U32(&p[16],(uint32_t)lround(Epoch->Longitude*1e7));
+	GPS_Mavlink_F32(&p[20],Epoch->MSL_Altitude);
+	GPS_Mavlink_F32(&p[24],Epoch->HDOP);
+	GPS_Mavlink_F32(&p[28],0.0f);
+	GPS_Mavlink_F32(&p[32],0.0f);
+	GPS_Mavlink_F32(&p[36],0.0f);
+	GPS_Mavlink_F32(&p[40],0.0f);
+	GPS_Mavlink_F32(&p[44],0.0f);
+	GPS_Mavlink_F32(&p[48],hypotf(Epoch->SigmaLatitude,Epoch->SigmaLongitude));
+	GPS_Mavlink_F32(&p[52],Epoch->SigmaAltitude);
+	GPS_Mavlink_U16(&p[56],ignore);
+	GPS_Mavlink_U16(&p[58],Week);
+	p[60]=0;
+	p[61]=GPS_Mavlink_FixType(Epoch);
+	p[62]=Epoch->SatellitesUsed;
+	//	extension
+	GPS_Mavlink_U16(&p[63],0);
+	return GPS_Mavlink_Finish(Buffer,GPS_MAVLINK_ID_GPS_INPUT,65,151);
+}
+//##################################################################################################################
+void	GPS_Mavlink_Publish(const GPS_Epoch_t *Epoch)
+{
+	//	called by GPS_Process for every epoch, the frame stays in GPS_Mavlink.Frame until the next one
+	uint16_t	len;
+	if(GPS_Mavlink.System==0)
+		GPS_Mavlink_Init(_GPS_MAVLINK_SYSID,_GPS_MAVLINK_COMPID);
+	#if (_GPS_MAVLINK_AUTO==GPS_MAVLINK_ID_GPS2_RAW)
+	len=GPS_Mavlink_Gps2Raw(GPS_Mavlink.Frame,Epoch,(uint64_t)HAL_GetTick()*1000);
+	#else
+	len=GPS_Mavlink_GpsRawInt(GPS_Mavlink.Frame,Epoch,(uint64_t)HAL_GetTick()*1000);
+	#endif
+	_GPS_MAVLINK_TX(GPS_Mavlink.Frame,len);
+}
+//##################################################################################################################
+
+#endif
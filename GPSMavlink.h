@@ -0,0 +1,38 @@
+#ifndef _GPSMAVLINK_H_
+#define _GPSMAVLINK_H_
+
+#include <stdint.h>
+#include "GPSConfig.h"
+#include "GPS.h"
+
+//##################################################################################################################
+//	MAVLink v2 encoder for GPS_RAW_INT, GPS2_RAW and GPS_INPUT. Fields are packed straight into the caller's
+//	frame buffer from GPS.Epoch and the X.25 checksum runs once over the finished frame.
+//##################################################################################################################
+
+#define	GPS_MAVLINK_ID_GPS_RAW_INT			24
+#define	GPS_MAVLINK_ID_GPS2_RAW					124
+#define	GPS_MAVLINK_ID_GPS_INPUT				232
+#define	GPS_MAVLINK_MAX_FRAME						(10+65+2)
+
+typedef struct
+{
+	uint8_t			System;
+	uint8_t			Component;
+	uint8_t			Sequence;
+	uint32_t		Frames;
+	uint8_t			Frame[GPS_MAVLINK_MAX_FRAME];
+
+}GPS_Mavlink_t;
+
+extern GPS_Mavlink_t GPS_Mavlink;
+//##################################################################################################################
+void			GPS_Mavlink_Init(uint8_t System,uint8_t Component);
+//	each returns the frame length written to Buffer (GPS_MAVLINK_MAX_FRAME bytes are enough)
+uint16_t	GPS_Mavlink_GpsRawInt(uint8_t *Buffer,const GPS_Epoch_t *Epoch,uint64_t TimeUsec);
+uint16_t	GPS_Mavlink_Gps2Raw(uint8_t *Buffer,const GPS_Epoch_t *Epoch,uint64_t TimeUsec);
+uint16_t	GPS_Mavlink_GpsInput(uint8_t *Buffer,const GPS_Epoch_t *Epoch,uint64_t TimeUsec,uint16_t Week,uint32_t WeekMs);
+void			GPS_Mavlink_Publish(const GPS_Epoch_t *Epoch);
+//##################################################################################################################
+
+#endif
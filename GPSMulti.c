@@ -0,0 +1,97 @@
+#include "GPSConfig.h"
+
+#if (_GPS_MULTI==1)
+
+#include "GPSMulti.h"
+#include <string.h>
+
+#if (_GPS_HOST==1)
+#define	GPS_MULTI_CYCLES()				GPS_Host_Cycles()
+#else
+#define	GPS_MULTI_CYCLES()				(DWT->CYCCNT)
+#endif
+
+GPS_Multi_t GPS_Multi;
+//##################################################################################################################
+void	GPS_Multi_Init(void)
+{
+	memset(&GPS_Multi,0,sizeof(GPS_Multi));
+	#if (_GPS_HOST==0)
+	CoreDebug->DEMCR|=CoreDebug_DEMCR_TRCENA_Msk;
+	DWT->CTRL|=DWT_CTRL_CYCCNTENA_Msk;
+	#endif
+	GPS_Multi.Start=GPS_MULTI_CYCLES();
+}
+//##################################################################################################################
+int8_t	GPS_Multi_Add(UART_HandleTypeDef *Uart)
+{
+	GPS_MultiRx_t	*rx;
+	if(GPS_Multi.Count>=_GPS_MULTI_MAX)
+		return -1;
+	rx=&GPS_Multi.Rx[GPS_Multi.Count];
+	memset(rx,0,sizeof(GPS_MultiRx_t));
+	rx->Uart=Uart;
+	GPS_InitEx(&rx->Gps);
+	#if (_GPS_MULTI_IDLE==1)
+	HAL_UARTEx_ReceiveToIdle_DMA(Uart,rx->Dma,sizeof(rx->Dma));
+	#else
+	HAL_UART_Receive_DMA(Uart,rx->Dma,sizeof(rx->Dma));
+	#endif
+	return (int8_t)GPS_Multi.Count++;
+}
+//##################################################################################################################
+void	GPS_Multi_Service(void)
+{
+	for(uint8_t i=0 ; i<GPS_Multi.Count ; i++)
+	{
+		GPS_MultiRx_t	*rx=&GPS_Multi.Rx[i];
+		uint32_t	start=GPS_MULTI_CYCLES();
+		uint16_t	head=(uint16_t)(sizeof(rx->Dma)-__HAL_DMA_GET_COUNTER(rx->Uart->hdmarx));
+		uint16_t	budget=_GPS_MULTI_BUDGET;
+		if(head==sizeof(rx->Dma))
+			head=0;
+		//	at most two runs when the data wraps around the end of the buffer
+		while((rx->Tail!=head) && (budget>0))
+		{
+			uint16_t	end=(head>rx->Tail) ? head : (uint16_t)sizeof(rx->Dma);
+			uint16_t	len=(uint16_t)(end-rx->Tail);
+			if(len>budget)
+				len=budget;
+			GPS_RxChunk(&rx->Gps,&rx->Dma[rx->Tail],len);
+			rx->Bytes+=len;
+			budget-=len;
+			rx->Tail+=len;
+			if(rx->Tail==sizeof(rx->Dma))
+				rx->Tail=0;
+		}
+		if(rx->Tail!=head)
+			rx->Deferred++;
+		if(GPS_ProcessEx(&rx->Gps))
+			rx->Bursts++;
+		start=GPS_MULTI_CYCLES()-start;
+		rx->Cycles+=start;
+		if(start>rx->Peak)
+			rx->Peak=start;
+	}
+}
+//##################################################################################################################
+uint16_t	GPS_Multi_Load(uint8_t Index)
+{
+	uint32_t	elapsed=GPS_MULTI_CYCLES()-GPS_Multi.Start;
+	if((Index>=GPS_Multi.Count) || (elapsed==0))
+		return 0;
+	return (uint16_t)(((uint64_t)GPS_Multi.Rx[Index].Cycles*1000)/elapsed);
+}
+//##################################################################################################################
+void	GPS_Multi_ResetLoad(void)
+{
+	for(uint8_t i=0 ; i<GPS_Multi.Count ; i++)
+	{
+		GPS_Multi.Rx[i].Cycles=0;
+		GPS_Multi.Rx[i].Peak=0;
+	}
+	GPS_Multi.Start=GPS_MULTI_CYCLES();
+}
+//##################################################################################################################
+
+#endif
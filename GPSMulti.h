@@ -0,0 +1,52 @@
+#ifndef _GPSMULTI_H_
+#define _GPSMULTI_H_
+
+#include <stdint.h>
+#include "GPSConfig.h"
+#include "GPS.h"
+#if (_GPS_HOST==1)
+#include "GPSHost.h"
+#else
+#include "usart.h"
+#endif
+
+//##################################################################################################################
+//	Several receivers on circular DMA, serviced together from one timer tick or UART idle event instead of one
+//	interrupt per byte. Each call moves at most _GPS_MULTI_BUDGET bytes and parses at most one burst per
+//	receiver, and the cycles spent are charged to the receiver.
+//##################################################################################################################
+
+typedef struct
+{
+	GPS_t								Gps;
+	UART_HandleTypeDef	*Uart;
+	uint16_t						Tail;
+	uint32_t						Bytes;
+	uint32_t						Bursts;
+	uint32_t						Deferred;
+	uint32_t						Cycles;
+	uint32_t						Peak;
+	uint8_t							Dma[_GPS_MULTI_DMA];
+
+}GPS_MultiRx_t;
+
+typedef struct
+{
+	uint8_t				Count;
+	uint32_t			Start;
+	GPS_MultiRx_t	Rx[_GPS_MULTI_MAX];
+
+}GPS_Multi_t;
+
+extern GPS_Multi_t GPS_Multi;
+//##################################################################################################################
+void			GPS_Multi_Init(void);
+//	returns the receiver index, or -1 when _GPS_MULTI_MAX are in use
+int8_t		GPS_Multi_Add(UART_HandleTypeDef *Uart);
+void			GPS_Multi_Service(void);
+//	share of the cycles since the last GPS_Multi_ResetLoad(), in permille
+uint16_t	GPS_Multi_Load(uint8_t Index);
+void			GPS_Multi_ResetLoad(void);
+//##################################################################################################################
+
+#endif
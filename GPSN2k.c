@@ -0,0 +1,252 @@
+#if defined(__linux__) && !defined(_GNU_SOURCE)
+#define	_GNU_SOURCE								//	sendmmsg
+#endif
+#include "GPSConfig.h"
+
+#if (_GPS_N2K==1)
+
+#include "GPSN2k.h"
+#include <string.h>
+#include <stddef.h>
+#include <math.h>
+#if (_GPS_HOST==1) && defined(__linux__)
+#include <sys/socket.h>
+#include <sys/uio.h>
+#include <net/if.h>
+#include <linux/can.h>
+#include <linux/can/raw.h>
+#include <unistd.h>
+#endif
+
+#define	GPS_N2K_PGN_POSITION						129025UL
+#define	GPS_N2K_PGN_COG_SOG							129026UL
+#define	GPS_N2K_PGN_GNSS								129029UL
+#define	GPS_N2K_PGN_TIME								126992UL
+#define	GPS_N2K_GNSS_LEN								43
+
+#if (_GPS_HOST==1) && defined(__linux__)
+typedef char	GPS_N2kFrameLayout[((sizeof(GPS_N2kFrame_t)==sizeof(struct can_frame)) && (offsetof(struct can_frame,data)==8)) ? 1 : -1];
+#endif
+
+typedef struct
+{
+	uint32_t		Pgn;
+	uint8_t			Priority;
+	uint16_t		Interval;
+
+}GPS_N2kSchedule_t;
+
+//	transmit intervals and default priorities from the PGN definitions
+static const GPS_N2kSchedule_t	GPS_N2kSchedule[GPS_N2K_PGNS]=
+{
+	{GPS_N2K_PGN_POSITION,	2,	100},
+	{GPS_N2K_PGN_COG_SOG,		2,	250},
+	{GPS_N2K_PGN_GNSS,			3,	1000},
+	{GPS_N2K_PGN_TIME,			3,	1000},
+};
+
+GPS_N2k_t GPS_N2k;
+//##################################################################################################################
+static void	GPS_N2k_Put16(uint8_t *p,uint16_t Value)
+{
+	p[0]=(uint8_t)Value;
+	p[1]=(uint8_t)(Value>>8);
+}
+//##################################################################################################################
+static void	GPS_N2k_Put32(uint8_t *p,uint32_t Value)
+{
+	GPS_N2k_Put16(p,(uint16_t)Value);
+	GPS_N2k_Put16(p+2,(uint16_t)(Value>>16));
+}
+//##################################################################################################################
+static void	GPS_N2k_Put64(uint8_t *p,int64_t Value)
+{
+	GPS_N2k_Put32(p,(uint32_t)(uint64_t)Value);
+	GPS_N2k_Put32(p+4,(uint32_t)((uint64_t)Value>>32));
+}
+//##################################################################################################################
+static GPS_N2kFrame_t	*GPS_N2k_Frame(uint8_t *Count,GPS_N2kPgn_t Pgn)
+{
+	GPS_N2kFrame_t	*f=&GPS_N2k.Batch[(*Count)++];
+	f->Id=GPS_N2K_EXTENDED | ((uint32_t)GPS_N2kSchedule[Pgn].Priority<<26) | (GPS_N2kSchedule[Pgn].Pgn<<8) | _GPS_N2K_ADDRESS;
+	f->Len=8;
+	memset(f->Pad,0,sizeof(f->Pad));
+	memset(f->Data,0xFF,sizeof(f->Data));
+	return f;
+}
+//##################################################################################################################
+static uint8_t	GPS_N2k_System(const char *Mode)
+{
+	//	type of system from the GNS constellation modes, GPS when only GGA was seen
+	uint8_t	gps=(Mode[0]!=0) && (Mode[0]!='N');
+	uint8_t	glo=(Mode[0]!=0) && (Mode[1]!=0) && (Mode[1]!='N');
+	uint8_t	gal=(Mode[0]!=0) && (Mode[1]!=0) && (Mode[2]!=0) && (Mode[2]!='N');
+	if(gps && glo)
+		return 2;
+	if(glo)
+		return 1;
+	if(gal && !gps)
+		return 8;
+	return 0;
+}
+//##################################################################################################################
+static void	GPS_N2k_FastPacket(uint8_t *Count,GPS_N2kPgn_t Pgn,const uint8_t *Data,uint8_t Len)
+{
+	//	first frame: sequence/counter, total length, 6 bytes. Following frames: sequence/counter, 7 bytes.
+	uint8_t	seq=(uint8_t)((GPS_N2k.FastSeq++ & 7)<<5);
+	uint8_t	index=0;
+	for(uint8_t i=0 ; i<Len ; index++)
+	{
+		GPS_N2kFrame_t	*f=GPS_N2k_Frame(Count,Pgn);
+		uint8_t	n=(index==0) ? 6 : 7;
+		if(n>Len-i)
+			n=(uint8_t)(Len-i);
+		f->Data[0]=(uint8_t)(seq | index);
+		if(index==0)
+			f->Data[1]=Len;
+		memcpy(&f->Data[8-((index==0) ? 6 : 7)],&Data[i],n);
+		i+=n;
+	}
+}
+//##################################################################################################################
+static void	GPS_N2k_Encode(uint8_t *Count,GPS_N2kPgn_t Pgn)
+{
+	const GPS_Epoch_t	*e=&GPS_N2k.Epoch;
+	GPS_N2kFrame_t		*f;
+	uint32_t					tod=e->UTC_Time*10;
+	switch(Pgn)
+	{
+		case GPS_N2K_POSITION:
+			f=GPS_N2k_Frame(Count,Pgn);
+			GPS_N2k_Put32(&f->Data[0],(uint32_t)(int32_t)llround(e->Latitude*1e7));
+			GPS_N2k_Put32(&f->Data[4],(uint32_t)(int32_t)llround(e->Longitude*1e7));
+		break;
+		case GPS_N2K_COG_SOG:
+			//	no course or speed in the epoch, sent as not available
+			f=GPS_N2k_Frame(Count,Pgn);
+			f->Data[0]=GPS_N2k.Sid;
+			f->Data[1]=0xFC;
+		break;
+		case GPS_N2K_GNSS:
+		{
+			uint8_t	d[GPS_N2K_GNSS_LEN];
+			d[0]=GPS_N2k.Sid;
+			GPS_N2k_Put16(&d[1],GPS_N2k.Days);
+			GPS_N2k_Put32(&d[3],tod);
+			GPS_N2k_Put64(&d[7],llround(e->Latitude*1e16));
+			GPS_N2k_Put64(&d[15],llround(e->Longitude*1e16));
+			GPS_N2k_Put64(&d[23],llround((e->MSL_Altitude+(double)e->Geoid_Separation)*1e6));
+			d[31]=(uint8_t)(GPS_N2k_System(e->Mode) | ((e->Fix<=8) ? e->Fix : 0)<<4);
+			d[32]=0xFC;
+			d[33]=e->SatellitesUsed;
+			GPS_N2k_Put16(&d[34],(e->HDOP>0.0f) ? (uint16_t)(int16_t)lroundf(e->HDOP*100.0f) : 0x7FFF);
+			GPS_N2k_Put16(&d[36],0x7FFF);
+			GPS_N2k_Put32(&d[38],(uint32_t)(int32_t)lroundf(e->Geoid_Separation*100.0f));
+			d[42]=0;
+			GPS_N2k_FastPacket(Count,Pgn,d,sizeof(d));
+		}
+		break;
+		default:
+			f=GPS_N2k_Frame(Count,Pgn);
+			f->Data[0]=GPS_N2k.Sid;
+			f->Data[1]=0xF0;
+			GPS_N2k_Put16(&f->Data[2],GPS_N2k.Days);
+			GPS_N2k_Put32(&f->Data[4],tod);
+		break;
+	}
+	GPS_N2k.Sent[Pgn]++;
+}
+//##################################################################################################################
+static void	GPS_N2k_Check(void)
+{
+	//	Days is 0xFFFF or a real date once initialized
+	if(GPS_N2k.Days==0)
+		GPS_N2k_Init();
+}
+//##################################################################################################################
+void	GPS_N2k_Init(void)
+{
+	memset(&GPS_N2k,0,sizeof(GPS_N2k));
+	GPS_N2k.Days=0xFFFF;
+	GPS_N2k.Socket=-1;
+}
+//##################################################################################################################
+void	GPS_N2k_SetEpoch(const GPS_Epoch_t *Epoch)
+{
+	//	called by GPS_Process for every epoch, the SID ties the PGNs of one epoch together
+	GPS_N2k_Check();
+	memcpy(&GPS_N2k.Epoch,Epoch,sizeof(GPS_Epoch_t));
+	GPS_N2k.Valid=(Epoch->Fix>0);
+	GPS_N2k.Sid=(GPS_N2k.Sid>=252) ? 0 : GPS_N2k.Sid+1;
+}
+//##################################################################################################################
+void	GPS_N2k_SetDate(uint16_t Days)
+{
+	GPS_N2k.Days=Days;
+}
+//##################################################################################################################
+uint8_t	GPS_N2k_Poll(uint32_t Now)
+{
+	//	returns the number of frames handed to _GPS_N2K_TX
+	uint8_t	count=0;
+	if(GPS_N2k.Valid==0)
+		return 0;
+	for(uint8_t i=0 ; i<GPS_N2K_PGNS ; i++)
+	{
+		if((GPS_N2k.Sent[i]!=0) && (Now-GPS_N2k.Last[i]<GPS_N2kSchedule[i].Interval))
+			continue;
+		GPS_N2k.Last[i]=Now;
+		GPS_N2k_Encode(&count,(GPS_N2kPgn_t)i);
+	}
+	if(count==0)
+		return 0;
+	if(_GPS_N2K_TX(GPS_N2k.Batch,count)!=count)
+		GPS_N2k.Errors++;
+	GPS_N2k.Frames+=count;
+	return count;
+}
+//##################################################################################################################
+#if (_GPS_HOST==1) && defined(__linux__)
+int	GPS_N2k_CanOpen(const char *Interface)
+{
+	struct sockaddr_can	addr;
+	int	s;
+	GPS_N2k_Check();
+	s=socket(PF_CAN,SOCK_RAW,CAN_RAW);
+	if(s<0)
+		return -1;
+	memset(&addr,0,sizeof(addr));
+	addr.can_family=AF_CAN;
+	addr.can_ifindex=(int)if_nametoindex(Interface);
+	if((addr.can_ifindex==0) || (bind(s,(struct sockaddr*)&addr,sizeof(addr))<0))
+	{
+		close(s);
+		return -1;
+	}
+	GPS_N2k.Socket=s;
+	return s;
+}
+//##################################################################################################################
+uint8_t	GPS_N2k_CanSend(const GPS_N2kFrame_t *Frames,uint8_t Count)
+{
+	//	one sendmmsg for the whole batch, the frames are passed in place
+	struct mmsghdr	msg[GPS_N2K_MAX_FRAMES];
+	struct iovec		iov[GPS_N2K_MAX_FRAMES];
+	int	sent;
+	if(GPS_N2k.Socket<0)
+		return 0;
+	memset(msg,0,sizeof(struct mmsghdr)*Count);
+	for(uint8_t i=0 ; i<Count ; i++)
+	{
+		iov[i].iov_base=(void*)&Frames[i];
+		iov[i].iov_len=sizeof(struct can_frame);
+		msg[i].msg_hdr.msg_iov=&iov[i];
+		msg[i].msg_hdr.msg_iovlen=1;
+	}
+	sent=sendmmsg(GPS_N2k.Socket,msg,Count,0);
+	return (sent>0) ? (uint8_t)sent : 0;
+}
+#endif
+//##################################################################################################################
+
+#endif
@@ -0,0 +1,66 @@
+#ifndef _GPSN2K_H_
+#define _GPSN2K_H_
+
+#include <stdint.h>
+#include "GPSConfig.h"
+#include "GPS.h"
+
+//##################################################################################################################
+//	NMEA 2000 output of the epoch solution: 129025 position rapid update, 129026 COG/SOG rapid update, 129029
+//	GNSS position data (fast packet) and 126992 system time. GPS_N2k_Poll() sends every PGN that is due, all
+//	frames of one poll in a single _GPS_N2K_TX call. On Linux the default transport is a SocketCAN socket.
+//##################################################################################################################
+
+#define	GPS_N2K_EXTENDED								0x80000000UL		//	set in Id, same as CAN_EFF_FLAG
+#define	GPS_N2K_MAX_FRAMES							10
+
+//	same layout as struct can_frame, so a batch goes to the socket as is
+typedef struct
+{
+	uint32_t		Id;
+	uint8_t			Len;
+	uint8_t			Pad[3];
+	uint8_t			Data[8];
+
+}GPS_N2kFrame_t;
+
+typedef enum
+{
+	GPS_N2K_POSITION=0,
+	GPS_N2K_COG_SOG,
+	GPS_N2K_GNSS,
+	GPS_N2K_TIME,
+	GPS_N2K_PGNS,
+
+}GPS_N2kPgn_t;
+
+typedef struct
+{
+	uint8_t					Valid;
+	uint8_t					Sid;
+	uint16_t				Days;
+	uint8_t					FastSeq;
+	uint32_t				Last[GPS_N2K_PGNS];
+	uint32_t				Sent[GPS_N2K_PGNS];
+	uint32_t				Frames;
+	uint32_t				Errors;
+	int							Socket;
+	GPS_Epoch_t			Epoch;
+	GPS_N2kFrame_t	Batch[GPS_N2K_MAX_FRAMES];
+
+}GPS_N2k_t;
+
+extern GPS_N2k_t GPS_N2k;
+//##################################################################################################################
+void			GPS_N2k_Init(void);
+void			GPS_N2k_SetEpoch(const GPS_Epoch_t *Epoch);
+//	days since 1970-01-01, GGA/GNS carry no date
+void			GPS_N2k_SetDate(uint16_t Days);
+uint8_t		GPS_N2k_Poll(uint32_t Now);
+#if (_GPS_HOST==1) && defined(__linux__)
+int				GPS_N2k_CanOpen(const char *Interface);
+uint8_t		GPS_N2k_CanSend(const GPS_N2kFrame_t *Frames,uint8_t Count);
+#endif
+//##################################################################################################################
+
+#endif
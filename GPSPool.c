@@ -0,0 +1,310 @@
+#include "GPSConfig.h"
+
+#if (_GPS_POOL==1)
+
+#include "GPSPool.h"
+#include <string.h>
+#if (_GPS_HOST==1)
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <pthread.h>
+#endif
+
+#define	GPS_POOL_EMPTY							0xFFFFUL
+#define	GPS_POOL_WORDS(size)				(((size)+7)/8)
+
+#if (_GPS_POOL_SENTENCES>=GPS_POOL_EMPTY) || (_GPS_POOL_EPOCHS>=GPS_POOL_EMPTY)
+#error "a pool holds at most 65534 blocks"
+#endif
+
+typedef struct
+{
+	uint64_t					*Base;
+	uint32_t					Words;
+	uint16_t					Count;
+	uint16_t					*Next;
+	//	free list head: index in the low half, ABA tag in the high half
+	volatile uint32_t	Head;
+	GPS_PoolStats_t		Stats;
+
+}GPS_Pool_t;
+
+static uint64_t	GPS_PoolSentence[_GPS_POOL_SENTENCES][GPS_POOL_WORDS(_GPS_POOL_SENTENCE_SIZE)];
+static uint64_t	GPS_PoolEpoch[_GPS_POOL_EPOCHS][GPS_POOL_WORDS(sizeof(GPS_Epoch_t))];
+static uint16_t	GPS_PoolSentenceNext[_GPS_POOL_SENTENCES];
+static uint16_t	GPS_PoolEpochNext[_GPS_POOL_EPOCHS];
+
+static GPS_Pool_t	GPS_Pool[GPS_POOL_TYPES]=
+{
+	{&GPS_PoolSentence[0][0],	GPS_POOL_WORDS(_GPS_POOL_SENTENCE_SIZE),	_GPS_POOL_SENTENCES,	GPS_PoolSentenceNext,	GPS_POOL_EMPTY,	{0}},
+	{&GPS_PoolEpoch[0][0],		GPS_POOL_WORDS(sizeof(GPS_Epoch_t)),			_GPS_POOL_EPOCHS,			GPS_PoolEpochNext,		GPS_POOL_EMPTY,	{0}},
+};
+//##################################################################################################################
+void	GPS_Pool_Init(void)
+{
+	for(uint8_t t=0 ; t<GPS_POOL_TYPES ; t++)
+	{
+		GPS_Pool_t	*p=&GPS_Pool[t];
+		for(uint16_t i=0 ; i<p->Count ; i++)
+			p->Next[i]=(uint16_t)((i+1<p->Count) ? (uint32_t)i+1 : GPS_POOL_EMPTY);
+		memset(&p->Stats,0,sizeof(GPS_PoolStats_t));
+		p->Stats.Blocks=p->Count;
+		p->Stats.BlockSize=p->Words*8;
+		__atomic_store_n(&p->Head,(p->Count>0) ? 0 : GPS_POOL_EMPTY,__ATOMIC_RELEASE);
+	}
+}
+//##################################################################################################################
+void	*GPS_Pool_Alloc(GPS_PoolType_t Type)
+{
+	GPS_Pool_t	*p=&GPS_Pool[Type];
+	uint32_t		old=__atomic_load_n(&p->Head,__ATOMIC_ACQUIRE);
+	uint32_t		index,use,peak;
+	do
+	{
+		index=old & 0xFFFF;
+		if(index==GPS_POOL_EMPTY)
+		{
+			__atomic_add_fetch(&p->Stats.Failures,1,__ATOMIC_RELAXED);
+			return NULL;
+		}
+		//	a stale link read here loses the compare-and-swap on the tag
+	}while(!__atomic_compare_exchange_n(&p->Head,&old,(((old>>16)+1)<<16) | __atomic_load_n(&p->Next[index],__ATOMIC_RELAXED),1,__ATOMIC_ACQ_REL,__ATOMIC_ACQUIRE));
+	__atomic_add_fetch(&p->Stats.Allocs,1,__ATOMIC_RELAXED);
+	use=__atomic_add_fetch(&p->Stats.InUse,1,__ATOMIC_RELAXED);
+	peak=__atomic_load_n(&p->Stats.Peak,__ATOMIC_RELAXED);
+	while((use>peak) && !__atomic_compare_exchange_n(&p->Stats.Peak,&peak,use,1,__ATOMIC_RELAXED,__ATOMIC_RELAXED));
+	return &p->Base[index*p->Words];
+}
+//##################################################################################################################
+void	GPS_Pool_Free(GPS_PoolType_t Type,void *Block)
+{
+	GPS_Pool_t	*p=&GPS_Pool[Type];
+	uint32_t		index,old;
+	if(!GPS_Pool_Owns(Type,Block))
+		return;
+	index=(uint32_t)(((uint64_t*)Block-p->Base)/p->Words);
+	old=__atomic_load_n(&p->Head,__ATOMIC_ACQUIRE);
+	do
+	{
+		__atomic_store_n(&p->Next[index],(uint16_t)(old & 0xFFFF),__ATOMIC_RELAXED);
+	}while(!__atomic_compare_exchange_n(&p->Head,&old,(((old>>16)+1)<<16) | index,1,__ATOMIC_ACQ_REL,__ATOMIC_ACQUIRE));
+	__atomic_add_fetch(&p->Stats.Frees,1,__ATOMIC_RELAXED);
+	__atomic_sub_fetch(&p->Stats.InUse,1,__ATOMIC_RELAXED);
+}
+//##################################################################################################################
+uint8_t	GPS_Pool_Owns(GPS_PoolType_t Type,const void *Block)
+{
+	const GPS_Pool_t	*p=&GPS_Pool[Type];
+	uintptr_t	a=(uintptr_t)Block;
+	uintptr_t	base=(uintptr_t)p->Base;
+	if((Block==NULL) || (a<base) || (a>=base+(uintptr_t)p->Count*p->Words*8))
+		return 0;
+	return ((a-base)%(p->Words*8))==0;
+}
+//##################################################################################################################
+uint32_t	GPS_Pool_BlockSize(GPS_PoolType_t Type)
+{
+	return GPS_Pool[Type].Words*8;
+}
+//##################################################################################################################
+void	GPS_Pool_Stats(GPS_PoolType_t Type,GPS_PoolStats_t *Stats)
+{
+	memcpy(Stats,&GPS_Pool[Type].Stats,sizeof(GPS_PoolStats_t));
+}
+#if (_GPS_HOST==1)
+//##################################################################################################################
+#define	GPS_POOL_BENCH_THREADS			8
+#define	GPS_POOL_BENCH_WINDOW				((_GPS_POOL_SENTENCES<_GPS_POOL_EPOCHS) ? _GPS_POOL_SENTENCES : _GPS_POOL_EPOCHS)
+
+typedef struct
+{
+	uint32_t		Rounds;
+	uint32_t		Window;
+	uint32_t		Id;
+	uint32_t		Failures;
+	uint32_t		HeapCalls;
+	uint8_t			Exact;
+
+}GPS_PoolWorker_t;
+
+//	--wrap redirects the program's heap calls here, without it __real_* stay unresolved and the wrappers unused
+extern void	*__real_malloc(size_t Size) __attribute__((weak));
+extern void	*__real_calloc(size_t Count,size_t Size) __attribute__((weak));
+extern void	*__real_realloc(void *Block,size_t Size) __attribute__((weak));
+extern void	__real_free(void *Block) __attribute__((weak));
+void	*__wrap_malloc(size_t Size);
+void	*__wrap_calloc(size_t Count,size_t Size);
+void	*__wrap_realloc(void *Block,size_t Size);
+void	__wrap_free(void *Block);
+
+static __thread uint32_t	GPS_PoolHeapCalls __attribute__((tls_model("initial-exec")));
+//##################################################################################################################
+void	*__wrap_malloc(size_t Size)
+{
+	GPS_PoolHeapCalls++;
+	return __real_malloc(Size);
+}
+//##################################################################################################################
+void	*__wrap_calloc(size_t Count,size_t Size)
+{
+	GPS_PoolHeapCalls++;
+	return __real_calloc(Count,Size);
+}
+//##################################################################################################################
+void	*__wrap_realloc(void *Block,size_t Size)
+{
+	GPS_PoolHeapCalls++;
+	return __real_realloc(Block,Size);
+}
+//##################################################################################################################
+void	__wrap_free(void *Block)
+{
+	GPS_PoolHeapCalls++;
+	__real_free(Block);
+}
+//##################################################################################################################
+uint32_t	GPS_Pool_HeapCalls(void)
+{
+	if((__real_malloc==NULL) || (__real_calloc==NULL) || (__real_realloc==NULL) || (__real_free==NULL))
+		return GPS_POOL_NOT_COUNTED;
+	return GPS_PoolHeapCalls;
+}
+//##################################################################################################################
+static double	GPS_Pool_Now(void)
+{
+	struct timespec	ts;
+	clock_gettime(CLOCK_MONOTONIC,&ts);
+	return ts.tv_sec+ts.tv_nsec*1e-9;
+}
+//##################################################################################################################
+static uint8_t	GPS_Pool_Churn(uint32_t Rounds,uint32_t Window,uint32_t Id,uint8_t Heap,uint32_t *Failures)
+{
+	//	a decoder handing sentence/epoch pairs on: each round takes a pair and gives back the one Window rounds
+	//	older. Both ends of a block carry its owner and round, so a block handed out twice shows up on its way back.
+	static const uint32_t	size[2]={_GPS_POOL_SENTENCE_SIZE,sizeof(GPS_Epoch_t)};
+	uint32_t	*held[GPS_POOL_BENCH_WINDOW][2];
+	uint8_t		exact=1;
+	memset(held,0,sizeof(held));
+	for(uint32_t r=0 ; r<Rounds+Window ; r++)
+	{
+		uint32_t	**slot=held[r%Window];
+		for(uint8_t k=0 ; k<2 ; k++)
+		{
+			uint32_t	last=size[k]/sizeof(uint32_t)-1;
+			uint32_t	*b=slot[k];
+			if(b!=NULL)
+			{
+				uint32_t	stamp=(Id<<24) | ((r-Window) & 0xFFFFFF);
+				exact&=(b[0]==stamp) && (b[last]==~stamp);
+				if(Heap!=0)
+					free(b);
+				else
+					GPS_Pool_Free((GPS_PoolType_t)k,b);
+			}
+			b=(r>=Rounds) ? NULL : (Heap!=0) ? (uint32_t*)malloc(size[k]) : (uint32_t*)GPS_Pool_Alloc((GPS_PoolType_t)k);
+			if(b!=NULL)
+			{
+				b[0]=(Id<<24) | (r & 0xFFFFFF);
+				b[last]=~b[0];
+			}
+			else if(r<Rounds)
+				(*Failures)++;
+			slot[k]=b;
+		}
+	}
+	return exact;
+}
+//##################################################################################################################
+static void	*GPS_Pool_Worker(void *Arg)
+{
+	GPS_PoolWorker_t	*w=(GPS_PoolWorker_t*)Arg;
+	uint32_t	heap=GPS_Pool_HeapCalls();
+	w->Exact=GPS_Pool_Churn(w->Rounds,w->Window,w->Id,0,&w->Failures);
+	w->HeapCalls=GPS_Pool_HeapCalls()-heap;
+	return NULL;
+}
+//##################################################################################################################
+uint8_t	GPS_Pool_Bench(uint32_t Rounds,uint8_t Threads,GPS_PoolBench_t *Result)
+{
+	pthread_t					t[GPS_POOL_BENCH_THREADS];
+	GPS_PoolWorker_t	w[GPS_POOL_BENCH_THREADS];
+	GPS_PoolStats_t		stats;
+	uint32_t	failures=0,heap;
+	uint8_t		exact=1,n=0;
+	double		start,ns;
+	memset(Result,0,sizeof(GPS_PoolBench_t));
+	memset(w,0,sizeof(w));
+	if((Rounds==0) || (GPS_POOL_BENCH_WINDOW==0))
+		return 0;
+	if(Threads>GPS_POOL_BENCH_THREADS)
+		Threads=GPS_POOL_BENCH_THREADS;
+	Result->Rounds=Rounds;
+	Result->Window=GPS_POOL_BENCH_WINDOW;
+	Result->HeapCounted=(GPS_Pool_HeapCalls()!=GPS_POOL_NOT_COUNTED);
+	GPS_Pool_Init();
+	//	best of 3, each round is two allocs and two frees
+	for(uint8_t run=0 ; run<3 ; run++)
+	{
+		heap=GPS_Pool_HeapCalls();
+		start=GPS_Pool_Now();
+		exact&=GPS_Pool_Churn(Rounds,Result->Window,0,0,&failures);
+		ns=(GPS_Pool_Now()-start)*1e9/(4.0*Rounds);
+		Result->HeapCalls+=GPS_Pool_HeapCalls()-heap;
+		if((run==0) || (ns<Result->PoolNs))
+			Result->PoolNs=ns;
+		start=GPS_Pool_Now();
+		exact&=GPS_Pool_Churn(Rounds,Result->Window,0,1,&failures);
+		ns=(GPS_Pool_Now()-start)*1e9/(4.0*Rounds);
+		if((run==0) || (ns<Result->HeapNs))
+			Result->HeapNs=ns;
+	}
+	//	the window is shared out, so the threads together never need more blocks than one pool holds
+	start=GPS_Pool_Now();
+	for( ; n<Threads ; n++)
+	{
+		w[n].Rounds=Rounds;
+		w[n].Window=(Result->Window/Threads>0) ? Result->Window/Threads : 1;
+		w[n].Id=n+1;
+		if(pthread_create(&t[n],NULL,GPS_Pool_Worker,&w[n])!=0)
+			break;
+	}
+	for(uint8_t i=0 ; i<n ; i++)
+	{
+		pthread_join(t[i],NULL);
+		exact&=w[i].Exact;
+		failures+=w[i].Failures;
+		Result->HeapCalls+=w[i].HeapCalls;
+	}
+	if(n>0)
+		Result->ThreadNs=(GPS_Pool_Now()-start)*1e9/(4.0*Rounds*n);
+	Result->Threads=n;
+	for(uint8_t k=0 ; k<GPS_POOL_TYPES ; k++)
+	{
+		GPS_Pool_Stats((GPS_PoolType_t)k,&stats);
+		Result->Allocs+=stats.Allocs;
+		Result->Failures+=stats.Failures;
+		if(stats.Peak>Result->Peak)
+			Result->Peak=stats.Peak;
+		exact&=(stats.Allocs==stats.Frees) && (stats.InUse==0) && (stats.Peak==Result->Window);
+	}
+	if(Result->HeapCounted==0)
+		Result->HeapCalls=0;
+	Result->Exact=exact && (failures==0) && (Result->Failures==0) && (Result->HeapCalls==0);
+	return Result->Exact;
+}
+//##################################################################################################################
+void	GPS_Pool_Report(const GPS_PoolBench_t *Result)
+{
+	printf("%lu rounds, window %lu, %s\r\n",(unsigned long)Result->Rounds,(unsigned long)Result->Window,(Result->Exact!=0) ? "no block handed out twice" : "MISMATCH");
+	printf("pool %.1f ns, malloc/free %.1f ns per call\r\n",Result->PoolNs,Result->HeapNs);
+	printf("%u threads: %.1f ns per call, %lu pool allocations, %lu failed, peak %lu blocks\r\n",Result->Threads,Result->ThreadNs,(unsigned long)Result->Allocs,(unsigned long)Result->Failures,(unsigned long)Result->Peak);
+	if(Result->HeapCounted!=0)
+		printf("%lu heap calls during the pool runs\r\n",(unsigned long)Result->HeapCalls);
+	else
+		printf("heap calls not counted, link with -Wl,--wrap=malloc,--wrap=calloc,--wrap=realloc,--wrap=free\r\n");
+}
+#endif
+//##################################################################################################################
+
+#endif
@@ -0,0 +1,73 @@
+#ifndef _GPSPOOL_H_
+#define _GPSPOOL_H_
+
+#include <stdint.h>
+#include "GPSConfig.h"
+#include "GPS.h"
+
+//##################################################################################################################
+//	Fixed-block pools, one per object type, sized in GPSConfig.h and placed in static memory. Alloc and Free are
+//	a lock-free pop/push on a tagged free list, so they can be used from interrupts and host threads alike.
+//	Needs compare-and-swap (Cortex-M3 and up, or the host). The pools are for the application's own sentence
+//	buffers and epochs, the decoder keeps its state in GPS_t and does not draw from them.
+//##################################################################################################################
+
+typedef enum
+{
+	GPS_POOL_SENTENCE=0,
+	GPS_POOL_EPOCH,
+	GPS_POOL_TYPES,
+
+}GPS_PoolType_t;
+
+typedef struct
+{
+	uint32_t		Blocks;
+	uint32_t		BlockSize;
+	uint32_t		Allocs;
+	uint32_t		Frees;
+	uint32_t		Failures;
+	uint32_t		InUse;
+	uint32_t		Peak;
+
+}GPS_PoolStats_t;
+
+#if (_GPS_HOST==1)
+typedef struct
+{
+	uint32_t		Rounds;
+	uint32_t		Window;
+	uint8_t			Threads;
+	uint8_t			Exact;
+	uint32_t		Allocs;
+	uint32_t		Failures;
+	uint32_t		Peak;
+	uint8_t			HeapCounted;
+	uint32_t		HeapCalls;
+	double			PoolNs;
+	double			HeapNs;
+	double			ThreadNs;
+
+}GPS_PoolBench_t;
+#endif
+
+//##################################################################################################################
+void			GPS_Pool_Init(void);
+//	NULL when the pool is empty, never falls back to the heap
+void			*GPS_Pool_Alloc(GPS_PoolType_t Type);
+void			GPS_Pool_Free(GPS_PoolType_t Type,void *Block);
+uint8_t		GPS_Pool_Owns(GPS_PoolType_t Type,const void *Block);
+uint32_t	GPS_Pool_BlockSize(GPS_PoolType_t Type);
+void			GPS_Pool_Stats(GPS_PoolType_t Type,GPS_PoolStats_t *Stats);
+#if (_GPS_HOST==1)
+//	re-initialises the pools, run it before anything holds a block
+uint8_t		GPS_Pool_Bench(uint32_t Rounds,uint8_t Threads,GPS_PoolBench_t *Result);
+void			GPS_Pool_Report(const GPS_PoolBench_t *Result);
+//	malloc/calloc/realloc/free calls made by the calling thread, counted only when linked with
+//	-Wl,--wrap=malloc,--wrap=calloc,--wrap=realloc,--wrap=free. GPS_POOL_NOT_COUNTED otherwise.
+#define		GPS_POOL_NOT_COUNTED			0xFFFFFFFFUL
+uint32_t	GPS_Pool_HeapCalls(void);
+#endif
+//##################################################################################################################
+
+#endif
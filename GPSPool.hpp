@@ -0,0 +1,99 @@
+#ifndef _GPSPOOL_HPP_
+#define _GPSPOOL_HPP_
+
+#include <cstddef>
+#include <memory_resource>
+#include <new>
+#include <string>
+#include <vector>
+
+extern "C"
+{
+#include "GPSPool.h"
+}
+
+//##################################################################################################################
+//	std::pmr adapter over one GPSPool type. Requests that fit a block come from the pool, anything else (or an
+//	empty pool) goes to Upstream, which by default refuses with std::bad_alloc rather than touching the heap.
+//##################################################################################################################
+
+class GPS_PoolResource final : public std::pmr::memory_resource
+{
+public:
+	explicit GPS_PoolResource(GPS_PoolType_t Type,std::pmr::memory_resource *Upstream=std::pmr::null_memory_resource()) noexcept
+		: Type(Type), Upstream(Upstream)
+	{
+	}
+
+private:
+	void	*do_allocate(std::size_t Bytes,std::size_t Alignment) override
+	{
+		if((Bytes<=GPS_Pool_BlockSize(Type)) && (Alignment<=alignof(std::max_align_t)) && (Alignment<=8))
+		{
+			void	*p=GPS_Pool_Alloc(Type);
+			if(p!=nullptr)
+				return p;
+		}
+		return Upstream->allocate(Bytes,Alignment);
+	}
+
+	void	do_deallocate(void *Block,std::size_t Bytes,std::size_t Alignment) override
+	{
+		if(GPS_Pool_Owns(Type,Block))
+			GPS_Pool_Free(Type,Block);
+		else
+			Upstream->deallocate(Block,Bytes,Alignment);
+	}
+
+	bool	do_is_equal(const std::pmr::memory_resource &Other) const noexcept override
+	{
+		return this==&Other;
+	}
+
+	GPS_PoolType_t						Type;
+	std::pmr::memory_resource	*Upstream;
+};
+
+#if (_GPS_HOST==1)
+//##################################################################################################################
+//	Host check of the adapter through real containers: a vector and a string that each fill one block must come
+//	from the pool without a heap call, a request one byte larger must reach Upstream (and throw with the default
+//	one), and the pool counters must balance afterwards. Needs two free blocks of Type.
+inline bool	GPS_PoolResource_Check(GPS_PoolType_t Type)
+{
+	GPS_PoolResource	resource(Type);
+	GPS_PoolStats_t		before,after;
+	const std::size_t	size=GPS_Pool_BlockSize(Type);
+	uint32_t	heap;
+	bool			ok=true;
+	GPS_Pool_Stats(Type,&before);
+	heap=GPS_Pool_HeapCalls();
+	try
+	{
+		std::pmr::vector<char>	vector(size,'v',&resource);
+		std::pmr::string				string(size-1,'s',&resource);
+		ok&=(GPS_Pool_Owns(Type,vector.data())!=0) && (GPS_Pool_Owns(Type,string.data())!=0);
+		ok&=(vector.back()=='v') && (string.back()=='s');
+	}
+	catch(const std::bad_alloc &)
+	{
+		ok=false;
+	}
+	if(heap!=GPS_POOL_NOT_COUNTED)
+		ok&=(GPS_Pool_HeapCalls()==heap);
+	try
+	{
+		void	*p=resource.allocate(size+1);
+		resource.deallocate(p,size+1);
+		ok=false;
+	}
+	catch(const std::bad_alloc &)
+	{
+	}
+	GPS_Pool_Stats(Type,&after);
+	ok&=(after.Allocs-before.Allocs==2) && (after.Frees-before.Frees==2) && (after.InUse==before.InUse);
+	return ok;
+}
+#endif
+
+#endif
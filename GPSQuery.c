@@ -0,0 +1,394 @@
+#include "GPSConfig.h"
+
+#if (_GPS_QUERY==1)
+
+#if (_GPS_ARCHIVE==0)
+#error "GPSQuery reads _GPS_ARCHIVE files"
+#endif
+
+#include "GPSQuery.h"
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+#if (_GPS_QUERY_SIMD==1) && defined(__x86_64__) && defined(__GNUC__)
+#define	GPS_QUERY_AVX2
+#include <immintrin.h>
+#endif
+
+#define	GPS_QUERY_DAY									86400000UL
+//	meters per 1e-7 degree of latitude
+#define	GPS_QUERY_METERS							0.011131949
+#define	GPS_QUERY_DEG2RAD							1.7453292519943295e-9
+//	180 degrees, a longer longitude step goes the other way round
+#define	GPS_QUERY_HALF								1800000000.0
+//	decoded rows start here, the row before is the last one of the previous block
+#define	GPS_QUERY_PAD									8
+
+typedef struct
+{
+	uint64_t		Rows;
+	int64_t			Sum;
+	int32_t			Min;
+	int32_t			Max;
+	uint64_t		Duration;
+	double			Distance;
+
+}GPS_QueryAcc_t;
+
+typedef struct
+{
+	int32_t			Column[GPS_ARCHIVE_COLUMNS][GPS_QUERY_PAD+_GPS_ARCHIVE_BLOCK] __attribute__((aligned(32)));
+	int32_t			Select[_GPS_ARCHIVE_BLOCK] __attribute__((aligned(32)));
+	GPS_QueryAcc_t	Acc[_GPS_QUERY_GROUPS];
+	uint32_t		Last;										//	block decoded last, for the step into the next one
+	uint8_t			Avx2;
+
+}GPS_QueryState_t;
+
+static GPS_QueryState_t	GPS_QueryState;
+//##################################################################################################################
+static double	GPS_Query_Now(void)
+{
+	struct timespec	ts;
+	clock_gettime(CLOCK_MONOTONIC,&ts);
+	return ts.tv_sec+ts.tv_nsec*1e-9;
+}
+//##################################################################################################################
+static void	GPS_Query_RangeC(const int32_t *In,uint32_t N,int32_t Lo,int32_t Hi,int32_t *Select)
+{
+	for(uint32_t i=0 ; i<N ; i++)
+		Select[i]&=-(int32_t)((In[i]>=Lo) & (In[i]<=Hi));
+}
+//##################################################################################################################
+static void	GPS_Query_FoldC(const int32_t *In,const int32_t *Select,uint32_t N,GPS_QueryAcc_t *Acc)
+{
+	//	In NULL only counts
+	uint32_t	rows=0;
+	for(uint32_t i=0 ; i<N ; i++)
+		rows-=(uint32_t)Select[i];
+	Acc->Rows+=rows;
+	if(In==NULL)
+		return;
+	for(uint32_t i=0 ; i<N ; i++)
+	{
+		int32_t	x=In[i] & Select[i];
+		Acc->Sum+=x;
+		Acc->Min=(Select[i] && (In[i]<Acc->Min)) ? In[i] : Acc->Min;
+		Acc->Max=(Select[i] && (In[i]>Acc->Max)) ? In[i] : Acc->Max;
+	}
+}
+//##################################################################################################################
+static void	GPS_Query_MotionC(const int32_t *Time,const int32_t *Lat,const int32_t *Lon,const int32_t *Select,uint32_t N,uint32_t Gap,double Kx,GPS_QueryAcc_t *Acc)
+{
+	//	step from row i-1 to row i, counted for a matching row i when it is shorter than Gap
+	const int32_t	*t0=Time-1,*y0=Lat-1,*x0=Lon-1;
+	uint64_t	duration=0;
+	double		distance=0.0;
+	for(uint32_t i=0 ; i<N ; i++)
+	{
+		uint32_t	dt=(uint32_t)Time[i]-(uint32_t)t0[i];
+		double		dy=(double)Lat[i]-(double)y0[i];
+		double		dx=(double)Lon[i]-(double)x0[i];
+		dx=((dx>GPS_QUERY_HALF) ? dx-2.0*GPS_QUERY_HALF : (dx<-GPS_QUERY_HALF) ? dx+2.0*GPS_QUERY_HALF : dx)*Kx;
+		if(Select[i] && (dt-1<Gap))
+		{
+			duration+=dt;
+			distance+=sqrt(dy*dy+dx*dx);
+		}
+	}
+	Acc->Duration+=duration;
+	Acc->Distance+=distance*GPS_QUERY_METERS;
+}
+#ifdef GPS_QUERY_AVX2
+//##################################################################################################################
+__attribute__((target("avx2")))
+static void	GPS_Query_RangeAvx2(const int32_t *In,uint32_t N,int32_t Lo,int32_t Hi,int32_t *Select)
+{
+	const __m256i	lo=_mm256_set1_epi32(Lo);
+	const __m256i	hi=_mm256_set1_epi32(Hi);
+	uint32_t			i=0;
+	for( ; i+8<=N ; i+=8)
+	{
+		__m256i	x=_mm256_loadu_si256((const __m256i*)&In[i]);
+		__m256i	out=_mm256_or_si256(_mm256_cmpgt_epi32(lo,x),_mm256_cmpgt_epi32(x,hi));
+		_mm256_storeu_si256((__m256i*)&Select[i],_mm256_andnot_si256(out,_mm256_loadu_si256((const __m256i*)&Select[i])));
+	}
+	GPS_Query_RangeC(&In[i],N-i,Lo,Hi,&Select[i]);
+}
+//##################################################################################################################
+__attribute__((target("avx2")))
+static void	GPS_Query_FoldAvx2(const int32_t *In,const int32_t *Select,uint32_t N,GPS_QueryAcc_t *Acc)
+{
+	const __m256i	top=_mm256_set1_epi32(INT32_MAX);
+	const __m256i	bottom=_mm256_set1_epi32(INT32_MIN);
+	__m256i				rows=_mm256_setzero_si256();
+	__m256i				sum=_mm256_setzero_si256();
+	__m256i				lo=top,hi=bottom;
+	int64_t				s[4];
+	int32_t				m[8],n[8],r[8];
+	uint32_t			i=0;
+	for( ; i+8<=N ; i+=8)
+	{
+		__m256i	sel=_mm256_loadu_si256((const __m256i*)&Select[i]);
+		rows=_mm256_sub_epi32(rows,sel);
+		if(In!=NULL)
+		{
+			__m256i	x=_mm256_loadu_si256((const __m256i*)&In[i]);
+			__m256i	xs=_mm256_and_si256(x,sel);
+			sum=_mm256_add_epi64(sum,_mm256_cvtepi32_epi64(_mm256_castsi256_si128(xs)));
+			sum=_mm256_add_epi64(sum,_mm256_cvtepi32_epi64(_mm256_extracti128_si256(xs,1)));
+			lo=_mm256_min_epi32(lo,_mm256_blendv_epi8(top,x,sel));
+			hi=_mm256_max_epi32(hi,_mm256_blendv_epi8(bottom,x,sel));
+		}
+	}
+	_mm256_storeu_si256((__m256i*)r,rows);
+	_mm256_storeu_si256((__m256i*)s,sum);
+	_mm256_storeu_si256((__m256i*)m,lo);
+	_mm256_storeu_si256((__m256i*)n,hi);
+	for(uint8_t k=0 ; k<8 ; k++)
+	{
+		Acc->Rows+=(uint32_t)r[k];
+		Acc->Min=(m[k]<Acc->Min) ? m[k] : Acc->Min;
+		Acc->Max=(n[k]>Acc->Max) ? n[k] : Acc->Max;
+	}
+	Acc->Sum+=s[0]+s[1]+s[2]+s[3];
+	GPS_Query_FoldC((In!=NULL) ? &In[i] : NULL,&Select[i],N-i,Acc);
+}
+//##################################################################################################################
+__attribute__((target("avx2")))
+static void	GPS_Query_MotionAvx2(const int32_t *Time,const int32_t *Lat,const int32_t *Lon,const int32_t *Select,uint32_t N,uint32_t Gap,double Kx,GPS_QueryAcc_t *Acc)
+{
+	//	four steps at a time in double. dt-1<Gap unsigned is a signed compare after flipping the sign bits.
+	const __m128i	bias=_mm_set1_epi32(INT32_MIN);
+	const __m128i	gap=_mm_xor_si128(_mm_set1_epi32((int32_t)Gap),bias);
+	const __m128i	one=_mm_set1_epi32(1);
+	const __m256d	kx=_mm256_set1_pd(Kx);
+	const __m256d	half=_mm256_set1_pd(GPS_QUERY_HALF);
+	const __m256d	low=_mm256_set1_pd(-GPS_QUERY_HALF);
+	const __m256d	turn=_mm256_set1_pd(2.0*GPS_QUERY_HALF);
+	const int32_t	*t0=Time-1,*y0=Lat-1,*x0=Lon-1;
+	__m256i				duration=_mm256_setzero_si256();
+	__m256d				distance=_mm256_setzero_pd();
+	int64_t				d[4];
+	double				m[4];
+	uint32_t			i=0;
+	for( ; i+4<=N ; i+=4)
+	{
+		__m128i	dt=_mm_sub_epi32(_mm_loadu_si128((const __m128i*)&Time[i]),_mm_loadu_si128((const __m128i*)&t0[i]));
+		__m128i	ok=_mm_and_si128(_mm_cmpgt_epi32(gap,_mm_xor_si128(_mm_sub_epi32(dt,one),bias)),_mm_loadu_si128((const __m128i*)&Select[i]));
+		__m256d	dy=_mm256_sub_pd(_mm256_cvtepi32_pd(_mm_loadu_si128((const __m128i*)&Lat[i])),_mm256_cvtepi32_pd(_mm_loadu_si128((const __m128i*)&y0[i])));
+		__m256d	dx=_mm256_sub_pd(_mm256_cvtepi32_pd(_mm_loadu_si128((const __m128i*)&Lon[i])),_mm256_cvtepi32_pd(_mm_loadu_si128((const __m128i*)&x0[i])));
+		dx=_mm256_sub_pd(dx,_mm256_and_pd(_mm256_cmp_pd(dx,half,_CMP_GT_OQ),turn));
+		dx=_mm256_mul_pd(_mm256_add_pd(dx,_mm256_and_pd(_mm256_cmp_pd(dx,low,_CMP_LT_OQ),turn)),kx);
+		__m256d	h=_mm256_sqrt_pd(_mm256_add_pd(_mm256_mul_pd(dy,dy),_mm256_mul_pd(dx,dx)));
+		duration=_mm256_add_epi64(duration,_mm256_cvtepu32_epi64(_mm_and_si128(dt,ok)));
+		distance=_mm256_add_pd(distance,_mm256_and_pd(h,_mm256_castsi256_pd(_mm256_cvtepi32_epi64(ok))));
+	}
+	_mm256_storeu_si256((__m256i*)d,duration);
+	_mm256_storeu_pd(m,distance);
+	Acc->Duration+=(uint64_t)(d[0]+d[1]+d[2]+d[3]);
+	Acc->Distance+=(m[0]+m[1]+m[2]+m[3])*GPS_QUERY_METERS;
+	GPS_Query_MotionC(&Time[i],&Lat[i],&Lon[i],&Select[i],N-i,Gap,Kx,Acc);
+}
+#endif
+//##################################################################################################################
+static void	GPS_Query_Range(const int32_t *In,uint32_t N,int32_t Lo,int32_t Hi,int32_t *Select)
+{
+	#ifdef GPS_QUERY_AVX2
+	if(GPS_QueryState.Avx2)
+	{
+		GPS_Query_RangeAvx2(In,N,Lo,Hi,Select);
+		return;
+	}
+	#endif
+	GPS_Query_RangeC(In,N,Lo,Hi,Select);
+}
+//##################################################################################################################
+static void	GPS_Query_Fold(const int32_t *In,const int32_t *Select,uint32_t N,GPS_QueryAcc_t *Acc)
+{
+	#ifdef GPS_QUERY_AVX2
+	if(GPS_QueryState.Avx2)
+	{
+		GPS_Query_FoldAvx2(In,Select,N,Acc);
+		return;
+	}
+	#endif
+	GPS_Query_FoldC(In,Select,N,Acc);
+}
+//##################################################################################################################
+static void	GPS_Query_Motion(const int32_t *Time,const int32_t *Lat,const int32_t *Lon,const int32_t *Select,uint32_t N,uint32_t Gap,double Kx,GPS_QueryAcc_t *Acc)
+{
+	#ifdef GPS_QUERY_AVX2
+	if(GPS_QueryState.Avx2)
+	{
+		GPS_Query_MotionAvx2(Time,Lat,Lon,Select,N,Gap,Kx,Acc);
+		return;
+	}
+	#endif
+	GPS_Query_MotionC(Time,Lat,Lon,Select,N,Gap,Kx,Acc);
+}
+//##################################################################################################################
+static uint8_t	GPS_Query_Block(const GPS_ArchiveReader_t *Reader,const GPS_Query_t *Query,uint32_t Block,uint32_t Gap,uint32_t Groups,GPS_QueryResult_t *Result)
+{
+	GPS_QueryState_t					*q=&GPS_QueryState;
+	const GPS_ArchiveBlock_t	*b=&Reader->Index[Block].Block;
+	uint8_t		motion=(Query->Aggregate>=GPS_QUERY_DURATION);
+	uint8_t		value=(Query->Aggregate!=GPS_QUERY_COUNT) && !motion;
+	uint32_t	need=0,filter=0;
+	uint32_t	rows=b->Rows;
+	//	pushdown: a filter that misses the block range skips it, one that covers it is dropped for this block
+	for(uint8_t f=0 ; f<Query->Filters ; f++)
+	{
+		const GPS_QueryFilter_t	*p=&Query->Filter[f];
+		if((b->Max[p->Column]<p->Min) || (b->Min[p->Column]>p->Max))
+		{
+			Result->Skipped++;
+			return 1;
+		}
+		if((b->Min[p->Column]<p->Min) || (b->Max[p->Column]>p->Max))
+			filter|=1U<<f;
+	}
+	if((filter==0) && (Query->Aggregate!=GPS_QUERY_SUM) && (Query->Aggregate<=GPS_QUERY_MAX) && ((Query->Bucket==0) || ((uint32_t)b->Min[GPS_ARCHIVE_TIME]/Query->Bucket==(uint32_t)b->Max[GPS_ARCHIVE_TIME]/Query->Bucket)))
+	{
+		uint32_t				g=(Query->Bucket==0) ? 0 : (uint32_t)b->Min[GPS_ARCHIVE_TIME]/Query->Bucket;
+		GPS_QueryAcc_t	*a;
+		//	a time past the end of the day (a damaged block) belongs to no group, as in the row path
+		if(g>=Groups)
+		{
+			Result->Skipped++;
+			return 1;
+		}
+		a=&q->Acc[g];
+		a->Rows+=rows;
+		a->Min=(b->Min[Query->Column]<a->Min) ? b->Min[Query->Column] : a->Min;
+		a->Max=(b->Max[Query->Column]>a->Max) ? b->Max[Query->Column] : a->Max;
+		Result->Answered++;
+		Result->Matched+=rows;
+		return 1;
+	}
+	for(uint8_t f=0 ; f<Query->Filters ; f++)
+		if(filter & (1U<<f))
+			need|=1U<<Query->Filter[f].Column;
+	if(value)
+		need|=1U<<Query->Column;
+	if(motion)
+		need|=(1U<<GPS_ARCHIVE_TIME) | (1U<<GPS_ARCHIVE_LATITUDE) | (1U<<GPS_ARCHIVE_LONGITUDE);
+	if(Query->Bucket!=0)
+		need|=1U<<GPS_ARCHIVE_TIME;
+	//	the row before the block is only kept when this block follows the one decoded last
+	uint8_t	follow=(Block>0) && (q->Last==Block-1);
+	for(uint8_t c=0 ; c<GPS_ARCHIVE_COLUMNS ; c++)
+	{
+		int32_t	*col=&q->Column[c][GPS_QUERY_PAD];
+		int32_t	prev=(follow!=0) ? col[Reader->Index[Block-1].Block.Rows-1] : 0;
+		if((need & (1U<<c))==0)
+			continue;
+		if(GPS_Archive_Column(Reader,Block,(GPS_ArchiveColumn_t)c,col)!=rows)
+			return 0;
+		col[-1]=(follow!=0) ? prev : col[0];
+		Result->Columns++;
+	}
+	Result->Decoded++;
+	q->Last=Block;
+	for(uint32_t i=0 ; i<rows ; i++)
+		q->Select[i]=-1;
+	for(uint8_t f=0 ; f<Query->Filters ; f++)
+		if(filter & (1U<<f))
+			GPS_Query_Range(&q->Column[Query->Filter[f].Column][GPS_QUERY_PAD],rows,Query->Filter[f].Min,Query->Filter[f].Max,q->Select);
+	//	rows are in time order, so each bucket is a run of rows
+	const int32_t	*time=&q->Column[GPS_ARCHIVE_TIME][GPS_QUERY_PAD];
+	double				kx=cos(((double)b->Min[GPS_ARCHIVE_LATITUDE]+(double)b->Max[GPS_ARCHIVE_LATITUDE])*0.5*GPS_QUERY_DEG2RAD);
+	for(uint32_t i=0,j ; i<rows ; i=j)
+	{
+		uint32_t				g=0;
+		GPS_QueryAcc_t	*a;
+		j=rows;
+		if(Query->Bucket!=0)
+		{
+			uint32_t	start;
+			g=(uint32_t)time[i]/Query->Bucket;
+			start=g*Query->Bucket;
+			for(j=i+1 ; (j<rows) && ((uint32_t)time[j]-start<Query->Bucket) ; j++);
+			if(g>=Groups)
+				continue;
+		}
+		a=&q->Acc[g];
+		uint64_t	before=a->Rows;
+		GPS_Query_Fold(value ? &q->Column[Query->Column][GPS_QUERY_PAD+i] : NULL,&q->Select[i],j-i,a);
+		Result->Matched+=a->Rows-before;
+		if(motion)
+			GPS_Query_Motion(&time[i],&q->Column[GPS_ARCHIVE_LATITUDE][GPS_QUERY_PAD+i],&q->Column[GPS_ARCHIVE_LONGITUDE][GPS_QUERY_PAD+i],&q->Select[i],j-i,Gap,kx,a);
+	}
+	return 1;
+}
+//##################################################################################################################
+uint8_t	GPS_Query_Run(const GPS_ArchiveReader_t *Reader,const GPS_Query_t *Query,GPS_QueryResult_t *Result)
+{
+	GPS_QueryState_t	*q=&GPS_QueryState;
+	double		start=GPS_Query_Now();
+	uint32_t	gap=(Query->Gap!=0) ? Query->Gap : _GPS_QUERY_GAP;
+	uint32_t	groups=(Query->Bucket==0) ? 1 : (uint32_t)((GPS_QUERY_DAY+Query->Bucket-1)/Query->Bucket);
+	memset(Result,0,sizeof(GPS_QueryResult_t));
+	if((Reader->Index==NULL) || (groups>_GPS_QUERY_GROUPS) || (Query->Filters>_GPS_QUERY_FILTERS) || ((uint32_t)Query->Column>=GPS_ARCHIVE_COLUMNS))
+		return 0;
+	for(uint8_t f=0 ; f<Query->Filters ; f++)
+		if((uint32_t)Query->Filter[f].Column>=GPS_ARCHIVE_COLUMNS)
+			return 0;
+	#ifdef GPS_QUERY_AVX2
+	__builtin_cpu_init();
+	q->Avx2=(__builtin_cpu_supports("avx2")!=0);
+	#endif
+	Result->Simd=q->Avx2;
+	q->Last=UINT32_MAX;
+	for(uint32_t g=0 ; g<groups ; g++)
+	{
+		memset(&q->Acc[g],0,sizeof(GPS_QueryAcc_t));
+		q->Acc[g].Min=INT32_MAX;
+		q->Acc[g].Max=INT32_MIN;
+	}
+	Result->Blocks=Reader->Footer.Blocks;
+	Result->Rows=Reader->Footer.Rows;
+	for(uint32_t i=0 ; i<Reader->Footer.Blocks ; i++)
+		if(GPS_Query_Block(Reader,Query,i,gap,groups,Result)==0)
+			return 0;
+	for(uint32_t g=0 ; g<groups ; g++)
+	{
+		const GPS_QueryAcc_t	*a=&q->Acc[g];
+		GPS_QueryGroup_t			*r=&Result->Group[Result->Groups];
+		if(a->Rows==0)
+			continue;
+		r->Start=g*Query->Bucket;
+		r->Rows=a->Rows;
+		switch(Query->Aggregate)
+		{
+			case GPS_QUERY_COUNT:			r->Value=(double)a->Rows;																	break;
+			case GPS_QUERY_SUM:				r->Value=(double)a->Sum;																	break;
+			case GPS_QUERY_MIN:				r->Value=a->Min;																					break;
+			case GPS_QUERY_MAX:				r->Value=a->Max;																					break;
+			case GPS_QUERY_MEAN:			r->Value=(double)a->Sum/a->Rows;													break;
+			case GPS_QUERY_DURATION:	r->Value=a->Duration*1e-3;																break;
+			case GPS_QUERY_DISTANCE:	r->Value=a->Distance;																			break;
+			case GPS_QUERY_SPEED:			r->Value=(a->Duration>0) ? a->Distance/(a->Duration*1e-3) : 0.0;	break;
+		}
+		Result->Groups++;
+	}
+	Result->Seconds=GPS_Query_Now()-start;
+	return 1;
+}
+//##################################################################################################################
+void	GPS_Query_Report(const GPS_QueryResult_t *Result)
+{
+	printf("%lu of %lu rows matched, %lu blocks: %lu skipped, %lu from headers, %lu decoded (%lu columns), %s, %.3f ms\r\n",
+		(unsigned long)Result->Matched,(unsigned long)Result->Rows,(unsigned long)Result->Blocks,(unsigned long)Result->Skipped,
+		(unsigned long)Result->Answered,(unsigned long)Result->Decoded,(unsigned long)Result->Columns,(Result->Simd!=0) ? "avx2" : "scalar",Result->Seconds*1e3);
+	for(uint32_t i=0 ; i<Result->Groups ; i++)
+	{
+		const GPS_QueryGroup_t	*g=&Result->Group[i];
+		printf("%02lu:%02lu:%02lu.%03lu %10lu %.3f\r\n",(unsigned long)(g->Start/3600000),(unsigned long)(g->Start/60000%60),
+			(unsigned long)(g->Start/1000%60),(unsigned long)(g->Start%1000),(unsigned long)g->Rows,g->Value);
+	}
+}
+//##################################################################################################################
+
+#endif
@@ -0,0 +1,77 @@
+#ifndef _GPSQUERY_H_
+#define _GPSQUERY_H_
+
+#include <stdint.h>
+#include "GPSConfig.h"
+#include "GPSArchive.h"
+
+//##################################################################################################################
+//	Filter, group by time bucket and aggregate over a fix archive. Filters are inclusive column ranges, all of them
+//	must hold. A block whose min/max misses a filter is skipped without decoding. A filter that the whole block
+//	passes is not decoded. COUNT/MIN/MAX of a block that falls in one bucket come straight from its header. Only the
+//	columns a query reads are decoded, and the kernels run eight rows at a time with AVX2 where the host has it.
+//##################################################################################################################
+
+typedef enum
+{
+	GPS_QUERY_COUNT=0,
+	GPS_QUERY_SUM,
+	GPS_QUERY_MIN,
+	GPS_QUERY_MAX,
+	GPS_QUERY_MEAN,
+	GPS_QUERY_DURATION,								//	s covered by matching fixes, each one counting the step from the previous fix
+	GPS_QUERY_DISTANCE,								//	m over the same steps
+	GPS_QUERY_SPEED,									//	m/s, DISTANCE over DURATION
+
+}GPS_QueryAggregate_t;
+
+typedef struct
+{
+	GPS_ArchiveColumn_t	Column;
+	int32_t							Min;
+	int32_t							Max;
+
+}GPS_QueryFilter_t;
+
+typedef struct
+{
+	GPS_QueryFilter_t			Filter[_GPS_QUERY_FILTERS];
+	uint8_t								Filters;
+	GPS_QueryAggregate_t	Aggregate;
+	GPS_ArchiveColumn_t		Column;					//	for SUM, MIN, MAX and MEAN
+	uint32_t							Bucket;					//	ms of day per group, 0 for a single group
+	uint32_t							Gap;						//	longer steps are outages, 0 for _GPS_QUERY_GAP
+
+}GPS_Query_t;
+
+typedef struct
+{
+	uint32_t		Start;									//	ms of day
+	uint64_t		Rows;
+	double			Value;
+
+}GPS_QueryGroup_t;
+
+typedef struct
+{
+	GPS_QueryGroup_t	Group[_GPS_QUERY_GROUPS];
+	uint32_t		Groups;
+	uint32_t		Blocks;
+	uint32_t		Skipped;
+	uint32_t		Answered;
+	uint32_t		Decoded;
+	uint32_t		Columns;
+	uint64_t		Rows;
+	uint64_t		Matched;
+	uint8_t			Simd;
+	double			Seconds;
+
+}GPS_QueryResult_t;
+
+//##################################################################################################################
+//	non-empty groups in time order. Returns 0 on a bad query or a damaged block.
+uint8_t		GPS_Query_Run(const GPS_ArchiveReader_t *Reader,const GPS_Query_t *Query,GPS_QueryResult_t *Result);
+void			GPS_Query_Report(const GPS_QueryResult_t *Result);
+//##################################################################################################################
+
+#endif
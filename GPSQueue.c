@@ -0,0 +1,153 @@
+#include "GPSConfig.h"
+
+#if (_GPS_QUEUE==1)
+
+#include "GPSQueue.h"
+#include <string.h>
+
+#if ((_GPS_QUEUE_DEPTH & (_GPS_QUEUE_DEPTH-1))!=0)
+#error "_GPS_QUEUE_DEPTH must be a power of two"
+#endif
+#if (_GPS_QUEUE_HOT==1) && (_GPS_FIX==0)
+#error "_GPS_QUEUE_HOT needs _GPS_FIX"
+#endif
+
+#define	GPS_QUEUE_LOAD(p)							__atomic_load_n(p,__ATOMIC_ACQUIRE)
+#define	GPS_QUEUE_STORE(p,v)					__atomic_store_n(p,v,__ATOMIC_RELEASE)
+#define	GPS_QUEUE_FENCE()							__atomic_thread_fence(__ATOMIC_SEQ_CST)
+#define	GPS_QUEUE_CAS(p,e,v)					__atomic_compare_exchange_n(p,e,v,0,__ATOMIC_ACQ_REL,__ATOMIC_ACQUIRE)
+
+//	slot version: bit 0 set while the parser writes, bit 1 set once the consumer took the item, +4 per write
+#define	GPS_QUEUE_BUSY								1
+#define	GPS_QUEUE_TAKEN								2
+
+GPS_Queue_t GPS_Queue;
+//##################################################################################################################
+static void	GPS_Queue_Fill(GPS_QueueConsumer_t *Consumer,uint32_t Seq,uint8_t Type,const GPS_QueueItem_t *Item,uint32_t Version)
+{
+	//	slot already marked busy, Version is its value before that
+	GPS_QueueSlot_t	*slot=&Consumer->Slot[Seq & (_GPS_QUEUE_DEPTH-1)];
+	GPS_QUEUE_FENCE();
+	slot->Seq=Seq;
+	slot->Type=Type;
+	memcpy(&Consumer->Item[Seq & (_GPS_QUEUE_DEPTH-1)],Item,sizeof(GPS_QueueItem_t));
+	GPS_QUEUE_STORE(&slot->Version,(Version | (GPS_QUEUE_BUSY | GPS_QUEUE_TAKEN))+1);
+}
+//##################################################################################################################
+static void	GPS_Queue_Write(GPS_QueueConsumer_t *Consumer,uint32_t Seq,uint8_t Type,const GPS_QueueItem_t *Item)
+{
+	GPS_QueueSlot_t	*slot=&Consumer->Slot[Seq & (_GPS_QUEUE_DEPTH-1)];
+	GPS_Queue_Fill(Consumer,Seq,Type,Item,__atomic_fetch_or(&slot->Version,GPS_QUEUE_BUSY,__ATOMIC_ACQ_REL));
+}
+//##################################################################################################################
+static uint8_t	GPS_Queue_Replace(GPS_QueueConsumer_t *Consumer,uint32_t Seq,uint8_t Type,const GPS_QueueItem_t *Item)
+{
+	//	claims an unread slot before rewriting it. Fails when the consumer took the item in the meantime, a
+	//	consumer still copying it sees the version change and reads the slot again.
+	GPS_QueueSlot_t	*slot=&Consumer->Slot[Seq & (_GPS_QUEUE_DEPTH-1)];
+	uint32_t	v=GPS_QUEUE_LOAD(&slot->Version);
+	if((v & (GPS_QUEUE_BUSY | GPS_QUEUE_TAKEN)) || (slot->Seq!=Seq) || (GPS_QUEUE_CAS(&slot->Version,&v,v | GPS_QUEUE_BUSY)==0))
+		return 0;
+	GPS_Queue_Fill(Consumer,Seq,Type,Item,v);
+	return 1;
+}
+//##################################################################################################################
+int8_t	GPS_Queue_Subscribe(GPS_QueuePolicy_t Policy)
+{
+	GPS_QueueConsumer_t	*c;
+	if(GPS_Queue.Count>=_GPS_QUEUE_CONSUMERS)
+		return -1;
+	c=&GPS_Queue.Consumer[GPS_Queue.Count];
+	memset(c,0,sizeof(GPS_QueueConsumer_t));
+	c->Policy=Policy;
+	GPS_QUEUE_STORE(&c->Active,1);
+	return (int8_t)GPS_Queue.Count++;
+}
+//##################################################################################################################
+void	GPS_Queue_Push(const GPS_QueueItem_t *Item,uint8_t Type)
+{
+	for(uint8_t i=0 ; i<GPS_Queue.Count ; i++)
+	{
+		GPS_QueueConsumer_t	*c=&GPS_Queue.Consumer[i];
+		uint32_t	head=c->Head;
+		uint32_t	tail=GPS_QUEUE_LOAD(&c->Tail);
+		if(GPS_QUEUE_LOAD(&c->Active)==0)
+			continue;
+		if(head-tail>=_GPS_QUEUE_DEPTH)
+		{
+			if(c->Policy==GPS_QUEUE_DROP_NEWEST)
+			{
+				c->Dropped++;
+				continue;
+			}
+			if(c->Policy==GPS_QUEUE_KEEP_LATEST)
+			{
+				uint32_t	s=head;
+				while((s!=tail) && (c->Slot[(s-1) & (_GPS_QUEUE_DEPTH-1)].Type!=Type))
+					s--;
+				//	same sequence number, the consumer sees the newer fix in place of the older one
+				if((s!=tail) && (GPS_Queue_Replace(c,s-1,Type,Item)))
+				{
+					c->Coalesced++;
+					continue;
+				}
+			}
+			//	drop oldest: the consumer notices it was lapped and counts the loss. Also taken when the slot to
+			//	coalesce into was popped meanwhile, then there is usually room again.
+		}
+		GPS_Queue_Write(c,head,Type,Item);
+		c->Pushed++;
+		GPS_QUEUE_STORE(&c->Head,head+1);
+	}
+}
+//##################################################################################################################
+uint8_t	GPS_Queue_Pop(uint8_t Consumer,GPS_QueueItem_t *Item)
+{
+	GPS_QueueConsumer_t	*c=&GPS_Queue.Consumer[Consumer];
+	if(Consumer>=GPS_Queue.Count)
+		return 0;
+	for(;;)
+	{
+		uint32_t	head=GPS_QUEUE_LOAD(&c->Head);
+		uint32_t	tail=c->Tail;
+		uint32_t	v,seq;
+		GPS_QueueSlot_t	*slot;
+		if(tail==head)
+			return 0;
+		if(head-tail>_GPS_QUEUE_DEPTH)
+		{
+			c->Lost+=head-tail-_GPS_QUEUE_DEPTH;
+			tail=head-_GPS_QUEUE_DEPTH;
+			GPS_QUEUE_STORE(&c->Tail,tail);
+		}
+		slot=&c->Slot[tail & (_GPS_QUEUE_DEPTH-1)];
+		v=GPS_QUEUE_LOAD(&slot->Version);
+		if(v & GPS_QUEUE_BUSY)
+			continue;
+		seq=slot->Seq;
+		memcpy(Item,&c->Item[tail & (_GPS_QUEUE_DEPTH-1)],sizeof(GPS_QueueItem_t));
+		GPS_QUEUE_FENCE();
+		//	marking the slot taken is what keeps the parser from coalescing into it from now on
+		if((seq!=tail) || (GPS_QUEUE_CAS(&slot->Version,&v,v | GPS_QUEUE_TAKEN)==0))
+			continue;
+		c->Popped++;
+		GPS_QUEUE_STORE(&c->Tail,tail+1);
+		return 1;
+	}
+}
+//##################################################################################################################
+void	GPS_Queue_Stats(uint8_t Consumer,GPS_QueueStats_t *Stats)
+{
+	const GPS_QueueConsumer_t	*c=&GPS_Queue.Consumer[Consumer];
+	memset(Stats,0,sizeof(GPS_QueueStats_t));
+	if(Consumer>=GPS_Queue.Count)
+		return;
+	Stats->Pushed=c->Pushed;
+	Stats->Popped=c->Popped;
+	Stats->Dropped=c->Dropped;
+	Stats->Lost=c->Lost;
+	Stats->Coalesced=c->Coalesced;
+}
+//##################################################################################################################
+
+#endif
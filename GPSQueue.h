@@ -0,0 +1,83 @@
+#ifndef _GPSQUEUE_H_
+#define _GPSQUEUE_H_
+
+#include <stdint.h>
+#include "GPSConfig.h"
+#include "GPS.h"
+
+//##################################################################################################################
+//	Bounded epoch queue between GPS_Process and consumer tasks. Every consumer owns a ring of _GPS_QUEUE_DEPTH
+//	slots written by the parser only, so a stalled consumer never blocks the parser or another consumer. When a
+//	ring is full its policy decides which fix is lost, and every loss is counted.
+//##################################################################################################################
+
+typedef enum
+{
+	GPS_QUEUE_DROP_OLDEST=0,
+	GPS_QUEUE_DROP_NEWEST,
+	GPS_QUEUE_KEEP_LATEST,				//	a new fix replaces the newest unread fix of the same type, else drop oldest
+
+}GPS_QueuePolicy_t;
+
+//	_GPS_QUEUE_HOT carries the 32-byte GPS_Fix_t instead of the whole epoch
+#if (_GPS_QUEUE_HOT==1)
+typedef GPS_Fix_t		GPS_QueueItem_t;
+#else
+typedef GPS_Epoch_t	GPS_QueueItem_t;
+#endif
+
+typedef struct
+{
+	volatile uint32_t	Version;
+	uint32_t					Seq;
+	uint8_t						Type;
+
+}GPS_QueueSlot_t;
+
+typedef struct
+{
+	uint32_t		Pushed;
+	uint32_t		Popped;
+	uint32_t		Dropped;
+	uint32_t		Lost;
+	uint32_t		Coalesced;
+
+}GPS_QueueStats_t;
+
+typedef struct
+{
+	volatile uint8_t	Active;
+	GPS_QueuePolicy_t	Policy;
+	volatile uint32_t	Head;
+	volatile uint32_t	Tail;
+	//	written by the parser
+	uint32_t					Pushed;
+	uint32_t					Dropped;
+	uint32_t					Coalesced;
+	//	written by the consumer
+	uint32_t					Popped;
+	uint32_t					Lost;
+	//	slot headers apart from the items, so the items pack whole cache lines
+	GPS_QueueSlot_t		Slot[_GPS_QUEUE_DEPTH];
+	GPS_QueueItem_t		Item[_GPS_QUEUE_DEPTH];
+
+}GPS_QueueConsumer_t;
+
+typedef struct
+{
+	uint8_t							Count;
+	GPS_QueueConsumer_t	Consumer[_GPS_QUEUE_CONSUMERS];
+
+}GPS_Queue_t;
+
+extern GPS_Queue_t GPS_Queue;
+//##################################################################################################################
+//	returns the consumer index, or -1 when _GPS_QUEUE_CONSUMERS are in use
+int8_t		GPS_Queue_Subscribe(GPS_QueuePolicy_t Policy);
+//	called by GPS_Process with the fix quality as type
+void			GPS_Queue_Push(const GPS_QueueItem_t *Item,uint8_t Type);
+uint8_t		GPS_Queue_Pop(uint8_t Consumer,GPS_QueueItem_t *Item);
+void			GPS_Queue_Stats(uint8_t Consumer,GPS_QueueStats_t *Stats);
+//##################################################################################################################
+
+#endif
@@ -0,0 +1,567 @@
+#include "GPSConfig.h"
+
+#if (_GPS_RINEX==1)
+
+#include "GPSRinex.h"
+#include <string.h>
+#include <math.h>
+
+#define	GPS_RINEX_SYSTEMS						6
+#define	GPS_RINEX_CODES							4
+#define	GPS_RINEX_LINE							(4+GPS_RINEX_CODES*4*16+2)
+#define	GPS_RINEX_PI								3.1415926535898
+
+typedef struct
+{
+	char				Sys;
+	uint8_t			Prn;
+	uint8_t			System;
+	const GPS_RawxMeas_t	*Meas[GPS_RINEX_CODES];
+
+}GPS_RinexSat_t;
+
+static const char				GPS_RinexSys[GPS_RINEX_SYSTEMS+1]="GRECJS";
+static const char				*GPS_RinexCodes[GPS_RINEX_SYSTEMS][GPS_RINEX_CODES]=
+{
+	{"1C","2L","2S",NULL},
+	{"1C","2C",NULL,NULL},
+	{"1C","1B","7I","7Q"},
+	{"2I","7I",NULL,NULL},
+	{"1C","2S","2L",NULL},
+	{"1C",NULL,NULL,NULL},
+};
+static const double			GPS_RinexUra[16]={2.4,3.4,4.85,6.85,9.65,13.65,24.0,48.0,96.0,192.0,384.0,768.0,1536.0,3072.0,6144.0,6144.0};
+static const double			GPS_RinexPow10[23]={1e0,1e1,1e2,1e3,1e4,1e5,1e6,1e7,1e8,1e9,1e10,1e11,1e12,1e13,1e14,1e15,1e16,1e17,1e18,1e19,1e20,1e21,1e22};
+
+GPS_RinexState_t GPS_Rinex;
+//##################################################################################################################
+static uint8_t	GPS_Rinex_Signal(uint8_t GnssId,uint8_t SigId,uint8_t *System,uint8_t *Code)
+{
+	static const int8_t	map[7][8]=
+	{
+		{ 0,-1,-1, 1, 2,-1,-1,-1},		//	GPS: L1C/A, L2CL, L2CM
+		{ 0,-1,-1,-1,-1,-1,-1,-1},		//	SBAS: L1C/A
+		{ 0, 1,-1,-1,-1, 2, 3,-1},		//	Galileo: E1C, E1B, E5bI, E5bQ
+		{ 0, 0, 1, 1,-1,-1,-1,-1},		//	BeiDou: B1I D1/D2, B2I D1/D2
+		{-1,-1,-1,-1,-1,-1,-1,-1},
+		{ 0,-1,-1,-1, 1, 2,-1,-1},		//	QZSS: L1C/A, L2CM, L2CL
+		{ 0,-1, 1,-1,-1,-1,-1,-1},		//	GLONASS: L1OF, L2OF
+	};
+	static const uint8_t	system[7]={0,5,2,3,0,4,1};
+	if((GnssId>6) || (SigId>7) || (map[GnssId][SigId]<0))
+		return 0;
+	*System=system[GnssId];
+	*Code=(uint8_t)map[GnssId][SigId];
+	return 1;
+}
+//##################################################################################################################
+static void	GPS_Rinex_Civil(uint32_t Days,uint16_t *Year,uint8_t *Month,uint8_t *Day)
+{
+	//	days since 1980-01-06 to calendar date
+	uint32_t	z=Days+3657+719468;
+	uint32_t	era=z/146097;
+	uint32_t	doe=z-era*146097;
+	uint32_t	yoe=(doe-doe/1460+doe/36524-doe/146096)/365;
+	uint32_t	doy=doe-(365*yoe+yoe/4-yoe/100);
+	uint32_t	mp=(5*doy+2)/153;
+	*Day=(uint8_t)(doy-(153*mp+2)/5+1);
+	*Month=(uint8_t)(mp<10 ? mp+3 : mp-9);
+	*Year=(uint16_t)(yoe+era*400+(*Month<=2));
+}
+//##################################################################################################################
+static char*	GPS_Rinex_Int(char *p,int64_t v,uint8_t Width,char Pad)
+{
+	char			*q=p+Width;
+	uint8_t		neg=(v<0);
+	uint64_t	u=neg ? (uint64_t)-v : (uint64_t)v;
+	do
+	{
+		*--q=(char)('0'+u%10);
+		u/=10;
+	}while((u!=0) && (q>p));
+	while((Pad=='0') && (q>p+neg))
+		*--q='0';
+	if((neg) && (q>p))
+		*--q='-';
+	while(q>p)
+		*--q=' ';
+	return p+Width;
+}
+//##################################################################################################################
+static char*	GPS_Rinex_Fix(char *p,double x,uint8_t Width,uint8_t Decimals)
+{
+	//	Fw.d from one rounded integer, no printf
+	int64_t		v=llround(x*GPS_RinexPow10[Decimals]);
+	uint8_t		neg=(v<0);
+	uint64_t	u=neg ? (uint64_t)-v : (uint64_t)v;
+	char			*q=p+Width;
+	for(uint8_t i=0 ; i<Decimals ; i++)
+	{
+		*--q=(char)('0'+u%10);
+		u/=10;
+	}
+	*--q='.';
+	do
+	{
+		*--q=(char)('0'+u%10);
+		u/=10;
+	}while((u!=0) && (q>p));
+	if((neg) && (q>p))
+		*--q='-';
+	while(q>p)
+		*--q=' ';
+	return p+Width;
+}
+//##################################################################################################################
+static char*	GPS_Rinex_Exp(char *p,double x)
+{
+	//	D19.12: " d.ddddddddddddD+ee"
+	uint64_t	m=0;
+	int16_t		e=0;
+	double		a=fabs(x);
+	if(a>0.0)
+	{
+		e=(int16_t)floor(log10(a));
+		if(e>12)
+			a/=(e-12<=22) ? GPS_RinexPow10[e-12] : pow(10.0,e-12);
+		else if(12-e<=22)
+			a*=GPS_RinexPow10[12-e];
+		else
+			a*=pow(10.0,12-e);
+		m=(uint64_t)llround(a);
+		if(m>=10000000000000ULL)
+		{
+			m=(m+5)/10;
+			e++;
+		}
+		else if(m<1000000000000ULL)
+		{
+			m*=10;
+			e--;
+		}
+	}
+	p[0]=(x<0.0) ? '-' : ' ';
+	for(int8_t i=14 ; i>=3 ; i--)
+	{
+		p[i]=(char)('0'+m%10);
+		m/=10;
+	}
+	p[2]='.';
+	p[1]=(char)('0'+m%10);
+	p[15]='D';
+	p[16]=(e<0) ? '-' : '+';
+	if(e<0)
+		e=-e;
+	p[17]=(char)('0'+e/10%10);
+	p[18]=(char)('0'+e%10);
+	return p+19;
+}
+//##################################################################################################################
+static char*	GPS_Rinex_Reserve(GPS_RinexFile_t *File,uint32_t Len)
+{
+	//	Open() refuses buffers below GPS_RINEX_MIN_BUFFER, so Len always fits once flushed
+	if(File->Used+Len>File->Size)
+		GPS_Rinex_Flush(File);
+	return &File->Buffer[File->Used];
+}
+//##################################################################################################################
+static void	GPS_Rinex_Commit(GPS_RinexFile_t *File,char *End)
+{
+	//	trailing blanks are optional in RINEX, dropping them keeps files smaller
+	char	*start=&File->Buffer[File->Used];
+	while((End>start) && (End[-1]==' '))
+		End--;
+	*End++='\n';
+	File->Used=(uint32_t)(End-File->Buffer);
+}
+//##################################################################################################################
+static void	GPS_Rinex_Label(GPS_RinexFile_t *File,const char *Text,const char *Label)
+{
+	char		*p=GPS_Rinex_Reserve(File,82);
+	size_t	n=strlen(Text);
+	size_t	l=strlen(Label);
+	memset(p,' ',80);
+	memcpy(p,Text,(n>60) ? 60 : n);
+	memcpy(&p[60],Label,(l>20) ? 20 : l);
+	GPS_Rinex_Commit(File,p+60+l);
+}
+//##################################################################################################################
+uint8_t	GPS_Rinex_Open(GPS_RinexFile_t *File,char *Buffer,uint32_t Size,GPS_RinexWrite_t Write,void *Context,const char *Marker)
+{
+	memset(File,0,sizeof(GPS_RinexFile_t));
+	if((Buffer==NULL) || (Size<GPS_RINEX_MIN_BUFFER) || (Size<GPS_RINEX_LINE))
+		return 0;
+	File->Buffer=Buffer;
+	File->Size=Size;
+	File->Write=Write;
+	File->Context=Context;
+	File->Marker=(Marker!=NULL) ? Marker : "GPS";
+	return 1;
+}
+//##################################################################################################################
+void	GPS_Rinex_Flush(GPS_RinexFile_t *File)
+{
+	if(File->Used==0)
+		return;
+	if(File->Write(File->Context,File->Buffer,File->Used)!=File->Used)
+		File->Errors++;
+	File->Used=0;
+}
+//##################################################################################################################
+static char*	GPS_Rinex_Date(char *p,uint16_t Week,uint32_t Sow,uint8_t Seconds)
+{
+	//	"yyyy mm dd hh mm" and optionally " ss"
+	uint16_t	year;
+	uint8_t		month,day;
+	uint32_t	sod=Sow%86400;
+	uint32_t	f[4];
+	GPS_Rinex_Civil((uint32_t)Week*7+Sow/86400,&year,&month,&day);
+	f[0]=month;
+	f[1]=day;
+	f[2]=sod/3600;
+	f[3]=sod/60%60;
+	p=GPS_Rinex_Int(p,year,4,' ');
+	for(uint8_t i=0 ; i<4+Seconds ; i++)
+	{
+		*p++=' ';
+		p=GPS_Rinex_Int(p,(i<4) ? f[i] : sod%60,2,'0');
+	}
+	return p;
+}
+//##################################################################################################################
+static void	GPS_Rinex_ObsHeader(GPS_RinexFile_t *File,const GPS_RawxHeader_t *Header)
+{
+	char			line[64];
+	int64_t		t=llround(Header->RcvTow*1e7);
+	uint32_t	sow=(uint32_t)(t/10000000);
+	GPS_Rinex_Label(File,"     3.04           OBSERVATION DATA    M: Mixed","RINEX VERSION / TYPE");
+	GPS_Rinex_Label(File,"GPS","PGM / RUN BY / DATE");
+	GPS_Rinex_Label(File,File->Marker,"MARKER NAME");
+	GPS_Rinex_Label(File,"","OBSERVER / AGENCY");
+	GPS_Rinex_Label(File,"                    u-blox","REC # / TYPE / VERS");
+	GPS_Rinex_Label(File,"","ANT # / TYPE");
+	GPS_Rinex_Label(File,"        0.0000        0.0000        0.0000","APPROX POSITION XYZ");
+	GPS_Rinex_Label(File,"        0.0000        0.0000        0.0000","ANTENNA: DELTA H/E/N");
+	for(uint8_t s=0 ; s<GPS_RINEX_SYSTEMS ; s++)
+	{
+		uint8_t	n=0;
+		char		*p;
+		memset(line,' ',60);
+		line[60]=0;
+		line[0]=GPS_RinexSys[s];
+		while((n<GPS_RINEX_CODES) && (GPS_RinexCodes[s][n]!=NULL))
+			n++;
+		GPS_Rinex_Int(&line[3],n*4,3,' ');
+		p=&line[7];
+		for(uint8_t c=0 ; c<n ; c++)
+		{
+			for(uint8_t k=0 ; k<4 ; k++)
+			{
+				if(p>=&line[58])
+				{
+					GPS_Rinex_Label(File,line,"SYS / # / OBS TYPES");
+					memset(line,' ',60);
+					p=&line[7];
+				}
+				p[0]="CLDS"[k];
+				p[1]=GPS_RinexCodes[s][c][0];
+				p[2]=GPS_RinexCodes[s][c][1];
+				p+=4;
+			}
+		}
+		GPS_Rinex_Label(File,line,"SYS / # / OBS TYPES");
+	}
+	GPS_Rinex_Label(File,"DBHZ","SIGNAL STRENGTH UNIT");
+	{
+		uint16_t	year;
+		uint8_t		month,day;
+		uint32_t	sod=sow%86400;
+		uint32_t	f[4];
+		char			*p=line;
+		GPS_Rinex_Civil((uint32_t)Header->Week*7+sow/86400,&year,&month,&day);
+		f[0]=month;
+		f[1]=day;
+		f[2]=sod/3600;
+		f[3]=sod/60%60;
+		memset(line,' ',60);
+		line[60]=0;
+		p=GPS_Rinex_Int(p,year,6,' ');
+		for(uint8_t i=0 ; i<4 ; i++)
+			p=GPS_Rinex_Int(p,f[i],6,' ');
+		p=GPS_Rinex_Fix(p,(double)(sod%60)+(double)(t%10000000)*1e-7,13,7);
+		memcpy(p+5,"GPS",3);
+	}
+	GPS_Rinex_Label(File,line,"TIME OF FIRST OBS");
+	//	mandatory in 3.04, one per phase type: raw receiver phases, no quarter cycle correction applied
+	for(uint8_t s=0 ; s<GPS_RINEX_SYSTEMS ; s++)
+	{
+		for(uint8_t c=0 ; (c<GPS_RINEX_CODES) && (GPS_RinexCodes[s][c]!=NULL) ; c++)
+		{
+			memcpy(line,"x Lxx  0.00000",15);
+			line[0]=GPS_RinexSys[s];
+			line[3]=GPS_RinexCodes[s][c][0];
+			line[4]=GPS_RinexCodes[s][c][1];
+			GPS_Rinex_Label(File,line,"SYS / PHASE SHIFT");
+		}
+	}
+	GPS_Rinex_Label(File,"  0","GLONASS SLOT / FRQ #");
+	GPS_Rinex_Label(File," C1C    0.000 C1P    0.000 C2C    0.000 C2P    0.000","GLONASS COD/PHS/BIS");
+	GPS_Rinex_Label(File,"","END OF HEADER");
+	File->Header=1;
+}
+//##################################################################################################################
+void	GPS_Rinex_ObsEpoch(GPS_RinexFile_t *File,const GPS_RawxHeader_t *Header,const GPS_RawxMeas_t *Meas)
+{
+	static GPS_RinexSat_t	sat[_GPS_RINEX_MAX_SATS];
+	uint8_t		n=0;
+	int64_t		t=llround(Header->RcvTow*1e7);
+	uint32_t	sow=(uint32_t)(t/10000000);
+	char			*p;
+	if(File->Buffer==NULL)
+		return;
+	if(File->Header==0)
+		GPS_Rinex_ObsHeader(File,Header);
+	GPS_Rinex.Week=Header->Week;
+	for(uint8_t i=0 ; i<Header->NumMeas ; i++)
+	{
+		const GPS_RawxMeas_t	*m=&Meas[i];
+		uint8_t		system,code,j;
+		if(GPS_Rinex_Signal(m->GnssId,m->SigId,&system,&code)==0)
+			continue;
+		uint8_t	prn=(m->GnssId==1) ? (uint8_t)(m->SvId-100) : m->SvId;
+		if((prn==0) || (prn>99))
+			continue;
+		for(j=0 ; j<n ; j++)
+			if((sat[j].System==system) && (sat[j].Prn==prn))
+				break;
+		if(j==n)
+		{
+			if(n>=_GPS_RINEX_MAX_SATS)
+				continue;
+			//	keep the table ordered by system then PRN
+			while((j>0) && ((sat[j-1].System>system) || ((sat[j-1].System==system) && (sat[j-1].Prn>prn))))
+			{
+				sat[j]=sat[j-1];
+				j--;
+			}
+			memset(&sat[j],0,sizeof(GPS_RinexSat_t));
+			sat[j].System=system;
+			sat[j].Sys=GPS_RinexSys[system];
+			sat[j].Prn=prn;
+			n++;
+		}
+		sat[j].Meas[code]=m;
+	}
+	p=GPS_Rinex_Reserve(File,40);
+	memset(p,' ',35);
+	p[0]='>';
+	GPS_Rinex_Date(&p[2],Header->Week,sow,0);
+	GPS_Rinex_Fix(&p[18],(double)(sow%60)+(double)(t%10000000)*1e-7,11,7);
+	p[31]='0';
+	GPS_Rinex_Commit(File,GPS_Rinex_Int(&p[32],n,3,' '));
+	for(uint8_t j=0 ; j<n ; j++)
+	{
+		uint8_t	codes=0;
+		while((codes<GPS_RINEX_CODES) && (GPS_RinexCodes[sat[j].System][codes]!=NULL))
+			codes++;
+		p=GPS_Rinex_Reserve(File,GPS_RINEX_LINE);
+		p[0]=sat[j].Sys;
+		GPS_Rinex_Int(&p[1],sat[j].Prn,2,'0');
+		memset(&p[3],' ',codes*4*16);
+		for(uint8_t c=0 ; c<codes ; c++)
+		{
+			const GPS_RawxMeas_t	*m=sat[j].Meas[c];
+			char			*o=&p[3+c*64];
+			uint8_t		ssi,lli=0;
+			uint16_t	*lock;
+			if(m==NULL)
+				continue;
+			//	lock time going backwards is a cycle slip, carrier without resolved half cycle is flagged too
+			lock=&GPS_Rinex.Lock[sat[j].System][m->SvId & 63][c];
+			if(m->Locktime<*lock)
+				lli|=1;
+			if((m->TrkStat & 0x06)==0x02)
+				lli|=2;
+			*lock=m->Locktime;
+			ssi=(uint8_t)(m->Cno/6);
+			ssi=(ssi<1) ? 1 : (ssi>9) ? 9 : ssi;
+			if(m->TrkStat & 0x01)
+			{
+				GPS_Rinex_Fix(o,m->Pseudorange,14,3);
+				o[15]=(char)('0'+ssi);
+			}
+			if(m->TrkStat & 0x02)
+			{
+				GPS_Rinex_Fix(&o[16],m->CarrierPhase,14,3);
+				if(lli)
+					o[30]=(char)('0'+lli);
+				o[31]=(char)('0'+ssi);
+			}
+			GPS_Rinex_Fix(&o[32],m->Doppler,14,3);
+			GPS_Rinex_Fix(&o[48],m->Cno,14,3);
+		}
+		GPS_Rinex_Commit(File,&p[3+codes*64]);
+		File->Records++;
+	}
+	File->Epochs++;
+}
+//##################################################################################################################
+void	GPS_Rinex_NavHeader(GPS_RinexFile_t *File)
+{
+	if(File->Buffer==NULL)
+		return;
+	GPS_Rinex_Label(File,"     3.04           N: GNSS NAV DATA    G: GPS","RINEX VERSION / TYPE");
+	GPS_Rinex_Label(File,"GPS","PGM / RUN BY / DATE");
+	GPS_Rinex_Label(File,"","END OF HEADER");
+	File->Header=1;
+}
+//##################################################################################################################
+void	GPS_Rinex_NavRecord(GPS_RinexFile_t *File,const GPS_Eph_t *Eph)
+{
+	double	fit;
+	double	v[28];
+	char		*p;
+	if(File->Buffer==NULL)
+		return;
+	if(File->Header==0)
+		GPS_Rinex_NavHeader(File);
+	//	fit interval in hours, IS-GPS-200 table 20-XII
+	fit=4.0;
+	if(Eph->Fit)
+	{
+		uint16_t	i=Eph->Iodc;
+		if((i>=240) && (i<=247))
+			fit=8.0;
+		else if(((i>=248) && (i<=255)) || (i==496))
+			fit=14.0;
+		else if((i>=497) && (i<=503))
+			fit=26.0;
+		else if((i>=504) && (i<=510))
+			fit=50.0;
+		else if((i==511) || ((i>=752) && (i<=756)))
+			fit=74.0;
+		else if(i==757)
+			fit=98.0;
+		else
+			fit=6.0;
+	}
+	v[0]=Eph->Af0;			v[1]=Eph->Af1;			v[2]=Eph->Af2;
+	v[3]=Eph->Iode;			v[4]=Eph->Crs;			v[5]=Eph->DeltaN;				v[6]=Eph->M0;
+	v[7]=Eph->Cuc;			v[8]=Eph->E;				v[9]=Eph->Cus;					v[10]=Eph->SqrtA;
+	v[11]=Eph->Toe;			v[12]=Eph->Cic;			v[13]=Eph->Omega0;			v[14]=Eph->Cis;
+	v[15]=Eph->I0;			v[16]=Eph->Crc;			v[17]=Eph->Omega;				v[18]=Eph->OmegaDot;
+	v[19]=Eph->Idot;		v[20]=Eph->CodeL2;	v[21]=Eph->Week;				v[22]=Eph->L2P;
+	v[23]=GPS_RinexUra[Eph->Ura & 15];	v[24]=Eph->Health;	v[25]=Eph->Tgd;	v[26]=Eph->Iodc;
+	p=GPS_Rinex_Reserve(File,8*81);
+	memset(p,' ',23);
+	p[0]='G';
+	GPS_Rinex_Int(&p[1],Eph->Sv,2,'0');
+	p=GPS_Rinex_Date(&p[4],Eph->Week,Eph->Toc,1);
+	for(uint8_t i=0 ; i<3 ; i++)
+		p=GPS_Rinex_Exp(p,v[i]);
+	GPS_Rinex_Commit(File,p);
+	for(uint8_t l=0 ; l<7 ; l++)
+	{
+		uint8_t	n=(l==6) ? 2 : 4;
+		p=&File->Buffer[File->Used];
+		memset(p,' ',4);
+		p+=4;
+		for(uint8_t i=0 ; i<n ; i++)
+		{
+			double	x=(l==6) ? ((i==0) ? (double)Eph->Tow : fit) : v[3+l*4+i];
+			p=GPS_Rinex_Exp(p,x);
+		}
+		GPS_Rinex_Commit(File,p);
+	}
+	File->Records++;
+}
+//##################################################################################################################
+static uint32_t	GPS_Rinex_Bits(const uint32_t *Data,uint8_t Word,uint8_t Start,uint8_t Len)
+{
+	//	ICD numbering: word 1..10, bit 1 is the MSB of the 24 data bits
+	return (Data[Word-1]>>(24-(Start+Len-1))) & ((1UL<<Len)-1);
+}
+//##################################################################################################################
+static int32_t	GPS_Rinex_Signed(uint32_t Value,uint8_t Len)
+{
+	return (Len<32) && (Value & (1UL<<(Len-1))) ? (int32_t)(Value-(1UL<<Len)) : (int32_t)Value;
+}
+//##################################################################################################################
+uint8_t	GPS_Rinex_Subframe(const GPS_SfrbxHeader_t *Header,const uint32_t *Words,GPS_Eph_t **Eph)
+{
+	//	GPS L1C/A LNAV, subframes 1 to 3. Returns 1 when a new consistent ephemeris set is complete.
+	uint32_t	d[10];
+	uint8_t		sv=Header->SvId;
+	uint8_t		id;
+	GPS_Eph_t	*e;
+	if((Header->GnssId!=0) || (Header->NumWords<10) || (sv<1) || (sv>32))
+		return 0;
+	for(uint8_t i=0 ; i<10 ; i++)
+		d[i]=(Words[i]>>6) & 0xFFFFFF;
+	if((d[0]>>16)!=0x8B)
+		return 0;
+	id=(uint8_t)GPS_Rinex_Bits(d,2,20,3);
+	e=&GPS_Rinex.Eph[sv-1];
+	switch(id)
+	{
+		case 1:
+		{
+			uint16_t	wn=(uint16_t)GPS_Rinex_Bits(d,3,1,10);
+			uint32_t	tow;
+			uint16_t	ref=GPS_Rinex.Week ? GPS_Rinex.Week : 2048;
+			e->Week=(uint16_t)(wn+((ref-wn+512)/1024)*1024);
+			e->CodeL2=(uint8_t)GPS_Rinex_Bits(d,3,11,2);
+			e->Ura=(uint8_t)GPS_Rinex_Bits(d,3,13,4);
+			e->Health=(uint8_t)GPS_Rinex_Bits(d,3,17,6);
+			e->Iodc=(uint16_t)((GPS_Rinex_Bits(d,3,23,2)<<8) | GPS_Rinex_Bits(d,8,1,8));
+			e->L2P=(uint8_t)GPS_Rinex_Bits(d,4,1,1);
+			e->Tgd=GPS_Rinex_Signed(GPS_Rinex_Bits(d,7,17,8),8)*ldexp(1.0,-31);
+			e->Toc=GPS_Rinex_Bits(d,8,9,16)*16;
+			e->Af2=GPS_Rinex_Signed(GPS_Rinex_Bits(d,9,1,8),8)*ldexp(1.0,-55);
+			e->Af1=GPS_Rinex_Signed(GPS_Rinex_Bits(d,9,9,16),16)*ldexp(1.0,-43);
+			e->Af0=GPS_Rinex_Signed(GPS_Rinex_Bits(d,10,1,22),22)*ldexp(1.0,-31);
+			//	the HOW count is that of the next subframe, a count of 0 means this one began at the end of the week
+			tow=GPS_Rinex_Bits(d,2,1,17);
+			e->Tow=(tow==0) ? 604800-6 : tow*6-6;
+		}
+		break;
+		case 2:
+			e->Iode=(uint8_t)GPS_Rinex_Bits(d,3,1,8);
+			e->Crs=GPS_Rinex_Signed(GPS_Rinex_Bits(d,3,9,16),16)*ldexp(1.0,-5);
+			e->DeltaN=GPS_Rinex_Signed(GPS_Rinex_Bits(d,4,1,16),16)*ldexp(1.0,-43)*GPS_RINEX_PI;
+			e->M0=GPS_Rinex_Signed((GPS_Rinex_Bits(d,4,17,8)<<24) | GPS_Rinex_Bits(d,5,1,24),32)*ldexp(1.0,-31)*GPS_RINEX_PI;
+			e->Cuc=GPS_Rinex_Signed(GPS_Rinex_Bits(d,6,1,16),16)*ldexp(1.0,-29);
+			e->E=((GPS_Rinex_Bits(d,6,17,8)<<24) | GPS_Rinex_Bits(d,7,1,24))*ldexp(1.0,-33);
+			e->Cus=GPS_Rinex_Signed(GPS_Rinex_Bits(d,8,1,16),16)*ldexp(1.0,-29);
+			e->SqrtA=((GPS_Rinex_Bits(d,8,17,8)<<24) | GPS_Rinex_Bits(d,9,1,24))*ldexp(1.0,-19);
+			e->Toe=GPS_Rinex_Bits(d,10,1,16)*16;
+			e->Fit=(uint8_t)GPS_Rinex_Bits(d,10,17,1);
+		break;
+		case 3:
+			e->Cic=GPS_Rinex_Signed(GPS_Rinex_Bits(d,3,1,16),16)*ldexp(1.0,-29);
+			e->Omega0=GPS_Rinex_Signed((GPS_Rinex_Bits(d,3,17,8)<<24) | GPS_Rinex_Bits(d,4,1,24),32)*ldexp(1.0,-31)*GPS_RINEX_PI;
+			e->Cis=GPS_Rinex_Signed(GPS_Rinex_Bits(d,5,1,16),16)*ldexp(1.0,-29);
+			e->I0=GPS_Rinex_Signed((GPS_Rinex_Bits(d,5,17,8)<<24) | GPS_Rinex_Bits(d,6,1,24),32)*ldexp(1.0,-31)*GPS_RINEX_PI;
+			e->Crc=GPS_Rinex_Signed(GPS_Rinex_Bits(d,7,1,16),16)*ldexp(1.0,-5);
+			e->Omega=GPS_Rinex_Signed((GPS_Rinex_Bits(d,7,17,8)<<24) | GPS_Rinex_Bits(d,8,1,24),32)*ldexp(1.0,-31)*GPS_RINEX_PI;
+			e->OmegaDot=GPS_Rinex_Signed(GPS_Rinex_Bits(d,9,1,24),24)*ldexp(1.0,-43)*GPS_RINEX_PI;
+			GPS_Rinex.Iode3[sv-1]=(uint8_t)GPS_Rinex_Bits(d,10,1,8);
+			e->Idot=GPS_Rinex_Signed(GPS_Rinex_Bits(d,10,9,14),14)*ldexp(1.0,-43)*GPS_RINEX_PI;
+		break;
+		default:
+		return 0;
+	}
+	e->Sv=sv;
+	GPS_Rinex.Frames[sv-1]|=(uint8_t)(1<<(id-1));
+	if((GPS_Rinex.Frames[sv-1]!=0x07) || ((e->Iodc & 0xFF)!=e->Iode) || (GPS_Rinex.Iode3[sv-1]!=e->Iode))
+		return 0;
+	if(GPS_Rinex.Last[sv-1]==e->Iode+1)
+		return 0;
+	GPS_Rinex.Last[sv-1]=(int16_t)(e->Iode+1);
+	if(Eph!=NULL)
+		*Eph=e;
+	return 1;
+}
+//##################################################################################################################
+
+#endif
@@ -0,0 +1,91 @@
+#ifndef _GPSRINEX_H_
+#define _GPSRINEX_H_
+
+#include <stdint.h>
+#include "GPSConfig.h"
+#include "GPSUbx.h"
+
+//##################################################################################################################
+//	RINEX 3.04 observation and GPS navigation writer fed by the RXM-RAWX / RXM-SFRBX callbacks of GPSUbx.
+//	Lines are formatted with integer arithmetic straight into the output buffer, which is handed to Write() when
+//	full. The observation header is written with the first epoch.
+//##################################################################################################################
+
+//	smallest buffer GPS_Rinex_Open() accepts, one navigation record is reserved in one piece
+#define	GPS_RINEX_MIN_BUFFER				(8*81)
+
+typedef uint32_t	(*GPS_RinexWrite_t)(void *Context,const char *Data,uint32_t Len);
+
+typedef struct
+{
+	GPS_RinexWrite_t	Write;
+	void				*Context;
+	const char	*Marker;
+	char				*Buffer;
+	uint32_t		Size;
+	uint32_t		Used;
+	uint8_t			Header;
+	uint32_t		Epochs;
+	uint32_t		Records;
+	uint32_t		Errors;
+
+}GPS_RinexFile_t;
+
+typedef struct
+{
+	uint8_t			Sv;
+	uint16_t		Week;
+	uint8_t			CodeL2;
+	uint8_t			L2P;
+	uint8_t			Ura;
+	uint8_t			Health;
+	uint8_t			Fit;
+	uint16_t		Iodc;
+	uint8_t			Iode;
+	uint32_t		Tow;
+	uint32_t		Toc;
+	uint32_t		Toe;
+	double			Tgd;
+	double			Af0;
+	double			Af1;
+	double			Af2;
+	double			Crs;
+	double			Crc;
+	double			Cus;
+	double			Cuc;
+	double			Cis;
+	double			Cic;
+	double			DeltaN;
+	double			M0;
+	double			E;
+	double			SqrtA;
+	double			Omega0;
+	double			I0;
+	double			Omega;
+	double			OmegaDot;
+	double			Idot;
+
+}GPS_Eph_t;
+
+typedef struct
+{
+	GPS_Eph_t		Eph[32];
+	uint8_t			Frames[32];
+	uint8_t			Iode3[32];
+	int16_t			Last[32];
+	uint16_t		Week;
+	uint16_t		Lock[6][64][4];
+
+}GPS_RinexState_t;
+
+extern GPS_RinexState_t GPS_Rinex;
+//##################################################################################################################
+uint8_t		GPS_Rinex_Open(GPS_RinexFile_t *File,char *Buffer,uint32_t Size,GPS_RinexWrite_t Write,void *Context,const char *Marker);
+void			GPS_Rinex_Flush(GPS_RinexFile_t *File);
+void			GPS_Rinex_ObsEpoch(GPS_RinexFile_t *File,const GPS_RawxHeader_t *Header,const GPS_RawxMeas_t *Meas);
+void			GPS_Rinex_NavHeader(GPS_RinexFile_t *File);
+void			GPS_Rinex_NavRecord(GPS_RinexFile_t *File,const GPS_Eph_t *Eph);
+uint8_t		GPS_Rinex_Subframe(const GPS_SfrbxHeader_t *Header,const uint32_t *Words,GPS_Eph_t **Eph);
+//##################################################################################################################
+
+#endif
@@ -0,0 +1,307 @@
+#include "GPSConfig.h"
+
+#if (_GPS_HOST==1) && (_GPS_SIM==1)
+
+#include "GPSSim.h"
+#include "GPSHost.h"
+#include "GPS.h"
+#if (_GPS_ASSIST==1)
+#include "GPSAssist.h"
+#endif
+#include <stdio.h>
+#include <string.h>
+
+//	simulated clock at power up, also the date handed to the assistance loader
+#define	GPS_SIM_YEAR						2020
+#define	GPS_SIM_MONTH						1
+#define	GPS_SIM_DAY							1
+#define	GPS_SIM_HOUR						12
+
+GPS_Sim_t GPS_Sim;
+
+const GPS_SimProfile_t	GPS_SimProfiles[]=
+{
+	{"cold",						GPS_SIM_COLD,		0,																		1000,	9600,		NULL,0,0},
+	{"cold+time+pos",		GPS_SIM_COLD,		GPS_SIM_AID_TIME | GPS_SIM_AID_POS,		1000,	9600,		NULL,0,0},
+	{"cold+ephemeris",	GPS_SIM_COLD,		GPS_SIM_AID_TIME | GPS_SIM_AID_POS | GPS_SIM_AID_EPH,	1000,	9600,	NULL,0,0},
+	{"warm",						GPS_SIM_WARM,		0,																		1000,	9600,		NULL,0,0},
+	{"hot",							GPS_SIM_HOT,		0,																		1000,	9600,		NULL,0,0},
+	{"cold 5Hz",				GPS_SIM_COLD,		0,																		200,	115200,	NULL,0,0},
+};
+const uint8_t	GPS_SimProfileCount=sizeof(GPS_SimProfiles)/sizeof(GPS_SimProfiles[0]);
+//##################################################################################################################
+static float	GPS_Sim_Random(uint32_t *Seed)
+{
+	uint32_t	x=*Seed;
+	x^=x<<13;
+	x^=x>>17;
+	x^=x<<5;
+	*Seed=x;
+	return (float)(x>>8)/16777216.0f;
+}
+//##################################################################################################################
+static uint32_t	GPS_Sim_Model(uint8_t Aiding)
+{
+	//	returns the time of the first 2D fix in ms, from search time plus the ephemeris download when it is missing
+	GPS_SimStart_t	start=GPS_Sim.Profile->Start;
+	uint8_t	eph=(start==GPS_SIM_HOT) || (Aiding & GPS_SIM_AID_EPH);
+	uint8_t	tim=(start>=GPS_SIM_WARM) || (Aiding & GPS_SIM_AID_TIME);
+	uint8_t	pos=(start>=GPS_SIM_WARM) || (Aiding & GPS_SIM_AID_POS);
+	uint8_t	alm=(start>=GPS_SIM_WARM) || (Aiding & GPS_SIM_AID_ALM);
+	float		search,decode;
+	if(eph && tim && pos)
+		search=500.0f+1000.0f*GPS_Sim.Draw[0];
+	else if(alm || (tim && pos))
+		search=2000.0f+4000.0f*GPS_Sim.Draw[0];
+	else if(tim || pos)
+		search=8000.0f+8000.0f*GPS_Sim.Draw[0];
+	else
+		search=15000.0f+15000.0f*GPS_Sim.Draw[0];
+	if(eph)
+		decode=tim ? 0.0f : 6000.0f+6000.0f*GPS_Sim.Draw[1];
+	else
+		decode=18000.0f+12000.0f*GPS_Sim.Draw[1];
+	return (uint32_t)(search+decode);
+}
+//##################################################################################################################
+static void	GPS_Sim_Aid(uint8_t Aiding,uint32_t Len)
+{
+	uint32_t	now=HAL_GetTick()-GPS_Sim.Origin;
+	uint32_t	t;
+	if(GPS_Sim.AidTime<now)
+		GPS_Sim.AidTime=now;
+	GPS_Sim.AidTime+=(uint32_t)((uint64_t)Len*10000/GPS_Sim.Profile->Baudrate);
+	if((Aiding & ~GPS_Sim.Aiding)==0)
+		return;
+	GPS_Sim.Aiding|=Aiding;
+	t=GPS_Sim_Model(GPS_Sim.Aiding);
+	if(t<GPS_Sim.AidTime)
+		t=GPS_Sim.AidTime+(uint32_t)(500.0f*GPS_Sim.Draw[3]);
+	if(t<GPS_Sim.Time2D)
+	{
+		GPS_Sim.Time3D-=GPS_Sim.Time2D-t;
+		GPS_Sim.Time2D=t;
+	}
+}
+//##################################################################################################################
+static uint16_t	GPS_Sim_Sentence(char *Out,uint16_t Size,const char *Body)
+{
+	uint8_t	cs=0;
+	for(const char *p=Body ; *p ; p++)
+		cs^=(uint8_t)*p;
+	return (uint16_t)snprintf(Out,Size,"$%s*%02X\r\n",Body,cs);
+}
+//##################################################################################################################
+static void	GPS_Sim_Emit(uint32_t Now)
+{
+	char			body[96];
+	char			utc[16]="";
+	uint32_t	t=Now-GPS_Sim.Origin;
+	uint8_t		mode=GPS_Sim_Mode(Now);
+	uint32_t	ms=(uint32_t)GPS_SIM_HOUR*3600000+t;
+	uint16_t	n;
+	if((mode>1) || (t>GPS_Sim.Time2D/2) || (GPS_Sim.Profile->Start!=GPS_SIM_COLD) || (GPS_Sim.Aiding & GPS_SIM_AID_TIME))
+		snprintf(utc,sizeof(utc),"%02u%02u%02u.%02u",(unsigned)(ms/3600000%24),(unsigned)(ms/60000%60),(unsigned)(ms/1000%60),(unsigned)(ms%1000/10));
+	if(mode==1)
+		snprintf(body,sizeof(body),"GPGGA,%s,,,,,0,00,99.99,,,,,,",utc);
+	else
+		snprintf(body,sizeof(body),"GPGGA,%s,4807.0380,N,01131.0000,E,1,%02u,%.2f,545.4,M,46.9,M,,",utc,mode==2 ? 3 : 7,mode==2 ? 4.8 : 1.2);
+	n=GPS_Sim_Sentence(GPS_Sim.txBuffer,sizeof(GPS_Sim.txBuffer),body);
+	if(mode==3)
+		snprintf(body,sizeof(body),"GPGSA,A,3,04,05,09,12,17,24,28,,,,,,2.1,1.2,1.7");
+	else if(mode==2)
+		snprintf(body,sizeof(body),"GPGSA,A,2,04,05,09,,,,,,,,,,5.2,4.8,1.9");
+	else
+		snprintf(body,sizeof(body),"GPGSA,A,1,,,,,,,,,,,,,99.99,99.99,99.99");
+	n+=GPS_Sim_Sentence(&GPS_Sim.txBuffer[n],(uint16_t)(sizeof(GPS_Sim.txBuffer)-n),body);
+	GPS_Sim.txLen=n;
+	GPS_Sim.txIndex=0;
+	GPS_Sim.txStart=Now;
+}
+//##################################################################################################################
+void	GPS_Sim_Start(const GPS_SimProfile_t *Profile,uint32_t Seed)
+{
+	memset(&GPS_Sim,0,sizeof(GPS_Sim));
+	GPS_Sim.Profile=Profile;
+	GPS_Sim.Seed=Seed ? Seed : 1;
+	for(uint8_t i=0 ; i<4 ; i++)
+		GPS_Sim.Draw[i]=GPS_Sim_Random(&GPS_Sim.Seed);
+	GPS_Sim.Aiding=Profile->Aiding;
+	GPS_Sim.Origin=HAL_GetTick();
+	GPS_Sim.NextEpoch=GPS_Sim.Origin+Profile->Rate;
+	GPS_Sim.Time2D=GPS_Sim_Model(GPS_Sim.Aiding);
+	GPS_Sim.Time3D=GPS_Sim.Time2D+500+(uint32_t)(2500.0f*GPS_Sim.Draw[2]);
+}
+//##################################################################################################################
+uint8_t	GPS_Sim_Mode(uint32_t Now)
+{
+	uint32_t	t=Now-GPS_Sim.Origin;
+	if(t>=GPS_Sim.Time3D)
+		return 3;
+	if(t>=GPS_Sim.Time2D)
+		return 2;
+	return 1;
+}
+//##################################################################################################################
+void	GPS_Sim_Step(uint32_t Now)
+{
+	uint32_t	baud=GPS_Sim.Profile->Baudrate;
+	if((GPS_Sim.txIndex>=GPS_Sim.txLen) && ((int32_t)(Now-GPS_Sim.NextEpoch)>=0))
+	{
+		GPS_Sim_Emit(Now);
+		GPS_Sim.NextEpoch+=GPS_Sim.Profile->Rate;
+	}
+	while(GPS_Sim.txIndex<GPS_Sim.txLen)
+	{
+		//	10 bits per character on the wire
+		if(GPS_Sim.txStart+(uint32_t)((uint64_t)GPS_Sim.txIndex*10000/baud)>Now)
+			break;
+		GPS_Host_Feed(&_GPS_USART,(const uint8_t*)&GPS_Sim.txBuffer[GPS_Sim.txIndex],1);
+		GPS_Sim.txIndex++;
+	}
+}
+//##################################################################################################################
+static void	GPS_Sim_UbxAck(uint8_t Id)
+{
+	uint8_t	f[16]={0xB5,0x62,0x13,0x60,8,0,1,0,0,Id,0,0,0,0,0,0};
+	uint8_t	a=0,b=0;
+	for(uint8_t i=2 ; i<14 ; i++)
+	{
+		a+=f[i];
+		b+=a;
+	}
+	f[14]=a;
+	f[15]=b;
+	GPS_Host_Feed(&_GPS_USART,f,sizeof(f));
+}
+//##################################################################################################################
+static void	GPS_Sim_MtkAck(uint16_t Seq)
+{
+	uint8_t	f[12]={0x04,0x24,12,0,2,0,(uint8_t)Seq,(uint8_t)(Seq>>8),1,0,0x0D,0x0A};
+	for(uint8_t i=2 ; i<9 ; i++)
+		f[9]^=f[i];
+	GPS_Host_Feed(&_GPS_USART,f,sizeof(f));
+}
+//##################################################################################################################
+void	GPS_Sim_Rx(const uint8_t *Data,uint16_t Len)
+{
+	//	the assistance loader always hands over whole frames
+	uint16_t	i=0;
+	if((Len>=10) && (memcmp(Data,"$PMTK253,1",10)==0))
+	{
+		GPS_Sim.Binary=1;
+		return;
+	}
+	while(i+8<=Len)
+	{
+		const uint8_t	*f=&Data[i];
+		if((f[0]==0xB5) && (f[1]==0x62))
+		{
+			uint16_t	n=(uint16_t)(f[4] | (f[5]<<8))+8;
+			if(f[2]==0x13)
+			{
+				if(f[3]==0x40)
+					GPS_Sim_Aid(GPS_SIM_AID_TIME,n);
+				else if((f[3]==0x20) && (++GPS_Sim.AnoCount>=4))
+					GPS_Sim_Aid(GPS_SIM_AID_EPH,n);
+				else
+					GPS_Sim_Aid(0,n);
+				GPS_Sim_UbxAck(f[3]);
+			}
+			i+=n;
+		}
+		else if((f[0]==0x04) && (f[1]==0x24) && (GPS_Sim.Binary))
+		{
+			uint16_t	n=(uint16_t)(f[2] | (f[3]<<8));
+			uint16_t	cmd=(uint16_t)(f[4] | (f[5]<<8));
+			if(cmd==722)
+			{
+				uint16_t	seq=(uint16_t)(f[6] | (f[7]<<8));
+				GPS_Sim_Aid(seq==0xFFFF ? GPS_SIM_AID_EPH : 0,n);
+				GPS_Sim_MtkAck(seq);
+			}
+			else if(cmd==253)
+				GPS_Sim.Binary=0;
+			i+=(n>0) ? n : 1;
+		}
+		else
+			i++;
+	}
+}
+//##################################################################################################################
+uint8_t	GPS_Sim_Run(const GPS_SimProfile_t *Profile,uint16_t Runs,GPS_SimResult_t *Result)
+{
+	static uint32_t	ttff[_GPS_SIM_RUNS];
+	uint64_t	sum=0,sum3d=0;
+	uint16_t	n=0;
+	if(Runs>_GPS_SIM_RUNS)
+		Runs=_GPS_SIM_RUNS;
+	memset(Result,0,sizeof(GPS_SimResult_t));
+	GPS_Host_VirtualTick(1);
+	GPS_Host_SetTx(GPS_Sim_Rx);
+	for(uint16_t run=0 ; run<Runs ; run++)
+	{
+		uint32_t	now=0;
+		GPS_Host_SetTick(now);
+		GPS_Init();
+		GPS_Sim_Start(Profile,0x9E3779B9u*(run+1));
+		#if (_GPS_ASSIST==1)
+		if(Profile->AssistData!=NULL)
+		{
+			GPS_AssistTime_t	t={GPS_SIM_YEAR,GPS_SIM_MONTH,GPS_SIM_DAY,GPS_SIM_HOUR,0,0};
+			GPS_Assist_Stop();
+			GPS_Assist_StartFlash((GPS_AssistFormat_t)Profile->AssistFormat,Profile->AssistData,Profile->AssistSize,&t);
+		}
+		#endif
+		for( ; now<_GPS_SIM_TIMEOUT ; now++)
+		{
+			GPS_Host_SetTick(now);
+			#if (_GPS_ASSIST==1)
+			GPS_Assist_Process();
+			#endif
+			GPS_Sim_Step(now);
+			GPS_Process();
+			if(GPS.TTFF!=0)
+				break;
+		}
+		if(GPS.TTFF==0)
+		{
+			Result->Failed++;
+			continue;
+		}
+		ttff[n++]=GPS.TTFF;
+		sum+=GPS.TTFF;
+		sum3d+=GPS_Sim.Time3D;
+	}
+	GPS_Host_SetTx(NULL);
+	GPS_Host_VirtualTick(0);
+	Result->Runs=Runs;
+	if(n==0)
+		return 0;
+	for(uint16_t i=1 ; i<n ; i++)
+	{
+		uint32_t	v=ttff[i];
+		uint16_t	j=i;
+		for( ; (j>0) && (ttff[j-1]>v) ; j--)
+			ttff[j]=ttff[j-1];
+		ttff[j]=v;
+	}
+	Result->Min=ttff[0];
+	Result->Max=ttff[n-1];
+	Result->Mean=(uint32_t)(sum/n);
+	Result->P50=ttff[(n-1)*50/100];
+	Result->P90=ttff[(n-1)*90/100];
+	Result->P95=ttff[(n-1)*95/100];
+	Result->Mean3D=(uint32_t)(sum3d/n);
+	return 1;
+}
+//##################################################################################################################
+void	GPS_Sim_Report(const GPS_SimProfile_t *Profile,const GPS_SimResult_t *Result)
+{
+	printf("%-16s runs %4u fail %3u  ttff ms min %6lu p50 %6lu p90 %6lu p95 %6lu max %6lu mean %6lu  3D mean %6lu\r\n",
+		Profile->Name,Result->Runs,Result->Failed,(unsigned long)Result->Min,(unsigned long)Result->P50,(unsigned long)Result->P90,
+		(unsigned long)Result->P95,(unsigned long)Result->Max,(unsigned long)Result->Mean,(unsigned long)Result->Mean3D);
+}
+//##################################################################################################################
+
+#endif
@@ -0,0 +1,84 @@
+#ifndef _GPSSIM_H_
+#define _GPSSIM_H_
+
+#include <stdint.h>
+#include "GPSConfig.h"
+
+//##################################################################################################################
+//	Simulated receiver start-up for host runs. The model emits no-fix GGA/GSA, then 2D, then 3D fixes; acquisition
+//	and ephemeris times depend on the start mode and on the aiding the receiver holds or is uploaded by GPSAssist.
+//##################################################################################################################
+
+#define	GPS_SIM_AID_TIME			0x01
+#define	GPS_SIM_AID_POS				0x02
+#define	GPS_SIM_AID_ALM				0x04
+#define	GPS_SIM_AID_EPH				0x08
+
+typedef enum
+{
+	GPS_SIM_COLD=0,
+	GPS_SIM_WARM,
+	GPS_SIM_HOT,
+
+}GPS_SimStart_t;
+
+typedef struct
+{
+	const char			*Name;
+	GPS_SimStart_t	Start;
+	uint8_t					Aiding;
+	uint16_t				Rate;
+	uint32_t				Baudrate;
+	const uint8_t		*AssistData;
+	uint32_t				AssistSize;
+	uint8_t					AssistFormat;
+
+}GPS_SimProfile_t;
+
+typedef struct
+{
+	const GPS_SimProfile_t	*Profile;
+	uint32_t		Seed;
+	uint8_t			Aiding;
+	uint32_t		AidTime;
+	float				Draw[4];
+	uint32_t		Time2D;
+	uint32_t		Time3D;
+	uint32_t		NextEpoch;
+	uint32_t		Origin;
+	char				txBuffer[192];
+	uint16_t		txLen;
+	uint16_t		txIndex;
+	uint32_t		txStart;
+	uint8_t			Binary;
+	uint16_t		AnoCount;
+
+}GPS_Sim_t;
+
+typedef struct
+{
+	uint16_t		Runs;
+	uint16_t		Failed;
+	uint32_t		Min;
+	uint32_t		Max;
+	uint32_t		Mean;
+	uint32_t		P50;
+	uint32_t		P90;
+	uint32_t		P95;
+	uint32_t		Mean3D;
+
+}GPS_SimResult_t;
+
+extern GPS_Sim_t								GPS_Sim;
+extern const GPS_SimProfile_t		GPS_SimProfiles[];
+extern const uint8_t						GPS_SimProfileCount;
+//##################################################################################################################
+void		GPS_Sim_Start(const GPS_SimProfile_t *Profile,uint32_t Seed);
+void		GPS_Sim_Step(uint32_t Now);
+void		GPS_Sim_Rx(const uint8_t *Data,uint16_t Len);
+uint8_t	GPS_Sim_Mode(uint32_t Now);
+uint8_t	GPS_Sim_Run(const GPS_SimProfile_t *Profile,uint16_t Runs,GPS_SimResult_t *Result);
+void		GPS_Sim_Report(const GPS_SimProfile_t *Profile,const GPS_SimResult_t *Result);
+//##################################################################################################################
+
+#endif
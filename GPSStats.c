@@ -0,0 +1,224 @@
+#include "GPSConfig.h"
+
+#if (_GPS_STATS==1)
+
+#include "GPSStats.h"
+#include <string.h>
+#include <math.h>
+
+#define	GPS_STATS_WGS84_A						6378137.0
+#define	GPS_STATS_WGS84_E2					6.69437999014e-3
+#define	GPS_STATS_DEG2RAD						0.017453292519943295
+
+GPS_Stats_t GPS_Stats;
+//##################################################################################################################
+static void	GPS_Stats_Ecef(double Latitude,double Longitude,double Altitude,double *Ecef)
+{
+	double	sl=sin(Latitude*GPS_STATS_DEG2RAD);
+	double	cl=cos(Latitude*GPS_STATS_DEG2RAD);
+	double	n=GPS_STATS_WGS84_A/sqrt(1.0-GPS_STATS_WGS84_E2*sl*sl);
+	Ecef[0]=(n+Altitude)*cl*cos(Longitude*GPS_STATS_DEG2RAD);
+	Ecef[1]=(n+Altitude)*cl*sin(Longitude*GPS_STATS_DEG2RAD);
+	Ecef[2]=(n*(1.0-GPS_STATS_WGS84_E2)+Altitude)*sl;
+}
+//##################################################################################################################
+static void	GPS_Stats_P2Init(GPS_P2_t *P2,double Quantile)
+{
+	memset(P2,0,sizeof(GPS_P2_t));
+	P2->Quantile=Quantile;
+}
+//##################################################################################################################
+static void	GPS_Stats_P2Add(GPS_P2_t *P2,double x)
+{
+	//	P-square estimator (Jain & Chlamtac), five markers whatever the number of samples
+	double	*q=P2->Height;
+	double	*n=P2->Pos;
+	double	p=P2->Quantile;
+	uint8_t	k;
+	if(P2->Count<5)
+	{
+		uint8_t	i=(uint8_t)P2->Count++;
+		for( ; (i>0) && (q[i-1]>x) ; i--)
+			q[i]=q[i-1];
+		q[i]=x;
+		if(P2->Count==5)
+		{
+			for(i=0 ; i<5 ; i++)
+				n[i]=i+1;
+			P2->Desired[0]=1.0;
+			P2->Desired[1]=1.0+2.0*p;
+			P2->Desired[2]=1.0+4.0*p;
+			P2->Desired[3]=3.0+2.0*p;
+			P2->Desired[4]=5.0;
+		}
+		return;
+	}
+	P2->Count++;
+	if(x<q[0])
+	{
+		q[0]=x;
+		k=0;
+	}
+	else if(x>=q[4])
+	{
+		q[4]=x;
+		k=3;
+	}
+	else
+		for(k=0 ; x>=q[k+1] ; k++);
+	for(uint8_t i=k+1 ; i<5 ; i++)
+		n[i]+=1.0;
+	P2->Desired[1]+=p/2.0;
+	P2->Desired[2]+=p;
+	P2->Desired[3]+=(1.0+p)/2.0;
+	P2->Desired[4]+=1.0;
+	for(uint8_t i=1 ; i<4 ; i++)
+	{
+		double	d=P2->Desired[i]-n[i];
+		if(((d>=1.0) && (n[i+1]-n[i]>1.0)) || ((d<=-1.0) && (n[i-1]-n[i]<-1.0)))
+		{
+			int8_t	s=(d>0) ? 1 : -1;
+			double	h=q[i]+s/(n[i+1]-n[i-1])*((n[i]-n[i-1]+s)*(q[i+1]-q[i])/(n[i+1]-n[i])+(n[i+1]-n[i]-s)*(q[i]-q[i-1])/(n[i]-n[i-1]));
+			if((h<=q[i-1]) || (h>=q[i+1]))
+				h=q[i]+s*(q[i+s]-q[i])/(n[i+s]-n[i]);
+			q[i]=h;
+			n[i]+=s;
+		}
+	}
+}
+//##################################################################################################################
+static double	GPS_Stats_P2Get(const GPS_P2_t *P2)
+{
+	if(P2->Count==0)
+		return 0.0;
+	if(P2->Count<5)
+		return P2->Height[(uint8_t)((P2->Count-1)*P2->Quantile+0.5)];
+	return P2->Height[2];
+}
+//##################################################################################################################
+static void	GPS_Stats_AllanAdd(GPS_Allan_t *Allan,double Value)
+{
+	//	level j keeps the last four sums of 2^j samples. Adjacent averages of 2^(j+1) samples are taken every 2^j
+	//	samples, so each octave is half overlapping and costs O(1) memory.
+	for(uint8_t j=0 ; j<_GPS_STATS_OCTAVES-1 ; j++)
+	{
+		double	*r=Allan->Last[j];
+		r[0]=r[1];
+		r[1]=r[2];
+		r[2]=r[3];
+		r[3]=Value;
+		Allan->Count[j]++;
+		if((j==0) && (Allan->Count[0]>=2))
+		{
+			double	d=r[3]-r[2];
+			Allan->Sum[0]+=d*d;
+			Allan->Terms[0]++;
+		}
+		if(Allan->Count[j]>=4)
+		{
+			double	d=(r[3]+r[2]-r[1]-r[0])/(double)(2UL<<j);
+			Allan->Sum[j+1]+=d*d;
+			Allan->Terms[j+1]++;
+		}
+		if(Allan->Count[j] & 1)
+			break;
+		Value=r[2]+r[3];
+	}
+}
+//##################################################################################################################
+void	GPS_Stats_Reset(void)
+{
+	memset(&GPS_Stats,0,sizeof(GPS_Stats));
+	GPS_Stats_P2Init(&GPS_Stats.Cep50,0.50);
+	GPS_Stats_P2Init(&GPS_Stats.Cep95,0.95);
+}
+//##################################################################################################################
+void	GPS_Stats_SetReference(double Latitude,double Longitude,double Altitude)
+{
+	GPS_Stats_Ecef(Latitude,Longitude,Altitude,GPS_Stats.RefEcef);
+	GPS_Stats.SinLat=sin(Latitude*GPS_STATS_DEG2RAD);
+	GPS_Stats.CosLat=cos(Latitude*GPS_STATS_DEG2RAD);
+	GPS_Stats.SinLon=sin(Longitude*GPS_STATS_DEG2RAD);
+	GPS_Stats.CosLon=cos(Longitude*GPS_STATS_DEG2RAD);
+	GPS_Stats.Reference=1;
+}
+//##################################################################################################################
+void	GPS_Stats_AddPosition(double Latitude,double Longitude,double Altitude)
+{
+	double	ecef[3],d[3],enu[3];
+	//	markers set up on the first fix only, a full reset here would drop PPS samples taken before it
+	if(GPS_Stats.Cep50.Quantile==0.0)
+	{
+		GPS_Stats_P2Init(&GPS_Stats.Cep50,0.50);
+		GPS_Stats_P2Init(&GPS_Stats.Cep95,0.95);
+	}
+	if(GPS_Stats.Reference==0)
+		GPS_Stats_SetReference(Latitude,Longitude,Altitude);
+	GPS_Stats_Ecef(Latitude,Longitude,Altitude,ecef);
+	d[0]=ecef[0]-GPS_Stats.RefEcef[0];
+	d[1]=ecef[1]-GPS_Stats.RefEcef[1];
+	d[2]=ecef[2]-GPS_Stats.RefEcef[2];
+	enu[0]=-GPS_Stats.SinLon*d[0]+GPS_Stats.CosLon*d[1];
+	enu[1]=-GPS_Stats.SinLat*GPS_Stats.CosLon*d[0]-GPS_Stats.SinLat*GPS_Stats.SinLon*d[1]+GPS_Stats.CosLat*d[2];
+	enu[2]=GPS_Stats.CosLat*GPS_Stats.CosLon*d[0]+GPS_Stats.CosLat*GPS_Stats.SinLon*d[1]+GPS_Stats.SinLat*d[2];
+	GPS_Stats.Fixes++;
+	for(uint8_t i=0 ; i<3 ; i++)
+	{
+		GPS_Welford_t	*w=&GPS_Stats.Axis[i];
+		double	delta=enu[i]-w->Mean;
+		w->Mean+=delta/GPS_Stats.Fixes;
+		w->M2+=delta*(enu[i]-w->Mean);
+		GPS_Stats_AllanAdd(&GPS_Stats.Allan[i],enu[i]);
+	}
+	double	r=hypot(enu[0]-GPS_Stats.Axis[0].Mean,enu[1]-GPS_Stats.Axis[1].Mean);
+	GPS_Stats_P2Add(&GPS_Stats.Cep50,r);
+	GPS_Stats_P2Add(&GPS_Stats.Cep95,r);
+}
+//##################################################################################################################
+void	GPS_Stats_AddFix(const GPGGA_t *Fix)
+{
+	if(Fix->PositionFixIndicator==0)
+		return;
+	double	lat=(Fix->NS_Indicator=='S') ? -Fix->LatitudeDecimal : Fix->LatitudeDecimal;
+	double	lon=(Fix->EW_Indicator=='W') ? -Fix->LongitudeDecimal : Fix->LongitudeDecimal;
+	GPS_Stats_AddPosition(lat,lon,Fix->MSL_Altitude+Fix->Geoid_Separation);
+}
+//##################################################################################################################
+void	GPS_Stats_AddPPS(int32_t OffsetNs)
+{
+	//	phase samples one second apart, differenced into fractional frequency
+	if(GPS_Stats.PpsCount++>0)
+		GPS_Stats_AllanAdd(&GPS_Stats.Allan[GPS_STATS_PPS],(double)((int64_t)OffsetNs-GPS_Stats.PpsLast)*1e-9);
+	GPS_Stats.PpsLast=OffsetNs;
+}
+//##################################################################################################################
+void	GPS_Stats_Get(GPS_StatsResult_t *Result)
+{
+	memset(Result,0,sizeof(GPS_StatsResult_t));
+	Result->Fixes=GPS_Stats.Fixes;
+	if(GPS_Stats.Fixes==0)
+		return;
+	for(uint8_t i=0 ; i<3 ; i++)
+	{
+		Result->Mean[i]=GPS_Stats.Axis[i].Mean;
+		if(GPS_Stats.Fixes>1)
+			Result->Std[i]=sqrt(GPS_Stats.Axis[i].M2/(GPS_Stats.Fixes-1));
+	}
+	Result->Cep50=GPS_Stats_P2Get(&GPS_Stats.Cep50);
+	Result->Cep95=GPS_Stats_P2Get(&GPS_Stats.Cep95);
+	Result->Drms2=2.0*sqrt(Result->Std[0]*Result->Std[0]+Result->Std[1]*Result->Std[1]);
+}
+//##################################################################################################################
+uint32_t	GPS_Stats_Adev(GPS_StatsSeries_t Series,uint8_t Octave,double *Deviation)
+{
+	//	tau = 2^Octave samples, returns the number of differences averaged
+	const GPS_Allan_t	*a=&GPS_Stats.Allan[Series];
+	*Deviation=0.0;
+	if((Series>=GPS_STATS_SERIES) || (Octave>=_GPS_STATS_OCTAVES) || (a->Terms[Octave]==0))
+		return 0;
+	*Deviation=sqrt(a->Sum[Octave]/(2.0*a->Terms[Octave]));
+	return a->Terms[Octave];
+}
+//##################################################################################################################
+
+#endif
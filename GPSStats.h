@@ -0,0 +1,90 @@
+#ifndef _GPSSTATS_H_
+#define _GPSSTATS_H_
+
+#include <stdint.h>
+#include "GPSConfig.h"
+#include "GPS.h"
+
+//##################################################################################################################
+//	Online accuracy statistics over the published fixes. Positions are taken in a local east/north/up frame around
+//	the first fix (or GPS_Stats_SetReference). Memory is fixed: Welford moments, P-square quantile markers for CEP
+//	and one octave-spaced Allan cascade per series, all queryable at any time.
+//##################################################################################################################
+
+typedef enum
+{
+	GPS_STATS_EAST=0,
+	GPS_STATS_NORTH,
+	GPS_STATS_UP,
+	GPS_STATS_PPS,
+	GPS_STATS_SERIES,
+
+}GPS_StatsSeries_t;
+
+typedef struct
+{
+	double			Mean;
+	double			M2;
+
+}GPS_Welford_t;
+
+typedef struct
+{
+	double			Quantile;
+	uint32_t		Count;
+	double			Height[5];
+	double			Pos[5];
+	double			Desired[5];
+
+}GPS_P2_t;
+
+typedef struct
+{
+	double			Last[_GPS_STATS_OCTAVES][4];
+	uint32_t		Count[_GPS_STATS_OCTAVES];
+	double			Sum[_GPS_STATS_OCTAVES];
+	uint32_t		Terms[_GPS_STATS_OCTAVES];
+
+}GPS_Allan_t;
+
+typedef struct
+{
+	uint32_t		Fixes;
+	uint8_t			Reference;
+	double			RefEcef[3];
+	double			SinLat;
+	double			CosLat;
+	double			SinLon;
+	double			CosLon;
+	GPS_Welford_t	Axis[3];
+	GPS_P2_t		Cep50;
+	GPS_P2_t		Cep95;
+	GPS_Allan_t	Allan[GPS_STATS_SERIES];
+	uint32_t		PpsCount;
+	int32_t			PpsLast;
+
+}GPS_Stats_t;
+
+typedef struct
+{
+	uint32_t		Fixes;
+	double			Mean[3];
+	double			Std[3];
+	double			Cep50;
+	double			Cep95;
+	double			Drms2;
+
+}GPS_StatsResult_t;
+
+extern GPS_Stats_t GPS_Stats;
+//##################################################################################################################
+void			GPS_Stats_Reset(void);
+void			GPS_Stats_SetReference(double Latitude,double Longitude,double Altitude);
+void			GPS_Stats_AddFix(const GPGGA_t *Fix);
+void			GPS_Stats_AddPosition(double Latitude,double Longitude,double Altitude);
+void			GPS_Stats_AddPPS(int32_t OffsetNs);
+void			GPS_Stats_Get(GPS_StatsResult_t *Result);
+uint32_t	GPS_Stats_Adev(GPS_StatsSeries_t Series,uint8_t Octave,double *Deviation);
+//##################################################################################################################
+
+#endif
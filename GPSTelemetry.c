@@ -0,0 +1,295 @@
+#include "GPSConfig.h"
+
+#if (_GPS_TELEMETRY==1)
+
+#include "GPSTelemetry.h"
+#include <string.h>
+#include <math.h>
+#if (_GPS_HOST==1)
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#endif
+
+#define	GPS_TELEMETRY_ALT_OFFSET				1000.0f
+#define	GPS_TELEMETRY_LAT_SCALE					((double)((1UL<<_GPS_TELEMETRY_LAT_BITS)-1)/180.0)
+#define	GPS_TELEMETRY_LON_SCALE					((double)((1UL<<_GPS_TELEMETRY_LON_BITS)-1)/360.0)
+#define	GPS_TELEMETRY_MASK(n)						((uint32_t)((1ULL<<(n))-1))
+
+#if (_GPS_TELEMETRY_LAT_BITS>31) || (_GPS_TELEMETRY_LON_BITS>31) || (_GPS_TELEMETRY_ALT_BITS>24) || (_GPS_TELEMETRY_DELTA_BITS>16)
+#error "telemetry field widths out of range"
+#endif
+//##################################################################################################################
+static void	GPS_Telemetry_Put(GPS_Telemetry_t *Telemetry,uint32_t Value,uint8_t Bits)
+{
+	//	MSB first, the caller has checked the room
+	uint8_t		*p=&Telemetry->Buffer[Telemetry->Bits>>3];
+	uint8_t		used=(uint8_t)(Telemetry->Bits & 7);
+	uint64_t	v=(uint64_t)(Value & GPS_TELEMETRY_MASK(Bits))<<(40-used-Bits);
+	p[0]=(uint8_t)((p[0] & (0xFF00>>used)) | (uint8_t)(v>>32));
+	for(uint8_t i=1 ; i*8<used+Bits ; i++)
+		p[i]=(uint8_t)(v>>(32-i*8));
+	Telemetry->Bits+=Bits;
+}
+//##################################################################################################################
+static uint32_t	GPS_Telemetry_Get(GPS_Telemetry_t *Telemetry,uint8_t Bits)
+{
+	const uint8_t	*p=&Telemetry->Buffer[Telemetry->Bits>>3];
+	uint8_t		used=(uint8_t)(Telemetry->Bits & 7);
+	uint64_t	v=0;
+	for(uint8_t i=0 ; i*8<used+Bits ; i++)
+		v|=(uint64_t)p[i]<<(32-i*8);
+	Telemetry->Bits+=Bits;
+	return (uint32_t)(v>>(40-used-Bits)) & GPS_TELEMETRY_MASK(Bits);
+}
+//##################################################################################################################
+static void	GPS_Telemetry_Quantize(const GPS_Epoch_t *Epoch,GPS_TelemetryState_t *State)
+{
+	float	alt=(Epoch->MSL_Altitude+GPS_TELEMETRY_ALT_OFFSET)/_GPS_TELEMETRY_ALT_STEP;
+	float	hdop=Epoch->HDOP*2.0f+0.5f;
+	State->Time=(Epoch->UTC_Time/1000)%86400;
+	State->Lat=(uint32_t)((Epoch->Latitude+90.0)*GPS_TELEMETRY_LAT_SCALE+0.5);
+	State->Lon=(uint32_t)((Epoch->Longitude+180.0)*GPS_TELEMETRY_LON_SCALE+0.5) & GPS_TELEMETRY_MASK(_GPS_TELEMETRY_LON_BITS);
+	State->Alt=(alt<=0.0f) ? 0 : (alt>=(float)GPS_TELEMETRY_MASK(_GPS_TELEMETRY_ALT_BITS)) ? GPS_TELEMETRY_MASK(_GPS_TELEMETRY_ALT_BITS) : (uint32_t)(alt+0.5f);
+	State->Quality=((uint32_t)(Epoch->Fix & 15)<<10) | ((uint32_t)((Epoch->SatellitesUsed<31) ? Epoch->SatellitesUsed : 31)<<5) | ((hdop<31.0f) ? (uint32_t)hdop : 31);
+}
+//##################################################################################################################
+static int32_t	GPS_Telemetry_Wrap(uint32_t Now,uint32_t Last,uint8_t Bits)
+{
+	//	difference on a circle of 2^Bits, so the longitude seam and an altitude clamp need no special case
+	uint32_t	d=(Now-Last) & GPS_TELEMETRY_MASK(Bits);
+	return (int32_t)(d<<(32-Bits))>>(32-Bits);
+}
+//##################################################################################################################
+void	GPS_Telemetry_Begin(GPS_Telemetry_t *Telemetry,uint8_t *Buffer,uint32_t Size)
+{
+	Telemetry->Buffer=Buffer;
+	Telemetry->Size=Size;
+	Telemetry->Bits=0;
+	Telemetry->Frames=0;
+	Telemetry->Reference=0;
+}
+//##################################################################################################################
+uint8_t	GPS_Telemetry_Encode(GPS_Telemetry_t *Telemetry,const GPS_Epoch_t *Epoch)
+{
+	GPS_TelemetryState_t	s;
+	GPS_TelemetryState_t	*l=&Telemetry->Last;
+	uint32_t	room=Telemetry->Size*8-Telemetry->Bits;
+	uint32_t	dt,dlat,dlon,dalt,half=1UL<<(_GPS_TELEMETRY_DELTA_BITS-1);
+	uint8_t		key;
+	GPS_Telemetry_Quantize(Epoch,&s);
+	dt=(s.Time+86400-l->Time)%86400;
+	dlat=(uint32_t)(int32_t)(s.Lat-l->Lat)+half;
+	dlon=(uint32_t)GPS_Telemetry_Wrap(s.Lon,l->Lon,_GPS_TELEMETRY_LON_BITS)+half;
+	dalt=(uint32_t)(int32_t)(s.Alt-l->Alt)+half;
+	//	one test for all the reasons a delta cannot be used
+	key=(Telemetry->Reference==0) | (Telemetry->Frames>=_GPS_TELEMETRY_KEYFRAME) | (s.Quality!=l->Quality) | (dt>63) | (((dlat | dlon | dalt)>>_GPS_TELEMETRY_DELTA_BITS)!=0);
+	if(room<(key ? GPS_TELEMETRY_KEY_BITS : GPS_TELEMETRY_DELTA_BITS))
+		return 0;
+	GPS_Telemetry_Put(Telemetry,key,1);
+	if(key)
+	{
+		GPS_Telemetry_Put(Telemetry,s.Time,17);
+		GPS_Telemetry_Put(Telemetry,s.Lat,_GPS_TELEMETRY_LAT_BITS);
+		GPS_Telemetry_Put(Telemetry,s.Lon,_GPS_TELEMETRY_LON_BITS);
+		GPS_Telemetry_Put(Telemetry,s.Alt,_GPS_TELEMETRY_ALT_BITS);
+		GPS_Telemetry_Put(Telemetry,s.Quality,14);
+		Telemetry->Frames=0;
+		Telemetry->Keyframes++;
+		Telemetry->TotalBits+=GPS_TELEMETRY_KEY_BITS;
+	}
+	else
+	{
+		GPS_Telemetry_Put(Telemetry,dt,6);
+		GPS_Telemetry_Put(Telemetry,dlat,_GPS_TELEMETRY_DELTA_BITS);
+		GPS_Telemetry_Put(Telemetry,dlon,_GPS_TELEMETRY_DELTA_BITS);
+		GPS_Telemetry_Put(Telemetry,dalt,_GPS_TELEMETRY_DELTA_BITS);
+		Telemetry->Frames++;
+		Telemetry->TotalBits+=GPS_TELEMETRY_DELTA_BITS;
+	}
+	Telemetry->Reference=1;
+	Telemetry->Fixes++;
+	*l=s;
+	return 1;
+}
+//##################################################################################################################
+uint32_t	GPS_Telemetry_Bytes(const GPS_Telemetry_t *Telemetry)
+{
+	return (Telemetry->Bits+7)>>3;
+}
+//##################################################################################################################
+uint8_t	GPS_Telemetry_Decode(GPS_Telemetry_t *Telemetry,GPS_Epoch_t *Epoch)
+{
+	GPS_TelemetryState_t	*l=&Telemetry->Last;
+	uint32_t	room=Telemetry->Size*8-Telemetry->Bits;
+	uint32_t	half=1UL<<(_GPS_TELEMETRY_DELTA_BITS-1);
+	if(room<GPS_TELEMETRY_DELTA_BITS)
+		return 0;
+	if(GPS_Telemetry_Get(Telemetry,1))
+	{
+		if(room<GPS_TELEMETRY_KEY_BITS)
+			return 0;
+		l->Time=GPS_Telemetry_Get(Telemetry,17);
+		l->Lat=GPS_Telemetry_Get(Telemetry,_GPS_TELEMETRY_LAT_BITS);
+		l->Lon=GPS_Telemetry_Get(Telemetry,_GPS_TELEMETRY_LON_BITS);
+		l->Alt=GPS_Telemetry_Get(Telemetry,_GPS_TELEMETRY_ALT_BITS);
+		l->Quality=GPS_Telemetry_Get(Telemetry,14);
+		Telemetry->Reference=1;
+	}
+	else
+	{
+		//	a zero-padded tail reads as a delta without a keyframe before it
+		if(Telemetry->Reference==0)
+			return 0;
+		l->Time=(l->Time+GPS_Telemetry_Get(Telemetry,6))%86400;
+		l->Lat+=GPS_Telemetry_Get(Telemetry,_GPS_TELEMETRY_DELTA_BITS)-half;
+		l->Lon=(l->Lon+GPS_Telemetry_Get(Telemetry,_GPS_TELEMETRY_DELTA_BITS)-half) & GPS_TELEMETRY_MASK(_GPS_TELEMETRY_LON_BITS);
+		l->Alt+=GPS_Telemetry_Get(Telemetry,_GPS_TELEMETRY_DELTA_BITS)-half;
+	}
+	memset(Epoch,0,sizeof(GPS_Epoch_t));
+	Epoch->UTC_Time=l->Time*1000;
+	Epoch->Latitude=l->Lat/GPS_TELEMETRY_LAT_SCALE-90.0;
+	Epoch->Longitude=l->Lon/GPS_TELEMETRY_LON_SCALE-180.0;
+	if(Epoch->Longitude>=180.0)
+		Epoch->Longitude-=360.0;
+	Epoch->MSL_Altitude=l->Alt*_GPS_TELEMETRY_ALT_STEP-GPS_TELEMETRY_ALT_OFFSET;
+	Epoch->Fix=(uint8_t)(l->Quality>>10);
+	Epoch->SatellitesUsed=(uint8_t)((l->Quality>>5) & 31);
+	Epoch->HDOP=(l->Quality & 31)*0.5f;
+	Telemetry->Fixes++;
+	return 1;
+}
+//##################################################################################################################
+#if (_GPS_HOST==1)
+static double	GPS_Telemetry_Now(void)
+{
+	struct timespec	ts;
+	clock_gettime(CLOCK_MONOTONIC,&ts);
+	return ts.tv_sec+ts.tv_nsec*1e-9;
+}
+//##################################################################################################################
+static uint32_t	GPS_Telemetry_Nmea(const GPS_Epoch_t *Epoch)
+{
+	//	length of the GGA a receiver sends for this fix, 5 decimals of minutes
+	char			line[128];
+	uint32_t	t=Epoch->UTC_Time/1000;
+	double		lat=fabs(Epoch->Latitude),lon=fabs(Epoch->Longitude);
+	int				n=snprintf(line,sizeof(line),"$GPGGA,%02u%02u%02u.00,%02d%08.5f,%c,%03d%08.5f,%c,%u,%02u,%.1f,%.1f,M,46.9,M,,*00\r\n",
+		(unsigned)(t/3600),(unsigned)(t/60%60),(unsigned)(t%60),(int)lat,(lat-(int)lat)*60.0,(Epoch->Latitude<0) ? 'S' : 'N',
+		(int)lon,(lon-(int)lon)*60.0,(Epoch->Longitude<0) ? 'W' : 'E',(unsigned)Epoch->Fix,(unsigned)Epoch->SatellitesUsed,Epoch->HDOP,Epoch->MSL_Altitude);
+	return (n>0) ? (uint32_t)n : 0;
+}
+//##################################################################################################################
+uint8_t	GPS_Telemetry_Bench(uint32_t Fixes,uint32_t Interval,uint32_t Packet,GPS_TelemetryBench_t *Result)
+{
+	GPS_Epoch_t		*fix=(GPS_Epoch_t*)malloc((size_t)Fixes*sizeof(GPS_Epoch_t));
+	uint8_t				*buf=(uint8_t*)malloc((size_t)Fixes*Packet);
+	uint32_t			*len=(uint32_t*)malloc((size_t)Fixes*sizeof(uint32_t));
+	GPS_Telemetry_t	tx,rx;
+	GPS_Epoch_t		e;
+	uint32_t			seed=0x9E3779B9,n=0,j=0;
+	uint64_t			nmea=0;
+	double				heading=0.3,speed=15.0,t;
+	memset(Result,0,sizeof(GPS_TelemetryBench_t));
+	if((fix==NULL) || (buf==NULL) || (len==NULL) || (Fixes==0) || (Packet*8<GPS_TELEMETRY_KEY_BITS))
+	{
+		free(fix);
+		free(buf);
+		free(len);
+		return 0;
+	}
+	//	15 m/s with a wandering heading, rolling hills, satellites and HDOP change now and then
+	memset(fix,0,(size_t)Fixes*sizeof(GPS_Epoch_t));
+	for(uint32_t i=0 ; i<Fixes ; i++)
+	{
+		GPS_Epoch_t	*f=&fix[i];
+		seed=seed*1664525+1013904223;
+		heading+=((int32_t)(seed>>16 & 0xFF)-128)*0.002;
+		f->UTC_Time=(uint32_t)((43200000ULL+(uint64_t)i*Interval)%86400000ULL);
+		f->Latitude=(i==0) ? 48.1 : fix[i-1].Latitude+cos(heading)*speed*Interval*1e-3/111320.0;
+		f->Longitude=(i==0) ? 11.5 : fix[i-1].Longitude+sin(heading)*speed*Interval*1e-3/(111320.0*cos(f->Latitude*0.017453292519943295));
+		f->MSL_Altitude=545.0f+40.0f*(float)sin(i*Interval*1e-6)+(float)((int32_t)(seed & 0xFF)-128)*0.01f;
+		f->Fix=1;
+		f->SatellitesUsed=(uint8_t)(10+((i/97) % 5));
+		f->HDOP=0.8f+0.5f*((i/131) % 3);
+		nmea+=GPS_Telemetry_Nmea(f);
+	}
+	for(uint8_t r=0 ; r<3 ; r++)
+	{
+		memset(&tx,0,sizeof(tx));
+		n=0;
+		t=GPS_Telemetry_Now();
+		GPS_Telemetry_Begin(&tx,buf,Packet);
+		for(uint32_t i=0 ; i<Fixes ; i++)
+			if(GPS_Telemetry_Encode(&tx,&fix[i])==0)
+			{
+				len[n++]=GPS_Telemetry_Bytes(&tx);
+				GPS_Telemetry_Begin(&tx,&buf[(size_t)n*Packet],Packet);
+				GPS_Telemetry_Encode(&tx,&fix[i]);
+			}
+		len[n++]=GPS_Telemetry_Bytes(&tx);
+		t=(GPS_Telemetry_Now()-t)*1e9/Fixes;
+		if((r==0) || (t<Result->EncodeNs))
+			Result->EncodeNs=t;
+	}
+	Result->Fixes=Fixes;
+	Result->Packets=n;
+	Result->Keyframes=tx.Keyframes;
+	for(uint32_t p=0 ; p<n ; p++)
+		Result->Bytes+=len[p];
+	Result->BytesPerFix=(double)Result->Bytes/Fixes;
+	Result->NmeaPerFix=(double)nmea/Fixes;
+	Result->EpochSize=sizeof(GPS_Epoch_t);
+	Result->Exact=1;
+	for(uint8_t r=0 ; r<3 ; r++)
+	{
+		j=0;
+		t=GPS_Telemetry_Now();
+		for(uint32_t p=0 ; p<n ; p++)
+		{
+			memset(&rx,0,sizeof(rx));
+			GPS_Telemetry_Begin(&rx,&buf[(size_t)p*Packet],len[p]);
+			while(GPS_Telemetry_Decode(&rx,&e)==1)
+			{
+				//	the first pass checks every field against its quantisation step
+				if((r==0) && (j<Fixes))
+				{
+					const GPS_Epoch_t	*f=&fix[j];
+					double	dn=(e.Latitude-f->Latitude)*111320.0;
+					double	de=(e.Longitude-f->Longitude)*111320.0*cos(f->Latitude*0.017453292519943295);
+					double	d=sqrt(dn*dn+de*de);
+					if(d>Result->MaxError)
+						Result->MaxError=d;
+					if((e.UTC_Time/1000!=f->UTC_Time/1000) || (fabsf(e.MSL_Altitude-f->MSL_Altitude)>0.5f*_GPS_TELEMETRY_ALT_STEP+0.01f) ||
+						(e.Fix!=f->Fix) || (e.SatellitesUsed!=f->SatellitesUsed) || (fabsf(e.HDOP-f->HDOP)>0.26f))
+						Result->Exact=0;
+				}
+				j++;
+			}
+		}
+		t=(GPS_Telemetry_Now()-t)*1e9/Fixes;
+		if((r==0) || (t<Result->DecodeNs))
+			Result->DecodeNs=t;
+		if(j!=Fixes)
+			Result->Exact=0;
+	}
+	//	half a step of 180/2^LAT_BITS degrees and 360/2^LON_BITS at 48 degrees, with margin
+	if(Result->MaxError>111320.0*(90.0/GPS_TELEMETRY_MASK(_GPS_TELEMETRY_LAT_BITS)+180.0/GPS_TELEMETRY_MASK(_GPS_TELEMETRY_LON_BITS)))
+		Result->Exact=0;
+	free(fix);
+	free(buf);
+	free(len);
+	return Result->Exact;
+}
+//##################################################################################################################
+void	GPS_Telemetry_Report(const GPS_TelemetryBench_t *Result)
+{
+	printf("%lu fixes in %lu packets (%lu keyframes), %lu bytes, %s, worst %.2f m\r\n",(unsigned long)Result->Fixes,(unsigned long)Result->Packets,
+		(unsigned long)Result->Keyframes,(unsigned long)Result->Bytes,(Result->Exact!=0) ? "within the quantisation steps" : "MISMATCH",Result->MaxError);
+	printf("%.2f bytes per fix, NMEA GGA %.1f bytes (%.1fx), GPS_Epoch_t %lu bytes, encode %.1f ns, decode %.1f ns per fix\r\n",Result->BytesPerFix,
+		Result->NmeaPerFix,(Result->BytesPerFix>0.0) ? Result->NmeaPerFix/Result->BytesPerFix : 0.0,(unsigned long)Result->EpochSize,Result->EncodeNs,Result->DecodeNs);
+}
+#endif
+//##################################################################################################################
+
+#endif
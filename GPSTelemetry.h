@@ -0,0 +1,75 @@
+#ifndef _GPSTELEMETRY_H_
+#define _GPSTELEMETRY_H_
+
+#include <stdint.h>
+#include "GPSConfig.h"
+#include "GPS.h"
+
+//##################################################################################################################
+//	Bit-packed fix frames for low-bandwidth links. A packet starts with a keyframe (time of day, lat, lon, alt,
+//	fix, satellites, HDOP, 12 bytes with the default widths) followed by delta frames against the previous fix.
+//	A keyframe is forced every _GPS_TELEMETRY_KEYFRAME fixes, or when a delta does not fit.
+//##################################################################################################################
+
+#define	GPS_TELEMETRY_KEY_BITS			(1+17+_GPS_TELEMETRY_LAT_BITS+_GPS_TELEMETRY_LON_BITS+_GPS_TELEMETRY_ALT_BITS+4+5+5)
+#define	GPS_TELEMETRY_DELTA_BITS		(1+6+3*_GPS_TELEMETRY_DELTA_BITS)
+
+typedef struct
+{
+	uint32_t		Time;
+	uint32_t		Lat;
+	uint32_t		Lon;
+	uint32_t		Alt;
+	uint32_t		Quality;
+
+}GPS_TelemetryState_t;
+
+typedef struct
+{
+	uint8_t			*Buffer;
+	uint32_t		Size;
+	uint32_t		Bits;
+	uint8_t			Frames;
+	uint8_t			Reference;
+	GPS_TelemetryState_t	Last;
+
+	uint32_t		Fixes;
+	uint32_t		Keyframes;
+	uint32_t		TotalBits;
+
+}GPS_Telemetry_t;
+
+#if (_GPS_HOST==1)
+typedef struct
+{
+	uint32_t		Fixes;
+	uint32_t		Packets;
+	uint32_t		Keyframes;
+	uint32_t		Bytes;
+	uint8_t			Exact;
+	double			BytesPerFix;
+	double			NmeaPerFix;									//	the GGA sentence of the same fix
+	uint32_t		EpochSize;
+	double			MaxError;										//	m horizontal
+	double			EncodeNs;
+	double			DecodeNs;
+
+}GPS_TelemetryBench_t;
+#endif
+
+//##################################################################################################################
+void			GPS_Telemetry_Begin(GPS_Telemetry_t *Telemetry,uint8_t *Buffer,uint32_t Size);
+//	returns 0 when the packet is full, send Bytes() and Begin() a new one
+uint8_t		GPS_Telemetry_Encode(GPS_Telemetry_t *Telemetry,const GPS_Epoch_t *Epoch);
+uint32_t	GPS_Telemetry_Bytes(const GPS_Telemetry_t *Telemetry);
+//	decodes the next frame of a packet started with Begin(), returns 0 at the end of the packet
+uint8_t		GPS_Telemetry_Decode(GPS_Telemetry_t *Telemetry,GPS_Epoch_t *Epoch);
+#if (_GPS_HOST==1)
+//	a vehicle track with a fix every Interval ms into Packet-byte packets, decoded back and checked against the
+//	quantisation steps, bytes per fix against the NMEA GGA of each fix
+uint8_t		GPS_Telemetry_Bench(uint32_t Fixes,uint32_t Interval,uint32_t Packet,GPS_TelemetryBench_t *Result);
+void			GPS_Telemetry_Report(const GPS_TelemetryBench_t *Result);
+#endif
+//##################################################################################################################
+
+#endif
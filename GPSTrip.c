@@ -0,0 +1,246 @@
+#include "GPSConfig.h"
+
+#if (_GPS_TRIP==1)
+
+#if (_GPS_FIX==0)
+#error "GPSTrip needs _GPS_FIX"
+#endif
+#if (_GPS_TRIP_WINDOW<2) || (_GPS_TRIP_WINDOW>255)
+#error "_GPS_TRIP_WINDOW is 2 to 255 fixes"
+#endif
+
+#include "GPSTrip.h"
+#include <string.h>
+#include <math.h>
+
+#define	GPS_TRIP_METRE								0.011131949						//	m per 1e-7 degree of latitude
+#define	GPS_TRIP_DAY									86400000UL
+//	the sums are rebased past 0.42 degree from the reference, where the longitude scale is still within 1%
+#define	GPS_TRIP_REBASE								(1LL<<22)
+#define	GPS_TRIP_HALF									1800000000.0					//	180 degrees
+//	offsets are clamped here, 255 squares stay within int64. A window that reaches it is never calm anyway.
+#define	GPS_TRIP_CLAMP								(1LL<<27)
+
+GPS_Trip_t GPS_Trip;
+//##################################################################################################################
+static double	GPS_Trip_Wrap(double Longitude)
+{
+	//	into ±180 degrees, for longitudes and their differences alike
+	return (Longitude>GPS_TRIP_HALF) ? Longitude-2.0*GPS_TRIP_HALF : (Longitude<-GPS_TRIP_HALF) ? Longitude+2.0*GPS_TRIP_HALF : Longitude;
+}
+//##################################################################################################################
+static double	GPS_Trip_Distance2(const GPS_Trip_t *Trip,double Lat1,double Lon1,double Lat2,double Lon2)
+{
+	//	squared, in m
+	double	dy=(Lat2-Lat1)*GPS_TRIP_METRE;
+	double	dx=GPS_Trip_Wrap(Lon2-Lon1)*Trip->Scale;
+	return dx*dx+dy*dy;
+}
+//##################################################################################################################
+static void	GPS_Trip_Sum(GPS_Trip_t *Trip,const GPS_TripPoint_t *p,int8_t Sign)
+{
+	int64_t	y=(int64_t)p->Latitude-Trip->RefLatitude;
+	int64_t	x=(int64_t)GPS_Trip_Wrap((double)p->Longitude-Trip->RefLongitude);
+	y=(y>GPS_TRIP_CLAMP) ? GPS_TRIP_CLAMP : (y<-GPS_TRIP_CLAMP) ? -GPS_TRIP_CLAMP : y;
+	x=(x>GPS_TRIP_CLAMP) ? GPS_TRIP_CLAMP : (x<-GPS_TRIP_CLAMP) ? -GPS_TRIP_CLAMP : x;
+	Trip->SumLatitude+=Sign*y;
+	Trip->SumLongitude+=Sign*x;
+	Trip->SumLatitude2+=Sign*y*y;
+	Trip->SumLongitude2+=Sign*x*x;
+}
+//##################################################################################################################
+static void	GPS_Trip_Rebase(GPS_Trip_t *Trip,int32_t Latitude,int32_t Longitude)
+{
+	//	O(window), once every few tens of km
+	Trip->RefLatitude=Latitude;
+	Trip->RefLongitude=Longitude;
+	Trip->Scale=GPS_TRIP_METRE*cos(Latitude*1e-7*M_PI/180.0);
+	Trip->SumLatitude=Trip->SumLongitude=Trip->SumLatitude2=Trip->SumLongitude2=0;
+	for(uint8_t i=0 ; i<Trip->Count ; i++)
+		GPS_Trip_Sum(Trip,&Trip->Window[(Trip->Head+i)%_GPS_TRIP_WINDOW],1);
+}
+//##################################################################################################################
+static void	GPS_Trip_Emit(GPS_Trip_t *Trip,GPS_TripEventType_t Type,const GPS_TripPoint_t *From,const GPS_TripPoint_t *To)
+{
+	GPS_TripEvent_t	e;
+	memset(&e,0,sizeof(e));
+	e.Type=Type;
+	e.Start=From->Time;
+	e.End=To->Time;
+	e.Duration=(uint32_t)(To->Elapsed-From->Elapsed);
+	e.Fixes=To->Fixes-From->Fixes+1;
+	if(Type==GPS_TRIP_SUMMARY)
+	{
+		Trip->Trips++;
+		e.Latitude=From->Latitude;
+		e.Longitude=From->Longitude;
+		e.EndLatitude=To->Latitude;
+		e.EndLongitude=To->Longitude;
+		e.Distance=(float)(To->Odometer-From->Odometer);
+		e.MaxSpeed=Trip->MaxSpeed;
+	}
+	else
+	{
+		e.Latitude=(int32_t)lround(Trip->AnchorLatitude);
+		e.Longitude=(int32_t)lround(Trip->AnchorLongitude);
+		e.EndLatitude=e.Latitude;
+		e.EndLongitude=e.Longitude;
+		e.Spread=Trip->Spread;
+	}
+	if(Trip->Callback!=NULL)
+		Trip->Callback(Trip->Context,&e);
+}
+//##################################################################################################################
+void	GPS_Trip_Init(GPS_Trip_t *Trip,GPS_TripCallback_t Callback,void *Context)
+{
+	memset(Trip,0,sizeof(GPS_Trip_t));
+	Trip->Callback=Callback;
+	Trip->Context=Context;
+}
+//##################################################################################################################
+void	GPS_Trip_Point(GPS_Trip_t *Trip,uint32_t Time,int32_t Latitude,int32_t Longitude)
+{
+	GPS_TripPoint_t	p;
+	p.Latitude=Latitude;
+	p.Longitude=Longitude;
+	p.Time=Time;
+	p.Fixes=Trip->Fixes;
+	if(Trip->State==GPS_TRIP_IDLE)
+	{
+		p.Elapsed=0;
+		p.Odometer=0.0;
+		GPS_Trip_Rebase(Trip,Latitude,Longitude);
+		Trip->State=GPS_TRIP_MOVING;
+		Trip->TripStart=p;
+	}
+	else
+	{
+		uint32_t	dt=(Time>=Trip->Last.Time) ? Time-Trip->Last.Time : Time+GPS_TRIP_DAY-Trip->Last.Time;
+		if((dt==0) || (dt>=GPS_TRIP_DAY))
+			return;
+		int64_t	dy=(int64_t)Latitude-Trip->Last.Latitude,dx=(int64_t)GPS_Trip_Wrap((double)Longitude-Trip->Last.Longitude);
+		if(dt>_GPS_TRIP_GAP)
+		{
+			//	the window restarts after an outage, the state carries on
+			Trip->Count=0;
+			Trip->Gaps++;
+		}
+		else if((dy>GPS_TRIP_REBASE) || (dy<-GPS_TRIP_REBASE) || (dx>GPS_TRIP_REBASE) || (dx<-GPS_TRIP_REBASE))
+		{
+			//	and after a jump, which no window can be calm across
+			Trip->Count=0;
+		}
+		p.Elapsed=Trip->Last.Elapsed+dt;
+		p.Odometer=Trip->Last.Odometer+sqrt(GPS_Trip_Distance2(Trip,Trip->Last.Latitude,Trip->Last.Longitude,Latitude,Longitude));
+		dy=(int64_t)Latitude-Trip->RefLatitude;
+		dx=(int64_t)GPS_Trip_Wrap((double)Longitude-Trip->RefLongitude);
+		if((dy>GPS_TRIP_REBASE) || (dy<-GPS_TRIP_REBASE) || (dx>GPS_TRIP_REBASE) || (dx<-GPS_TRIP_REBASE))
+			GPS_Trip_Rebase(Trip,Latitude,Longitude);
+	}
+	if(Trip->Count==_GPS_TRIP_WINDOW)
+	{
+		GPS_Trip_Sum(Trip,&Trip->Window[Trip->Head],-1);
+		Trip->Head=(uint8_t)((Trip->Head+1)%_GPS_TRIP_WINDOW);
+		Trip->Count--;
+	}
+	Trip->Window[(Trip->Head+Trip->Count)%_GPS_TRIP_WINDOW]=p;
+	Trip->Count++;
+	GPS_Trip_Sum(Trip,&p,1);
+	Trip->Last=p;
+	Trip->Fixes++;
+	if(Trip->Count<_GPS_TRIP_WINDOW)
+		return;
+	//	window centre, spread and speed, compared squared so that a fix takes no root or division on the way
+	const GPS_TripPoint_t	*first=&Trip->Window[Trip->Head];
+	const double	m2=GPS_TRIP_METRE*GPS_TRIP_METRE,s2=Trip->Scale*Trip->Scale;
+	double	my=Trip->SumLatitude*(1.0/_GPS_TRIP_WINDOW),mx=Trip->SumLongitude*(1.0/_GPS_TRIP_WINDOW);
+	double	spread=(Trip->SumLatitude2*(1.0/_GPS_TRIP_WINDOW)-my*my)*m2+(Trip->SumLongitude2*(1.0/_GPS_TRIP_WINDOW)-mx*mx)*s2;
+	double	span=(double)(p.Elapsed-first->Elapsed)*1e-3;
+	double	move=GPS_Trip_Distance2(Trip,first->Latitude,first->Longitude,Latitude,Longitude);
+	double	limit=_GPS_TRIP_SPEED*0.01*span;
+	uint8_t	calm=(move<limit*limit);
+	double	cy=Trip->RefLatitude+my,cx=GPS_Trip_Wrap(Trip->RefLongitude+mx);
+	if((Trip->State==GPS_TRIP_MOVING) && (calm!=0) && (spread<(double)_GPS_TRIP_RADIUS*_GPS_TRIP_RADIUS))
+	{
+		Trip->State=GPS_TRIP_CANDIDATE;
+		Trip->StopStart=*first;
+		Trip->Inside=p;
+		Trip->AnchorLatitude=cy;
+		Trip->AnchorLongitude=cx;
+		Trip->AnchorFixes=1;
+		Trip->Spread=(float)sqrt(fmax(0.0,spread));
+		return;
+	}
+	if((Trip->State!=GPS_TRIP_MOVING) && (GPS_Trip_Distance2(Trip,Trip->AnchorLatitude,Trip->AnchorLongitude,cy,cx)>(double)_GPS_TRIP_RADIUS*_GPS_TRIP_RADIUS))
+	{
+		if(Trip->State==GPS_TRIP_STOPPED)
+		{
+			GPS_Trip_Emit(Trip,GPS_TRIP_STOP_END,&Trip->StopStart,&Trip->Inside);
+			Trip->TripStart=Trip->Inside;
+			Trip->MaxSpeed=0.0f;
+		}
+		Trip->State=GPS_TRIP_MOVING;
+	}
+	if(Trip->State==GPS_TRIP_MOVING)
+	{
+		if(move>Trip->MaxSpeed*span*Trip->MaxSpeed*span)
+			Trip->MaxSpeed=(float)(sqrt(move)/span);
+		return;
+	}
+	if((calm!=0) && (GPS_Trip_Distance2(Trip,Trip->AnchorLatitude,Trip->AnchorLongitude,Latitude,Longitude)<=(double)_GPS_TRIP_RADIUS*_GPS_TRIP_RADIUS))
+	{
+		//	the anchor follows the mean of the calm fixes inside the radius, the last one dates the stop end
+		Trip->Inside=p;
+		Trip->AnchorFixes++;
+		Trip->AnchorLatitude+=(Latitude-Trip->AnchorLatitude)/Trip->AnchorFixes;
+		Trip->AnchorLongitude=GPS_Trip_Wrap(Trip->AnchorLongitude+GPS_Trip_Wrap(Longitude-Trip->AnchorLongitude)/Trip->AnchorFixes);
+	}
+	if((Trip->State==GPS_TRIP_CANDIDATE) && (Trip->Inside.Elapsed-Trip->StopStart.Elapsed>=_GPS_TRIP_DWELL))
+	{
+		if(Trip->StopStart.Elapsed>Trip->TripStart.Elapsed)
+			GPS_Trip_Emit(Trip,GPS_TRIP_SUMMARY,&Trip->TripStart,&Trip->StopStart);
+		GPS_Trip_Emit(Trip,GPS_TRIP_STOP_START,&Trip->StopStart,&Trip->Inside);
+		Trip->State=GPS_TRIP_STOPPED;
+		Trip->Stops++;
+	}
+}
+//##################################################################################################################
+void	GPS_Trip_Add(GPS_Trip_t *Trip,const GPS_Fix_t *Fix)
+{
+	if(Fix->Fix!=0)
+		GPS_Trip_Point(Trip,Fix->UTC_Time,Fix->Latitude,Fix->Longitude);
+}
+//##################################################################################################################
+void	GPS_Trip_Flush(GPS_Trip_t *Trip)
+{
+	if(Trip->State==GPS_TRIP_STOPPED)
+		GPS_Trip_Emit(Trip,GPS_TRIP_STOP_END,&Trip->StopStart,&Trip->Inside);
+	else if((Trip->State!=GPS_TRIP_IDLE) && (Trip->Last.Elapsed>Trip->TripStart.Elapsed))
+		GPS_Trip_Emit(Trip,GPS_TRIP_SUMMARY,&Trip->TripStart,&Trip->Last);
+	GPS_Trip_Init(Trip,Trip->Callback,Trip->Context);
+}
+#if (_GPS_ARCHIVE==1)
+//##################################################################################################################
+uint8_t	GPS_Trip_Archive(GPS_Trip_t *Trip,const GPS_ArchiveReader_t *Reader)
+{
+	//	only the four columns it reads are decoded; the open trip or stop is left for GPS_Trip_Flush()
+	static int32_t	time[_GPS_ARCHIVE_BLOCK],lat[_GPS_ARCHIVE_BLOCK],lon[_GPS_ARCHIVE_BLOCK],fix[_GPS_ARCHIVE_BLOCK];
+	if(Reader->Index==NULL)
+		return 0;
+	for(uint32_t b=0 ; b<Reader->Footer.Blocks ; b++)
+	{
+		uint32_t	n=GPS_Archive_Column(Reader,b,GPS_ARCHIVE_TIME,time);
+		uint8_t		all=(Reader->Index[b].Block.Min[GPS_ARCHIVE_FIX]!=0);
+		if((n==0) || (GPS_Archive_Column(Reader,b,GPS_ARCHIVE_LATITUDE,lat)!=n) || (GPS_Archive_Column(Reader,b,GPS_ARCHIVE_LONGITUDE,lon)!=n)
+			|| ((all==0) && (GPS_Archive_Column(Reader,b,GPS_ARCHIVE_FIX,fix)!=n)))
+			return 0;
+		for(uint32_t i=0 ; i<n ; i++)
+			if((all!=0) || (fix[i]!=0))
+				GPS_Trip_Point(Trip,(uint32_t)time[i],lat[i],lon[i]);
+	}
+	return 1;
+}
+#endif
+//##################################################################################################################
+
+#endif
@@ -0,0 +1,116 @@
+#ifndef _GPSTRIP_H_
+#define _GPSTRIP_H_
+
+#include <stdint.h>
+#include "GPSConfig.h"
+#include "GPS.h"
+#if (_GPS_ARCHIVE==1)
+#include "GPSArchive.h"
+#endif
+
+//##################################################################################################################
+//	Stop/trip segmentation over the fix stream. The last _GPS_TRIP_WINDOW fixes are kept in a ring with running
+//	integer sums, so the window speed (first to last fix) and the RMS spread around its centre cost O(1) a fix.
+//	A calm window opens a stop candidate anchored at its centre. It becomes a stop once the fixes stay within
+//	_GPS_TRIP_RADIUS of the anchor for _GPS_TRIP_DWELL ms, and ends when the window centre leaves the radius.
+//	The stop start is dated back to the first fix of the calm window, its end to the last calm window inside the
+//	radius. _GPS_TRIP_SPEED is in cm/s.
+//##################################################################################################################
+
+typedef enum
+{
+	GPS_TRIP_STOP_START=0,
+	GPS_TRIP_STOP_END,
+	GPS_TRIP_SUMMARY,
+
+}GPS_TripEventType_t;
+
+typedef enum
+{
+	GPS_TRIP_IDLE=0,
+	GPS_TRIP_MOVING,
+	GPS_TRIP_CANDIDATE,
+	GPS_TRIP_STOPPED,
+
+}GPS_TripState_t;
+
+//	Start and End are UTC ms of day, Duration runs across midnight. A stop reports its anchor in Latitude/Longitude,
+//	a trip its start there and its end in EndLatitude/EndLongitude.
+typedef struct
+{
+	GPS_TripEventType_t	Type;
+	uint32_t		Start;
+	uint32_t		End;
+	uint32_t		Duration;
+	int32_t			Latitude;
+	int32_t			Longitude;
+	int32_t			EndLatitude;
+	int32_t			EndLongitude;
+	float				Distance;								//	m
+	float				MaxSpeed;								//	m/s over the window
+	float				Spread;									//	RMS radius of the window that opened the stop, m
+	uint32_t		Fixes;
+
+}GPS_TripEvent_t;
+
+typedef void	(*GPS_TripCallback_t)(void *Context,const GPS_TripEvent_t *Event);
+
+typedef struct
+{
+	int32_t			Latitude;
+	int32_t			Longitude;
+	uint32_t		Time;
+	uint32_t		Fixes;
+	uint64_t		Elapsed;
+	double			Odometer;
+
+}GPS_TripPoint_t;
+
+typedef struct
+{
+	GPS_TripCallback_t	Callback;
+	void				*Context;
+	GPS_TripState_t	State;
+
+	GPS_TripPoint_t	Window[_GPS_TRIP_WINDOW];
+	uint8_t			Head;
+	uint8_t			Count;
+	int32_t			RefLatitude;						//	the sums are taken around this point
+	int32_t			RefLongitude;
+	double			Scale;									//	m per 1e-7 degree of longitude at RefLatitude
+	int64_t			SumLatitude;
+	int64_t			SumLongitude;
+	int64_t			SumLatitude2;
+	int64_t			SumLongitude2;
+	GPS_TripPoint_t	Last;
+
+	GPS_TripPoint_t	TripStart;
+	float				MaxSpeed;
+	GPS_TripPoint_t	StopStart;
+	GPS_TripPoint_t	Inside;									//	last calm fix within the radius of the anchor
+	double			AnchorLatitude;									//	1e-7 degree
+	double			AnchorLongitude;
+	uint32_t		AnchorFixes;
+	float				Spread;
+
+	uint32_t		Fixes;
+	uint32_t		Gaps;
+	uint32_t		Stops;
+	uint32_t		Trips;
+
+}GPS_Trip_t;
+
+extern GPS_Trip_t GPS_Trip;
+//##################################################################################################################
+void			GPS_Trip_Init(GPS_Trip_t *Trip,GPS_TripCallback_t Callback,void *Context);
+//	fixes without a position are ignored. GPS_Trip is fed from every published epoch.
+void			GPS_Trip_Add(GPS_Trip_t *Trip,const GPS_Fix_t *Fix);
+void			GPS_Trip_Point(GPS_Trip_t *Trip,uint32_t Time,int32_t Latitude,int32_t Longitude);
+//	closes the open trip or stop at the last fix
+void			GPS_Trip_Flush(GPS_Trip_t *Trip);
+#if (_GPS_ARCHIVE==1)
+uint8_t		GPS_Trip_Archive(GPS_Trip_t *Trip,const GPS_ArchiveReader_t *Reader);
+#endif
+//##################################################################################################################
+
+#endif
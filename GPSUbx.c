@@ -0,0 +1,373 @@
+#include "GPSConfig.h"
+
+#if (_GPS_UBX==1)
+
+#include "GPSUbx.h"
+#if (_GPS_CRC==1)
+#include "GPSCrc.h"
+#endif
+#include <string.h>
+#include <stddef.h>
+#if (_GPS_HOST==1)
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#endif
+
+#if defined(__BYTE_ORDER__) && (__BYTE_ORDER__!=__ORDER_LITTLE_ENDIAN__)
+#error "GPSUbx records use the UBX little-endian layout"
+#endif
+
+typedef char	GPS_UbxRawxHeaderSize[(sizeof(GPS_RawxHeader_t)==16) ? 1 : -1];
+typedef char	GPS_UbxRawxMeasSize[(sizeof(GPS_RawxMeas_t)==32) ? 1 : -1];
+typedef char	GPS_UbxSfrbxHeaderSize[(sizeof(GPS_SfrbxHeader_t)==8) ? 1 : -1];
+
+GPS_Ubx_t GPS_Ubx;
+//##################################################################################################################
+static uint16_t	GPS_Ubx_Checksum(const uint8_t *Data,uint32_t Len)
+{
+	#if (_GPS_CRC==1)
+	return GPS_Crc_Fletcher16(0,Data,Len);
+	#else
+	uint8_t	a=0,b=0;
+	for(uint32_t i=0 ; i<Len ; i++)
+	{
+		a+=Data[i];
+		b+=a;
+	}
+	return (uint16_t)(a | (b<<8));
+	#endif
+}
+//##################################################################################################################
+static void	GPS_Ubx_Dispatch(uint8_t Class,uint8_t Id,const uint8_t *Payload,uint16_t Len)
+{
+	GPS_Ubx.Frames++;
+	if((Class==GPS_UBX_CLASS_RXM) && ((Id==GPS_UBX_ID_RAWX) || (Id==GPS_UBX_ID_SFRBX)))
+	{
+		//	records are read in place when the payload is 8-byte aligned, otherwise moved once to the frame buffer
+		if(((uintptr_t)Payload & 7)!=0)
+		{
+			if(Len>sizeof(GPS_Ubx.Payload))
+			{
+				GPS_Ubx.Overflows++;
+				return;
+			}
+			memcpy(GPS_Ubx.Payload,Payload,Len);
+			Payload=(const uint8_t*)GPS_Ubx.Payload;
+			GPS_Ubx.Copies++;
+		}
+		else if(Payload!=(const uint8_t*)GPS_Ubx.Payload)
+			GPS_Ubx.ZeroCopy++;
+		if(Id==GPS_UBX_ID_RAWX)
+		{
+			const GPS_RawxHeader_t	*h=(const GPS_RawxHeader_t*)Payload;
+			if((Len<sizeof(GPS_RawxHeader_t)) || (Len!=sizeof(GPS_RawxHeader_t)+h->NumMeas*sizeof(GPS_RawxMeas_t)))
+			{
+				GPS_Ubx.Errors++;
+				return;
+			}
+			if(GPS_Ubx.Rawx!=NULL)
+				GPS_Ubx.Rawx(h,(const GPS_RawxMeas_t*)(Payload+sizeof(GPS_RawxHeader_t)));
+		}
+		else
+		{
+			const GPS_SfrbxHeader_t	*h=(const GPS_SfrbxHeader_t*)Payload;
+			if((Len<sizeof(GPS_SfrbxHeader_t)) || (Len!=sizeof(GPS_SfrbxHeader_t)+h->NumWords*4))
+			{
+				GPS_Ubx.Errors++;
+				return;
+			}
+			if(GPS_Ubx.Sfrbx!=NULL)
+				GPS_Ubx.Sfrbx(h,(const uint32_t*)(Payload+sizeof(GPS_SfrbxHeader_t)));
+		}
+		return;
+	}
+	if(GPS_Ubx.Message!=NULL)
+		GPS_Ubx.Message(Class,Id,Payload,Len);
+}
+//##################################################################################################################
+void	GPS_Ubx_Init(GPS_UbxRawx_t Rawx,GPS_UbxSfrbx_t Sfrbx,GPS_UbxMessage_t Message)
+{
+	memset(&GPS_Ubx,0,sizeof(GPS_Ubx));
+	GPS_Ubx.Rawx=Rawx;
+	GPS_Ubx.Sfrbx=Sfrbx;
+	GPS_Ubx.Message=Message;
+}
+//##################################################################################################################
+void	GPS_Ubx_RxByte(uint8_t Data)
+{
+	uint8_t	*payload=(uint8_t*)GPS_Ubx.Payload;
+	GPS_Ubx.Bytes++;
+	switch(GPS_Ubx.State)
+	{
+		case 0:
+			if(Data==0xB5)
+				GPS_Ubx.State=1;
+		return;
+		case 1:
+			GPS_Ubx.State=(Data==0x62) ? 2 : (Data==0xB5) ? 1 : 0;
+		return;
+		case 2:
+			GPS_Ubx.Class=Data;
+			GPS_Ubx.CkA=Data;
+			GPS_Ubx.CkB=Data;
+			GPS_Ubx.State=3;
+		return;
+		case 3:
+			GPS_Ubx.Id=Data;
+		break;
+		case 4:
+			GPS_Ubx.Len=Data;
+		break;
+		case 5:
+			GPS_Ubx.Len|=(uint16_t)Data<<8;
+			GPS_Ubx.Index=0;
+			if(GPS_Ubx.Len>sizeof(GPS_Ubx.Payload))
+				GPS_Ubx.Overflows++;
+			GPS_Ubx.CkA+=Data;
+			GPS_Ubx.CkB+=GPS_Ubx.CkA;
+			GPS_Ubx.State=(GPS_Ubx.Len==0) ? 7 : 6;
+		return;
+		case 6:
+			if(GPS_Ubx.Index<sizeof(GPS_Ubx.Payload))
+				payload[GPS_Ubx.Index]=Data;
+			if(++GPS_Ubx.Index==GPS_Ubx.Len)
+				GPS_Ubx.State=7;
+			GPS_Ubx.CkA+=Data;
+			GPS_Ubx.CkB+=GPS_Ubx.CkA;
+		return;
+		case 7:
+			if(Data!=GPS_Ubx.CkA)
+			{
+				GPS_Ubx.Errors++;
+				GPS_Ubx.State=0;
+			}
+			else
+				GPS_Ubx.State=8;
+		return;
+		default:
+			GPS_Ubx.State=0;
+			if(Data!=GPS_Ubx.CkB)
+				GPS_Ubx.Errors++;
+			else if(GPS_Ubx.Len<=sizeof(GPS_Ubx.Payload))
+				GPS_Ubx_Dispatch(GPS_Ubx.Class,GPS_Ubx.Id,payload,GPS_Ubx.Len);
+		return;
+	}
+	GPS_Ubx.CkA+=Data;
+	GPS_Ubx.CkB+=GPS_Ubx.CkA;
+	GPS_Ubx.State++;
+}
+//##################################################################################################################
+void	GPS_Ubx_Feed(const uint8_t *Data,uint32_t Len)
+{
+	//	whole frames inside the chunk are checked and dispatched in place, only frames split across chunks go
+	//	through the byte state machine
+	while(Len>0)
+	{
+		if(GPS_Ubx.State==0)
+		{
+			const uint8_t	*p=(const uint8_t*)memchr(Data,0xB5,Len);
+			if(p==NULL)
+			{
+				GPS_Ubx.Bytes+=Len;
+				return;
+			}
+			GPS_Ubx.Bytes+=(uint32_t)(p-Data);
+			Len-=(uint32_t)(p-Data);
+			Data=p;
+			if(Len>=8)
+			{
+				uint32_t	n=(uint32_t)(Data[4] | (Data[5]<<8));
+				if(Data[1]!=0x62)
+				{
+					Data++;
+					Len--;
+					GPS_Ubx.Bytes++;
+					continue;
+				}
+				if(n+8<=Len)
+				{
+					if(GPS_Ubx_Checksum(&Data[2],n+4)==(uint16_t)(Data[n+6] | (Data[n+7]<<8)))
+					{
+						GPS_Ubx.Bytes+=n+8;
+						GPS_Ubx_Dispatch(Data[2],Data[3],&Data[6],(uint16_t)n);
+						Data+=n+8;
+						Len-=n+8;
+					}
+					else
+					{
+						GPS_Ubx.Errors++;
+						GPS_Ubx.Bytes++;
+						Data++;
+						Len--;
+					}
+					continue;
+				}
+			}
+		}
+		GPS_Ubx_RxByte(*Data++);
+		Len--;
+	}
+}
+//##################################################################################################################
+#if (_GPS_HOST==1)
+static uint32_t	GPS_UbxBenchMeas;
+static uint32_t	GPS_UbxBenchWords;
+static uint32_t	GPS_UbxBenchOther;
+static uint32_t	GPS_UbxBenchSum;
+//##################################################################################################################
+static void	GPS_Ubx_BenchRawx(const GPS_RawxHeader_t *Header,const GPS_RawxMeas_t *Meas)
+{
+	GPS_UbxBenchMeas+=Header->NumMeas;
+	for(uint8_t i=0 ; i<Header->NumMeas ; i++)
+		GPS_UbxBenchSum+=Meas[i].Cno+Meas[i].SvId;
+}
+//##################################################################################################################
+static void	GPS_Ubx_BenchSfrbx(const GPS_SfrbxHeader_t *Header,const uint32_t *Words)
+{
+	GPS_UbxBenchWords+=Header->NumWords;
+	GPS_UbxBenchSum+=Words[0];
+}
+//##################################################################################################################
+static void	GPS_Ubx_BenchMessage(uint8_t Class,uint8_t Id,const uint8_t *Payload,uint16_t Len)
+{
+	(void)Class;
+	(void)Id;
+	(void)Payload;
+	GPS_UbxBenchOther+=Len;
+}
+//##################################################################################################################
+static double	GPS_Ubx_Now(void)
+{
+	struct timespec	ts;
+	clock_gettime(CLOCK_MONOTONIC,&ts);
+	return ts.tv_sec+ts.tv_nsec*1e-9;
+}
+//##################################################################################################################
+static uint32_t	GPS_Ubx_BenchFrame(uint8_t *Out,uint8_t Class,uint8_t Id,uint16_t Len,uint32_t *Seed)
+{
+	//	header and random payload, the caller sets its fields and closes the frame
+	Out[0]=0xB5;
+	Out[1]=0x62;
+	Out[2]=Class;
+	Out[3]=Id;
+	Out[4]=(uint8_t)Len;
+	Out[5]=(uint8_t)(Len>>8);
+	for(uint16_t i=0 ; i<Len ; i++)
+	{
+		*Seed=*Seed*1664525+1013904223;
+		Out[6+i]=(uint8_t)(*Seed>>24);
+	}
+	return 6;
+}
+//##################################################################################################################
+static void	GPS_Ubx_BenchClose(uint8_t *Frame,uint16_t Len)
+{
+	uint16_t	ck=GPS_Ubx_Checksum(&Frame[2],Len+4);
+	Frame[6+Len]=(uint8_t)ck;
+	Frame[7+Len]=(uint8_t)(ck>>8);
+}
+//##################################################################################################################
+static double	GPS_Ubx_BenchRun(const uint8_t *Data,uint32_t Len,uint32_t Chunk)
+{
+	double	t;
+	GPS_Ubx_Init(GPS_Ubx_BenchRawx,GPS_Ubx_BenchSfrbx,GPS_Ubx_BenchMessage);
+	GPS_UbxBenchMeas=0;
+	GPS_UbxBenchWords=0;
+	GPS_UbxBenchOther=0;
+	GPS_UbxBenchSum=0;
+	t=GPS_Ubx_Now();
+	if(Chunk==0)
+	{
+		for(uint32_t i=0 ; i<Len ; i++)
+			GPS_Ubx_RxByte(Data[i]);
+	}
+	else
+	{
+		for(uint32_t i=0 ; i<Len ; i+=Chunk)
+			GPS_Ubx_Feed(&Data[i],(Len-i<Chunk) ? Len-i : Chunk);
+	}
+	return GPS_Ubx_Now()-t;
+}
+//##################################################################################################################
+uint8_t	GPS_Ubx_Bench(uint32_t Epochs,uint8_t Meas,uint32_t Chunk,GPS_UbxBench_t *Result)
+{
+	//	an epoch is one RAWX, one SFRBX per 8 measurements and a NAV-PVT, after 0..7 bytes of line noise so
+	//	payloads land both aligned and unaligned
+	uint32_t	rawx=sizeof(GPS_RawxHeader_t)+Meas*sizeof(GPS_RawxMeas_t);
+	uint32_t	sfrbx=sizeof(GPS_SfrbxHeader_t)+10*4;
+	uint32_t	epoch=7+rawx+8+(Meas/8)*(sfrbx+8)+92+8;
+	uint32_t	seed=0x1234567,len=0,sum,words,other,frames;
+	uint8_t		*buf;
+	double		t;
+	memset(Result,0,sizeof(GPS_UbxBench_t));
+	if((Meas==0) || (rawx>_GPS_UBX_BUFFER) || ((uint64_t)Epochs*epoch>0x7FFFFFFF) || (Chunk==0))
+		return 0;
+	if((buf=(uint8_t*)malloc((size_t)Epochs*epoch))==NULL)
+		return 0;
+	for(uint32_t e=0 ; e<Epochs ; e++)
+	{
+		GPS_RawxHeader_t	h;
+		for(uint32_t i=0 ; i<(e & 7) ; i++)
+			buf[len++]=0x00;
+		len+=GPS_Ubx_BenchFrame(&buf[len],GPS_UBX_CLASS_RXM,GPS_UBX_ID_RAWX,(uint16_t)rawx,&seed);
+		memset(&h,0,sizeof(h));
+		h.RcvTow=e*0.05;
+		h.NumMeas=Meas;
+		memcpy(&buf[len],&h,sizeof(h));
+		GPS_Ubx_BenchClose(&buf[len-6],(uint16_t)rawx);
+		len+=rawx+2;
+		for(uint8_t s=0 ; s<Meas/8 ; s++)
+		{
+			len+=GPS_Ubx_BenchFrame(&buf[len],GPS_UBX_CLASS_RXM,GPS_UBX_ID_SFRBX,(uint16_t)sfrbx,&seed);
+			buf[len+4]=10;
+			GPS_Ubx_BenchClose(&buf[len-6],(uint16_t)sfrbx);
+			len+=sfrbx+2;
+		}
+		len+=GPS_Ubx_BenchFrame(&buf[len],0x01,0x07,92,&seed);
+		GPS_Ubx_BenchClose(&buf[len-6],92);
+		len+=92+2;
+	}
+	Result->Epochs=Epochs;
+	Result->Meas=Meas;
+	Result->Chunk=Chunk;
+	Result->Bytes=len;
+	frames=Epochs*(2+Meas/8);
+	//	both paths must see every frame and hand over the same records, best of three runs each
+	for(uint8_t r=0 ; r<3 ; r++)
+	{
+		t=GPS_Ubx_BenchRun(buf,len,0);
+		if((r==0) || (len/t*1e-6>Result->ByteRate))
+			Result->ByteRate=len/t*1e-6;
+	}
+	sum=GPS_UbxBenchSum;
+	words=GPS_UbxBenchWords;
+	other=GPS_UbxBenchOther;
+	Result->Exact=(GPS_Ubx.Frames==frames) && (GPS_Ubx.Errors==0) && (GPS_UbxBenchMeas==Epochs*Meas) && (words==Epochs*(Meas/8)*10) && (other==Epochs*92);
+	for(uint8_t r=0 ; r<3 ; r++)
+	{
+		t=GPS_Ubx_BenchRun(buf,len,Chunk);
+		if((r==0) || (len/t*1e-6>Result->ChunkRate))
+			Result->ChunkRate=len/t*1e-6;
+	}
+	Result->Exact=Result->Exact && (GPS_Ubx.Frames==frames) && (GPS_Ubx.Errors==0) && (GPS_UbxBenchSum==sum) && (GPS_UbxBenchWords==words) && (GPS_UbxBenchOther==other);
+	Result->Frames=GPS_Ubx.Frames;
+	Result->ZeroCopy=GPS_Ubx.ZeroCopy;
+	Result->Copies=GPS_Ubx.Copies;
+	//	how many receivers at 20 Hz the chunked path keeps up with
+	Result->Realtime=Result->ChunkRate*1e6/((double)len/Epochs*20.0);
+	free(buf);
+	return Result->Exact;
+}
+//##################################################################################################################
+void	GPS_Ubx_Report(const GPS_UbxBench_t *Result)
+{
+	printf("%lu epochs of %u measurements, %lu bytes, %lu frames, %s\r\n",(unsigned long)Result->Epochs,(unsigned)Result->Meas,
+		(unsigned long)Result->Bytes,(unsigned long)Result->Frames,(Result->Exact!=0) ? "all frames decoded" : "MISMATCH");
+	printf("byte path %.1f MB/s, %lu-byte chunks %.1f MB/s (%lu in place, %lu copied), %.0fx a 20 Hz receiver\r\n",Result->ByteRate,
+		(unsigned long)Result->Chunk,Result->ChunkRate,(unsigned long)Result->ZeroCopy,(unsigned long)Result->Copies,Result->Realtime);
+}
+#endif
+//##################################################################################################################
+
+#endif
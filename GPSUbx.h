@@ -0,0 +1,120 @@
+#ifndef _GPSUBX_H_
+#define _GPSUBX_H_
+
+#include <stdint.h>
+#include "GPSConfig.h"
+
+//##################################################################################################################
+//	UBX framer with RXM-RAWX and RXM-SFRBX decoders. The records below have the exact UBX wire layout, so on
+//	little-endian targets a frame that sits aligned in the receive buffer is handed over without any copy.
+//##################################################################################################################
+
+#define	GPS_UBX_CLASS_RXM					0x02
+#define	GPS_UBX_ID_RAWX						0x15
+#define	GPS_UBX_ID_SFRBX					0x13
+
+typedef struct
+{
+	double			RcvTow;
+	uint16_t		Week;
+	int8_t			LeapS;
+	uint8_t			NumMeas;
+	uint8_t			RecStat;
+	uint8_t			Version;
+	uint8_t			Reserved[2];
+
+}GPS_RawxHeader_t;
+
+typedef struct
+{
+	double			Pseudorange;
+	double			CarrierPhase;
+	float				Doppler;
+	uint8_t			GnssId;
+	uint8_t			SvId;
+	uint8_t			SigId;
+	uint8_t			FreqId;
+	uint16_t		Locktime;
+	uint8_t			Cno;
+	uint8_t			PrStdev;
+	uint8_t			CpStdev;
+	uint8_t			DoStdev;
+	uint8_t			TrkStat;
+	uint8_t			Reserved;
+
+}GPS_RawxMeas_t;
+
+typedef struct
+{
+	uint8_t			GnssId;
+	uint8_t			SvId;
+	uint8_t			SigId;
+	uint8_t			FreqId;
+	uint8_t			NumWords;
+	uint8_t			Chn;
+	uint8_t			Version;
+	uint8_t			Reserved;
+
+}GPS_SfrbxHeader_t;
+
+typedef void	(*GPS_UbxRawx_t)(const GPS_RawxHeader_t *Header,const GPS_RawxMeas_t *Meas);
+typedef void	(*GPS_UbxSfrbx_t)(const GPS_SfrbxHeader_t *Header,const uint32_t *Words);
+typedef void	(*GPS_UbxMessage_t)(uint8_t Class,uint8_t Id,const uint8_t *Payload,uint16_t Len);
+
+typedef struct
+{
+	GPS_UbxRawx_t			Rawx;
+	GPS_UbxSfrbx_t		Sfrbx;
+	GPS_UbxMessage_t	Message;
+
+	uint8_t			State;
+	uint8_t			Class;
+	uint8_t			Id;
+	uint8_t			CkA;
+	uint8_t			CkB;
+	uint16_t		Len;
+	uint16_t		Index;
+
+	uint32_t		Bytes;
+	uint32_t		Frames;
+	uint32_t		Errors;
+	uint32_t		Overflows;
+	uint32_t		ZeroCopy;
+	uint32_t		Copies;
+
+	double			Payload[(_GPS_UBX_BUFFER+7)/8];
+
+}GPS_Ubx_t;
+
+#if (_GPS_HOST==1)
+typedef struct
+{
+	uint32_t		Epochs;
+	uint32_t		Meas;
+	uint32_t		Chunk;
+	uint32_t		Bytes;
+	uint32_t		Frames;
+	uint32_t		ZeroCopy;
+	uint32_t		Copies;
+	uint8_t			Exact;
+	double			ByteRate;
+	double			ChunkRate;
+	double			Realtime;
+
+}GPS_UbxBench_t;
+#endif
+
+extern GPS_Ubx_t GPS_Ubx;
+//##################################################################################################################
+void	GPS_Ubx_Init(GPS_UbxRawx_t Rawx,GPS_UbxSfrbx_t Sfrbx,GPS_UbxMessage_t Message);
+void	GPS_Ubx_RxByte(uint8_t Data);
+void	GPS_Ubx_Feed(const uint8_t *Data,uint32_t Len);
+#if (_GPS_HOST==1)
+//	Epochs of RAWX with Meas measurements, SFRBX and NAV-PVT, byte path against Chunk-sized feeds. Replaces the
+//	callbacks, call GPS_Ubx_Init() again afterwards.
+uint8_t	GPS_Ubx_Bench(uint32_t Epochs,uint8_t Meas,uint32_t Chunk,GPS_UbxBench_t *Result);
+void		GPS_Ubx_Report(const GPS_UbxBench_t *Result);
+#endif
+//##################################################################################################################
+
+#endif
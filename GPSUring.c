@@ -0,0 +1,380 @@
+#include "GPSConfig.h"
+
+#if (_GPS_URING==1)
+
+#if (_GPS_HOST==0)
+#error "GPSUring needs _GPS_HOST"
+#endif
+
+#include <linux/io_uring.h>
+#include "GPSUring.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <sys/uio.h>
+
+//	newer than some <linux/io_uring.h>, kernel 6.7+
+#define	GPS_URING_OP_READ_MULTISHOT				49
+#define	GPS_URING_GROUP										0
+#define	GPS_URING_STREAM									0xFFFFFFFFFFFFFFFFULL
+#define	GPS_URING_CANCEL									0xFFFFFFFFFFFFFFFEULL
+#define	GPS_URING_TIMEOUT_NS							100000000LL
+
+#if ((_GPS_URING_DEPTH & (_GPS_URING_DEPTH-1))!=0)
+#error "_GPS_URING_DEPTH must be a power of two"
+#endif
+//##################################################################################################################
+static int	GPS_Uring_Enter(GPS_Uring_t *Uring,uint32_t Submit,uint32_t Wait)
+{
+	//	waits at most GPS_URING_TIMEOUT_NS so Stop is seen
+	struct __kernel_timespec				ts={0,GPS_URING_TIMEOUT_NS};
+	struct io_uring_getevents_arg		arg;
+	int	r;
+	memset(&arg,0,sizeof(arg));
+	arg.ts=(uint64_t)(uintptr_t)&ts;
+	Uring->Enters++;
+	r=(int)syscall(__NR_io_uring_enter,Uring->fd,Submit,Wait,(Wait>0) ? (IORING_ENTER_GETEVENTS | IORING_ENTER_EXT_ARG) : 0,(Wait>0) ? &arg : NULL,sizeof(arg));
+	return ((r<0) && (errno!=ETIME) && (errno!=EINTR)) ? -errno : 0;
+}
+//##################################################################################################################
+static struct io_uring_sqe	*GPS_Uring_Sqe(GPS_Uring_t *Uring)
+{
+	uint32_t	tail=*Uring->SqTail;
+	struct io_uring_sqe	*sqe=&Uring->Sqes[tail & Uring->SqMask];
+	memset(sqe,0,sizeof(struct io_uring_sqe));
+	Uring->SqArray[tail & Uring->SqMask]=tail & Uring->SqMask;
+	__atomic_store_n(Uring->SqTail,tail+1,__ATOMIC_RELEASE);
+	return sqe;
+}
+//##################################################################################################################
+static void	GPS_Uring_Provide(GPS_Uring_t *Uring,uint16_t Bid)
+{
+	struct io_uring_buf	*b=&Uring->BufRing->bufs[Uring->BufRing->tail & (_GPS_URING_DEPTH-1)];
+	b->addr=(uint64_t)(uintptr_t)&Uring->Buffers[(uint32_t)Bid*_GPS_URING_BUFFER];
+	b->len=_GPS_URING_BUFFER;
+	b->bid=Bid;
+	__atomic_store_n(&Uring->BufRing->tail,(uint16_t)(Uring->BufRing->tail+1),__ATOMIC_RELEASE);
+}
+//##################################################################################################################
+static void	GPS_Uring_Drain(GPS_Uring_t *Uring,uint64_t Outstanding)
+{
+	//	reads still owned by the kernel must complete before their buffers are reused or the ring is torn down,
+	//	their results are dropped. Gives up if the ring itself fails.
+	while(Outstanding>0)
+	{
+		uint32_t	head,tail;
+		if(GPS_Uring_Enter(Uring,*Uring->SqTail-*Uring->SqHead,1)<0)
+			return;
+		head=*Uring->CqHead;
+		tail=__atomic_load_n(Uring->CqTail,__ATOMIC_ACQUIRE);
+		for( ; (head!=tail) && (Outstanding>0) ; head++)
+		{
+			Uring->Completions++;
+			Outstanding--;
+		}
+		__atomic_store_n(Uring->CqHead,head,__ATOMIC_RELEASE);
+	}
+}
+//##################################################################################################################
+int	GPS_Uring_Init(GPS_Uring_t *Uring)
+{
+	struct io_uring_params	p;
+	struct io_uring_buf_reg	reg;
+	struct iovec						iov[_GPS_URING_DEPTH];
+	uint8_t		*sq;
+	memset(Uring,0,sizeof(GPS_Uring_t));
+	memset(&p,0,sizeof(p));
+	Uring->fd=(int)syscall(__NR_io_uring_setup,_GPS_URING_DEPTH*2,&p);
+	if(Uring->fd<0)
+		return -errno;
+	if((p.features & IORING_FEAT_SINGLE_MMAP)==0)
+	{
+		close(Uring->fd);
+		return -ENOSYS;
+	}
+	//	one mapping for both rings
+	Uring->RingSize=p.sq_off.array+p.sq_entries*sizeof(uint32_t);
+	if(Uring->RingSize<p.cq_off.cqes+p.cq_entries*sizeof(struct io_uring_cqe))
+		Uring->RingSize=p.cq_off.cqes+p.cq_entries*sizeof(struct io_uring_cqe);
+	Uring->Ring=mmap(NULL,Uring->RingSize,PROT_READ | PROT_WRITE,MAP_SHARED | MAP_POPULATE,Uring->fd,IORING_OFF_SQ_RING);
+	Uring->SqesSize=p.sq_entries*sizeof(struct io_uring_sqe);
+	Uring->Sqes=(struct io_uring_sqe*)mmap(NULL,Uring->SqesSize,PROT_READ | PROT_WRITE,MAP_SHARED | MAP_POPULATE,Uring->fd,IORING_OFF_SQES);
+	//	buffers and the provided buffer ring, page aligned
+	Uring->Buffers=(uint8_t*)mmap(NULL,_GPS_URING_DEPTH*_GPS_URING_BUFFER,PROT_READ | PROT_WRITE,MAP_PRIVATE | MAP_ANONYMOUS,-1,0);
+	Uring->BufRing=(struct io_uring_buf_ring*)mmap(NULL,_GPS_URING_DEPTH*sizeof(struct io_uring_buf),PROT_READ | PROT_WRITE,MAP_PRIVATE | MAP_ANONYMOUS,-1,0);
+	if((Uring->Ring==MAP_FAILED) || (Uring->Sqes==MAP_FAILED) || (Uring->Buffers==MAP_FAILED) || (Uring->BufRing==MAP_FAILED))
+	{
+		GPS_Uring_Exit(Uring);
+		return -ENOMEM;
+	}
+	sq=(uint8_t*)Uring->Ring;
+	Uring->SqHead=(uint32_t*)(sq+p.sq_off.head);
+	Uring->SqTail=(uint32_t*)(sq+p.sq_off.tail);
+	Uring->SqMask=*(uint32_t*)(sq+p.sq_off.ring_mask);
+	Uring->SqArray=(uint32_t*)(sq+p.sq_off.array);
+	Uring->CqHead=(uint32_t*)(sq+p.cq_off.head);
+	Uring->CqTail=(uint32_t*)(sq+p.cq_off.tail);
+	Uring->CqMask=*(uint32_t*)(sq+p.cq_off.ring_mask);
+	Uring->Cqes=(struct io_uring_cqe*)(sq+p.cq_off.cqes);
+	for(uint32_t i=0 ; i<_GPS_URING_DEPTH ; i++)
+	{
+		iov[i].iov_base=&Uring->Buffers[i*_GPS_URING_BUFFER];
+		iov[i].iov_len=_GPS_URING_BUFFER;
+	}
+	if(syscall(__NR_io_uring_register,Uring->fd,IORING_REGISTER_BUFFERS,iov,_GPS_URING_DEPTH)<0)
+	{
+		int	e=-errno;
+		GPS_Uring_Exit(Uring);
+		return e;
+	}
+	//	no buffer ring on kernels without it, GPS_Uring_Stream then fails with -EINVAL
+	memset(&reg,0,sizeof(reg));
+	reg.ring_addr=(uint64_t)(uintptr_t)Uring->BufRing;
+	reg.ring_entries=_GPS_URING_DEPTH;
+	reg.bgid=GPS_URING_GROUP;
+	if(syscall(__NR_io_uring_register,Uring->fd,IORING_REGISTER_PBUF_RING,&reg,1)<0)
+	{
+		munmap(Uring->BufRing,_GPS_URING_DEPTH*sizeof(struct io_uring_buf));
+		Uring->BufRing=NULL;
+		return 0;
+	}
+	//	the kernel owns the ring from here on, it is filled once and buffers go back one by one as they are fed
+	Uring->BufRing->tail=0;
+	for(uint16_t i=0 ; i<_GPS_URING_DEPTH ; i++)
+		GPS_Uring_Provide(Uring,i);
+	return 0;
+}
+//##################################################################################################################
+void	GPS_Uring_Exit(GPS_Uring_t *Uring)
+{
+	if((Uring->Ring!=NULL) && (Uring->Ring!=MAP_FAILED))
+		munmap(Uring->Ring,Uring->RingSize);
+	if((Uring->Sqes!=NULL) && ((void*)Uring->Sqes!=MAP_FAILED))
+		munmap(Uring->Sqes,Uring->SqesSize);
+	if((Uring->Buffers!=NULL) && ((void*)Uring->Buffers!=MAP_FAILED))
+		munmap(Uring->Buffers,_GPS_URING_DEPTH*_GPS_URING_BUFFER);
+	if((Uring->BufRing!=NULL) && ((void*)Uring->BufRing!=MAP_FAILED))
+		munmap(Uring->BufRing,_GPS_URING_DEPTH*sizeof(struct io_uring_buf));
+	if(Uring->fd>=0)
+		close(Uring->fd);
+	memset(Uring,0,sizeof(GPS_Uring_t));
+	Uring->fd=-1;
+}
+//##################################################################################################################
+int64_t	GPS_Uring_File(GPS_Uring_t *Uring,int fd,GPS_UringSink_t Sink,void *Context)
+{
+	//	buffer i always holds the read with sequence number i mod depth, so completions that arrive out of order
+	//	are parked until every earlier buffer has been fed
+	struct stat	st;
+	int32_t		res[_GPS_URING_DEPTH];
+	uint64_t	submitted=0,completed=0,fed=0,size,total=0;
+	uint32_t	inflight=0;
+	if(fstat(fd,&st)<0)
+		return -errno;
+	size=(uint64_t)st.st_size;
+	for(uint32_t i=0 ; i<_GPS_URING_DEPTH ; i++)
+		res[i]=-EINPROGRESS;
+	while(fed*_GPS_URING_BUFFER<size)
+	{
+		uint32_t	head,tail;
+		int				e;
+		while((inflight<_GPS_URING_DEPTH) && (submitted*_GPS_URING_BUFFER<size))
+		{
+			struct io_uring_sqe	*sqe=GPS_Uring_Sqe(Uring);
+			uint32_t	i=(uint32_t)(submitted & (_GPS_URING_DEPTH-1));
+			sqe->opcode=IORING_OP_READ_FIXED;
+			sqe->fd=fd;
+			sqe->off=submitted*_GPS_URING_BUFFER;
+			sqe->addr=(uint64_t)(uintptr_t)&Uring->Buffers[i*_GPS_URING_BUFFER];
+			sqe->len=_GPS_URING_BUFFER;
+			sqe->buf_index=(uint16_t)i;
+			sqe->user_data=submitted;
+			submitted++;
+			inflight++;
+		}
+		e=GPS_Uring_Enter(Uring,*Uring->SqTail-*Uring->SqHead,1);
+		if(e<0)
+		{
+			GPS_Uring_Drain(Uring,submitted-completed);
+			return e;
+		}
+		head=*Uring->CqHead;
+		tail=__atomic_load_n(Uring->CqTail,__ATOMIC_ACQUIRE);
+		for( ; head!=tail ; head++)
+		{
+			struct io_uring_cqe	*cqe=&Uring->Cqes[head & Uring->CqMask];
+			res[cqe->user_data & (_GPS_URING_DEPTH-1)]=cqe->res;
+			Uring->Completions++;
+			completed++;
+		}
+		__atomic_store_n(Uring->CqHead,head,__ATOMIC_RELEASE);
+		//	feed in order
+		while(res[fed & (_GPS_URING_DEPTH-1)]!=-EINPROGRESS)
+		{
+			uint32_t	i=(uint32_t)(fed & (_GPS_URING_DEPTH-1));
+			uint64_t	want=size-fed*_GPS_URING_BUFFER;
+			if(want>_GPS_URING_BUFFER)
+				want=_GPS_URING_BUFFER;
+			if((res[i]<0) || ((uint64_t)res[i]!=want))
+			{
+				e=(res[i]<0) ? res[i] : -EIO;
+				GPS_Uring_Drain(Uring,submitted-completed);
+				return e;
+			}
+			Sink(Context,&Uring->Buffers[i*_GPS_URING_BUFFER],(uint32_t)res[i]);
+			total+=(uint64_t)res[i];
+			res[i]=-EINPROGRESS;
+			fed++;
+			inflight--;
+		}
+	}
+	Uring->Bytes+=total;
+	return (int64_t)total;
+}
+//##################################################################################################################
+int64_t	GPS_Uring_Stream(GPS_Uring_t *Uring,int fd,GPS_UringSink_t Sink,void *Context)
+{
+	uint64_t	total=0;
+	uint8_t		armed=0,cancel=0;
+	if(Uring->BufRing==NULL)
+		return -EINVAL;
+	//	an armed read is cancelled on Stop and run down to its last completion, so the next call starts clean
+	while((Uring->Stop==0) || (armed) || (cancel==1))
+	{
+		uint32_t	head,tail;
+		int				e;
+		if((Uring->Stop) && (armed) && (cancel==0))
+		{
+			struct io_uring_sqe	*sqe=GPS_Uring_Sqe(Uring);
+			sqe->opcode=IORING_OP_ASYNC_CANCEL;
+			sqe->addr=GPS_URING_STREAM;
+			sqe->user_data=GPS_URING_CANCEL;
+			cancel=1;
+		}
+		else if((armed==0) && (Uring->Stop==0))
+		{
+			struct io_uring_sqe	*sqe=GPS_Uring_Sqe(Uring);
+			sqe->opcode=GPS_URING_OP_READ_MULTISHOT;
+			sqe->fd=fd;
+			sqe->flags=IOSQE_BUFFER_SELECT;
+			sqe->buf_group=GPS_URING_GROUP;
+			sqe->user_data=GPS_URING_STREAM;
+			armed=1;
+		}
+		e=GPS_Uring_Enter(Uring,*Uring->SqTail-*Uring->SqHead,1);
+		if(e<0)
+			return e;
+		head=*Uring->CqHead;
+		tail=__atomic_load_n(Uring->CqTail,__ATOMIC_ACQUIRE);
+		for( ; head!=tail ; head++)
+		{
+			struct io_uring_cqe	*cqe=&Uring->Cqes[head & Uring->CqMask];
+			Uring->Completions++;
+			if(cqe->user_data==GPS_URING_CANCEL)
+			{
+				cancel=2;
+				continue;
+			}
+			if((cqe->flags & IORING_CQE_F_MORE)==0)
+				armed=0;
+			if(cqe->res>0)
+			{
+				uint16_t	bid=(uint16_t)(cqe->flags>>IORING_CQE_BUFFER_SHIFT);
+				Sink(Context,&Uring->Buffers[(uint32_t)bid*_GPS_URING_BUFFER],(uint32_t)cqe->res);
+				total+=(uint64_t)cqe->res;
+				GPS_Uring_Provide(Uring,bid);
+			}
+			else if(cqe->res==0)
+				Uring->Stop=1;
+			else if((cqe->res!=-ENOBUFS) && (cqe->res!=-ECANCELED))
+			{
+				__atomic_store_n(Uring->CqHead,head+1,__ATOMIC_RELEASE);
+				return cqe->res;
+			}
+		}
+		__atomic_store_n(Uring->CqHead,head,__ATOMIC_RELEASE);
+	}
+	Uring->Bytes+=total;
+	return (int64_t)total;
+}
+//##################################################################################################################
+static double	GPS_Uring_Now(void)
+{
+	struct timespec	ts;
+	clock_gettime(CLOCK_MONOTONIC,&ts);
+	return ts.tv_sec+ts.tv_nsec*1e-9;
+}
+//##################################################################################################################
+uint8_t	GPS_Uring_Bench(const char *Path,GPS_UringSink_t Sink,void *Context,uint8_t Runs,GPS_UringBench_t *Result)
+{
+	//	best of Runs for each method, the file is expected to be in the page cache after the first run
+	GPS_Uring_t	uring;
+	struct stat	st;
+	uint8_t			*buf;
+	int					fd=open(Path,O_RDONLY);
+	memset(Result,0,sizeof(GPS_UringBench_t));
+	if((fd<0) || (fstat(fd,&st)<0) || (st.st_size==0))
+		return 0;
+	buf=(uint8_t*)malloc(_GPS_URING_BUFFER);
+	if((buf==NULL) || (GPS_Uring_Init(&uring)<0))
+	{
+		free(buf);
+		close(fd);
+		return 0;
+	}
+	Result->Bytes=(uint64_t)st.st_size;
+	for(uint8_t r=0 ; r<Runs ; r++)
+	{
+		double	t,mbs;
+		ssize_t	n;
+		void		*map;
+		//	read()
+		t=GPS_Uring_Now();
+		lseek(fd,0,SEEK_SET);
+		while((n=read(fd,buf,_GPS_URING_BUFFER))>0)
+			Sink(Context,buf,(uint32_t)n);
+		mbs=Result->Bytes/(GPS_Uring_Now()-t)/1e6;
+		if(mbs>Result->Read)
+			Result->Read=mbs;
+		//	mmap, fed in the same chunk size
+		t=GPS_Uring_Now();
+		map=mmap(NULL,(size_t)st.st_size,PROT_READ,MAP_PRIVATE,fd,0);
+		if(map!=MAP_FAILED)
+		{
+			madvise(map,(size_t)st.st_size,MADV_SEQUENTIAL);
+			for(uint64_t o=0 ; o<Result->Bytes ; o+=_GPS_URING_BUFFER)
+				Sink(Context,(const uint8_t*)map+o,(uint32_t)((Result->Bytes-o<_GPS_URING_BUFFER) ? Result->Bytes-o : _GPS_URING_BUFFER));
+			munmap(map,(size_t)st.st_size);
+			mbs=Result->Bytes/(GPS_Uring_Now()-t)/1e6;
+			if(mbs>Result->Mmap)
+				Result->Mmap=mbs;
+		}
+		//	io_uring
+		t=GPS_Uring_Now();
+		if(GPS_Uring_File(&uring,fd,Sink,Context)==(int64_t)Result->Bytes)
+		{
+			mbs=Result->Bytes/(GPS_Uring_Now()-t)/1e6;
+			if(mbs>Result->Uring)
+				Result->Uring=mbs;
+		}
+	}
+	GPS_Uring_Exit(&uring);
+	free(buf);
+	close(fd);
+	return 1;
+}
+//##################################################################################################################
+void	GPS_Uring_Report(const GPS_UringBench_t *Result)
+{
+	printf("%llu bytes: read() %.0f MB/s, mmap %.0f MB/s, io_uring %.0f MB/s\r\n",(unsigned long long)Result->Bytes,Result->Read,Result->Mmap,Result->Uring);
+}
+//##################################################################################################################
+
+#endif
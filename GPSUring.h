@@ -0,0 +1,60 @@
+#ifndef _GPSURING_H_
+#define _GPSURING_H_
+
+#include <stdint.h>
+#include "GPSConfig.h"
+
+//##################################################################################################################
+//	io_uring input for the host build. Log files are read with READ_FIXED into registered buffers, with
+//	_GPS_URING_DEPTH reads in flight. ttys and pipes use one multishot read that keeps picking buffers from a
+//	provided buffer ring. In both cases the sink gets the kernel-filled buffer itself.
+//##################################################################################################################
+
+typedef void	(*GPS_UringSink_t)(void *Context,const uint8_t *Data,uint32_t Len);
+
+typedef struct
+{
+	int								fd;
+	uint32_t					*SqHead;
+	uint32_t					*SqTail;
+	uint32_t					SqMask;
+	uint32_t					*SqArray;
+	uint32_t					*CqHead;
+	uint32_t					*CqTail;
+	uint32_t					CqMask;
+	struct io_uring_cqe	*Cqes;
+	struct io_uring_sqe	*Sqes;
+	void							*Ring;
+	uint32_t					RingSize;
+	uint32_t					SqesSize;
+	struct io_uring_buf_ring	*BufRing;
+	uint8_t						*Buffers;
+	volatile uint8_t	Stop;
+	uint64_t					Bytes;
+	uint64_t					Completions;
+	uint64_t					Enters;
+
+}GPS_Uring_t;
+
+typedef struct
+{
+	uint64_t		Bytes;
+	double			Read;
+	double			Mmap;
+	double			Uring;
+
+}GPS_UringBench_t;
+
+//##################################################################################################################
+int				GPS_Uring_Init(GPS_Uring_t *Uring);
+void			GPS_Uring_Exit(GPS_Uring_t *Uring);
+//	whole regular file, in order. Returns the bytes fed or -errno.
+int64_t		GPS_Uring_File(GPS_Uring_t *Uring,int fd,GPS_UringSink_t Sink,void *Context);
+//	tty/pipe until end of file or Stop. Returns the bytes fed or -errno.
+int64_t		GPS_Uring_Stream(GPS_Uring_t *Uring,int fd,GPS_UringSink_t Sink,void *Context);
+//	MB/s for a read() loop, mmap and GPS_Uring_File on the same file and sink
+uint8_t		GPS_Uring_Bench(const char *Path,GPS_UringSink_t Sink,void *Context,uint8_t Runs,GPS_UringBench_t *Result);
+void			GPS_Uring_Report(const GPS_UringBench_t *Result);
+//##################################################################################################################
+
+#endif
@@ -0,0 +1,233 @@
+#include "GPSConfig.h"
+
+#if (_GPS_WCET==1)
+
+#include "GPSWcet.h"
+#include <string.h>
+#include <stdio.h>
+
+#if (_GPS_HOST==1)
+#define	GPS_WCET_CYCLES()					GPS_Host_Cycles()
+#else
+#define	GPS_WCET_CYCLES()					(DWT->CYCCNT)
+#endif
+#define	GPS_WCET_CLOSE						0x80000000UL
+#define	GPS_WCET_MASK							0x7FFFFFFFUL
+
+static uint32_t	GPS_WcetSeed;
+//##################################################################################################################
+static uint32_t	GPS_Wcet_Random(uint32_t Range)
+{
+	GPS_WcetSeed^=GPS_WcetSeed<<13;
+	GPS_WcetSeed^=GPS_WcetSeed>>17;
+	GPS_WcetSeed^=GPS_WcetSeed<<5;
+	return GPS_WcetSeed%Range;
+}
+//##################################################################################################################
+static char	*GPS_Wcet_Digits(char *p,uint8_t Int,uint8_t Frac)
+{
+	//	a number with every digit position used, the worst case for the accumulators
+	for(uint8_t i=0 ; i<Int ; i++)
+		*p++=(char)('1'+GPS_Wcet_Random(9));
+	if(Frac>0)
+		*p++='.';
+	for(uint8_t i=0 ; i<Frac ; i++)
+		*p++=(char)('0'+GPS_Wcet_Random(10));
+	*p++=',';
+	return p;
+}
+//##################################################################################################################
+static uint32_t	GPS_Wcet_Sentence(uint8_t *Buffer,uint32_t Room,const char *Body,uint8_t Corrupt)
+{
+	uint8_t		sum=0;
+	uint32_t	n=(uint32_t)strlen(Body);
+	if(n+6>Room)
+		return 0;
+	for(uint32_t i=0 ; i<n ; i++)
+		sum^=(uint8_t)Body[i];
+	Buffer[0]='$';
+	memcpy(&Buffer[1],Body,n);
+	sprintf((char*)&Buffer[n+1],"*%02X\r\n",(uint8_t)(sum ^ Corrupt));
+	return n+6;
+}
+//##################################################################################################################
+uint32_t	GPS_Wcet_Corpus(uint8_t *Buffer,uint32_t Size,uint32_t Seed)
+{
+	char			body[160];
+	char			time[12]="000000.000,";
+	uint32_t	used=0,n=1;
+	uint32_t	tag=0;
+	GPS_WcetSeed=(Seed!=0) ? Seed : 1;
+	while(n>0)
+	{
+		char	*p=body;
+		uint8_t	corrupt=0;
+		switch(GPS_Wcet_Random(10))
+		{
+			case 0:
+			case 1:
+				//	longest GGA of a new epoch: publish the last one, merge and publish
+				tag=(tag+1)%86400;
+				sprintf(time,"%02lu%02lu%02lu.999,",(unsigned long)(tag/3600),(unsigned long)((tag/60)%60),(unsigned long)(tag%60));
+				p+=sprintf(p,"GNGGA,%s",time);
+				p=GPS_Wcet_Digits(p,4,7);
+				p+=sprintf(p,"S,");
+				p=GPS_Wcet_Digits(p,5,7);
+				p+=sprintf(p,"W,8,99,");
+				p=GPS_Wcet_Digits(p,2,2);
+				p+=sprintf(p,"-");
+				p=GPS_Wcet_Digits(p,5,1);
+				p+=sprintf(p,"M,-");
+				p=GPS_Wcet_Digits(p,3,1);
+				p+=sprintf(p,"M,");
+				p=GPS_Wcet_Digits(p,2,1);
+				sprintf(p,"1023");
+			break;
+			case 2:
+				//	GNS of the same epoch, merged in place with all six modes
+				p+=sprintf(p,"GNGNS,%s",time);
+				p=GPS_Wcet_Digits(p,4,7);
+				p+=sprintf(p,"N,");
+				p=GPS_Wcet_Digits(p,5,7);
+				p+=sprintf(p,"E,RRFPDA,99,");
+				p=GPS_Wcet_Digits(p,2,2);
+				p=GPS_Wcet_Digits(p,5,1);
+				p=GPS_Wcet_Digits(p,3,1);
+				sprintf(p,",,S");
+			break;
+			case 3:
+				p+=sprintf(p,"GNGST,%s",time);
+				for(uint8_t i=0 ; i<7 ; i++)
+					p=GPS_Wcet_Digits(p,4,3);
+				p[-1]=0;
+			break;
+			case 4:
+				//	stale or repeated time tags and bad checksums
+				sprintf(body,"GPGGA,%s,,,,%lu,00,,,,,,,",time,(unsigned long)GPS_Wcet_Random(9));
+				corrupt=(uint8_t)GPS_Wcet_Random(2);
+			break;
+			case 5:
+				//	fields and sentences past the bounds
+				p+=sprintf(p,"GPGGA,");
+				p=GPS_Wcet_Digits(p,(uint8_t)(10+GPS_Wcet_Random(30)),(uint8_t)GPS_Wcet_Random(30));
+				p=GPS_Wcet_Digits(p,9,9);
+				p=GPS_Wcet_Digits(p,9,9);
+				p=GPS_Wcet_Digits(p,9,9);
+				p[-1]=0;
+			break;
+			case 6:
+				memset(body,',',100);
+				memcpy(body,"GNGNS",5);
+				body[5+GPS_Wcet_Random(95)]=0;
+			break;
+			case 7:
+				//	'$' runs
+				body[0]=0;
+				for(uint8_t i=(uint8_t)GPS_Wcet_Random(20) ; (i>0) && (used<Size) ; i--)
+					Buffer[used++]='$';
+			break;
+			default:
+				//	noise, with the delimiters made likely
+				for(uint8_t i=0 ; i<64 ; i++)
+				{
+					static const char	pick[]="$,*.-0123456789ABCDEFGNSTxyz\r\n";
+					body[i]=(GPS_Wcet_Random(2)==0) ? pick[GPS_Wcet_Random(sizeof(pick)-1)] : (char)(1+GPS_Wcet_Random(255));
+				}
+				body[64]=0;
+				n=(Size-used<64) ? 0 : 64;
+				memcpy(&Buffer[used],body,n);
+				used+=n;
+				continue;
+		}
+		if(body[0]==0)
+			continue;
+		n=GPS_Wcet_Sentence(&Buffer[used],Size-used,body,corrupt);
+		used+=n;
+	}
+	return used;
+}
+//##################################################################################################################
+void	GPS_Wcet_Measure(GPS_t *Gps,const uint8_t *Data,uint32_t Len,uint8_t Runs,uint32_t *Cycles,GPS_WcetResult_t *Result)
+{
+	uint32_t	t,dt;
+	memset(Result,0,sizeof(GPS_WcetResult_t));
+	#if (_GPS_HOST==0)
+	CoreDebug->DEMCR|=CoreDebug_DEMCR_TRCENA_Msk;
+	DWT->CTRL|=DWT_CTRL_CYCCNTENA_Msk;
+	#endif
+	Result->Overhead=0xFFFFFFFFUL;
+	for(uint8_t i=0 ; i<64 ; i++)
+	{
+		t=GPS_WCET_CYCLES();
+		dt=GPS_WCET_CYCLES()-t;
+		if(dt<Result->Overhead)
+			Result->Overhead=dt;
+	}
+	if(Cycles==NULL)
+		Runs=1;
+	else
+		for(uint32_t i=0 ; i<Len ; i++)
+			Cycles[i]=GPS_WCET_MASK;
+	for(uint8_t r=0 ; r<Runs ; r++)
+	{
+		GPS_InitEx(Gps);
+		for(uint32_t i=0 ; i<Len ; i++)
+		{
+			//	the second checksum digit is the only byte that can merge and publish
+			uint32_t	close=(Gps->Stream.State==3) ? GPS_WCET_CLOSE : 0;
+			uint8_t		epoch;
+			t=GPS_WCET_CYCLES();
+			GPS_RxChunk(Gps,&Data[i],1);
+			epoch=GPS_ProcessEx(Gps);
+			dt=GPS_WCET_CYCLES()-t;
+			dt=(dt>Result->Overhead) ? dt-Result->Overhead : 0;
+			if((r==0) && (epoch!=0))
+				Result->Epochs++;
+			if(Cycles!=NULL)
+			{
+				if(dt<(Cycles[i] & GPS_WCET_MASK))
+					Cycles[i]=dt;
+				Cycles[i]|=close;
+			}
+			else if((close!=0) && (dt>Result->SentenceMax))
+			{
+				Result->SentenceMax=dt;
+				Result->SentenceWorst=i;
+			}
+			else if((close==0) && (dt>Result->ByteMax))
+			{
+				Result->ByteMax=dt;
+				Result->ByteWorst=i;
+			}
+			if((r==0) && (close!=0))
+				Result->Sentences++;
+		}
+	}
+	if(Cycles!=NULL)
+		for(uint32_t i=0 ; i<Len ; i++)
+		{
+			dt=Cycles[i] & GPS_WCET_MASK;
+			if((Cycles[i] & GPS_WCET_CLOSE) && (dt>Result->SentenceMax))
+			{
+				Result->SentenceMax=dt;
+				Result->SentenceWorst=i;
+			}
+			else if(((Cycles[i] & GPS_WCET_CLOSE)==0) && (dt>Result->ByteMax))
+			{
+				Result->ByteMax=dt;
+				Result->ByteWorst=i;
+			}
+		}
+	Result->Bytes=Len;
+	Result->Bound=Result->SentenceMax+(_GPS_WCET_SENTENCE+4)*Result->ByteMax;
+}
+//##################################################################################################################
+void	GPS_Wcet_Report(const GPS_WcetResult_t *Result)
+{
+	printf("%lu bytes, %lu sentences closed, %lu epochs\r\n",(unsigned long)Result->Bytes,(unsigned long)Result->Sentences,(unsigned long)Result->Epochs);
+	printf("worst byte %lu cycles (at %lu), worst closing byte %lu cycles (at %lu)\r\n",(unsigned long)Result->ByteMax,(unsigned long)Result->ByteWorst,(unsigned long)Result->SentenceMax,(unsigned long)Result->SentenceWorst);
+	printf("bound per sentence %lu cycles, timer overhead %lu removed\r\n",(unsigned long)Result->Bound,(unsigned long)Result->Overhead);
+}
+//##################################################################################################################
+
+#endif
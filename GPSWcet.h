@@ -0,0 +1,44 @@
+#ifndef _GPSWCET_H_
+#define _GPSWCET_H_
+
+#include <stdint.h>
+#include "GPSConfig.h"
+#include "GPS.h"
+#if (_GPS_HOST==1)
+#include "GPSHost.h"
+#else
+#include "usart.h"
+#endif
+
+//##################################################################################################################
+//	Measurement harness for the bounded decoder (_GPS_WCET with _GPS_STREAM). Every byte of a corpus is timed on its
+//	own through GPS_RxChunk() and GPS_ProcessEx(), with DWT->CYCCNT on target and GPS_Host_Cycles() (1 count per ns)
+//	on the host. Bytes that close a sentence carry the merge and publish, so they are kept apart from the others.
+//##################################################################################################################
+
+typedef struct
+{
+	uint32_t		Bytes;
+	uint32_t		Sentences;
+	uint32_t		Epochs;
+	uint32_t		Overhead;
+	uint32_t		ByteMax;
+	uint32_t		ByteWorst;
+	uint32_t		SentenceMax;
+	uint32_t		SentenceWorst;
+	//	SentenceMax+(_GPS_WCET_SENTENCE+4)*ByteMax, the cost of one sentence of any content
+	uint32_t		Bound;
+
+}GPS_WcetResult_t;
+
+//##################################################################################################################
+//	fills Buffer with valid sentences at their longest, repeated and stale time tags, bad checksums, over-long
+//	fields and sentences, '$' and ',' runs and noise. Returns the bytes written.
+uint32_t	GPS_Wcet_Corpus(uint8_t *Buffer,uint32_t Size,uint32_t Seed);
+//	Runs passes from GPS_InitEx(), each byte keeps its fastest pass to filter out interrupts and cache misses.
+//	Cycles is Len words of scratch, NULL for a single pass (target with interrupts off).
+void			GPS_Wcet_Measure(GPS_t *Gps,const uint8_t *Data,uint32_t Len,uint8_t Runs,uint32_t *Cycles,GPS_WcetResult_t *Result);
+void			GPS_Wcet_Report(const GPS_WcetResult_t *Result);
+//##################################################################################################################
+
+#endif